@@ -40,8 +40,19 @@ if __name__ == '__main__':
     # Get the limits for each zoom
     list_zoom_ints = sorted(list_zoom_ints)
 
+    # Ranges of created tiles reported by qm_tiler (needed when empty tiles are skipped), if available
+    availability = {}
+    availability_file = os.path.join(param.tms_dir, "availability.json")
+    if os.path.isfile(availability_file):
+        with open(availability_file) as infile:
+            availability = json.load(infile).get("available", {})
+
     available = []
     for folder_x_int in list_zoom_ints:
+        if str(folder_x_int) in availability:
+            available.append(availability[str(folder_x_int)])
+            continue
+
         cur_limits = {}
 	folder_x = str(folder_x_int)
 
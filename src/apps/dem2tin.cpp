@@ -28,6 +28,7 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <thread>
 // GDAL
 #include "gdal_priv.h"
 #include <ogrsf_frmts.h>
@@ -63,7 +64,8 @@ int main ( int argc, char **argv) {
             psBorderSimpMaxDist, psBorderSimpMaxLength, psHierMaxSurfaceVariance, psWlopRetainPercentage, psWlopRadius, psGridCellSize,
             psRandomRemovePercentage;
     float clippingHighValue, clippingLowValue;
-    int simpStopEdgesCount, heighMapSamplingSteps, greedyInitGridSize;
+    int simpStopEdgesCount, heighMapSamplingSteps, greedyInitGridSize, greedyBatchSize;
+    RefinementBudget greedyBudget;
     unsigned int psHierMaxClusterSize, psWlopIterNumber, psMinFeaturePolylineSize;
     bool bathymetryFlag, verbose, resetOrigin, psPreserveSharpEdges;
 
@@ -93,6 +95,12 @@ int main ( int argc, char **argv) {
              "An initial grid of this size will be used as base mesh to start the insertion process. Defaults to the 4 corners of the terrain if < 0")
             ("tc-greedy-error-type", po::value<string>(&greedyErrorType)->default_value("height"),
              "The error computation type. Available: height, 3d.")
+            ("tc-greedy-batch", po::value<int>(&greedyBatchSize)->default_value(0),
+             "Insert up to this number of points with non-overlapping conflict zones at once, updating the triangulation using all the available cores. Disabled if <= 1.")
+            ("tc-greedy-max-vertices", po::value<std::size_t>(&greedyBudget.maxVertices)->default_value(0),
+             "Stop the greedy insertion when the TIN reaches this number of vertices, even if the error tolerance is not fulfilled. Disabled if 0.")
+            ("tc-greedy-max-time", po::value<double>(&greedyBudget.maxMilliseconds)->default_value(0),
+             "Stop the greedy insertion after this number of milliseconds. Disabled if <= 0.")
             ("tc-lt-stop-edges-count", po::value<int>(&simpStopEdgesCount)->default_value(500),
              "Simplification stops when the number of edges is below this value.")
             ("tc-lt-weight-volume", po::value<double>(&simpWeightVolume)->default_value(0.5),
@@ -323,6 +331,8 @@ int main ( int argc, char **argv) {
         }
         std::shared_ptr<TinCreationGreedyInsertionStrategy> tcGreedy
                 = std::make_shared<TinCreationGreedyInsertionStrategy>(greedyErrorTol, greedyInitGridSize, et);
+        tcGreedy->setBatchInsertion(greedyBatchSize, std::thread::hardware_concurrency());
+        tcGreedy->setRefinementBudget(greedyBudget);
         tinCreator.setCreator(tcGreedy);
     }
 //    else if (tinCreationStrategy.compare("remeshing") == 0) {
@@ -391,6 +401,8 @@ int main ( int argc, char **argv) {
 
     chrono::duration<double> elapsed = finish - start;
     if (verbose) cout << " done, " << elapsed.count() << " seconds." << endl;
+    if (verbose && tinCreator.getLastStopCriterion() != StopNotApplicable)
+        cout << "Stopped by: " << stopCriterionName(tinCreator.getLastStopCriterion()) << endl;
 
     // Recover the real values for the coordinates
     for (Polyhedron::Point_iterator it = poly.points_begin(); it != poly.points_end(); ++it) {
@@ -27,23 +27,31 @@
 // Boost
 #include <boost/program_options.hpp>
 #include <boost/progress.hpp>
+#include <boost/algorithm/string.hpp>
 // Std
 #include <iostream>
 #include <string>
 #include <chrono>
 #include <future>
+#include <functional>
 // GDAl
 #include "cpl_conv.h"
 #include <ogrsf_frmts.h>
 // Project-specific
 #include "quantized_mesh_tiles_pyramid_builder.h"
+#include "parallelism_budget.h"
 #include "zoom_tiles_scheduler.h"
+#include "dataset_coverage.h"
+#include "mosaic_dataset.h"
 #include "ellipsoid.h"
 #include "tin_creation/tin_creator.h"
 #include "tin_creation/tin_creation_delaunay_strategy.h"
 #include "tin_creation/tin_creation_simplification_lindstrom_turk_strategy.h"
+#include "tin_creation/tin_creation_greedy_scan_strategy.h"
 #include "tin_creation/tin_creation_remeshing_strategy.h"
 #include "tin_creation/tin_creation_greedy_insertion_strategy.h"
+#include "tin_creation/tin_creation_rtin_strategy.h"
+#include "tin_creation/tin_creation_simplification_meshopt_strategy.h"
 #include "tin_creation/tin_creation_simplification_point_set_hierarchy.h"
 #include "tin_creation/tin_creation_simplification_point_set_wlop.h"
 #include "tin_creation/tin_creation_simplification_point_set_grid.h"
@@ -86,26 +94,44 @@ namespace std
     }
 }
 
+/**
+ * @brief Rule to use a TIN creation strategy for the tiles in a range of zooms whose roughness is below a threshold
+ */
+struct AdaptiveTinCreationRule
+{
+    std::string strategy;
+    double maxRoughness = 0.0;
+    unsigned int minZoom = 0;
+    unsigned int maxZoom = std::numeric_limits<unsigned int>::max();
+};
+
+
+
 int main ( int argc, char **argv)
 {
     // Command line parser
-    std::string inputFile, outDir, tinCreationStrategy, schedulerType, debugDir, configFile, greedyErrorType;
+    std::string inputFile, inputListFile, outDir, tinCreationStrategy, schedulerType, debugDir, configFile, greedyErrorType, emptyTilesPolicyName, remeshingFallback;
     int startZoom, endZoom;
     double simpWeightVolume, simpWeightBoundary, simpWeightShape, remeshingFacetAngle;
     float clippingHighValue, clippingLowValue, belowSeaLevelScaleFactor, aboveSeaLevelScaleFactor;
-    int heighMapSamplingSteps, greedyInitGridSize;
+    int heighMapSamplingSteps, greedyInitGridSize, greedyBatchSize;
+    RefinementBudget greedyBudget, remeshingBudget;
     unsigned int psWlopIterNumber, psMinFeaturePolylineSize;
     int numThreads = 0;
+    int mosaicMaxOpenFiles;
     bool bathymetryFlag, psPreserveSharpEdges;
+    std::vector<std::string> adaptiveRuleStrings;
     // Parameters per zoom level
     std::vector<int> simpStopEdgesCount;
     std::vector<unsigned int> psHierMaxClusterSize;
-    std::vector<double> greedyErrorTol, remeshingFacetDistance, remeshingFacetSize, remeshingEdgeSize, psBorderSimpMaxDist, psBorderSimpMaxLength, psHierMaxSurfaceVariance, psWlopRetainPercentage, psWlopRadius, psGridCellSize, psRandomRemovePercentage;
+    std::vector<double> greedyErrorTol, rtinErrorTol, meshoptErrorTol, remeshingFacetDistance, remeshingFacetSize, remeshingEdgeSize, psBorderSimpMaxDist, psBorderSimpMaxLength, psHierMaxSurfaceVariance, psWlopRetainPercentage, psWlopRadius, psGridCellSize, psRandomRemovePercentage;
 
     po::options_description options("qm_tiler options");
     options.add_options()
             ( "help,h", "Produce help message" )
-            ( "input,i", po::value<std::string>(&inputFile), "Input terrain file to parse (can be specified like this or as a positional parameter)" )
+            ( "input,i", po::value<std::string>(&inputFile), "Input terrain file to parse (can be specified like this or as a positional parameter). If it is a directory, all the rasters within it are used as a mosaic" )
+            ( "input-list", po::value<std::string>(&inputListFile), "Text file listing the rasters (one per line) to use as a mosaic input, instead of a single input file. The rasters must share the same reference system, and the later ones in the list have precedence where they overlap" )
+            ( "mosaic-max-open-files", po::value<int>(&mosaicMaxOpenFiles)->default_value(64), "Maximum number of rasters of a mosaic input kept open by each thread" )
             ( "output-dir,o", po::value<std::string>(&outDir)->default_value("terrain_tiles_qm"), "The output directory for the tiles" )
             ( "start-zoom,s", po::value<int>(&startZoom)->default_value(-1), "The zoom level to start at. This should be greater than the end zoom level (i.e., the TMS pyramid is constructed from bottom to top). If smaller than zero, defaults to the maximum zoom possible according to DEM resolution." )
             ( "end-zoom,e", po::value<int>(&endZoom)->default_value(0), "The zoom level to end at. This should be less than the start zoom level (i.e., the TMS pyramid is constructed from bottom to top)." )
@@ -117,19 +143,29 @@ int main ( int argc, char **argv)
             ( "below-sea-level-scale-factor", po::value<float>(&belowSeaLevelScaleFactor)->default_value(-1), "Scale factor to apply to the readings below sea level (ignored if < 0)" )
             ( "num-threads", po::value<int>(&numThreads)->default_value(1), "Number of threads used (0=max_threads)" )
             ( "scheduler", po::value<string>(&schedulerType)->default_value("rowwise"), "Scheduler type. Defines the preferred tile processing order within a zoom. Note that on multithreaded executions this order may not be preserved. OPTIONS: rowwise, columnwise, chessboard, 4connected (see documentation for the meaning of each)" )
-            ( "tc-strategy", po::value<string>(&tinCreationStrategy)->default_value("greedy"), "TIN creation strategy. OPTIONS: greedy, lt, delaunay, ps-hierarchy, ps-wlop, ps-grid, ps-random (see documentation for further information)" )
-            ( "tc-greedy-error-tol", po::value<vector<double> >(&greedyErrorTol)->multitoken()->default_value(vector<double>{150000}), "Error tolerance for a tile to fulfill in the greedy insertion approach (*).")
+            ( "empty-tiles", po::value<string>(&emptyTilesPolicyName)->default_value("process"), "What to do with the tiles containing only no data values, detected using a low resolution coverage index of the input (only available if the input has a no data value and is in EPSG:4326). OPTIONS: process (as any other tile), flat (create a flat tile without reading the raster), skip (do not create the tile, the tiles created are listed in the availability.json file of the output directory)" )
+            ( "tc-strategy", po::value<string>(&tinCreationStrategy)->default_value("greedy"), "TIN creation strategy. OPTIONS: greedy, greedy-scan, rtin, lt, meshopt, delaunay, remeshing, ps-hierarchy, ps-wlop, ps-grid, ps-random (see documentation for further information)" )
+            ( "tc-adaptive-rule", po::value<vector<string> >(&adaptiveRuleStrings)->multitoken(), "Use a different TIN creation strategy for the tiles whose roughness (RMS deviation of the heights from the mean of their 4 neighbors, in meters) is below a threshold, in the form <strategy>:<max roughness>[:<min zoom>[:<max zoom>]]. Can be specified multiple times, the first rule matching a tile is used (so the rules with lower thresholds should go first), and the tiles not matching any rule use --tc-strategy. The strategy selected for each tile is logged." )
+            ( "tc-greedy-error-tol", po::value<vector<double> >(&greedyErrorTol)->multitoken()->default_value(vector<double>{150000}), "Error tolerance for a tile to fulfill in the greedy insertion approaches (greedy and greedy-scan) (*).")
             ( "tc-greedy-init-grid-size", po::value<int>(&greedyInitGridSize)->default_value(-1), "An initial grid of this size will be used as base mesh to start the insertion process. Defaults to the 4 corners of the tile if < 0")
-            ( "tc-greedy-error-type", po::value<string>(&greedyErrorType)->default_value("height"), "The error computation type. Available: height, 3d.")
-            ( "tc-lt-stop-edges-count", po::value<vector<int> >(&simpStopEdgesCount)->multitoken()->default_value(vector<int>{500}), "Simplification stops when the number of edges is below this value (*)." )
+            ( "tc-greedy-error-type", po::value<string>(&greedyErrorType)->default_value("height"), "The error computation type for the greedy insertion approaches. Available: height, 3d.")
+            ( "tc-greedy-batch", po::value<int>(&greedyBatchSize)->default_value(0), "Insert up to this number of points with non-overlapping conflict zones at once in the greedy approach, updating the triangulation using the cores not used by the tiling threads. Disabled if <= 1.")
+            ( "tc-greedy-max-vertices", po::value<std::size_t>(&greedyBudget.maxVertices)->default_value(0), "Stop the greedy insertion approaches when a tile reaches this number of vertices, even if the error tolerance is not fulfilled. Disabled if 0.")
+            ( "tc-greedy-max-bytes", po::value<std::size_t>(&greedyBudget.maxBytes)->default_value(0), "Stop the greedy insertion approaches when the estimated size of the tile (uncompressed, without extensions) reaches this number of bytes. Disabled if 0.")
+            ( "tc-greedy-max-time", po::value<double>(&greedyBudget.maxMilliseconds)->default_value(0), "Stop the greedy insertion approaches after this number of milliseconds refining a tile. Disabled if <= 0.")
+            ( "tc-rtin-error-tol", po::value<vector<double> >(&rtinErrorTol)->multitoken()->default_value(vector<double>{150000}), "Error tolerance for a tile to fulfill in the RTIN approach (*). Use 2^k+1 samples per tile (e.g., 129) to avoid resampling the grid.")
+            ( "tc-lt-stop-edges-count", po::value<vector<int> >(&simpStopEdgesCount)->multitoken()->default_value(vector<int>{500}), "Simplification stops when the number of edges is below this value (*). Also used by the meshopt approach." )
             ( "tc-lt-weight-volume", po::value<double>(&simpWeightVolume)->default_value(0.5), "Simplification volume weight (Lindstrom-Turk cost function, see original reference)." )
             ( "tc-lt-weight-boundary", po::value<double>(&simpWeightBoundary)->default_value(0.5), "Simplification boundary weight (Lindstrom-Turk cost function, see original reference)." )
             ( "tc-lt-weight-shape", po::value<double>(&simpWeightShape)->default_value(1e-10), "Simplification shape weight (Lindstrom-Turk cost function, see original reference)." )
-// For the moment, we eliminate the remeshing mode for tiles generation
-//            ( "tc-remeshing-facet-distance", po::value<vector<double> >(&remeshingFacetDistance)->multitoken()->default_value(vector<double>{150000}), "Remeshing facet distance threshold." )
-//            ( "tc-remeshing-facet-angle", po::value<double>(&remeshingFacetAngle)->default_value(25), "Remeshing facet angle threshold." )
-//            ( "tc-remeshing-facet-size", po::value<vector<double> >(&remeshingFacetSize)->multitoken()->default_value(vector<double>{150000}), "Remeshing facet size threshold." )
-//            ( "tc-remeshing-edge-size", po::value<vector<double> >(&remeshingEdgeSize)->multitoken()->default_value(vector<double>{150000}), "Remeshing edge size threshold." )
+            ( "tc-meshopt-error-tol", po::value<vector<double> >(&meshoptErrorTol)->multitoken(), "Error tolerance for the meshopt approach (*). If set, the simplification also stops before the quadric error of a vertex exceeds it.")
+            ( "tc-remeshing-facet-distance", po::value<vector<double> >(&remeshingFacetDistance)->multitoken()->default_value(vector<double>{150000}), "Remeshing facet distance threshold (*)." )
+            ( "tc-remeshing-facet-angle", po::value<double>(&remeshingFacetAngle)->default_value(25), "Remeshing facet angle threshold." )
+            ( "tc-remeshing-facet-size", po::value<vector<double> >(&remeshingFacetSize)->multitoken()->default_value(vector<double>{150000}), "Remeshing facet size threshold (*)." )
+            ( "tc-remeshing-edge-size", po::value<vector<double> >(&remeshingEdgeSize)->multitoken()->default_value(vector<double>{150000}), "Remeshing edge size threshold (*)." )
+            ( "tc-remeshing-max-vertices", po::value<std::size_t>(&remeshingBudget.maxVertices)->default_value(0), "Abandon the remeshing of a tile when it reaches this number of vertices, and use the fallback strategy instead. Disabled if 0.")
+            ( "tc-remeshing-max-time", po::value<double>(&remeshingBudget.maxMilliseconds)->default_value(0), "Abandon the remeshing of a tile after this number of milliseconds, and use the fallback strategy instead. Disabled if <= 0.")
+            ( "tc-remeshing-fallback", po::value<string>(&remeshingFallback)->default_value("greedy"), "TIN creation strategy for the tiles whose remeshing runs out of budget (any but remeshing).")
             ( "tc-ps-border-max-error", po::value<vector<double> >(&psBorderSimpMaxDist)->multitoken()->default_value(vector<double>{10000}), "Polyline simplification error at borders (*)." )
             ( "tc-ps-border-max-length-xy-percent", po::value<vector<double> >(&psBorderSimpMaxLength)->multitoken()->default_value(std::vector<double>{20}), "Polyline simplification, maximum length of border edges when projected to the XY plane. Expressed as a percentage [0..100] (*)." )
             ( "tc-ps-preserve-sharp-edges", po::value<bool>(&psPreserveSharpEdges)->default_value(true), "Preserve and simplify the sharp edges present in the terrain (dihedral angle between incident faces > 60 degrees)." )
@@ -176,59 +212,65 @@ int main ( int argc, char **argv)
         return 1;
     }
 
+    std::transform(tinCreationStrategy.begin(), tinCreationStrategy.end(), tinCreationStrategy.begin(), ::tolower);
     bool preserveBorders = tinCreationStrategy.compare("delaunay") != 0;
 
-    // Setup all GDAL-supported raster drivers
-    GDALAllRegister();
-    CPLSetConfigOption("VRT_SHARED_SOURCE", "0"); // Needed when accessing a single VRT from multiple threads: http://gdal.org/gdal_vrttut.html#gdal_vrttut_mt
-
-    // --- Create as many tilers as required threads ---
-    std::vector<QuantizedMeshTiler> tilers ;
-    std::vector<GDALDataset *> gdalDatasets ;
-    if (numThreads == 0)
-        numThreads = std::thread::hardware_concurrency();
-    for ( int i = 0; i < numThreads; i++ ) {
-        // Open the input dataset
-        //GDALDataset *gdalDataset = (GDALDataset *) GDALOpen(inputFile.c_str(), GA_ReadOnly);
-        gdalDatasets.push_back( (GDALDataset *) GDALOpen(inputFile.c_str(), GA_ReadOnly) );
-        if (gdalDatasets[i] == NULL) {
-            cerr << "[Error] Could not open GDAL dataset" << endl;
-            return EXIT_FAILURE;
+    // Parse the rules to select the TIN creation strategy per tile, in the form <strategy>:<max roughness>[:<min zoom>[:<max zoom>]]
+    std::vector<AdaptiveTinCreationRule> adaptiveRules;
+    for (std::vector<std::string>::const_iterator it = adaptiveRuleStrings.begin(); it != adaptiveRuleStrings.end(); ++it) {
+        std::vector<std::string> fields;
+        boost::split(fields, *it, boost::is_any_of(":"));
+        AdaptiveTinCreationRule rule;
+        try {
+            if (fields.size() < 2 || fields.size() > 4)
+                throw std::invalid_argument("wrong number of fields");
+            rule.strategy = fields[0];
+            std::transform(rule.strategy.begin(), rule.strategy.end(), rule.strategy.begin(), ::tolower);
+            rule.maxRoughness = std::stod(fields[1]);
+            if (fields.size() > 2)
+                rule.minZoom = std::stoul(fields[2]);
+            if (fields.size() > 3)
+                rule.maxZoom = std::stoul(fields[3]);
         }
+        catch (std::exception& e) {
+            cerr << "[ERROR] Wrong TIN creation adaptive rule \"" << *it << "\", the format is <strategy>:<max roughness>[:<min zoom>[:<max zoom>]]" << endl;
+            return 1;
+        }
+        adaptiveRules.push_back(rule);
+    }
+    if (!adaptiveRules.empty() && !preserveBorders) {
+        cerr << "[ERROR] The TIN creation adaptive rules cannot be used with the delaunay strategy as default, as it does not preserve the borders of the tiles" << endl;
+        return 1;
+    }
 
-        // Define the grid we are going to use
-        int tileSize = 256;
-        ctb::Grid grid = ctb::GlobalGeodetic(tileSize);
-
-        // And the ellipsoid of reference
-        Ellipsoid e;
-        e = WGS84Ellipsoid();
-
-        // The tiler options (default for the moment, let the user change this in the future?)
-        ctb::TilerOptions gdalTilerOptions = ctb::TilerOptions();
-
-        // The quantized mesh tiler options
-        QuantizedMeshTiler::QMTOptions qmtOptions;
-        qmtOptions.IsBathymetry = bathymetryFlag;
-        qmtOptions.RefEllipsoid = e;
-        qmtOptions.HeighMapSamplingSteps = heighMapSamplingSteps;
-        qmtOptions.ClippingHighValue = clippingHighValue;
-        qmtOptions.ClippingLowValue = clippingLowValue;
-        qmtOptions.AboveSeaLevelScaleFactor = aboveSeaLevelScaleFactor;
-        qmtOptions.BelowSeaLevelScaleFactor = belowSeaLevelScaleFactor;
+    std::transform(remeshingFallback.begin(), remeshingFallback.end(), remeshingFallback.begin(), ::tolower);
+    if (remeshingFallback.compare("remeshing") == 0) {
+        cerr << "[ERROR] The fallback strategy for remeshing cannot be remeshing" << endl;
+        return 1;
+    }
 
-        // Setup the TIN creator
-        TinCreator tinCreator;
-        std::transform(tinCreationStrategy.begin(), tinCreationStrategy.end(), tinCreationStrategy.begin(), ::tolower);
-        if (tinCreationStrategy.compare("lt") == 0) {
+    // Creates a new instance of a TIN creation strategy given its name (NULL if unknown)
+    std::function<std::shared_ptr<TinCreationStrategy>(const std::string&)> createTinCreationStrategy;
+    createTinCreationStrategy = [&](const std::string& name) -> std::shared_ptr<TinCreationStrategy> {
+        if (name.compare("lt") == 0) {
             std::shared_ptr<TinCreationSimplificationLindstromTurkStrategy> tcLT
                     = std::make_shared<TinCreationSimplificationLindstromTurkStrategy>(simpStopEdgesCount,
                                                                                        simpWeightVolume,
                                                                                        simpWeightBoundary,
                                                                                        simpWeightShape);
-            tinCreator.setCreator(tcLT);
+            return tcLT;
+        }
+        else if (name.compare("meshopt") == 0) {
+            std::shared_ptr<TinCreationSimplificationMeshoptStrategy> tcMeshopt
+                    = std::make_shared<TinCreationSimplificationMeshoptStrategy>(simpStopEdgesCount, meshoptErrorTol);
+            return tcMeshopt;
+        }
+        else if (name.compare("rtin") == 0) {
+            std::shared_ptr<TinCreationRtinStrategy> tcRtin
+                    = std::make_shared<TinCreationRtinStrategy>(rtinErrorTol);
+            return tcRtin;
         }
-        else if (tinCreationStrategy.compare("greedy") == 0) {
+        else if (name.compare("greedy") == 0 || name.compare("greedy-scan") == 0) {
             std::transform(greedyErrorType.begin(), greedyErrorType.end(), greedyErrorType.begin(), ::tolower);
             int et;
             if (greedyErrorType.compare("height") == 0)
@@ -236,23 +278,38 @@ int main ( int argc, char **argv)
             else if (greedyErrorType.compare("3d") == 0)
                 et = TinCreationGreedyInsertionStrategy::Error3D;
             else {
-                std::cerr << "[ERROR] Unknown error type \"" << tinCreationStrategy << "\" for the Greedy TIN creation strategy" << std::endl;
-                return 1;
+                std::cerr << "[ERROR] Unknown error type \"" << greedyErrorType << "\" for the Greedy TIN creation strategy" << std::endl;
+                return std::shared_ptr<TinCreationStrategy>();
             }
 
-            std::shared_ptr<TinCreationGreedyInsertionStrategy> tcGreedy
-                    = std::make_shared<TinCreationGreedyInsertionStrategy>(greedyErrorTol, greedyInitGridSize, et);
-            tinCreator.setCreator(tcGreedy);
+            if (name.compare("greedy") == 0) {
+                std::shared_ptr<TinCreationGreedyInsertionStrategy> tcGreedy
+                        = std::make_shared<TinCreationGreedyInsertionStrategy>(greedyErrorTol, greedyInitGridSize, et);
+                tcGreedy->setBatchInsertion(greedyBatchSize, std::thread::hardware_concurrency());
+                tcGreedy->setRefinementBudget(greedyBudget);
+                return tcGreedy;
+            }
+            else {
+                std::shared_ptr<TinCreationGreedyScanStrategy> tcGreedyScan
+                        = std::make_shared<TinCreationGreedyScanStrategy>(greedyErrorTol, et);
+                tcGreedyScan->setRefinementBudget(greedyBudget);
+                return tcGreedyScan;
+            }
+        }
+        else if (name.compare("remeshing") == 0) {
+            std::shared_ptr<TinCreationRemeshingStrategy> tcRemesh
+                    = std::make_shared<TinCreationRemeshingStrategy>(remeshingFacetDistance,
+                                                                     remeshingFacetAngle,
+                                                                     remeshingFacetSize,
+                                                                     remeshingEdgeSize);
+            tcRemesh->setRefinementBudget(remeshingBudget);
+            std::shared_ptr<TinCreationStrategy> tcFallback = createTinCreationStrategy(remeshingFallback);
+            if (!tcFallback)
+                return tcFallback;
+            tcRemesh->setFallbackStrategy(tcFallback);
+            return tcRemesh;
         }
-//        else if (tinCreationStrategy.compare("remeshing") == 0) {
-//            std::shared_ptr<TinCreationRemeshingStrategy> tcRemesh
-//                    = std::make_shared<TinCreationRemeshingStrategy>(remeshingFacetDistance,
-//                                                                     remeshingFacetAngle,
-//                                                                     remeshingFacetSize,
-//                                                                     remeshingEdgeSize);
-//            tinCreator.setCreator(tcRemesh);
-//        }
-        else if (tinCreationStrategy.compare("ps-hierarchy") == 0) {
+        else if (name.compare("ps-hierarchy") == 0) {
             std::shared_ptr<TinCreationSimplificationPointSetHierarchy> tcHier
                     = std::make_shared<TinCreationSimplificationPointSetHierarchy>(psBorderSimpMaxDist,
                                                                                    psBorderSimpMaxLength,
@@ -260,9 +317,9 @@ int main ( int argc, char **argv)
                                                                                    psPreserveSharpEdges,
                                                                                    psHierMaxClusterSize,
                                                                                    psHierMaxSurfaceVariance);
-            tinCreator.setCreator(tcHier);
+            return tcHier;
         }
-        else if (tinCreationStrategy.compare("ps-wlop") == 0) {
+        else if (name.compare("ps-wlop") == 0) {
             std::shared_ptr<TinCreationSimplificationPointSetWLOP> tcWlop
                     = std::make_shared<TinCreationSimplificationPointSetWLOP>(psBorderSimpMaxDist,
                                                                               psBorderSimpMaxLength,
@@ -271,38 +328,112 @@ int main ( int argc, char **argv)
                                                                               psWlopRetainPercentage,
                                                                               psWlopRadius,
                                                                               psWlopIterNumber);
-            tinCreator.setCreator(tcWlop);
+            return tcWlop;
         }
-        else if (tinCreationStrategy.compare("ps-grid") == 0) {
+        else if (name.compare("ps-grid") == 0) {
             std::shared_ptr<TinCreationSimplificationPointSetGrid> tcGrid
                     = std::make_shared<TinCreationSimplificationPointSetGrid>(psBorderSimpMaxDist,
                                                                               psBorderSimpMaxLength,
                                                                               psMinFeaturePolylineSize,
                                                                               psPreserveSharpEdges,
                                                                               psGridCellSize);
-            tinCreator.setCreator(tcGrid);
+            return tcGrid;
         }
-        else if (tinCreationStrategy.compare("ps-random") == 0) {
+        else if (name.compare("ps-random") == 0) {
             std::shared_ptr<TinCreationSimplificationPointSetRandom> tcRand
                     = std::make_shared<TinCreationSimplificationPointSetRandom>(psBorderSimpMaxDist,
                                                                                 psBorderSimpMaxLength,
                                                                                 psMinFeaturePolylineSize,
                                                                                 psPreserveSharpEdges,
                                                                                 psRandomRemovePercentage);
-            tinCreator.setCreator(tcRand);
+            return tcRand;
         }
-        else if (tinCreationStrategy.compare("delaunay") == 0) {
+        else if (name.compare("delaunay") == 0) {
             std::shared_ptr<TinCreationDelaunayStrategy> tcDel =
                     std::make_shared<TinCreationDelaunayStrategy>();
-            tinCreator.setCreator(tcDel);
+            return tcDel;
         }
         else {
-            std::cerr << "[ERROR] Unknown TIN creation strategy \"" << tinCreationStrategy << "\"" << std::endl;
+            std::cerr << "[ERROR] Unknown TIN creation strategy \"" << name << "\"" << std::endl;
+            return std::shared_ptr<TinCreationStrategy>();
+        }
+    };
+
+    // Setup all GDAL-supported raster drivers
+    GDALAllRegister();
+    CPLSetConfigOption("VRT_SHARED_SOURCE", "0"); // Needed when accessing a single VRT from multiple threads: http://gdal.org/gdal_vrttut.html#gdal_vrttut_mt
+
+    // Index the rasters of the input, if it is a mosaic
+    std::shared_ptr<const MosaicIndex> mosaic ;
+    if (!inputListFile.empty() || fs::is_directory(inputFile)) {
+        try {
+            std::vector<std::string> mosaicFiles = inputListFile.empty() ? MosaicIndex::listDirectory(inputFile)
+                                                                         : MosaicIndex::readFileList(inputListFile);
+            mosaic = std::make_shared<const MosaicIndex>(mosaicFiles);
+        }
+        catch (ctb::CTBException &e) {
+            cerr << "[ERROR] " << e.what() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // --- Create as many tilers as required threads ---
+    std::vector<QuantizedMeshTiler> tilers ;
+    std::vector<GDALDataset *> gdalDatasets ;
+    if (numThreads == 0)
+        numThreads = std::thread::hardware_concurrency();
+    // The parallel algorithms within the tiles share these threads too, not the whole machine
+    ParallelismBudget::setNumThreads(numThreads);
+    for ( int i = 0; i < numThreads; i++ ) {
+        // Open the input dataset (for a mosaic, a dataset without data summarizing its extents)
+        //GDALDataset *gdalDataset = (GDALDataset *) GDALOpen(inputFile.c_str(), GA_ReadOnly);
+        if (mosaic)
+            gdalDatasets.push_back( mosaic->createSummaryDataset() );
+        else
+            gdalDatasets.push_back( (GDALDataset *) GDALOpen(inputFile.c_str(), GA_ReadOnly) );
+        if (gdalDatasets[i] == NULL) {
+            cerr << "[Error] Could not open GDAL dataset" << endl;
+            return EXIT_FAILURE;
+        }
+
+        // Define the grid we are going to use
+        int tileSize = 256;
+        ctb::Grid grid = ctb::GlobalGeodetic(tileSize);
+
+        // And the ellipsoid of reference
+        Ellipsoid e;
+        e = WGS84Ellipsoid();
+
+        // The tiler options (default for the moment, let the user change this in the future?)
+        ctb::TilerOptions gdalTilerOptions = ctb::TilerOptions();
+
+        // The quantized mesh tiler options
+        QuantizedMeshTiler::QMTOptions qmtOptions;
+        qmtOptions.IsBathymetry = bathymetryFlag;
+        qmtOptions.RefEllipsoid = e;
+        qmtOptions.HeighMapSamplingSteps = heighMapSamplingSteps;
+        qmtOptions.ClippingHighValue = clippingHighValue;
+        qmtOptions.ClippingLowValue = clippingLowValue;
+        qmtOptions.AboveSeaLevelScaleFactor = aboveSeaLevelScaleFactor;
+        qmtOptions.BelowSeaLevelScaleFactor = belowSeaLevelScaleFactor;
+
+        // Setup the TIN creator (a different instance of the strategies per thread)
+        TinCreator tinCreator;
+        std::shared_ptr<TinCreationStrategy> tinCreationStrategyPtr = createTinCreationStrategy(tinCreationStrategy);
+        if (!tinCreationStrategyPtr)
             return 1;
+        tinCreator.setCreator(tinCreationStrategyPtr, tinCreationStrategy);
+        for (std::vector<AdaptiveTinCreationRule>::const_iterator it = adaptiveRules.begin(); it != adaptiveRules.end(); ++it) {
+            std::shared_ptr<TinCreationStrategy> adaptiveStrategyPtr = createTinCreationStrategy(it->strategy);
+            if (!adaptiveStrategyPtr)
+                return 1;
+            tinCreator.addAdaptiveCreator(adaptiveStrategyPtr, it->strategy, it->maxRoughness, it->minZoom, it->maxZoom);
         }
 
         // Create the tiler object
         QuantizedMeshTiler tiler(gdalDatasets[i], grid, gdalTilerOptions, qmtOptions, tinCreator);
+        if (mosaic)
+            tiler.setMosaic(mosaic, mosaicMaxOpenFiles);
         // Add the tiler
         tilers.push_back(tiler);
     }
@@ -336,6 +467,20 @@ int main ( int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    // Policy for the empty tiles
+    int emptyTilesPolicy;
+    std::transform(emptyTilesPolicyName.begin(), emptyTilesPolicyName.end(), emptyTilesPolicyName.begin(), ::tolower ) ;
+    if (emptyTilesPolicyName.compare("process") == 0)
+        emptyTilesPolicy = QuantizedMeshTilesPyramidBuilder::EmptyTilesProcess;
+    else if (emptyTilesPolicyName.compare("flat") == 0)
+        emptyTilesPolicy = QuantizedMeshTilesPyramidBuilder::EmptyTilesFlat;
+    else if (emptyTilesPolicyName.compare("skip") == 0)
+        emptyTilesPolicy = QuantizedMeshTilesPyramidBuilder::EmptyTilesSkip;
+    else {
+        std::cerr << "[ERROR] Unknown empty tiles policy \"" << emptyTilesPolicyName << "\"" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     // Create the output directory, if needed
     fs::path outDirPath(outDir) ;
     if (!fs::exists(outDirPath) && !fs::create_directory(outDirPath)) {
@@ -346,6 +491,15 @@ int main ( int argc, char **argv)
     // Create the tiles
     QuantizedMeshTilesPyramidBuilder qmtpb(tilers, scheduler);
     auto start = std::chrono::high_resolution_clock::now();
+    if (emptyTilesPolicy != QuantizedMeshTilesPyramidBuilder::EmptyTilesProcess && mosaic)
+        std::cout << "The coverage index is not available for mosaic inputs, tiles without data will be processed" << std::endl;
+    else if (emptyTilesPolicy != QuantizedMeshTilesPyramidBuilder::EmptyTilesProcess) {
+        // Coverage index of the input, computed once for all the zooms
+        DatasetCoverage coverage(gdalDatasets[0], tilers[0].grid().getSRS());
+        if (coverage.isEnabled())
+            std::cout << "Coverage index: " << coverage.validRatio()*100.0 << "% of the input contains data" << std::endl;
+        qmtpb.setDatasetCoverage(coverage, emptyTilesPolicy);
+    }
     if (preserveBorders)
         qmtpb.createTmsPyramid(startZoom, endZoom, outDir, debugDir);
     else
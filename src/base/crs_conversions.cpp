@@ -19,6 +19,14 @@
 // Author: Ricard Campos (ricardcd@gmail.com)
 
 #include "crs_conversions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace crs_conversions
 {
@@ -87,7 +95,7 @@ void ecef2llh( const double& x, const double& y, const double& z,
     if( c2 > 0.3 ){
         s = ( zp/r )*( 1.0 + c2*( a1 + u + s2*v )/r );
         lat = asin( s );      //Lat
-        double ss = s*s;
+        ss = s*s;
         c = sqrt( 1.0 - ss );
     }
     else{
@@ -115,4 +123,238 @@ void ecef2llh( const double& x, const double& y, const double& z,
     lat *= 180./M_PI;
 }
 
-} // End namespace crs_conversions
\ No newline at end of file
+
+
+// --- GeodeticECEFConverter ---
+
+// WGS84 ellipsoid, defined as in GeographicLib
+static const double kWGS84A = 6378137.0 ;                            // Semi-major axis
+static const double kWGS84F = 1.0/298.257223563 ;                    // Flattening
+static const double kWGS84E2 = kWGS84F*( 2.0 - kWGS84F ) ;           // First eccentricity squared
+static const double kWGS84E2m = ( 1.0 - kWGS84F )*( 1.0 - kWGS84F ) ; // 1 - e^2
+
+// Size of the tables of trigonometric terms (must be a power of 2). A table is emptied when all the slots probed for a
+// new value are taken, so that it follows the values of the current tile
+static const std::size_t kTableBits = 10 ;
+static const std::size_t kTableSize = std::size_t(1) << kTableBits ;
+static const std::size_t kTableMaxProbes = 16 ;
+
+// Sine and cosine of an angle in degrees, exact for multiples of 90 degrees (as GeographicLib::Math::sincosd)
+static void sincosd( const double& x, double& sinx, double& cosx )
+{
+    int q = 0 ;
+    double r = std::remquo( x, 90.0, &q ) ; // r in [-45, 45]
+    r *= M_PI/180.0 ;
+    double s = std::sin( r ), c = std::cos( r ) ;
+    switch ( unsigned(q) & 3U ) {
+        case 0U: sinx =  s; cosx =  c; break;
+        case 1U: sinx =  c; cosx = -s; break;
+        case 2U: sinx = -s; cosx = -c; break;
+        default: sinx = -c; cosx =  s; break;
+    }
+}
+
+// Slot of a value in the tables
+static inline std::size_t tableSlot( const double& value )
+{
+    std::uint64_t bits ;
+    std::memcpy( &bits, &value, sizeof(bits) ) ;
+    return (std::size_t)( ( bits*0x9E3779B97F4A7C15ULL ) >> ( 64 - kTableBits ) ) ;
+}
+
+// Find the terms of a value in one of the tables, computing them if they are not there yet
+template <class ComputeTerms, class TrigTerms>
+static const TrigTerms& findOrInsertTerms( std::vector<TrigTerms>& table, const double& value, ComputeTerms computeTerms )
+{
+    std::size_t slot = tableSlot( value ) ;
+    for ( std::size_t probe = 0; probe < kTableMaxProbes; probe++ ) {
+        TrigTerms& entry = table[( slot + probe ) & ( kTableSize - 1 )] ;
+        if ( entry.value == value )
+            return entry ;
+        if ( std::isnan( entry.value ) ) {
+            computeTerms( value, entry ) ;
+            return entry ;
+        }
+    }
+
+    // Full neighborhood (i.e., the table contains the values of many tiles already): start over
+    TrigTerms empty = table[slot] ;
+    empty.value = std::numeric_limits<double>::quiet_NaN() ;
+    std::fill( table.begin(), table.end(), empty ) ;
+    computeTerms( value, table[slot] ) ;
+    return table[slot] ;
+}
+
+template <class TrigTerms>
+static void computeLonTerms( const double& lon, TrigTerms& terms )
+{
+    terms.value = lon ;
+    sincosd( lon, terms.sin, terms.cos ) ;
+    terms.radius = 0.0 ;
+}
+
+template <class TrigTerms>
+static void computeLatTerms( const double& lat, TrigTerms& terms )
+{
+    terms.value = lat ;
+    sincosd( lat, terms.sin, terms.cos ) ;
+    terms.radius = kWGS84A/std::sqrt( 1.0 - kWGS84E2*terms.sin*terms.sin ) ;
+}
+
+// Arithmetic pass of the geodetic to ECEF conversion, for points with their terms already gathered
+static void geodeticTermsToECEFScalar( const double* sinLon, const double* cosLon,
+                                       const double* sinLat, const double* cosLat, const double* radius,
+                                       const double* h, std::size_t n,
+                                       double* x, double* y, double* z )
+{
+    for ( std::size_t k = 0; k < n; k++ ) {
+        double xy = ( radius[k] + h[k] )*cosLat[k] ;
+        x[k] = xy*cosLon[k] ;
+        y[k] = xy*sinLon[k] ;
+        z[k] = ( kWGS84E2m*radius[k] + h[k] )*sinLat[k] ;
+    }
+}
+
+#if defined(__AVX2__)
+
+static void geodeticTermsToECEF( const double* sinLon, const double* cosLon,
+                                 const double* sinLat, const double* cosLat, const double* radius,
+                                 const double* h, std::size_t n,
+                                 double* x, double* y, double* z )
+{
+    const __m256d e2m = _mm256_set1_pd( kWGS84E2m ) ;
+    std::size_t k = 0 ;
+    for ( ; k + 4 <= n; k += 4 ) {
+        __m256d hv = _mm256_loadu_pd( h + k ) ;
+        __m256d rv = _mm256_loadu_pd( radius + k ) ;
+        __m256d xy = _mm256_mul_pd( _mm256_add_pd( rv, hv ), _mm256_loadu_pd( cosLat + k ) ) ;
+        _mm256_storeu_pd( x + k, _mm256_mul_pd( xy, _mm256_loadu_pd( cosLon + k ) ) ) ;
+        _mm256_storeu_pd( y + k, _mm256_mul_pd( xy, _mm256_loadu_pd( sinLon + k ) ) ) ;
+        __m256d zr = _mm256_add_pd( _mm256_mul_pd( e2m, rv ), hv ) ;
+        _mm256_storeu_pd( z + k, _mm256_mul_pd( zr, _mm256_loadu_pd( sinLat + k ) ) ) ;
+    }
+
+    // Remaining points
+    geodeticTermsToECEFScalar( sinLon + k, cosLon + k, sinLat + k, cosLat + k, radius + k, h + k, n - k,
+                               x + k, y + k, z + k ) ;
+}
+
+bool GeodeticECEFConverter::isVectorized() { return true ; }
+
+#else
+
+static void geodeticTermsToECEF( const double* sinLon, const double* cosLon,
+                                 const double* sinLat, const double* cosLat, const double* radius,
+                                 const double* h, std::size_t n,
+                                 double* x, double* y, double* z )
+{
+    geodeticTermsToECEFScalar( sinLon, cosLon, sinLat, cosLat, radius, h, n, x, y, z ) ;
+}
+
+bool GeodeticECEFConverter::isVectorized() { return false ; }
+
+#endif
+
+
+
+GeodeticECEFConverter::GeodeticECEFConverter()
+{
+    TrigTerms empty ;
+    empty.value = std::numeric_limits<double>::quiet_NaN() ;
+    empty.sin = empty.cos = empty.radius = 0.0 ;
+    m_lonTable.assign( kTableSize, empty ) ;
+    m_latTable.assign( kTableSize, empty ) ;
+}
+
+
+
+const GeodeticECEFConverter::TrigTerms& GeodeticECEFConverter::lonTerms( const double& lon )
+{
+    return findOrInsertTerms( m_lonTable, lon, computeLonTerms<TrigTerms> ) ;
+}
+
+
+
+const GeodeticECEFConverter::TrigTerms& GeodeticECEFConverter::latTerms( const double& lat )
+{
+    return findOrInsertTerms( m_latTable, lat, computeLatTerms<TrigTerms> ) ;
+}
+
+
+
+void GeodeticECEFConverter::geodeticToECEF( const double* lon, const double* lat, const double* h, std::size_t n,
+                                            double* x, double* y, double* z )
+{
+    m_sinLon.resize( n ) ;
+    m_cosLon.resize( n ) ;
+    m_sinLat.resize( n ) ;
+    m_cosLat.resize( n ) ;
+    m_radius.resize( n ) ;
+
+    // Gather the trigonometric terms (consecutive points usually share their longitude or latitude, so we check the
+    // previous one before going to the tables)
+    TrigTerms lastLon, lastLat ;
+    computeLonTerms( 0.0, lastLon ) ;
+    computeLatTerms( 0.0, lastLat ) ;
+    for ( std::size_t k = 0; k < n; k++ ) {
+        if ( lon[k] != lastLon.value ) {
+            if ( std::isnan( lon[k] ) )
+                computeLonTerms( lon[k], lastLon ) ;
+            else
+                lastLon = lonTerms( lon[k] ) ;
+        }
+        m_sinLon[k] = lastLon.sin ;
+        m_cosLon[k] = lastLon.cos ;
+
+        if ( lat[k] != lastLat.value ) {
+            if ( std::isnan( lat[k] ) )
+                computeLatTerms( lat[k], lastLat ) ;
+            else
+                lastLat = latTerms( lat[k] ) ;
+        }
+        m_sinLat[k] = lastLat.sin ;
+        m_cosLat[k] = lastLat.cos ;
+        m_radius[k] = lastLat.radius ;
+    }
+
+    geodeticTermsToECEF( m_sinLon.data(), m_cosLon.data(), m_sinLat.data(), m_cosLat.data(), m_radius.data(),
+                         h, n, x, y, z ) ;
+}
+
+
+
+void GeodeticECEFConverter::geodeticToECEF( const double& lon, const double& lat, const double& h,
+                                            double& x, double& y, double& z )
+{
+    geodeticToECEF( &lon, &lat, &h, 1, &x, &y, &z ) ;
+}
+
+
+
+void GeodeticECEFConverter::ecefToGeodetic( const double* x, const double* y, const double* z, std::size_t n,
+                                            double* lon, double* lat, double* h ) const
+{
+    for ( std::size_t k = 0; k < n; k++ )
+        ecef2llh( x[k], y[k], z[k], lat[k], lon[k], h[k] ) ;
+}
+
+
+
+void GeodeticECEFConverter::ecefToGeodetic( const double& x, const double& y, const double& z,
+                                            double& lon, double& lat, double& h ) const
+{
+    ecef2llh( x, y, z, lat, lon, h ) ;
+}
+
+
+
+void radiiOfCurvature( const double& lat, double& meridian, double& primeVertical )
+{
+    double sinLat, cosLat ;
+    sincosd( lat, sinLat, cosLat ) ;
+    double w2 = 1.0 - kWGS84E2*sinLat*sinLat ;
+    primeVertical = kWGS84A/std::sqrt( w2 ) ;
+    meridian = primeVertical*kWGS84E2m/w2 ;
+}
+
+} // End namespace crs_conversions
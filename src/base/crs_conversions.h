@@ -22,6 +22,8 @@
 #define EMODNET_QMGC_CRS_CONVERSIONS_H
 
 #include <math.h>
+#include <cstddef>
+#include <vector>
 
 /*! @namespace crs_conversions
     @brief Simple CRS conversions tools
@@ -51,6 +53,92 @@ namespace crs_conversions
      */
     void ecef2llh( const double& x, const double& y, const double& z,
                    double& lat, double& lon, double& h );
+
+    /**
+     * @brief Radii of curvature of the WGS84 ellipsoid at a given latitude
+     * @param lat Latitude (in degrees)
+     * @param[out] meridian Radius of curvature in the meridian (north-south direction, in meters)
+     * @param[out] primeVertical Radius of curvature in the prime vertical (east-west direction, in meters)
+     */
+    void radiiOfCurvature( const double& lat, double& meridian, double& primeVertical ) ;
+
+    /**
+     * @class GeodeticECEFConverter
+     * @brief Batched conversions between geodetic (longitude/latitude/height, WGS84) and Earth-Centered Earth-Fixed
+     * coordinates.
+     *
+     * The points are given as separate arrays for each coordinate (structure of arrays). The geodetic to ECEF conversion
+     * uses the closed form formula, in two passes: the trigonometric terms of the longitude/latitude of each point are
+     * gathered first, and then the ECEF coordinates are computed with plain arithmetic over the arrays (using AVX2 when
+     * the code is compiled with support for it). Since the points of a tile come from a regular grid, their longitudes
+     * and latitudes only take a few distinct values (e.g., 256 each), so these terms are kept in small tables indexed by
+     * value, and only computed the first time a value is seen. The ECEF to geodetic conversion uses the closed form
+     * method in ecef2llh.
+     *
+     * The results match the ones of GeographicLib::Geocentric up to rounding errors. The tables are modified during the
+     * conversion, so an instance should not be shared between threads.
+     */
+    class GeodeticECEFConverter
+    {
+    public:
+        /// Constructor
+        GeodeticECEFConverter() ;
+
+        /**
+         * @brief Converts a set of points from geodetic to ECEF coordinates
+         * @param lon Longitudes (in degrees)
+         * @param lat Latitudes (in degrees, in [-90, 90])
+         * @param h Heights (in meters)
+         * @param n Number of points
+         * @param[out] x Earth-Centered Earth-Fixed X
+         * @param[out] y Earth-Centered Earth-Fixed Y
+         * @param[out] z Earth-Centered Earth-Fixed Z
+         */
+        void geodeticToECEF( const double* lon, const double* lat, const double* h, std::size_t n,
+                             double* x, double* y, double* z ) ;
+
+        /**
+         * @brief Converts a set of points from ECEF to geodetic coordinates
+         * @param x Earth-Centered Earth-Fixed X
+         * @param y Earth-Centered Earth-Fixed Y
+         * @param z Earth-Centered Earth-Fixed Z
+         * @param n Number of points
+         * @param[out] lon Longitudes (in degrees)
+         * @param[out] lat Latitudes (in degrees)
+         * @param[out] h Heights (in meters)
+         */
+        void ecefToGeodetic( const double* x, const double* y, const double* z, std::size_t n,
+                             double* lon, double* lat, double* h ) const ;
+
+        /// Single point version of geodeticToECEF
+        void geodeticToECEF( const double& lon, const double& lat, const double& h,
+                             double& x, double& y, double& z ) ;
+
+        /// Single point version of ecefToGeodetic
+        void ecefToGeodetic( const double& x, const double& y, const double& z,
+                             double& lon, double& lat, double& h ) const ;
+
+        /// Check if the arithmetic pass of geodeticToECEF was compiled using SIMD instructions
+        static bool isVectorized() ;
+
+    private:
+        /// Trigonometric terms of a longitude/latitude value
+        struct TrigTerms
+        {
+            double value ;  //!< The longitude/latitude (NaN for an empty entry)
+            double sin ;    //!< Its sine
+            double cos ;    //!< Its cosine
+            double radius ; //!< Prime vertical radius of curvature (for latitudes only)
+        } ;
+
+        std::vector<TrigTerms> m_lonTable ;
+        std::vector<TrigTerms> m_latTable ;
+        // Per-point terms gathered from the tables, reused between calls
+        std::vector<double> m_sinLon, m_cosLon, m_sinLat, m_cosLat, m_radius ;
+
+        const TrigTerms& lonTerms( const double& lon ) ;
+        const TrigTerms& latTerms( const double& lat ) ;
+    } ;
 } // End namespace crs_conversions
 
 #endif // EMODNET_QMGC_CONVERSIONS_H
@@ -0,0 +1,130 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "dataset_coverage.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+
+DatasetCoverage::DatasetCoverage(GDALDataset* dataset, const OGRSpatialReference& gridSRS, const int& maxCellsPerSide)
+    : m_enabled(false), m_numCols(0), m_numRows(0), m_cellSize(1)
+{
+    if ( dataset == NULL || dataset->GetRasterCount() < 1 )
+        return ;
+
+    // The coverage only makes sense if the tiles of the dataset may contain no data values
+    GDALRasterBand* band = dataset->GetRasterBand(1) ;
+    int hasNoData = 0 ;
+    band->GetNoDataValue(&hasNoData) ;
+    if ( !hasNoData || ( band->GetMaskFlags() & GMF_ALL_VALID ) ) {
+        std::cout << "The input dataset has no \"no data\" value, coverage index disabled" << std::endl ;
+        return ;
+    }
+
+    // The tile bounds are expressed in the reference system of the grid, we do not reproject them
+    OGRSpatialReference datasetSRS(dataset->GetProjectionRef()) ;
+    if ( !datasetSRS.IsSame(&gridSRS) ) {
+        std::cerr << "[WARNING] The input dataset is not in the reference system of the tiling grid, coverage index disabled" << std::endl ;
+        return ;
+    }
+
+    if ( dataset->GetGeoTransform(m_geoTransform) != CE_None || m_geoTransform[2] != 0 || m_geoTransform[4] != 0 ) {
+        std::cerr << "[WARNING] The input dataset is not north-up, coverage index disabled" << std::endl ;
+        return ;
+    }
+
+    const int width = dataset->GetRasterXSize() ;
+    const int height = dataset->GetRasterYSize() ;
+    m_cellSize = std::max( 1, ( std::max(width, height) + maxCellsPerSide - 1 ) / maxCellsPerSide ) ;
+    m_numCols = ( width + m_cellSize - 1 ) / m_cellSize ;
+    m_numRows = ( height + m_cellSize - 1 ) / m_cellSize ;
+
+    // Read the mask, a strip of cells at a time, and mark the cells with at least one valid pixel
+    GDALRasterBand* mask = band->GetMaskBand() ;
+    std::vector<GByte> strip( (std::size_t)width * m_cellSize ) ;
+    std::vector<unsigned char> validCells( (std::size_t)m_numCols * m_numRows, 0 ) ;
+    for ( int r = 0; r < m_numRows; r++ ) {
+        const int firstRow = r * m_cellSize ;
+        const int numStripRows = std::min( m_cellSize, height - firstRow ) ;
+        if ( mask->RasterIO( GF_Read, 0, firstRow, width, numStripRows,
+                             (void*) strip.data(), width, numStripRows,
+                             GDT_Byte, 0, 0 ) != CE_None ) {
+            std::cerr << "[WARNING] Could not read the mask of the input dataset, coverage index disabled" << std::endl ;
+            m_numCols = m_numRows = 0 ;
+            return ;
+        }
+        unsigned char* cellsRow = &validCells[(std::size_t)r * m_numCols] ;
+        for ( int j = 0; j < numStripRows; j++ ) {
+            const GByte* pixelsRow = &strip[(std::size_t)j * width] ;
+            for ( int i = 0; i < width; i++ ) {
+                if ( pixelsRow[i] != 0 )
+                    cellsRow[i / m_cellSize] = 1 ;
+            }
+        }
+    }
+
+    // Summed-area table
+    const int w = m_numCols+1 ;
+    m_summedArea.assign( (std::size_t)w * (m_numRows+1), 0 ) ;
+    for ( int r = 0; r < m_numRows; r++ ) {
+        unsigned int rowSum = 0 ;
+        for ( int c = 0; c < m_numCols; c++ ) {
+            rowSum += validCells[(std::size_t)r * m_numCols + c] ;
+            m_summedArea[(r+1)*w + c+1] = m_summedArea[r*w + c+1] + rowSum ;
+        }
+    }
+
+    m_enabled = true ;
+}
+
+
+
+bool DatasetCoverage::hasData(const ctb::CRSBounds& bounds) const
+{
+    if ( !m_enabled )
+        return true ;
+
+    // Bounds in pixel coordinates (the dataset is north-up, so the max Y is the first row)
+    const double px0 = ( bounds.getMinX() - m_geoTransform[0] ) / m_geoTransform[1] ;
+    const double px1 = ( bounds.getMaxX() - m_geoTransform[0] ) / m_geoTransform[1] ;
+    const double py0 = ( bounds.getMaxY() - m_geoTransform[3] ) / m_geoTransform[5] ;
+    const double py1 = ( bounds.getMinY() - m_geoTransform[3] ) / m_geoTransform[5] ;
+
+    // Range of cells, dilated by one cell and clamped to the grid (in double, to avoid overflows when casting)
+    const double c0 = std::max( std::floor( std::min(px0, px1) / m_cellSize ) - 1, 0.0 ) ;
+    const double c1 = std::min( std::floor( std::max(px0, px1) / m_cellSize ) + 1, (double)m_numCols-1 ) ;
+    const double r0 = std::max( std::floor( std::min(py0, py1) / m_cellSize ) - 1, 0.0 ) ;
+    const double r1 = std::min( std::floor( std::max(py0, py1) / m_cellSize ) + 1, (double)m_numRows-1 ) ;
+    if ( c0 > c1 || r0 > r1 )
+        return false ; // Out of the dataset
+
+    return numValidCells( (int)c0, (int)r0, (int)c1, (int)r1 ) > 0 ;
+}
+
+
+
+double DatasetCoverage::validRatio() const
+{
+    if ( !m_enabled || m_numCols == 0 || m_numRows == 0 )
+        return 1.0 ;
+    return (double)numValidCells( 0, 0, m_numCols-1, m_numRows-1 ) / ( (double)m_numCols * m_numRows ) ;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_DATASET_COVERAGE_H
+#define EMODNET_QMGC_DATASET_COVERAGE_H
+
+#include <vector>
+#include <gdal_priv.h>
+#include <ogr_spatialref.h>
+#include <ctb.hpp>
+
+/**
+ * @class DatasetCoverage
+ * @brief Low resolution index of the areas of a raster dataset containing valid (i.e., not no data) samples.
+ *
+ * The index is built once, with a single sequential pass over the mask of the first band of the dataset, where each
+ * cell of a coarse grid (at most \p maxCellsPerSide cells per dimension) records whether any of the pixels it covers is
+ * valid. A summed-area table over this grid allows checking in constant time if a region of the dataset may contain
+ * data.
+ *
+ * The check is conservative: the region is dilated by one cell, so that the samples interpolated by the warping/resampling
+ * at the borders of a valid area are also considered as data. When the index cannot be built (e.g., the dataset has no
+ * no data value, or it is not in the reference system of the tiling grid), it is disabled and all regions are considered
+ * to contain data.
+ */
+class DatasetCoverage
+{
+public:
+    /// Default constructor: disabled coverage (all the regions contain data)
+    DatasetCoverage() : m_enabled(false), m_numCols(0), m_numRows(0), m_cellSize(1) {}
+
+    /**
+     * @brief Build the coverage index of a dataset
+     * @param dataset The input dataset
+     * @param gridSRS Reference system of the tiling grid (the coverage is disabled if the dataset is not in this system)
+     * @param maxCellsPerSide Maximum number of cells of the coverage grid in each dimension
+     */
+    DatasetCoverage(GDALDataset* dataset, const OGRSpatialReference& gridSRS, const int& maxCellsPerSide = 2048) ;
+
+    /// Check whether the index is available
+    bool isEnabled() const { return m_enabled ; }
+
+    /**
+     * @brief Check if the region defined by some bounds may contain valid data
+     * @param bounds The region, in the coordinates of the reference system of the tiling grid
+     * @return False if the region is known to contain only no data values, true otherwise
+     */
+    bool hasData(const ctb::CRSBounds& bounds) const ;
+
+    /// Ratio of cells of the coverage grid containing valid data (1 if disabled)
+    double validRatio() const ;
+
+private:
+    // --- Attributes ---
+    bool m_enabled ;
+    int m_numCols, m_numRows ;              //!< Size of the coverage grid
+    int m_cellSize ;                        //!< Size of a coverage cell, in pixels of the dataset
+    double m_geoTransform[6] ;              //!< Geotransform of the dataset
+    std::vector<unsigned int> m_summedArea ; //!< (m_numCols+1) x (m_numRows+1) summed-area table of the valid cells
+
+    // --- Private Functions ---
+    /// Number of valid cells in the range of cells [c0..c1] x [r0..r1]
+    unsigned int numValidCells(const int& c0, const int& r0, const int& c1, const int& r1) const {
+        const int w = m_numCols+1 ;
+        return m_summedArea[(r1+1)*w + c1+1] - m_summedArea[r0*w + c1+1] - m_summedArea[(r1+1)*w + c0] + m_summedArea[r0*w + c0] ;
+    }
+};
+
+#endif //EMODNET_QMGC_DATASET_COVERAGE_H
@@ -0,0 +1,401 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "mosaic_dataset.h"
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <limits>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <gdal_vrt.h>
+#include <cpl_error.h>
+
+namespace fs = boost::filesystem ;
+
+
+
+MosaicIndex::MosaicIndex( const std::vector<std::string>& fileNames )
+    : m_minX( std::numeric_limits<double>::infinity() ), m_minY( std::numeric_limits<double>::infinity() )
+    , m_maxX( -std::numeric_limits<double>::infinity() ), m_maxY( -std::numeric_limits<double>::infinity() )
+    , m_pixelSize( std::numeric_limits<double>::infinity() )
+    , m_noDataValue( DefaultNoDataValue )
+{
+    OGRSpatialReference mosaicSRS ;
+    bool noDataSet = false ;
+    std::vector<BoxValue> boxes ;
+
+    for ( std::vector<std::string>::const_iterator it = fileNames.begin(); it != fileNames.end(); ++it ) {
+        CPLPushErrorHandler( CPLQuietErrorHandler ) ;
+        GDALDataset* dataset = (GDALDataset*) GDALOpen( it->c_str(), GA_ReadOnly ) ;
+        CPLPopErrorHandler() ;
+        if ( dataset == NULL ) {
+            std::cerr << "[WARNING] Could not open " << *it << " as a raster, skipped from the mosaic" << std::endl ;
+            continue ;
+        }
+
+        MosaicSource src ;
+        src.fileName = *it ;
+        src.width = dataset->GetRasterXSize() ;
+        src.height = dataset->GetRasterYSize() ;
+        bool valid = dataset->GetRasterCount() > 0 &&
+                     dataset->GetGeoTransform( src.geoTransform ) == CE_None &&
+                     src.geoTransform[2] == 0 && src.geoTransform[4] == 0 ;
+        if ( !valid ) {
+            std::cerr << "[WARNING] " << *it << " is not a georeferenced north-up raster, skipped from the mosaic" << std::endl ;
+            GDALClose( dataset ) ;
+            continue ;
+        }
+
+        // All the rasters must share the reference system of the first one
+        OGRSpatialReference srs( dataset->GetProjectionRef() ) ;
+        if ( m_sources.empty() ) {
+            m_projectionRef = dataset->GetProjectionRef() ;
+            mosaicSRS = srs ;
+        }
+        else if ( !srs.IsSame( &mosaicSRS ) ) {
+            std::cerr << "[WARNING] " << *it << " is not in the reference system of the mosaic, skipped" << std::endl ;
+            GDALClose( dataset ) ;
+            continue ;
+        }
+
+        int hasNoData = 0 ;
+        src.noDataValue = dataset->GetRasterBand(1)->GetNoDataValue( &hasNoData ) ;
+        src.hasNoData = hasNoData != 0 ;
+        if ( src.hasNoData && !noDataSet ) {
+            m_noDataValue = src.noDataValue ;
+            noDataSet = true ;
+        }
+        GDALClose( dataset ) ;
+
+        m_minX = std::min( m_minX, src.minX() ) ;
+        m_minY = std::min( m_minY, src.minY() ) ;
+        m_maxX = std::max( m_maxX, src.maxX() ) ;
+        m_maxY = std::max( m_maxY, src.maxY() ) ;
+        m_pixelSize = std::min( m_pixelSize, std::min( std::abs( src.geoTransform[1] ), std::abs( src.geoTransform[5] ) ) ) ;
+
+        boxes.push_back( std::make_pair( Box( BoxPoint( src.minX(), src.minY() ), BoxPoint( src.maxX(), src.maxY() ) ),
+                                         (int)m_sources.size() ) ) ;
+        m_sources.push_back( src ) ;
+    }
+
+    if ( m_sources.empty() )
+        throw ctb::CTBException( "None of the input files of the mosaic is a valid raster" ) ;
+
+    // Bulk loading of the R-tree
+    m_rtree = RTree( boxes.begin(), boxes.end() ) ;
+
+    std::cout << "Mosaic of " << m_sources.size() << " rasters, bounds = (" << m_minX << ", " << m_minY << ") --> ("
+              << m_maxX << ", " << m_maxY << "), pixel size = " << m_pixelSize << std::endl ;
+}
+
+
+
+std::vector<std::string> MosaicIndex::listDirectory( const std::string& dirName )
+{
+    // Sidecar files that GDAL may be able to open, but are not rasters of the mosaic by themselves
+    static const char* ignoredExtensions[] = { ".xml", ".ovr", ".msk", ".aux", ".prj", ".tfw", ".txt", ".md5" } ;
+
+    std::vector<std::string> fileNames ;
+    for ( fs::recursive_directory_iterator it( dirName ), end; it != end; ++it ) {
+        if ( !fs::is_regular_file( it->path() ) )
+            continue ;
+        std::string ext = boost::algorithm::to_lower_copy( it->path().extension().string() ) ;
+        if ( std::find_if( std::begin(ignoredExtensions), std::end(ignoredExtensions),
+                           [&ext]( const char* e ) { return ext == e ; } ) != std::end(ignoredExtensions) )
+            continue ;
+        fileNames.push_back( it->path().string() ) ;
+    }
+    std::sort( fileNames.begin(), fileNames.end() ) ;
+
+    return fileNames ;
+}
+
+
+
+std::vector<std::string> MosaicIndex::readFileList( const std::string& listFileName )
+{
+    std::vector<std::string> fileNames ;
+    std::ifstream ifs( listFileName ) ;
+    if ( !ifs.good() )
+        throw ctb::CTBException( "Could not open the list of input files" ) ;
+
+    fs::path listDir = fs::path( listFileName ).parent_path() ;
+    std::string line ;
+    while ( std::getline( ifs, line ) ) {
+        boost::algorithm::trim( line ) ;
+        if ( line.empty() || line[0] == '#' )
+            continue ;
+        fs::path p( line ) ;
+        fileNames.push_back( p.is_absolute() ? p.string() : ( listDir / p ).string() ) ;
+    }
+
+    return fileNames ;
+}
+
+
+
+std::vector<int> MosaicIndex::query( const double& minX, const double& minY, const double& maxX, const double& maxY ) const
+{
+    std::vector<BoxValue> found ;
+    m_rtree.query( boost::geometry::index::intersects( Box( BoxPoint( minX, minY ), BoxPoint( maxX, maxY ) ) ),
+                   std::back_inserter( found ) ) ;
+
+    std::vector<int> ids ;
+    ids.reserve( found.size() ) ;
+    for ( std::vector<BoxValue>::const_iterator it = found.begin(); it != found.end(); ++it )
+        ids.push_back( it->second ) ;
+    std::sort( ids.begin(), ids.end() ) ;
+
+    return ids ;
+}
+
+
+
+GDALDataset* MosaicIndex::createSummaryDataset() const
+{
+    const double width = std::ceil( ( m_maxX - m_minX ) / m_pixelSize ) ;
+    const double height = std::ceil( ( m_maxY - m_minY ) / m_pixelSize ) ;
+    if ( width > INT_MAX || height > INT_MAX )
+        throw ctb::CTBException( "The extents of the mosaic are too large for its resolution" ) ;
+
+    // A VRT without sources does not allocate any data
+    VRTDatasetH hVRT = VRTCreate( (int)width, (int)height ) ;
+    double geoTransform[6] = { m_minX, m_pixelSize, 0.0, m_maxY, 0.0, -m_pixelSize } ;
+    GDALSetGeoTransform( hVRT, geoTransform ) ;
+    GDALSetProjection( hVRT, m_projectionRef.c_str() ) ;
+    GDALAddBand( hVRT, GDT_Float32, NULL ) ;
+    if ( GDALSetRasterNoDataValue( GDALGetRasterBand( hVRT, 1 ), m_noDataValue ) != CE_None ) {
+        GDALClose( hVRT ) ;
+        throw ctb::CTBException( "Could not set the no data value of the mosaic" ) ;
+    }
+
+    return (GDALDataset*) hVRT ;
+}
+
+
+
+MosaicReader::MosaicReader( const std::shared_ptr<const MosaicIndex>& index,
+                            const OGRSpatialReference& gridSRS,
+                            const int& maxOpenFiles )
+    : m_index( index ), m_gridSRS( gridSRS ), m_gridToMosaic( NULL ), m_maxOpenFiles( std::max( maxOpenFiles, 1 ) )
+{
+    initTransformation() ;
+}
+
+
+
+MosaicReader::MosaicReader( const MosaicReader& reader )
+    : m_index( reader.m_index ), m_gridSRS( reader.m_gridSRS ), m_gridToMosaic( NULL ), m_maxOpenFiles( reader.m_maxOpenFiles )
+{
+    initTransformation() ;
+}
+
+
+
+MosaicReader::~MosaicReader()
+{
+    for ( std::list<std::pair<int, GDALDataset*>>::iterator it = m_openSources.begin(); it != m_openSources.end(); ++it )
+        GDALClose( it->second ) ;
+    if ( m_gridToMosaic != NULL )
+        OGRCoordinateTransformation::DestroyCT( m_gridToMosaic ) ;
+}
+
+
+
+void MosaicReader::initTransformation()
+{
+    OGRSpatialReference mosaicSRS( m_index->projectionRef().c_str() ) ;
+    if ( mosaicSRS.IsSame( &m_gridSRS ) )
+        return ;
+
+#if GDAL_VERSION_MAJOR >= 3
+    // Tile bounds are always expressed as x = longitude, y = latitude
+    m_gridSRS.SetAxisMappingStrategy( OAMS_TRADITIONAL_GIS_ORDER ) ;
+    mosaicSRS.SetAxisMappingStrategy( OAMS_TRADITIONAL_GIS_ORDER ) ;
+#endif
+    m_gridToMosaic = OGRCreateCoordinateTransformation( &m_gridSRS, &mosaicSRS ) ;
+    if ( m_gridToMosaic == NULL )
+        throw ctb::CTBException( "Could not create the transformation from the grid to the mosaic reference system" ) ;
+}
+
+
+
+GDALDataset* MosaicReader::openSource( const int& i )
+{
+    std::unordered_map<int, std::list<std::pair<int, GDALDataset*>>::iterator>::iterator itMap = m_openSourcesMap.find( i ) ;
+    if ( itMap != m_openSourcesMap.end() ) {
+        // Move to the front of the list (most recently used)
+        m_openSources.splice( m_openSources.begin(), m_openSources, itMap->second ) ;
+        return itMap->second->second ;
+    }
+
+    GDALDataset* dataset = (GDALDataset*) GDALOpen( m_index->source(i).fileName.c_str(), GA_ReadOnly ) ;
+    if ( dataset == NULL )
+        return NULL ;
+
+    // Close the least recently used raster, if required
+    if ( (int)m_openSources.size() >= m_maxOpenFiles ) {
+        GDALClose( m_openSources.back().second ) ;
+        m_openSourcesMap.erase( m_openSources.back().first ) ;
+        m_openSources.pop_back() ;
+    }
+
+    m_openSources.push_front( std::make_pair( i, dataset ) ) ;
+    m_openSourcesMap[i] = m_openSources.begin() ;
+
+    return dataset ;
+}
+
+
+
+GDALDataset* MosaicReader::createWindowDataset( const ctb::CRSBounds& tileBounds, const int& tileSize )
+{
+    // Bounds of the tile in the reference system of the mosaic (sampling the borders of the tile when reprojecting)
+    double minX = tileBounds.getMinX(), minY = tileBounds.getMinY() ;
+    double maxX = tileBounds.getMaxX(), maxY = tileBounds.getMaxY() ;
+    if ( m_gridToMosaic != NULL ) {
+        const int numSamplesPerSide = 9 ;
+        std::vector<double> xs, ys ;
+        for ( int k = 0; k < numSamplesPerSide; k++ ) {
+            double t = (double)k / ( numSamplesPerSide-1 ) ;
+            double x = tileBounds.getMinX() + t*( tileBounds.getMaxX() - tileBounds.getMinX() ) ;
+            double y = tileBounds.getMinY() + t*( tileBounds.getMaxY() - tileBounds.getMinY() ) ;
+            xs.push_back( x ) ; ys.push_back( tileBounds.getMinY() ) ;
+            xs.push_back( x ) ; ys.push_back( tileBounds.getMaxY() ) ;
+            xs.push_back( tileBounds.getMinX() ) ; ys.push_back( y ) ;
+            xs.push_back( tileBounds.getMaxX() ) ; ys.push_back( y ) ;
+        }
+        std::vector<int> success( xs.size(), FALSE ) ;
+        m_gridToMosaic->Transform( (int)xs.size(), xs.data(), ys.data(), NULL, success.data() ) ;
+        minX = minY = std::numeric_limits<double>::infinity() ;
+        maxX = maxY = -std::numeric_limits<double>::infinity() ;
+        for ( std::size_t k = 0; k < xs.size(); k++ ) {
+            if ( !success[k] )
+                continue ;
+            minX = std::min( minX, xs[k] ) ; maxX = std::max( maxX, xs[k] ) ;
+            minY = std::min( minY, ys[k] ) ; maxY = std::max( maxY, ys[k] ) ;
+        }
+        if ( minX > maxX || minY > maxY )
+            return NULL ; // The tile cannot be represented in the reference system of the mosaic
+    }
+
+    // Resolution of the window: the one of the mosaic, unless the tile is coarser (we read at twice the resolution of the
+    // tile at most, the warping of the tiler takes care of the rest)
+    const double pixelSize = std::max( m_index->pixelSize(), std::max( maxX - minX, maxY - minY ) / ( 2.0*tileSize ) ) ;
+
+    // Margin for the resampling kernels of the warping
+    minX -= 2*pixelSize ; minY -= 2*pixelSize ;
+    maxX += 2*pixelSize ; maxY += 2*pixelSize ;
+
+    std::vector<int> ids = m_index->query( minX, minY, maxX, maxY ) ;
+    if ( ids.empty() )
+        return NULL ;
+
+    const int cols = (int)std::ceil( ( maxX - minX ) / pixelSize ) ;
+    const int rows = (int)std::ceil( ( maxY - minY ) / pixelSize ) ;
+    const float noData = (float)m_index->noDataValue() ;
+    m_windowBuffer.assign( (std::size_t)cols * rows, noData ) ;
+
+    // Compose the window, one source at a time (the later ones in the mosaic have precedence)
+    for ( std::vector<int>::const_iterator it = ids.begin(); it != ids.end(); ++it ) {
+        const MosaicSource& src = m_index->source( *it ) ;
+
+        // Window pixels whose center falls within the source
+        const int dx0 = std::max( 0, (int)std::ceil( ( std::max( minX, src.minX() ) - minX ) / pixelSize - 0.5 ) ) ;
+        const int dx1 = std::min( cols, (int)std::floor( ( std::min( maxX, src.maxX() ) - minX ) / pixelSize - 0.5 ) + 1 ) ;
+        const int dy0 = std::max( 0, (int)std::ceil( ( maxY - std::min( maxY, src.maxY() ) ) / pixelSize - 0.5 ) ) ;
+        const int dy1 = std::min( rows, (int)std::floor( ( maxY - std::max( minY, src.minY() ) ) / pixelSize - 0.5 ) + 1 ) ;
+        if ( dx1 <= dx0 || dy1 <= dy0 )
+            continue ;
+
+        // Corresponding region in the source, in (floating point) source pixels, clamped to the raster
+        double sx0 = ( minX + dx0*pixelSize - src.geoTransform[0] ) / src.geoTransform[1] ;
+        double sx1 = ( minX + dx1*pixelSize - src.geoTransform[0] ) / src.geoTransform[1] ;
+        double sy0 = ( maxY - dy0*pixelSize - src.geoTransform[3] ) / src.geoTransform[5] ;
+        double sy1 = ( maxY - dy1*pixelSize - src.geoTransform[3] ) / src.geoTransform[5] ;
+        sx0 = std::max( 0.0, std::min( sx0, (double)src.width ) ) ;
+        sx1 = std::max( 0.0, std::min( sx1, (double)src.width ) ) ;
+        sy0 = std::max( 0.0, std::min( sy0, (double)src.height ) ) ;
+        sy1 = std::max( 0.0, std::min( sy1, (double)src.height ) ) ;
+        if ( sx1 <= sx0 || sy1 <= sy0 )
+            continue ;
+
+        GDALDataset* dataset = openSource( *it ) ;
+        if ( dataset == NULL ) {
+            std::cerr << "[WARNING] Could not open " << src.fileName << ", ignored" << std::endl ;
+            continue ;
+        }
+
+        const int dstW = dx1 - dx0, dstH = dy1 - dy0 ;
+        const int srcX = (int)std::floor( sx0 ), srcY = (int)std::floor( sy0 ) ;
+        const int srcW = std::min( (int)std::ceil( sx1 ), src.width ) - srcX ;
+        const int srcH = std::min( (int)std::ceil( sy1 ), src.height ) - srcY ;
+
+        GDALRasterIOExtraArg extraArg ;
+        INIT_RASTERIO_EXTRA_ARG( extraArg ) ;
+        extraArg.eResampleAlg = pixelSize > 1.01*std::abs( src.geoTransform[1] ) ? GRIORA_Average : GRIORA_NearestNeighbour ;
+        extraArg.bFloatingPointWindowValidity = TRUE ;
+        extraArg.dfXOff = sx0 ;
+        extraArg.dfYOff = sy0 ;
+        extraArg.dfXSize = sx1 - sx0 ;
+        extraArg.dfYSize = sy1 - sy0 ;
+
+        m_sourceBuffer.resize( (std::size_t)dstW * dstH ) ;
+        if ( dataset->GetRasterBand(1)->RasterIO( GF_Read, srcX, srcY, srcW, srcH,
+                                                  (void*) m_sourceBuffer.data(), dstW, dstH,
+                                                  GDT_Float32, 0, 0, &extraArg ) != CE_None ) {
+            std::cerr << "[WARNING] Could not read " << src.fileName << ", ignored" << std::endl ;
+            continue ;
+        }
+
+        // Copy the valid values
+        const float srcNoData = (float)src.noDataValue ;
+        for ( int j = 0; j < dstH; j++ ) {
+            const float* srcRow = &m_sourceBuffer[(std::size_t)j * dstW] ;
+            float* dstRow = &m_windowBuffer[(std::size_t)( dy0 + j ) * cols + dx0] ;
+            for ( int i = 0; i < dstW; i++ ) {
+                if ( std::isnan( srcRow[i] ) || ( src.hasNoData && srcRow[i] == srcNoData ) )
+                    continue ;
+                dstRow[i] = srcRow[i] ;
+            }
+        }
+    }
+
+    // In-memory dataset with the composed window
+    GDALDriver* memDriver = GetGDALDriverManager()->GetDriverByName( "MEM" ) ;
+    GDALDataset* window = memDriver->Create( "", cols, rows, 1, GDT_Float32, NULL ) ;
+    if ( window == NULL )
+        throw ctb::CTBException( "Could not create the in-memory dataset for the mosaic window" ) ;
+    double geoTransform[6] = { minX, pixelSize, 0.0, maxY, 0.0, -pixelSize } ;
+    window->SetGeoTransform( geoTransform ) ;
+    window->SetProjection( m_index->projectionRef().c_str() ) ;
+    GDALRasterBand* band = window->GetRasterBand(1) ;
+    band->SetNoDataValue( m_index->noDataValue() ) ;
+    if ( band->RasterIO( GF_Write, 0, 0, cols, rows, (void*) m_windowBuffer.data(), cols, rows, GDT_Float32, 0, 0 ) != CE_None ) {
+        GDALClose( window ) ;
+        throw ctb::CTBException( "Could not write the mosaic window" ) ;
+    }
+
+    return window ;
+}
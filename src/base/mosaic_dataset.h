@@ -0,0 +1,191 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_MOSAIC_DATASET_H
+#define EMODNET_QMGC_MOSAIC_DATASET_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <gdal_priv.h>
+#include <ogr_spatialref.h>
+#include <ctb.hpp>
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+/**
+ * @struct MosaicSource
+ * @brief Description of one of the rasters composing a mosaic
+ */
+struct MosaicSource
+{
+    std::string fileName ;      //!< Path of the raster file
+    double geoTransform[6] ;    //!< Geotransform of the raster (north-up)
+    int width, height ;         //!< Size of the raster, in pixels
+    bool hasNoData ;            //!< Flag indicating whether the first band of the raster has a no data value
+    double noDataValue ;        //!< No data value of the first band (if hasNoData)
+
+    double minX() const { return geoTransform[0] ; }
+    double maxX() const { return geoTransform[0] + width*geoTransform[1] ; }
+    double minY() const { return geoTransform[3] + height*geoTransform[5] ; }
+    double maxY() const { return geoTransform[3] ; }
+};
+
+
+
+/**
+ * @class MosaicIndex
+ * @brief Spatial index (R-tree) over the footprints of a set of rasters forming a mosaic.
+ *
+ * The index is built once, opening each raster only to read its metadata, and it can then be shared (read-only)
+ * between threads. All the rasters must be north-up and in the same reference system, and the first band of each of
+ * them is used. Where rasters overlap, the ones later in the list have precedence.
+ */
+class MosaicIndex
+{
+    // --- Private Typedefs ---
+    typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> BoxPoint ;
+    typedef boost::geometry::model::box<BoxPoint> Box ;
+    typedef std::pair<Box, int> BoxValue ;
+    typedef boost::geometry::index::rtree<BoxValue, boost::geometry::index::quadratic<16>> RTree ;
+
+public:
+    /**
+     * @brief Builds the index of a set of rasters. The files that cannot be opened, or that are not in the same
+     * reference system as the first one, are skipped with a warning.
+     * @param fileNames The rasters composing the mosaic
+     * @throws ctb::CTBException if none of the files is a valid raster
+     */
+    MosaicIndex( const std::vector<std::string>& fileNames ) ;
+
+    /// Lists the files in a directory (recursively), to be used as input of the mosaic
+    static std::vector<std::string> listDirectory( const std::string& dirName ) ;
+
+    /// Reads the list of files in a text file (one per line, relative paths are relative to the list file)
+    static std::vector<std::string> readFileList( const std::string& listFileName ) ;
+
+    /// Number of rasters in the mosaic
+    std::size_t numSources() const { return m_sources.size() ; }
+
+    /// Description of a raster in the mosaic
+    const MosaicSource& source( const int& i ) const { return m_sources[i] ; }
+
+    /// Indices of the rasters intersecting a region (in the reference system of the mosaic), sorted by precedence
+    std::vector<int> query( const double& minX, const double& minY, const double& maxX, const double& maxY ) const ;
+
+    /// Reference system of the mosaic (WKT)
+    const std::string& projectionRef() const { return m_projectionRef ; }
+
+    /// Pixel size of the mosaic (the finest of all the rasters)
+    double pixelSize() const { return m_pixelSize ; }
+
+    /// No data value of the mosaic, used to fill the gaps between rasters (the one of the first raster defining it, or DefaultNoDataValue if none does)
+    double noDataValue() const { return m_noDataValue ; }
+
+    /// No data value of the mosaic when none of its rasters defines one
+    static constexpr double DefaultNoDataValue = -32768.0 ;
+
+    /**
+     * @brief Creates a dataset with the extents, resolution and reference system of the whole mosaic, but without data.
+     *
+     * This dataset is the one to give to the tilers, so that they can compute the bounds and zoom levels of the
+     * pyramid, while the actual data is read from the sources by a MosaicReader. The caller owns the dataset.
+     */
+    GDALDataset* createSummaryDataset() const ;
+
+private:
+    std::vector<MosaicSource> m_sources ;
+    RTree m_rtree ;
+    std::string m_projectionRef ;
+    double m_minX, m_minY, m_maxX, m_maxY ;
+    double m_pixelSize ;
+    double m_noDataValue ;
+};
+
+
+
+/**
+ * @class MosaicReader
+ * @brief Reads the data of a mosaic covering a tile, accessing only the rasters intersecting it.
+ *
+ * For each tile, a small in-memory dataset covering the tile is composed by reading the intersecting rasters, one at a
+ * time, at a resolution close to the one of the tile (so that the coarser zooms do not read the full resolution data).
+ * The opened rasters are kept in a least recently used cache bounding the number of open files.
+ *
+ * A reader is not thread-safe, use one per thread (copying a reader creates a new one with the same configuration and
+ * an empty cache).
+ */
+class MosaicReader
+{
+public:
+    /**
+     * @brief Constructor
+     * @param index The index of the mosaic
+     * @param gridSRS Reference system of the tiling grid, where the tile bounds are expressed
+     * @param maxOpenFiles Maximum number of rasters kept open
+     */
+    MosaicReader( const std::shared_ptr<const MosaicIndex>& index,
+                  const OGRSpatialReference& gridSRS,
+                  const int& maxOpenFiles = 64 ) ;
+
+    /// Copy constructor: same index and configuration, but a new (empty) cache of open files
+    MosaicReader( const MosaicReader& reader ) ;
+
+    /// Destructor, closes the open rasters
+    ~MosaicReader() ;
+
+    /**
+     * @brief Creates an in-memory dataset with the data of the mosaic covering a tile
+     * @param tileBounds Bounds of the tile, in the reference system of the tiling grid
+     * @param tileSize Size of the tile, in pixels
+     * @return The dataset (owned by the caller), or NULL if no raster of the mosaic intersects the tile
+     */
+    GDALDataset* createWindowDataset( const ctb::CRSBounds& tileBounds, const int& tileSize ) ;
+
+    /// Number of rasters currently open
+    std::size_t numOpenFiles() const { return m_openSources.size() ; }
+
+    /// No data value of the mosaic (the one of the window datasets, and of the tiles not intersecting any raster)
+    double noDataValue() const { return m_index->noDataValue() ; }
+
+private:
+    // --- Attributes ---
+    std::shared_ptr<const MosaicIndex> m_index ;
+    OGRSpatialReference m_gridSRS ;
+    OGRCoordinateTransformation* m_gridToMosaic ; //!< NULL if the mosaic is in the reference system of the grid
+    int m_maxOpenFiles ;
+    std::list<std::pair<int, GDALDataset*>> m_openSources ; //!< Open rasters, the most recently used first
+    std::unordered_map<int, std::list<std::pair<int, GDALDataset*>>::iterator> m_openSourcesMap ;
+    std::vector<float> m_windowBuffer, m_sourceBuffer ;
+
+    // --- Private Functions ---
+    /// Initializes the transformation from the grid to the mosaic reference systems
+    void initTransformation() ;
+
+    /// Gets an open raster of the mosaic, opening it (and closing the least recently used one) if needed
+    GDALDataset* openSource( const int& i ) ;
+
+    /// Prevent assignment (the cache is not copied)
+    MosaicReader& operator=( const MosaicReader& ) ;
+};
+
+#endif //EMODNET_QMGC_MOSAIC_DATASET_H
@@ -0,0 +1,62 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_PARALLEL_FOR_H
+#define EMODNET_QMGC_PARALLEL_FOR_H
+
+#include <cstddef>
+#include <algorithm>
+#ifdef CGAL_LINKED_WITH_TBB
+#include <tbb/task_arena.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+/**
+ * @brief Run a function over the range [0..n) split in contiguous chunks processed by different threads.
+ *
+ * The chunks are run with tbb::parallel_for within an arena limited to \p numThreads, so that the threads are taken
+ * from the worker pool shared by the process instead of being created on each call (as in the rest of parallel
+ * algorithms, see ParallelismBudget). When a single thread is requested, the range is too small to be split, or TBB is
+ * not available, the function is called once over the whole range by the calling thread.
+ *
+ * @param n Size of the range
+ * @param numThreads Maximum number of threads to use (including the calling one)
+ * @param f Function to call as f(begin, end) for each chunk. Calls for different chunks run concurrently.
+ * @param minChunkSize Minimum number of elements per chunk
+ */
+template <class Function>
+void parallelFor(const std::size_t& n, const int& numThreads, const Function& f, const std::size_t& minChunkSize = 256)
+{
+    std::size_t numChunks = std::min<std::size_t>(std::max(numThreads, 1), (n + minChunkSize - 1)/minChunkSize);
+#ifdef CGAL_LINKED_WITH_TBB
+    if (numChunks > 1) {
+        tbb::task_arena arena((int)numChunks);
+        arena.execute([&]() {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n, std::max(minChunkSize, (std::size_t)1)),
+                              [&f](const tbb::blocked_range<std::size_t>& r) { f(r.begin(), r.end()); });
+        });
+        return;
+    }
+#endif
+    f((std::size_t)0, n);
+}
+
+#endif //EMODNET_QMGC_PARALLEL_FOR_H
@@ -0,0 +1,63 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "parallelism_budget.h"
+#include <thread>
+#include <algorithm>
+
+
+
+std::atomic<int> ParallelismBudget::s_numThreads( 0 ) ;
+std::atomic<int> ParallelismBudget::s_numTilesInFlight( 0 ) ;
+
+
+
+void ParallelismBudget::setNumThreads( const int& numThreads )
+{
+    s_numThreads = std::max( numThreads, 0 ) ;
+}
+
+
+
+int ParallelismBudget::numThreads()
+{
+    int numThreads = s_numThreads ;
+    if ( numThreads <= 0 )
+        numThreads = std::max( (int)std::thread::hardware_concurrency(), 1 ) ;
+    return numThreads ;
+}
+
+
+
+int ParallelismBudget::numTilesInFlight()
+{
+    return s_numTilesInFlight ;
+}
+
+
+
+int ParallelismBudget::threadsPerTile( const int& maxThreads )
+{
+    // The cores are shared evenly between the tiles in flight (the share of a tile includes the thread processing it)
+    int numThreads = std::max( ParallelismBudget::numThreads() / std::max( numTilesInFlight(), 1 ), 1 ) ;
+    if ( maxThreads > 0 )
+        numThreads = std::min( numThreads, maxThreads ) ;
+    return numThreads ;
+}
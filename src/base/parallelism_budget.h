@@ -0,0 +1,76 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_PARALLELISM_BUDGET_H
+#define EMODNET_QMGC_PARALLELISM_BUDGET_H
+
+#include <atomic>
+
+/**
+ * @class ParallelismBudget
+ * @brief Shares the cores of the machine between the tiles being processed concurrently and the parallel algorithms
+ * running within each of them.
+ *
+ * The tiles in flight are registered with TileScope objects. An algorithm that can run in parallel within a tile asks
+ * for threadsPerTile() right before starting, so that it uses the cores left idle by the tile-level threads (e.g., at
+ * coarse zooms, with just a few tiles, or at the tail of a batch), and runs sequentially when all the cores are busy
+ * processing other tiles.
+ */
+class ParallelismBudget
+{
+public:
+    /**
+     * @brief Set the total number of threads to share
+     * @param numThreads Number of threads (<= 0 means using the number of concurrent threads supported by the hardware)
+     */
+    static void setNumThreads(const int& numThreads);
+
+    /// Total number of threads to share
+    static int numThreads();
+
+    /// Number of tiles currently being processed
+    static int numTilesInFlight();
+
+    /**
+     * @brief Number of threads a parallel algorithm within a tile may use at this moment (always >= 1)
+     * @param maxThreads Maximum number of threads to return (<= 0 means no limit)
+     */
+    static int threadsPerTile(const int& maxThreads = 0);
+
+    /**
+     * @class TileScope
+     * @brief Registers a tile as being processed during the lifetime of the object
+     */
+    class TileScope
+    {
+    public:
+        TileScope() { ++s_numTilesInFlight; }
+        ~TileScope() { --s_numTilesInFlight; }
+    private:
+        TileScope(const TileScope&);
+        TileScope& operator=(const TileScope&);
+    };
+
+private:
+    static std::atomic<int> s_numThreads;
+    static std::atomic<int> s_numTilesInFlight;
+};
+
+#endif //EMODNET_QMGC_PARALLELISM_BUDGET_H
@@ -22,24 +22,29 @@
 #include <algorithm>
 #include "tin_creation/tin_creation_cgal_types.h"
 #include <CGAL/centroid.h>
-#include <CGAL/Polygon_mesh_processing/compute_normal.h>
 #include <cmath>
 #include "meshoptimizer/meshoptimizer.h"
 #include "crs_conversions.h"
 #include <sstream>
+#include <memory>
 #include <gdal.h>
 #include "misc_utils.h"
-#include <GeographicLib/Geocentric.hpp>
+#include "raster_heights_processing.h"
+#include "tin_creation/planar_tile.h"
 
 QuantizedMeshTile QuantizedMeshTiler::createTile( const ctb::TileCoordinate &coord, BordersData& bd)
 {
-    // Get a terrain tile represented by the tile coordinate
-    QuantizedMeshTile qmTile(coord, m_options.RefEllipsoid );
-
     float minHeight, maxHeight;
     ctb::CRSBounds tileBounds;
-    std::vector<Point_3 > uvhPts = getUVHPointsFromRaster(coord, bd,
-                                                          minHeight, maxHeight, tileBounds);
+    TinCreation::HeightGridBorders borders;
+    TinCreation::HeightGridView grid = getHeightGridFromRaster(coord, bd,
+                                                               minHeight, maxHeight, tileBounds, borders);
+
+    // Choose the TIN creation strategy depending on how rough the tile is, if required to
+    if ( m_tinCreator.isAdaptive() ) {
+        m_lastTileRoughness = TinCreation::computeHeightGridRoughness( grid ) ;
+        m_tinCreator.selectCreator( coord.zoom, m_lastTileRoughness.rmsDetail ) ;
+    }
 
     // Inform the TIN creator about the bounds of the tile
     m_tinCreator.setBounds(tileBounds.getMinX(), tileBounds.getMinY(), minHeight,
@@ -69,18 +74,99 @@ QuantizedMeshTile QuantizedMeshTiler::createTile( const ctb::TileCoordinate &coo
 //        bd.tileWestVertices.push_back(bd.northWestCorner);
 //    }
 
+    // Constant or planar tiles (within the tolerance of the TIN creation strategy) do not need to go through the TIN
+    // creation, we directly create the minimal mesh. Note that, in order for the error of the resulting mesh to be
+    // bounded by the tolerance, both the samples and the vertices of the mesh must be within half of it from the plane.
+    // Deviations below half of the quantization step of the heights are not noticeable in the final tile anyway
+    const double planarTol = m_tinCreator.getPlanarTileTolerance() ;
+    if ( planarTol >= 0 ) {
+        const double heightRange = maxHeight - minHeight ;
+        TinCreation::TilePlane plane ;
+        bool isPlanar = false ;
+        if ( heightRange <= 0.5*planarTol ) {
+            plane = TinCreation::TilePlane( heightRange > 0 ? 0.5 : 0.0, 0.0, 0.0 ) ;
+            isPlanar = true ;
+        }
+        else {
+            const double maxDeviation = std::max( 0.5*planarTol/heightRange, 0.5/QuantizedMesh::MAX_VERTEX_DATA ) ;
+            isPlanar = TinCreation::fitPlaneToHeightGrid( grid, borders, maxDeviation, plane ) ;
+        }
+
+        if ( isPlanar ) {
+            TinCreation::polyhedronToIndexedMesh( TinCreation::createPlanarTileMesh( grid, borders, plane ), m_mesh ) ;
+            TinCreation::computeBorderFlags( m_mesh ) ;
+            return encodeTile( coord, m_mesh, minHeight, maxHeight, tileBounds, bd ) ;
+        }
+    }
+
     // Simplify the surface
-    Polyhedron surface = m_tinCreator.create(uvhPts, bd.tileEastVertices.size() > 0, bd.tileWestVertices.size() > 0, bd.tileNorthVertices.size() > 0, bd.tileSouthVertices.size() > 0) ;
+    m_tinCreator.createIndexedMesh(grid, borders, m_mesh) ;
+    m_stopCriteriaCounts[m_tinCreator.getLastStopCriterion()]++ ;
+
+    return encodeTile( coord, m_mesh, minHeight, maxHeight, tileBounds, bd ) ;
+}
+
+
+
+QuantizedMeshTile QuantizedMeshTiler::createFlatTile( const ctb::TileCoordinate &coord, BordersData& bd)
+{
+    double resolution;
+    ctb::CRSBounds tileBounds = terrainTileBounds(coord, resolution);
+
+    // The height given to no data values by the processing in getHeightGridFromRaster (i.e., after clipping, scaling, etc.)
+    double noDataValue ;
+    if ( m_mosaicReader )
+        noDataValue = m_mosaicReader->noDataValue() ;
+    else {
+        std::lock_guard<std::mutex> lock(m_mutex) ;
+        noDataValue = poDataset->GetRasterBand(1)->GetNoDataValue();
+    }
+    RasterHeightsProcessingParams params = getRasterHeightsProcessingParams( noDataValue, false ) ;
+    float noDataHeight = (float)noDataValue ;
+    float minHeight =  std::numeric_limits<float>::infinity() ;
+    float maxHeight = -std::numeric_limits<float>::infinity() ;
+    processRasterHeightsScalar( &noDataHeight, &noDataHeight, 1, params, minHeight, maxHeight ) ;
+
+    // The vertices to preserve from neighboring tiles may have other heights
+    const std::vector<Point_3>* bdBorders[4] = { &bd.tileEastVertices, &bd.tileWestVertices, &bd.tileNorthVertices, &bd.tileSouthVertices } ;
+    const Point_3* bdCorners[4] = { &bd.southWestCorner, &bd.southEastCorner, &bd.northWestCorner, &bd.northEastCorner } ;
+    const bool useCorners[4] = { bd.useSouthWestCorner(), bd.useSouthEastCorner(), bd.useNorthWestCorner(), bd.useNorthEastCorner() } ;
+    for ( int b = 0; b < 4; b++ ) {
+        for ( std::vector<Point_3>::const_iterator it = bdBorders[b]->begin(); it != bdBorders[b]->end(); ++it ) {
+            minHeight = std::min( minHeight, (float)it->z() ) ;
+            maxHeight = std::max( maxHeight, (float)it->z() ) ;
+        }
+        if ( useCorners[b] ) {
+            minHeight = std::min( minHeight, (float)bdCorners[b]->z() ) ;
+            maxHeight = std::max( maxHeight, (float)bdCorners[b]->z() ) ;
+        }
+    }
+
+    // Minimal TIN: the corners (flat, unless constrained) and the vertices to preserve from the neighbors
+    TinCreation::HeightGridView grid( NULL, m_options.HeighMapSamplingSteps, m_options.HeighMapSamplingSteps, 0, minHeight, maxHeight ) ;
+    TinCreation::HeightGridBorders borders ;
+    getHeightGridBorders( bd, grid, borders ) ;
+    TinCreation::polyhedronToIndexedMesh( TinCreation::createPlanarTileMesh( grid, borders, TinCreation::TilePlane( grid.normalizeHeight( noDataHeight ), 0.0, 0.0 ) ), m_mesh ) ;
+    TinCreation::computeBorderFlags( m_mesh ) ;
+
+    return encodeTile( coord, m_mesh, minHeight, maxHeight, tileBounds, bd ) ;
+}
+
+
 
-    // Important call! Sorts halfedges such that the non-border edges precede the border edges
-    // Needed for the next steps to work properly
-    surface.normalize_border() ;
+QuantizedMeshTile QuantizedMeshTiler::encodeTile( const ctb::TileCoordinate &coord,
+                                                  const IndexedMesh& mesh,
+                                                  float& minHeight, float& maxHeight,
+                                                  const ctb::CRSBounds& tileBounds,
+                                                  BordersData& bd ) const
+{
+    QuantizedMeshTile qmTile(coord, m_options.RefEllipsoid );
 
     // Compute the QuantizedMesh header...
-    computeQuantizedMeshHeader( qmTile, surface, minHeight, maxHeight, tileBounds ) ;
+    computeQuantizedMeshHeader( qmTile, mesh, minHeight, maxHeight, tileBounds ) ;
 
     // ...and the QuantizedMesh geometry
-    computeQuantizedMeshGeometry( qmTile, surface, minHeight, maxHeight, bd.tileEastVertices, bd.tileWestVertices, bd.tileNorthVertices, bd.tileSouthVertices) ;
+    computeQuantizedMeshGeometry( qmTile, mesh, minHeight, maxHeight, bd.tileEastVertices, bd.tileWestVertices, bd.tileNorthVertices, bd.tileSouthVertices) ;
 
     return qmTile;
 }
@@ -93,34 +179,65 @@ std::vector<TinCreation::Point_3> QuantizedMeshTiler::getUVHPointsFromRaster(con
                                                                              ctb::CRSBounds& tileBounds,
                                                                              const bool& ignoreNoDataPoints) const
 {
-    m_mutex.lock() ;
-    ctb::GDALTile *rasterTile = createRasterTile(coord); // the raster associated with this tile coordinate
-    GDALRasterBand *heightsBand = rasterTile->dataset->GetRasterBand(1);
+    TinCreation::HeightGridBorders borders ;
+    TinCreation::HeightGridView grid = getHeightGridFromRaster(coord, bd, minHeight, maxHeight, tileBounds, borders, ignoreNoDataPoints) ;
+
+    return TinCreation::heightGridToPoints(grid, borders) ;
+}
+
 
-    // The commented snipplet below retrieves the pixel size of this tile
-//    double adfGeoTransform[6];
-//    rasterTile->dataset->GetGeoTransform(adfGeoTransform);
-//    std::cout << "Pixel size = " << adfGeoTransform[1] << ", " << adfGeoTransform[5] << std::endl;
 
-    double noDataValue = heightsBand->GetNoDataValue();
+TinCreation::HeightGridView QuantizedMeshTiler::getHeightGridFromRaster(const ctb::TileCoordinate &coord,
+                                                                        BordersData& bd,
+                                                                        float& minHeight, float& maxHeight,
+                                                                        ctb::CRSBounds& tileBounds,
+                                                                        TinCreation::HeightGridBorders& borders,
+                                                                        const bool& ignoreNoDataPoints) const
+{
     double resolution;
     tileBounds = terrainTileBounds(coord, resolution);
+    const int numSteps = m_options.HeighMapSamplingSteps ;
 
-    // Copy the raster data into an array
-    float rasterHeights[m_options.HeighMapSamplingSteps * m_options.HeighMapSamplingSteps];
-    if (heightsBand->RasterIO(GF_Read, 0, 0, 256, 256,
-                              (void *) rasterHeights,
-                              m_options.HeighMapSamplingSteps, m_options.HeighMapSamplingSteps,
-                              GDT_Float32, 0, 0) != CE_None) {
-        throw ctb::CTBException("Could not read heights from raster");
+    double noDataValue ;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex) ;
+        m_heightsBuffer.resize(numSteps * numSteps);
+
+        // When reading from a mosaic, compose the data covering the tile and warp it instead of the (empty) dataset of the tiler.
+        // Declared before the raster tile, which references it, so that it is closed after the tile
+        std::unique_ptr<GDALDataset, void (*)(GDALDatasetH)> window(NULL, GDALClose) ;
+        std::unique_ptr<ctb::GDALTile> rasterTile ; // the raster associated with this tile coordinate
+        if ( m_mosaicReader ) {
+            window.reset( m_mosaicReader->createWindowDataset(mGrid.tileBounds(coord), mGrid.tileSize()) ) ;
+            if ( window )
+                rasterTile.reset( createWindowRasterTile(window.get(), coord) ) ;
+        }
+        else
+            rasterTile.reset( createRasterTile(coord) ) ;
 
-        for (int a = 0; a < m_options.HeighMapSamplingSteps*m_options.HeighMapSamplingSteps; a++)
-                rasterHeights[a] = 0.0;
-    }
-    m_mutex.unlock() ;
+        if ( !rasterTile ) {
+            // No raster of the mosaic covers this tile
+            noDataValue = m_mosaicReader->noDataValue() ;
+            std::fill(m_heightsBuffer.begin(), m_heightsBuffer.end(), (float)noDataValue) ;
+        }
+        else {
+            GDALRasterBand *heightsBand = rasterTile->dataset->GetRasterBand(1);
+
+            // The commented snipplet below retrieves the pixel size of this tile
+//            double adfGeoTransform[6];
+//            rasterTile->dataset->GetGeoTransform(adfGeoTransform);
+//            std::cout << "Pixel size = " << adfGeoTransform[1] << ", " << adfGeoTransform[5] << std::endl;
 
-    // Create a base triangulation (using Delaunay) with all the raster info available
-    std::vector< Point_3 > heightMapPoints ;
+            noDataValue = heightsBand->GetNoDataValue();
+
+            // Copy the raster data into the heights buffer (reused between tiles, the tiler is not shared between threads)
+            if (heightsBand->RasterIO(GF_Read, 0, 0, 256, 256,
+                                      (void *) m_heightsBuffer.data(),
+                                      numSteps, numSteps,
+                                      GDT_Float32, 0, 0) != CE_None)
+                throw ctb::CTBException("Could not read heights from raster");
+        }
+    }
 
     // Check the start of the rasters: if there are constrained vertices from neighboring tiles to maintain,
     // the western and/or the southern vertices are not touched, and thus we should parse the raster starting from index 1
@@ -128,161 +245,157 @@ std::vector<TinCreation::Point_3> QuantizedMeshTiler::getUVHPointsFromRaster(con
     bool constrainWestVertices = bd.tileWestVertices.size() > 0 ;
     bool constrainNorthVertices = bd.tileNorthVertices.size() > 0 ;
     bool constrainSouthVertices = bd.tileSouthVertices.size() > 0 ;
-//    bool constrainEastVertices = false, constrainWestVertices = false, constrainNorthVertices = false, constrainSouthVertices = false;
-//    getConstraintsAtBorders(bd, constrainEastVertices, constrainWestVertices, constrainNorthVertices, constrainSouthVertices);
 
     int startX = constrainWestVertices? 1: 0 ;
-    int endX = constrainEastVertices? m_options.HeighMapSamplingSteps-1: m_options.HeighMapSamplingSteps ;
+    int endX = constrainEastVertices? numSteps-1: numSteps ;
     int startY = constrainNorthVertices? 1: 0 ;
-    int endY = constrainSouthVertices? m_options.HeighMapSamplingSteps-1: m_options.HeighMapSamplingSteps ;
-
-    // Add the vertices from the raster
-    for ( int i = startX; i < endX; i++ ) {
-        for (int j = startY; j < endY; j++) {
-            // y coordinate within the tile
-            int y = m_options.HeighMapSamplingSteps - 1 - j;
-
-            // Skip special cases where we are at the corners, and the height was already computed
-            if (i == 0 && y == 0 && bd.useSouthWestCorner() ||
-                i == 0 && y == m_options.HeighMapSamplingSteps-1 && bd.useNorthWestCorner() ||
-                i == m_options.HeighMapSamplingSteps-1 && y == m_options.HeighMapSamplingSteps-1 && bd.useNorthEastCorner() ||
-                i == m_options.HeighMapSamplingSteps-1 && y == 0 && bd.useSouthEastCorner())
-                continue;
-
-//            // Check the latitude value: do not include measures over 90 deg
-//            float lat = tileBounds.getMinY() + ((tileBounds.getMaxY() - tileBounds.getMinY()) * ((float)y/(m_options.HeighMapSamplingSteps-1)));
-////            std::cout << "lat = " << lat << std::endl;
-//            if (lat >= 90 || lat <=-90)
-//                continue;
-
-            // Note that the heights in RasterIO have the origin in the upper-left corner,
-            // while the tile has it in the lower-left. Obviously, x = i
-
-            // Compute the height value
-            float height = rasterHeights[j * m_options.HeighMapSamplingSteps + i];
-
-            // Skip no data values, if required to
-            if (ignoreNoDataPoints && height == noDataValue)
-                continue;
-
-            // Clipping
-            height = clip( height, m_options.ClippingLowValue, m_options.ClippingHighValue ) ;
-
-            // When no data is available, and no skipping is required, we assume ground data
-            if ( height == noDataValue )
-                height = 0 ;
-
-            // If the input DEM contains bathymetry, consider the data as depth instead of altitude (negative value!)
-            if ( m_options.IsBathymetry )
-                height = -height ;
-
-            // Apply scales
-            if (height < 0 && m_options.BelowSeaLevelScaleFactor > 0) {
-                height *= m_options.BelowSeaLevelScaleFactor;
-            }
-            else if (height > 0 && m_options.AboveSeaLevelScaleFactor > 0) {
-                height *= m_options.AboveSeaLevelScaleFactor;
-            }
-
-            // In heightmap format
-            heightMapPoints.push_back(Point_3(i, y, height));
-        }
-    }
-    // Also, add the vertices to preserve from neighboring tiles (in heightmap format)...
-    if ( constrainEastVertices ) {
-        for ( std::vector<Point_3>::const_iterator it = bd.tileEastVertices.begin(); it != bd.tileEastVertices.end(); ++it ) {
-            heightMapPoints.push_back(*it);
-        }
-    }
-    if ( constrainWestVertices ) {
-        for ( std::vector<Point_3>::const_iterator it = bd.tileWestVertices.begin(); it != bd.tileWestVertices.end(); ++it ) {
-            heightMapPoints.push_back(*it);
+    int endY = constrainSouthVertices? numSteps-1: numSteps ;
+
+    // Transform the heights in place, row by row, computing the min/max height in the same pass.
+    // Note that the heights in RasterIO have the origin in the upper-left corner, while the tile has it in the lower-left
+    RasterHeightsProcessingParams params = getRasterHeightsProcessingParams( noDataValue, ignoreNoDataPoints ) ;
+
+    minHeight =  std::numeric_limits<float>::infinity() ;
+    maxHeight = -std::numeric_limits<float>::infinity() ;
+    for (int j = startY; j < endY; j++) {
+        // y coordinate within the tile
+        int y = numSteps - 1 - j;
+
+        // Skip special cases where we are at the corners, and the height will be taken from the corners to preserve
+        int rowStartX = startX, rowEndX = endX ;
+        if ( rowStartX == 0 && ( ( y == 0 && bd.useSouthWestCorner() ) || ( y == numSteps-1 && bd.useNorthWestCorner() ) ) )
+            rowStartX = 1 ;
+        if ( rowEndX == numSteps && ( ( y == 0 && bd.useSouthEastCorner() ) || ( y == numSteps-1 && bd.useNorthEastCorner() ) ) )
+            rowEndX = numSteps-1 ;
+
+        if ( rowEndX > rowStartX ) {
+            float* row = &m_heightsBuffer[j * numSteps] ;
+            processRasterHeights( row + rowStartX, row + rowStartX, rowEndX - rowStartX, params, minHeight, maxHeight ) ;
         }
     }
-    if ( constrainNorthVertices ) {
-        for ( std::vector<Point_3>::const_iterator it = bd.tileNorthVertices.begin(); it != bd.tileNorthVertices.end(); ++it ) {
-            heightMapPoints.push_back(*it);
+
+    // Also, the vertices to preserve from neighboring tiles (in heightmap format) and the corners are part of the tile
+    const std::vector<Point_3>* bdBorders[4] = { &bd.tileEastVertices, &bd.tileWestVertices, &bd.tileNorthVertices, &bd.tileSouthVertices } ;
+    const Point_3* bdCorners[4] = { &bd.southWestCorner, &bd.southEastCorner, &bd.northWestCorner, &bd.northEastCorner } ;
+    const bool useCorners[4] = { bd.useSouthWestCorner(), bd.useSouthEastCorner(), bd.useNorthWestCorner(), bd.useNorthEastCorner() } ;
+    for ( int b = 0; b < 4; b++ ) {
+        for ( std::vector<Point_3>::const_iterator it = bdBorders[b]->begin(); it != bdBorders[b]->end(); ++it ) {
+            minHeight = std::min( minHeight, (float)it->z() ) ;
+            maxHeight = std::max( maxHeight, (float)it->z() ) ;
         }
-    }
-    if ( constrainSouthVertices ) {
-        for ( std::vector<Point_3>::const_iterator it = bd.tileSouthVertices.begin(); it != bd.tileSouthVertices.end(); ++it ) {
-            heightMapPoints.push_back(*it);
+        if ( useCorners[b] ) {
+            minHeight = std::min( minHeight, (float)bdCorners[b]->z() ) ;
+            maxHeight = std::max( maxHeight, (float)bdCorners[b]->z() ) ;
         }
     }
-    // .. and the corners, if not already added above
-    if (bd.useSouthWestCorner()) {
-        heightMapPoints.push_back(bd.southWestCorner);
-    }
-    if (bd.useSouthEastCorner()) {
-        heightMapPoints.push_back(bd.southEastCorner);
-    }
-    if (bd.useNorthWestCorner()) {
-        heightMapPoints.push_back(bd.northWestCorner);
-    }
-    if (bd.useNorthEastCorner()) {
-        heightMapPoints.push_back(bd.northEastCorner);
-    }
 
-    // Compute min/max height
-    minHeight =  std::numeric_limits<float>::infinity() ;
-    maxHeight = -std::numeric_limits<float>::infinity() ;
-    for ( std::vector<Point_3>::iterator it = heightMapPoints.begin(); it != heightMapPoints.end(); ++it ) {
-        // Update max/min height
-        if (it->z() < minHeight)
-            minHeight = it->z();
-        if (it->z() > maxHeight)
-            maxHeight = it->z();
-    }
-
-    // Encode the points extracted from the raster in u/v/height values in the range [0..1]
-    // We simplify the mesh in u/v/h format because they are normalized values and the surface will be better
+    // View of the grid, from south to north, normalizing the heights to the min/max of the tile.
+    // We simplify the mesh in u/v/height format because they are normalized values and the surface will be better
     // conditioned for simplification
-    std::vector< Point_3 > uvhPts ;
-    for ( std::vector<Point_3>::iterator it = heightMapPoints.begin(); it != heightMapPoints.end(); ++it ) {
-        double u = remap( it->x(), 0.0, m_options.HeighMapSamplingSteps-1, 0.0, 1.0 ) ;
-        double v = remap( it->y(), 0.0, m_options.HeighMapSamplingSteps-1, 0.0, 1.0 ) ;
-        double h = remap( it->z(), minHeight, maxHeight, 0.0, 1.0 ) ;
+    TinCreation::HeightGridView grid( &m_heightsBuffer[(numSteps-1) * numSteps], numSteps, numSteps, -numSteps,
+                                      minHeight, maxHeight ) ;
+
+    // Encode the border vertices and corners in u/v/height values in the range [0..1]
+    getHeightGridBorders( bd, grid, borders ) ;
+
+    return grid ;
+}
+
+
 
-        uvhPts.push_back( Point_3( u, v, h ) ) ;
+void QuantizedMeshTiler::getHeightGridBorders(BordersData& bd,
+                                              const TinCreation::HeightGridView& grid,
+                                              TinCreation::HeightGridBorders& borders) const
+{
+    const std::vector<Point_3>* bdBorders[4] = { &bd.tileEastVertices, &bd.tileWestVertices, &bd.tileNorthVertices, &bd.tileSouthVertices } ;
+    const Point_3* bdCorners[4] = { &bd.southWestCorner, &bd.southEastCorner, &bd.northWestCorner, &bd.northEastCorner } ;
+    const bool useCorners[4] = { bd.useSouthWestCorner(), bd.useSouthEastCorner(), bd.useNorthWestCorner(), bd.useNorthEastCorner() } ;
+    Polyline* gridBorders[4] = { &borders.eastern, &borders.western, &borders.northern, &borders.southern } ;
+    Point_3* gridCorners[4] = { &borders.southWestCorner, &borders.southEastCorner, &borders.northWestCorner, &borders.northEastCorner } ;
+    for ( int b = 0; b < 4; b++ ) {
+        gridBorders[b]->clear() ;
+        gridBorders[b]->reserve( bdBorders[b]->size() ) ;
+        for ( std::vector<Point_3>::const_iterator it = bdBorders[b]->begin(); it != bdBorders[b]->end(); ++it )
+            gridBorders[b]->push_back( heightMapToUVH( *it, grid ) ) ;
+        if ( useCorners[b] )
+            *gridCorners[b] = heightMapToUVH( *bdCorners[b], grid ) ;
     }
+    borders.constrainSouthWestCorner = useCorners[0] ;
+    borders.constrainSouthEastCorner = useCorners[1] ;
+    borders.constrainNorthWestCorner = useCorners[2] ;
+    borders.constrainNorthEastCorner = useCorners[3] ;
+}
+
+
+
+ctb::GDALTile* QuantizedMeshTiler::createWindowRasterTile(GDALDataset *dataset, const ctb::TileCoordinate &coord) const
+{
+    // A tiler on the dataset, sharing the grid and options of this one, warps it exactly as this tiler does with its own dataset
+    ctb::TerrainTiler datasetTiler(dataset, mGrid, options) ;
+
+    return datasetTiler.createRasterTile(coord) ;
+}
 
-    delete rasterTile;
 
-    return uvhPts ;
+
+RasterHeightsProcessingParams QuantizedMeshTiler::getRasterHeightsProcessingParams(const double& noDataValue,
+                                                                                   const bool& ignoreNoDataPoints) const
+{
+    RasterHeightsProcessingParams params ;
+    params.noDataValue = noDataValue ;
+    params.ignoreNoData = ignoreNoDataPoints ;
+    params.clippingLowValue = m_options.ClippingLowValue ;
+    params.clippingHighValue = m_options.ClippingHighValue ;
+    params.isBathymetry = m_options.IsBathymetry ;
+    params.aboveSeaLevelScaleFactor = m_options.AboveSeaLevelScaleFactor ;
+    params.belowSeaLevelScaleFactor = m_options.BelowSeaLevelScaleFactor ;
+    return params ;
 }
 
 
 
 void QuantizedMeshTiler::computeQuantizedMeshHeader( QuantizedMeshTile& qmTile,
-                                                     const Polyhedron& surface,
+                                                     const IndexedMesh& mesh,
                                                      const float& minHeight, float& maxHeight,
                                                      const ctb::CRSBounds& tileBounds ) const
 {
     // Convert to lat/lon format
-    std::vector<Point_3> latLonPoints;
-    for ( Polyhedron::Point_const_iterator it = surface.points_begin(); it != surface.points_end(); ++it ) {
+    std::size_t numPoints = mesh.numVertices();
+    std::vector<double>& lons = m_encodingBuffers.lons;
+    std::vector<double>& lats = m_encodingBuffers.lats;
+    std::vector<double>& heights = m_encodingBuffers.heights;
+    lons.clear();
+    lats.clear();
+    heights.clear();
+    for ( std::vector<Point_3>::const_iterator it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it ) {
         // In Latitude, Longitude, Height format
         float lat = tileBounds.getMinY() + ((tileBounds.getMaxY() - tileBounds.getMinY()) * it->y());
         float lon = tileBounds.getMinX() + ((tileBounds.getMaxX() - tileBounds.getMinX()) * it->x());
         float height = minHeight + ((maxHeight - minHeight) * it->z());
-        latLonPoints.push_back(Point_3(lat, lon, height));
+        lats.push_back(lat);
+        lons.push_back(lon);
+        heights.push_back(height);
     }
 
-    // Points in ECEF coordinates
-    std::vector<Point_3> ecefPoints;
-    ecefPoints.reserve(latLonPoints.size());
+    // Points in ECEF coordinates, converted all at once
+    std::vector<double>& xs = m_encodingBuffers.xs;
+    std::vector<double>& ys = m_encodingBuffers.ys;
+    std::vector<double>& zs = m_encodingBuffers.zs;
+    xs.resize(numPoints);
+    ys.resize(numPoints);
+    zs.resize(numPoints);
+    m_ecefConverter.geodeticToECEF(lons.data(), lats.data(), heights.data(), numPoints, xs.data(), ys.data(), zs.data());
+
+    std::vector<Point_3>& ecefPoints = m_encodingBuffers.ecefPoints;
+    ecefPoints.clear();
     double minEcefX = std::numeric_limits<double>::infinity();
     double maxEcefX = -std::numeric_limits<double>::infinity();
     double minEcefY = std::numeric_limits<double>::infinity();
     double maxEcefY = -std::numeric_limits<double>::infinity();
     double minEcefZ = std::numeric_limits<double>::infinity();
     double maxEcefZ = -std::numeric_limits<double>::infinity();
-    GeographicLib::Geocentric earth(GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f());
-    for (int i = 0; i < latLonPoints.size(); i++) {
-        double tmpx, tmpy, tmpz;
-//        crs_conversions::llh2ecef(latLonPoints[i].x(), latLonPoints[i].y(), latLonPoints[i].z(),
-//                                  tmpx, tmpy, tmpz);
-        earth.Forward(latLonPoints[i].x(), latLonPoints[i].y(), latLonPoints[i].z(), tmpx, tmpy, tmpz);
+    for (std::size_t i = 0; i < numPoints; i++) {
+        double tmpx = xs[i], tmpy = ys[i], tmpz = zs[i];
         ecefPoints.push_back(Point_3(tmpx, tmpy, tmpz));
 
         if (tmpx < minEcefX)
@@ -339,7 +452,7 @@ void QuantizedMeshTiler::computeQuantizedMeshHeader( QuantizedMeshTile& qmTile,
 
 
 void QuantizedMeshTiler::computeQuantizedMeshGeometry(QuantizedMeshTile& qmTile,
-                                                      Polyhedron& surface,
+                                                      const IndexedMesh& mesh,
                                                       const float& minHeight, const float& maxHeight,
                                                       std::vector<Point_3> &tileEastVertices,
                                                       std::vector<Point_3> &tileWestVertices,
@@ -352,10 +465,10 @@ void QuantizedMeshTiler::computeQuantizedMeshGeometry(QuantizedMeshTile& qmTile,
     tileSouthVertices.clear();
 
     // --> VertexData part
-    std::vector<unsigned short> vertices ;
-    int numVertices = surface.size_of_vertices() ;
-    vertices.reserve(numVertices*3) ;
-    for ( Polyhedron::Point_const_iterator it = surface.points_begin(); it != surface.points_end(); ++it ) {
+    std::vector<unsigned short>& vertices = m_encodingBuffers.vertices ;
+    int numVertices = mesh.numVertices() ;
+    vertices.clear() ;
+    for ( std::vector<Point_3>::const_iterator it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it ) {
         double x = it->x() ;
         double y = it->y() ;
         double z = it->z() ;
@@ -389,31 +502,24 @@ void QuantizedMeshTiler::computeQuantizedMeshGeometry(QuantizedMeshTile& qmTile,
     // --> IndexData part
     QuantizedMesh::IndexData indexData ;
 
-    indexData.triangleCount = surface.size_of_facets() ;
-    indexData.indices.reserve(indexData.triangleCount*3) ;
-    for ( Polyhedron::Facet_iterator it = surface.facets_begin(); it != surface.facets_end(); ++it) {
-        Polyhedron::Halfedge_around_facet_circulator j = it->facet_begin();
-        // Facets in our polyhedral surface should be triangles
-        CGAL_assertion( CGAL::circulator_size(j) == 3);
-        // Extract integer indices
-        do {
-            indexData.indices.push_back( static_cast<unsigned int>( std::distance(surface.vertices_begin(), j->vertex()) ) );
-        } while ( ++j != it->facet_begin() );
-    }
+    indexData.triangleCount = mesh.numTriangles() ;
+    indexData.indices.assign( mesh.triangles.begin(), mesh.triangles.end() ) ;
 
     // Optimize the resulting mesh (in order to be able to codify the indices using the "high watermark" method required
     // by the quantized-mesh format, we need to optimize the vertex indices for the cache and fetch
     meshopt_optimizeVertexCache(&indexData.indices[0], &indexData.indices[0], indexData.indices.size(), numVertices, 32 ) ; // Last number is the virtual cache size
-    std::vector<unsigned int> vertexRemap(numVertices, ~0u);
-    meshopt_optimizeVertexFetch(&vertices[0], &indexData.indices[0], indexData.indices.size(), &vertices[0], numVertices, sizeof(unsigned short)*3, &vertexRemap[0] );
+    std::vector<unsigned int>& vertexRemap = m_encodingBuffers.vertexRemap;
+    vertexRemap.assign(numVertices, ~0u);
+    // The vertices not used by any triangle are dropped (their remapped index is ~0u)
+    const std::size_t numUsedVertices = meshopt_optimizeVertexFetch(&vertices[0], &indexData.indices[0], indexData.indices.size(), &vertices[0], numVertices, sizeof(unsigned short)*3, &vertexRemap[0] );
 
     // Store optimized vertices and indices
     QuantizedMesh::VertexData vertexData ;
-    vertexData.vertexCount = surface.size_of_vertices() ;
+    vertexData.vertexCount = numUsedVertices ;
     vertexData.u.reserve(vertexData.vertexCount) ;
     vertexData.v.reserve(vertexData.vertexCount) ;
     vertexData.height.reserve(vertexData.vertexCount) ;
-    for ( int i = 0; i < vertices.size(); i=i+3 ) {
+    for ( std::size_t i = 0; i < 3*numUsedVertices; i=i+3 ) {
         vertexData.u.push_back(vertices[i]) ;
         vertexData.v.push_back(vertices[i+1]) ;
         vertexData.height.push_back(vertices[i+2]) ;
@@ -422,120 +528,54 @@ void QuantizedMeshTiler::computeQuantizedMeshGeometry(QuantizedMeshTile& qmTile,
     qmTile.setIndexData(indexData) ;
 
     // --> EdgeIndices part (also collect the vertices to maintain for this tile)
+    // The vertices in the borders are the ones flagged in the mesh, those in the corners belong to two borders
     QuantizedMesh::EdgeIndices edgeIndices ;
-    edgeIndices.westIndices = std::vector<unsigned int>() ;
-    edgeIndices.southIndices = std::vector<unsigned int>() ;
-    edgeIndices.eastIndices = std::vector<unsigned int>() ;
-    edgeIndices.northIndices = std::vector<unsigned int>() ;
-    tileWestVertices.clear() ;
-    tileSouthVertices.clear() ;
-    Point_2 tileCenter( 0.5, 0.5 ) ;
-    Point_2 tileLowerLeftCorner( 0.0, 0.0 ) ;
-    Point_2 tileUpperLeftCorner( 0.0, 1.0 ) ;
-    Point_2 tileLowerRightCorner( 1.0, 0.0 ) ;
-    Point_2 tileUpperRightCorner( 1.0, 1.0 ) ;
-
-    // According to the CGAL documentation, normalization: "reorganizes the sequential storage of the edges such that the
-    // non-border edges precede the border edges, and that for each border edge the latter one of the two halfedges is a
-    // border halfedge (the first one is a non-border halfedge in conformance with the polyhedral surface definition)"
-    // Thus, we move along halfedges with an increment of 2
     int numCorners = 0 ; // Just to check correctness
-
-    Polyhedron::Halfedge_iterator e = surface.border_halfedges_begin() ;
-    ++e ; // We start at the second halfedge!
-    while( e->is_border() )
-    {
-        // Get the vertex index in the surface structure
-        unsigned int vertInd = static_cast<unsigned int>( std::distance(surface.vertices_begin(), e->vertex() ) ) ;
-        // Re-map the vertex index to the new index after optimizing for vertex fetching
-        vertInd = vertexRemap[vertInd] ;
-
-        // Relevant geometric info of the current edge
-        Point_3 p0 = e->vertex()->point() ; // This is the point we will take care of now
-        Point_3 p1 = e->prev()->vertex()->point() ; // This is the previous vertex, with which p0 forms an edge
-
-        // Differences between the points in the edge
-        double diffX = fabs( p1.x() - p0.x() ) ;
-        double diffY = fabs( p1.y() - p0.y() ) ;
-
-        // Check if it is a corner point: the next vertex changes from vertical to horizontal or viceversa
-        // If it is a corner point, we should add it twice to the corresponding border
-
-        // Next edge on the border (since we are in a border halfedge, the next operator points to the next halfedge around the "hole"
-        Point_3 p2 = e->next()->vertex()->point() ;
-
-        double diffXNext = fabs( p2.x() - p0.x() ) ;
-        double diffYNext = fabs( p2.y() - p0.y() ) ;
-        bool isCorner = ( ( diffX < diffY ) && ( diffXNext > diffYNext ) ) ||
-                        ( ( diffX > diffY ) && ( diffXNext < diffYNext ) ) ;
+    for ( int i = 0; i < numVertices; i++ ) {
+        const unsigned char flags = mesh.borderFlags[i] ;
+        const unsigned int vertInd = vertexRemap[i] ; // Index after optimizing for vertex fetching
+        if ( flags == 0 || vertInd == ~0u )
+            continue ;
 
         // The data must be converted back to double before returning it to update the cache
         // This is because the ranges for height depend on min/max height for each tile and we need to add this vertices as part of the vertices of the new tile, in other bounds
+        const Point_3& p0 = mesh.vertices[i] ;
         double x = remap( p0.x(), 0.0, 1.0, 0.0, m_options.HeighMapSamplingSteps - 1);
         double y = remap( p0.y(), 0.0, 1.0, 0.0, m_options.HeighMapSamplingSteps - 1);
         double h = remap( p0.z(), 0.0, 1.0, minHeight, maxHeight);
         Point_3 phm( x, y, h ) ; // Point in "heightmap" format
 
-        if ( isCorner ) {
-            numCorners++ ;
-            if ( p0.x() < 0.5 && p0.y() < 0.5 ) { // Corner (0, 0)
-                edgeIndices.westIndices.push_back(vertInd);
-                edgeIndices.southIndices.push_back(vertInd);
-                tileWestVertices.push_back(phm) ;
-                tileSouthVertices.push_back(phm) ;
-            }
-            else if ( p0.x() < 0.5 && p0.y() > 0.5 ) { // Corner (0, 1)
-                edgeIndices.westIndices.push_back(vertInd);
-                edgeIndices.northIndices.push_back(vertInd);
-                tileWestVertices.push_back( phm ) ;
-                tileNorthVertices.push_back( phm ) ;
-            }
-            else if ( p0.x() > 0.5 && p0.y() > 0.5 ) { // Corner (1, 1)
-                edgeIndices.northIndices.push_back(vertInd);
-                edgeIndices.eastIndices.push_back(vertInd);
-                tileNorthVertices.push_back( phm ) ;
-                tileEastVertices.push_back( phm ) ;
-            }
-            else { // p0.x() > 0.5 && p0.y() < 0.5 ) // Corner (1, 0)
-                edgeIndices.eastIndices.push_back(vertInd);
-                edgeIndices.southIndices.push_back(vertInd);
-                tileEastVertices.push_back( phm ) ;
-                tileSouthVertices.push_back( phm ) ;
-            }
+        if ( flags & IndexedMesh::BorderWest ) {
+            edgeIndices.westIndices.push_back(vertInd);
+            tileWestVertices.push_back(phm) ;
         }
-        else {
-            if (diffX < diffY) {
-                // Vertical edge, can be a western or eastern edge
-                if (p0.x() < 0.5) {
-                    // Western border edge/vertex
-                    edgeIndices.westIndices.push_back(vertInd);
-                    tileWestVertices.push_back(phm) ;
-                } else { // p0.x() >= 0.5
-                    // Eastern border vertex
-                    edgeIndices.eastIndices.push_back(vertInd);
-                    tileEastVertices.push_back(phm) ;
-                }
-            } else { // diffX >= diffY
-                // Horizontal edge, can be a northern or southern edge
-                if (p0.y() < 0.5) {
-                    // Southern border edge/vertex
-                    edgeIndices.southIndices.push_back(vertInd);
-                    tileSouthVertices.push_back(phm) ;
-                } else { // p0.y() >= 0.5
-                    // Northern border edge/vertex
-                    edgeIndices.northIndices.push_back(vertInd);
-                    tileNorthVertices.push_back(phm) ;
-                }
-            }
+        if ( flags & IndexedMesh::BorderEast ) {
+            edgeIndices.eastIndices.push_back(vertInd);
+            tileEastVertices.push_back(phm) ;
         }
-
-        // Advance 2 positions (i.e., skip non-border halfedges)
-        std::advance(e,2) ;
+        if ( flags & IndexedMesh::BorderSouth ) {
+            edgeIndices.southIndices.push_back(vertInd);
+            tileSouthVertices.push_back(phm) ;
+        }
+        if ( flags & IndexedMesh::BorderNorth ) {
+            edgeIndices.northIndices.push_back(vertInd);
+            tileNorthVertices.push_back(phm) ;
+        }
+        if ( ( flags & ( IndexedMesh::BorderWest | IndexedMesh::BorderEast ) ) &&
+             ( flags & ( IndexedMesh::BorderSouth | IndexedMesh::BorderNorth ) ) )
+            numCorners++ ;
     }
 
     if ( numCorners != 4 )
         std::cout << "[ERROR] Not all 4 corners of the tile were detected!" << std::endl ;
 
+    // Sort the indices along each border (v for the western/eastern ones, u for the southern/northern ones)
+    const unsigned short* optimizedVertices = vertices.data() ;
+    std::sort(edgeIndices.westIndices.begin(), edgeIndices.westIndices.end(), [optimizedVertices](unsigned int a, unsigned int b) { return optimizedVertices[3*a+1] < optimizedVertices[3*b+1]; });
+    std::sort(edgeIndices.eastIndices.begin(), edgeIndices.eastIndices.end(), [optimizedVertices](unsigned int a, unsigned int b) { return optimizedVertices[3*a+1] < optimizedVertices[3*b+1]; });
+    std::sort(edgeIndices.southIndices.begin(), edgeIndices.southIndices.end(), [optimizedVertices](unsigned int a, unsigned int b) { return optimizedVertices[3*a] < optimizedVertices[3*b]; });
+    std::sort(edgeIndices.northIndices.begin(), edgeIndices.northIndices.end(), [optimizedVertices](unsigned int a, unsigned int b) { return optimizedVertices[3*a] < optimizedVertices[3*b]; });
+
     edgeIndices.westVertexCount = edgeIndices.westIndices.size() ;
     edgeIndices.southVertexCount = edgeIndices.southIndices.size() ;
     edgeIndices.eastVertexCount = edgeIndices.eastIndices.size() ;
@@ -544,15 +584,38 @@ void QuantizedMeshTiler::computeQuantizedMeshGeometry(QuantizedMeshTile& qmTile,
     qmTile.setEdgeIndices(edgeIndices) ;
 
     // Extensions
-    // Compute normals
-    namespace PMP=CGAL::Polygon_mesh_processing;
-    QuantizedMesh::VertexNormals vertexNormals ;
-    for ( Polyhedron::Vertex_iterator vit = surface.vertices_begin(); vit != surface.vertices_end(); ++vit ) {
-        Vector_3 vn = PMP::compute_vertex_normal(vit, surface) ;
+    // Compute normals: normalized sum of the unit normals of the faces around each vertex (in uvh space, as
+    // CGAL::Polygon_mesh_processing::compute_vertex_normal does), stored in the optimized order of the vertices
+    std::vector<Vector_3>& normals = m_encodingBuffers.normals ;
+    normals.assign( numVertices, Vector_3( CGAL::NULL_VECTOR ) ) ;
+    for ( std::size_t t = 0; t+2 < mesh.triangles.size(); t += 3 ) {
+        const std::size_t i0 = mesh.triangles[t], i1 = mesh.triangles[t+1], i2 = mesh.triangles[t+2] ;
+        Vector_3 fn = CGAL::cross_product( mesh.vertices[i1] - mesh.vertices[i0], mesh.vertices[i2] - mesh.vertices[i0] ) ;
+        const double sqLength = fn.squared_length() ;
+        if ( sqLength <= 0.0 )
+            continue ; // Degenerate face
+        fn = fn / std::sqrt( sqLength ) ;
+        normals[i0] = normals[i0] + fn ;
+        normals[i1] = normals[i1] + fn ;
+        normals[i2] = normals[i2] + fn ;
+    }
 
-        vertexNormals.nx.push_back((float)vn.x()) ;
-        vertexNormals.ny.push_back((float)vn.y()) ;
-        vertexNormals.nz.push_back((float)vn.z()) ;
+    QuantizedMesh::VertexNormals vertexNormals ;
+    vertexNormals.nx.resize( numUsedVertices ) ;
+    vertexNormals.ny.resize( numUsedVertices ) ;
+    vertexNormals.nz.resize( numUsedVertices ) ;
+    for ( int i = 0; i < numVertices; i++ ) {
+        const unsigned int vertInd = vertexRemap[i] ;
+        if ( vertInd == ~0u )
+            continue ;
+        Vector_3 vn = normals[i] ;
+        const double sqLength = vn.squared_length() ;
+        if ( sqLength > 0.0 )
+            vn = vn / std::sqrt( sqLength ) ;
+
+        vertexNormals.nx[vertInd] = (float)vn.x() ;
+        vertexNormals.ny[vertInd] = (float)vn.y() ;
+        vertexNormals.nz[vertInd] = (float)vn.z() ;
     }
 
     // Write normals to tile
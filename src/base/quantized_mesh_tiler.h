@@ -28,8 +28,14 @@
 #include <boost/filesystem.hpp>
 #include "ellipsoid.h"
 #include "tin_creation/tin_creator.h"
+#include "tin_creation/height_grid_roughness.h"
 #include <mutex>
+#include <algorithm>
 #include "borders_data.h"
+#include "misc_utils.h"
+#include "raster_heights_processing.h"
+#include "mosaic_dataset.h"
+#include "crs_conversions.h"
 
 namespace fs = boost::filesystem ;
 
@@ -45,6 +51,8 @@ class QuantizedMeshTiler : public ctb::TerrainTiler
     typedef TinCreation::Vector_3 Vector_3;
     typedef TinCreation::Point_2 Point_2;
     typedef TinCreation::Polyhedron Polyhedron;
+    typedef TinCreation::Polyline Polyline;
+    typedef TinCreation::IndexedMesh IndexedMesh;
 
 public:
     // --- Options struct ---
@@ -81,6 +89,7 @@ public:
             : TerrainTiler(tiler.poDataset, tiler.mGrid, tiler.options)
             , m_options(tiler.m_options)
             , m_tinCreator(tiler.m_tinCreator)
+            , m_mosaicReader( tiler.m_mosaicReader ? std::make_shared<MosaicReader>(*tiler.m_mosaicReader) : std::shared_ptr<MosaicReader>() )
     {}
 
     /**
@@ -101,6 +110,20 @@ public:
      */
     QuantizedMeshTile createTile(const ctb::TileCoordinate &coord, BordersData& bd) ;
 
+    /**
+     * @brief Create a flat quantized mesh tile for a tile known to contain only no data values.
+     *
+     * The raster is not read, and no TIN creation takes place: the tile is a minimal mesh with the corners and the
+     * vertices to maintain from the neighbors, all of them (but the vertices from the neighbors) at the height the
+     * no data values would be given by createTile.
+     *
+     * @param coord TileCoordinate.
+     * @param bd Data to preserve for the borders (same behaviour as in createTile).
+     *
+     * @return The quantized mesh tile.
+     */
+    QuantizedMeshTile createFlatTile(const ctb::TileCoordinate &coord, BordersData& bd) ;
+
     /**
      * @brief Get the creation options for this tiler (QMTOptions structure)
      * @return QMTOptions structure
@@ -113,6 +136,38 @@ public:
      */
     void setTinCreatorParamsForZoom(const unsigned int& zoom) { m_tinCreator.setParamsForZoom(zoom); }
 
+    /// Check if the TIN creation strategy is selected per tile (see TinCreation::TinCreator::addAdaptiveCreator)
+    bool isTinCreatorAdaptive() const { return m_tinCreator.isAdaptive(); }
+
+    /// Name of the TIN creation strategy used for the last tile created with createTile
+    const std::string& getLastTileTinCreatorName() const { return m_tinCreator.getCreatorName(); }
+
+    /// Roughness of the last tile created with createTile (only computed if the TIN creation strategy is adaptive)
+    const TinCreation::HeightGridRoughness& getLastTileRoughness() const { return m_lastTileRoughness; }
+
+    /**
+     * @brief Number of tiles whose TIN creation was stopped by each criterion since the last reset
+     * @return Vector indexed by TinCreation::StopCriterion
+     */
+    const std::vector<unsigned int>& getStopCriteriaCounts() const { return m_stopCriteriaCounts; }
+
+    /// Reset the counts of the criteria stopping the TIN creation (see getStopCriteriaCounts)
+    void resetStopCriteriaCounts() { std::fill(m_stopCriteriaCounts.begin(), m_stopCriteriaCounts.end(), 0); }
+
+    /**
+     * @brief Read the heights from a mosaic of rasters instead of from the dataset of the tiler.
+     *
+     * In this case, the dataset passed on construction is only used for its extents and reference system (see
+     * MosaicIndex::createSummaryDataset), and the data for each tile is composed from the rasters of the mosaic
+     * intersecting it. Each tiler (i.e., each thread) has its own reader, with its own cache of open files.
+     *
+     * @param index The index of the mosaic
+     * @param maxOpenFiles Maximum number of rasters of the mosaic kept open by this tiler
+     */
+    void setMosaic(const std::shared_ptr<const MosaicIndex>& index, const int& maxOpenFiles) {
+        m_mosaicReader = std::make_shared<MosaicReader>(index, mGrid.getSRS(), maxOpenFiles);
+    }
+
     /**
      * @brief Get the heightmap values from the GDAL raster in normalized coordinates
      *
@@ -129,12 +184,51 @@ public:
                                                 ctb::CRSBounds& tileBounds,
                                                 const bool& ignoreNoDataPoints = false) const ;
 
+    /**
+     * @brief Get the heightmap values from the GDAL raster as a regular grid
+     *
+     * The heights are stored in an internal buffer of the tiler, so the returned view is valid until the next call
+     * to this function (or to getUVHPointsFromRaster/createTile).
+     *
+     * @param coord The coordinates of the tile
+     * @param bd Data falling in the borders of the tile (in heightmap coordinates)
+     * @param[out] minHeight Min height on the tile from raster
+     * @param[out] maxHeight Max height on the tile from raster
+     * @param[out] tileBounds Output variable containing the tile bounds
+     * @param[out] borders The vertices to preserve in the borders of the tile, in uvh coordinates
+     * @param ignoreNoDataPoints If set, the no data samples are marked as invalid (NaN) in the grid
+     * @return View of the heights grid
+     */
+    TinCreation::HeightGridView getHeightGridFromRaster(const ctb::TileCoordinate &coord,
+                                                        BordersData& bd,
+                                                        float& minHeight, float& maxHeight,
+                                                        ctb::CRSBounds& tileBounds,
+                                                        TinCreation::HeightGridBorders& borders,
+                                                        const bool& ignoreNoDataPoints = false) const ;
+
 private:
     // --- Attributes ---
     QMTOptions m_options;
     TinCreation::TinCreator m_tinCreator;
     mutable std::mutex m_mutex; // Mark mutex as mutable because it doesn't represent the object's real state
                                 // Note that we don't need the mutex if we create multiple instances of tilers, as done in qm_tiler right now. We leave it here in case it is needed for other implementations
+    std::shared_ptr<MosaicReader> m_mosaicReader; //!< Reader of the mosaic, if the input is a mosaic of rasters (NULL otherwise)
+    std::vector<unsigned int> m_stopCriteriaCounts = std::vector<unsigned int>(TinCreation::NumStopCriteria, 0); //!< Number of tiles stopped by each TinCreation::StopCriterion
+    mutable std::vector<float> m_heightsBuffer; //!< Heights read from the raster, reused between tiles to avoid allocating them for each tile. Since there is a tiler per thread, this is a per-thread buffer
+    TinCreation::HeightGridRoughness m_lastTileRoughness; //!< Roughness of the last tile, used to select its TIN creation strategy
+    mutable crs_conversions::GeodeticECEFConverter m_ecefConverter; //!< Geodetic to ECEF conversion of the vertices of each tile, with trigonometric tables reused between tiles (per-thread, as the buffer above)
+    IndexedMesh m_mesh; //!< TIN of the current tile, reused between tiles (per-thread, as m_heightsBuffer)
+
+    /// Working buffers used to encode each tile, reused between tiles (per-thread, as m_heightsBuffer)
+    struct EncodingBuffers {
+        std::vector<double> lons, lats, heights;      //!< Geodetic coordinates of the vertices
+        std::vector<double> xs, ys, zs;               //!< ECEF coordinates of the vertices
+        std::vector<Point_3> ecefPoints;              //!< ECEF coordinates of the vertices, as points
+        std::vector<unsigned short> vertices;         //!< Quantized u/v/h coordinates of the vertices
+        std::vector<unsigned int> vertexRemap;        //!< Vertex reordering after optimizing for vertex fetching
+        std::vector<Vector_3> normals;                //!< Accumulated normals of the faces around each vertex
+    };
+    mutable EncodingBuffers m_encodingBuffers;
 
     // --- Private Functions ---
     /**
@@ -152,14 +246,12 @@ private:
     }
 
     /**
-     * @brief Clip a value between lower and upper bounds.
-     * @param n The number to clip.
-     * @param lower Clipping lower bound.
-     * @param upper Clipping upper bound.
-     * @return Clipped value.
+     * @brief Convert a point in heightmap coordinates (i.e., x/y in sampling steps and height in meters) to uvh coordinates
      */
-    float clip(const float& n, const float& lower, const float& upper) const {
-        return std::max(lower, std::min(n, upper));
+    Point_3 heightMapToUVH(const Point_3& p, const TinCreation::HeightGridView& grid) const {
+        return Point_3( remap( p.x(), 0.0, m_options.HeighMapSamplingSteps-1, 0.0, 1.0 ),
+                        remap( p.y(), 0.0, m_options.HeighMapSamplingSteps-1, 0.0, 1.0 ),
+                        grid.normalizeHeight( p.z() ) ) ;
     }
 
 //    void getConstraintsAtBorders(BordersData& bd,
@@ -168,31 +260,75 @@ private:
 //                                 bool &constrainNorthernVertices,
 //                                 bool &constrainSouthernVertices) const;
 
+    /**
+     * @brief Convert the vertices to preserve in the borders of the tile (in heightmap coordinates) to uvh coordinates
+     * @param bd Data falling in the borders of the tile
+     * @param grid The grid of heights of the tile (only used to normalize the heights)
+     * @param[out] borders The vertices to preserve in the borders of the tile, in uvh coordinates
+     */
+    void getHeightGridBorders(BordersData& bd,
+                              const TinCreation::HeightGridView& grid,
+                              TinCreation::HeightGridBorders& borders) const ;
+
+    /**
+     * @brief Get the parameters of the transformation applied to the heights read from the raster
+     */
+    RasterHeightsProcessingParams getRasterHeightsProcessingParams(const double& noDataValue,
+                                                                   const bool& ignoreNoDataPoints) const ;
+
+    /**
+     * @brief Create the raster of a tile from a dataset other than the one of the tiler (e.g., a window of a mosaic)
+     *
+     * The dataset is warped as createRasterTile does with the dataset of the tiler, which is left untouched.
+     *
+     * @param dataset The dataset covering the tile. It must be kept open while the returned tile is in use
+     * @param coord TileCoordinate.
+     * @return The raster tile (owned by the caller)
+     */
+    ctb::GDALTile* createWindowRasterTile(GDALDataset *dataset, const ctb::TileCoordinate &coord) const ;
+
     // --- The following private functions split the processing required to generate the tiles for better readability ---
 
+    /**
+     * @brief Encode the TIN of a tile in quantized mesh format (common part of createTile and createFlatTile)
+     *
+     * @param coord TileCoordinate.
+     * @param mesh The TIN of the tile, in uvh coordinates, with its border flags
+     * @param minHeight Min height on the tile
+     * @param maxHeight Max height on the tile
+     * @param tileBounds The tile bounds (in the geographic reference system coordinates)
+     * @param[out] bd The vertices in the borders of the generated tile
+     * @return The quantized mesh tile.
+     */
+    QuantizedMeshTile encodeTile(const ctb::TileCoordinate &coord,
+                                 const IndexedMesh& mesh,
+                                 float& minHeight, float& maxHeight,
+                                 const ctb::CRSBounds& tileBounds,
+                                 BordersData& bd) const ;
 
 
     /**
      * @brief Compute the values of the header from the points in the simplified TIN
      *
      * @param qmTile The tile where the header will be written
-     * @param surface The triangle mesh containing the geometry of the tile (only its vertices will be used here)
+     * @param mesh The triangle mesh containing the geometry of the tile (only its vertices will be used here)
      * @param minHeight Min height on the tile from raster
      * @param maxHeight Max height on the tile from raster
      * @param tileBounds The tile bounds (in the geographic reference system coordinates)
      */
     void computeQuantizedMeshHeader(QuantizedMeshTile& qmTile,
-                                    const Polyhedron& surface,
+                                    const IndexedMesh& mesh,
                                     const float& minHeight, float& maxHeight,
                                     const ctb::CRSBounds& tileBounds) const ;
 
 
     /**
      * Compute and store all the parts of the Quantized Mesh format related to the geometry of the TIN
-     * While computing this information, we also store the vertices in the borders of the tile
+     * While computing this information, we also store the vertices in the borders of the tile (those flagged in the
+     * border flags of the mesh, see TinCreation::computeBorderFlags)
      *
      * @param qmTile The QuantizedMeshTile structure to modify
-     * @param surface The base triangle mesh containing the (simplified) geometry of the tile
+     * @param mesh The base triangle mesh containing the (simplified) geometry of the tile
      * @param minHeight Min height on the tile from raster
      * @param maxHeight Max height on the tile from raster
      * @param[out] tileEastVertices Eastern vertices of the tile
@@ -201,7 +337,7 @@ private:
      * @param[out] tileSouthVertices Southern vertices of the tile
      */
     void computeQuantizedMeshGeometry(QuantizedMeshTile& qmTile,
-                                      Polyhedron& surface,
+                                      const IndexedMesh& mesh,
                                       const float& minHeight, const float& maxHeight,
                                       std::vector<Point_3> &tileEastVertices,
                                       std::vector<Point_3> &tileWestVertices,
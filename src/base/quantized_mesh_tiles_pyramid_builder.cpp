@@ -21,7 +21,10 @@
 #include "quantized_mesh_tiles_pyramid_builder.h"
 #include <ctb.hpp>
 #include "zoom_tiles_border_vertices_cache.h"
+#include "parallelism_budget.h"
 #include <future>
+#include <fstream>
+#include <nlohmann/json.hpp>
 
 
 
@@ -29,10 +32,14 @@ QuantizedMeshTilesPyramidBuilder::
 QuantizedMeshTilesPyramidBuilder(const std::vector<QuantizedMeshTiler>& qmTilers,
                                          const ZoomTilesScheduler& scheduler)
     : m_scheduler(scheduler), m_numThreads(qmTilers.size()), m_tilers(qmTilers), m_debugMode(false), m_debugDir("")
+    , m_coverage(), m_emptyTilesPolicy(EmptyTilesProcess)
 {
     const unsigned int numMaxThreads = std::thread::hardware_concurrency();
     if ( m_numThreads <= 0 )
         m_numThreads = numMaxThreads ;
+
+    // One persistent thread per tiler, so that the per-thread buffers of the TIN creation are reused between tiles
+    m_workers.reset( new TileWorkers( m_numThreads ) ) ;
 }
 
 
@@ -78,6 +85,9 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramid(const int &startZoom, co
 
         std::cout << "--- Zoom " << zoom << " (" << zoomBounds.getMinX() << ", " << zoomBounds.getMinY() << ") --> (" << zoomBounds.getMaxX() << ", " << zoomBounds.getMaxY() << ") ---" << std::endl;
 
+        // Check which tiles contain data
+        initZoomCoverage(zoom, zoomBounds);
+
         // Prepare a new borders' cache
         m_bordersCache = ZoomTilesBorderVerticesCache(zoomBounds, m_tilers[0].getOptions().HeighMapSamplingSteps-1);
 
@@ -102,6 +112,12 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramid(const int &startZoom, co
             ctb::TilePoint tp;
             while (numThread < m_numThreads && getNextTileToProcess(tp)) {
                 numLaunchedProcesses++ ;
+
+                if (skipTile(tp.x, tp.y)) {
+                    // Empty tile, no file is generated and there are no borders to maintain from it
+                    m_bordersCache.setTileSkipped(tp.x, tp.y);
+                    continue;
+                }
                 std::cout << "Processing tile " << numLaunchedProcesses << "/" << m_scheduler.numTiles()
                           << ": x = " << tp.x << ", y = " << tp.y
                           << " (thread " << numThread << ")"
@@ -118,16 +134,18 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramid(const int &startZoom, co
                 BordersData bd;
                 m_bordersCache.getConstrainedBorderVerticesForTile(tp.x, tp.y, bd);
 
-                std::future<BordersData> f = std::async( std::launch::async,
-                                                         &QuantizedMeshTilesPyramidBuilder::createTile, this,
-                                                         coord, numThread, outDir, bd ); // Note: Using std::ref(bd) does not work, as we use bd as the future return value...
+                // Run it in the worker of the tiler (note: bd is captured by copy, as we use it as the future return value)
+                const int tilerIndex = numThread ;
+                std::future<BordersData> f = m_workers->submit( tilerIndex, [this, coord, tilerIndex, outDir, bd]() {
+                    return createTile( coord, tilerIndex, outDir, bd ) ;
+                } ) ;
 
                 futures.emplace_back(std::move(f));
 
                 numThread++;
             }
 
-            // Join the threads with the main thread and wait for the results to be ready
+            // Wait for the results to be ready
             for(auto &f : futures) {
                 f.wait();
             }
@@ -142,7 +160,11 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramid(const int &startZoom, co
 
         // Debug: the following line should be uncommented to show the current state of the processing graphically
         //m_bordersCache.showStatus(-1, -1, true);
+
+        reportStopCriteria();
     }
+
+    writeAvailability(outDir);
 }
 
 
@@ -191,6 +213,9 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramidUnconstrainedBorders(cons
 
         std::cout << "--- Zoom " << zoom << " (" << zoomBounds.getMinX() << ", " << zoomBounds.getMinY() << ") --> (" << zoomBounds.getMaxX() << ", " << zoomBounds.getMaxY() << ") ---" << std::endl ;
 
+        // Check which tiles contain data
+        initZoomCoverage( zoom, zoomBounds ) ;
+
         // Get the preferred ordering of processing
         m_scheduler.initSchedule( zoomBounds ) ;
 
@@ -204,6 +229,9 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramidUnconstrainedBorders(cons
 
                 numLaunchedProcesses++ ;
 
+                if ( skipTile(tp.x, tp.y) )
+                    continue ;
+
                 std::cout << "Processing tile " << numLaunchedProcesses << "/" << m_scheduler.numTiles()
                           << ": x = " << tp.x << ", y = " << tp.y
                           << " (thread " << numThread << ")"
@@ -211,23 +239,27 @@ void QuantizedMeshTilesPyramidBuilder::createTmsPyramidUnconstrainedBorders(cons
 
                 ctb::TileCoordinate coord(zoom, tp.x, tp.y);
 
-                // Launch thread
-                BordersData bd; // empty borders...
-                std::future<BordersData> f = std::async(std::launch::async,
-                                                        &QuantizedMeshTilesPyramidBuilder::createTile, this,
-                                                        coord, numThread, outDir, bd); // Note: Using std::ref(bd) does not work, as we use bd as the future return value...
+                // Run it in the worker of the tiler
+                const int tilerIndex = numThread ;
+                std::future<BordersData> f = m_workers->submit( tilerIndex, [this, coord, tilerIndex, outDir]() {
+                    return createTile( coord, tilerIndex, outDir, BordersData() ) ; // empty borders...
+                } ) ;
 
                 futures.emplace_back(std::move(f)) ;
 
                 numThread++ ;
             }
 
-            // Join the threads with the main thread and wait for the results to be ready
+            // Wait for the results to be ready
             for(auto &f : futures) {
                 f.wait() ;
             }
         }
+
+        reportStopCriteria() ;
     }
+
+    writeAvailability( outDir ) ;
 }
 
 
@@ -275,10 +307,26 @@ QuantizedMeshTilesPyramidBuilder::createTile( const ctb::TileCoordinate& coord,
 {
     // Note: Using std::ref(bd) does not work, as we use bd as the future return value... So we copy the borders data
     BordersData bdC(bd) ;
-    QuantizedMeshTile terrainTile = m_tilers[numThread].createTile(coord, bdC) ;
+
+    // Register the tile as in flight, so that the parallel algorithms within the other tiles do not count on its core
+    ParallelismBudget::TileScope tileScope ;
+    const bool isFlat = m_emptyTilesPolicy == EmptyTilesFlat && !tileHasData(coord.x, coord.y) ;
+    QuantizedMeshTile terrainTile = isFlat
+                                    ? m_tilers[numThread].createFlatTile(coord, bdC)
+                                    : m_tilers[numThread].createTile(coord, bdC) ;
 
     // Write the file to disk (should be thread safe, as every thread will write to a different file, but we don't risk and use a mutex)
     m_diskWriteMutex.lock();
+
+    // Log the TIN creation strategy selected for the tile, if selected per tile (the mutex also prevents mixing the
+    // logs of different threads)
+    if ( !isFlat && m_tilers[numThread].isTinCreatorAdaptive() ) {
+        const TinCreation::HeightGridRoughness& roughness = m_tilers[numThread].getLastTileRoughness() ;
+        std::cout << "Tile " << coord.zoom << "/" << coord.x << "/" << coord.y
+                  << ": TIN creation strategy = " << m_tilers[numThread].getLastTileTinCreatorName()
+                  << " (roughness = " << roughness.rmsDetail << ", height range = " << roughness.heightRange << ")"
+                  << std::endl ;
+    }
     const std::string fileName = getTileFileAndCreateDirs(coord, outDir);
     terrainTile.writeFile(fileName);
 
@@ -295,6 +343,123 @@ QuantizedMeshTilesPyramidBuilder::createTile( const ctb::TileCoordinate& coord,
 
 
 
+void QuantizedMeshTilesPyramidBuilder::initZoomCoverage( const int& zoom, const ctb::TileBounds& zoomBounds )
+{
+    m_zoomBounds = zoomBounds ;
+    const int numTilesX = zoomBounds.getMaxX() - zoomBounds.getMinX() + 1 ;
+    const int numTilesY = zoomBounds.getMaxY() - zoomBounds.getMinY() + 1 ;
+    m_zoomTilesWithData = std::vector<std::vector<bool>>( numTilesX, std::vector<bool>( numTilesY, true ) ) ;
+
+    int numEmpty = 0 ;
+    if ( m_coverage.isEnabled() && m_emptyTilesPolicy != EmptyTilesProcess ) {
+        for ( int tx = zoomBounds.getMinX(); tx <= zoomBounds.getMaxX(); tx++ ) {
+            for ( int ty = zoomBounds.getMinY(); ty <= zoomBounds.getMaxY(); ty++ ) {
+                ctb::CRSBounds tileBounds = m_tilers[0].grid().tileBounds( ctb::TileCoordinate( zoom, tx, ty ) ) ;
+                if ( !m_coverage.hasData( tileBounds ) ) {
+                    m_zoomTilesWithData[tx-zoomBounds.getMinX()][ty-zoomBounds.getMinY()] = false ;
+                    numEmpty++ ;
+                }
+            }
+        }
+        std::cout << numEmpty << "/" << numTilesX*numTilesY << " tiles contain only no data values ("
+                  << ( m_emptyTilesPolicy == EmptyTilesSkip ? "skipped" : "created as flat tiles" ) << ")" << std::endl ;
+    }
+
+    // Ranges of tiles that will be created: merge the runs of created tiles in consecutive rows into rectangles
+    std::vector<ctb::TileBounds> available ;
+    std::map<std::pair<int,int>, int> openRanges, nextOpenRanges ; // Run (startX, endX) in the previous row --> index in available
+    for ( int ty = zoomBounds.getMinY(); ty <= zoomBounds.getMaxY(); ty++ ) {
+        nextOpenRanges.clear() ;
+        int tx = zoomBounds.getMinX() ;
+        while ( tx <= zoomBounds.getMaxX() ) {
+            if ( skipTile( tx, ty ) ) {
+                tx++ ;
+                continue ;
+            }
+            int startX = tx ;
+            while ( tx <= zoomBounds.getMaxX() && !skipTile( tx, ty ) )
+                tx++ ;
+            std::pair<int,int> run( startX, tx-1 ) ;
+            std::map<std::pair<int,int>, int>::iterator it = openRanges.find( run ) ;
+            if ( it != openRanges.end() ) {
+                available[it->second].setMaxY( ty ) ;
+                nextOpenRanges[run] = it->second ;
+            }
+            else {
+                available.push_back( ctb::TileBounds( startX, ty, tx-1, ty ) ) ;
+                nextOpenRanges[run] = available.size()-1 ;
+            }
+        }
+        openRanges.swap( nextOpenRanges ) ;
+    }
+    m_availableTiles[zoom] = available ;
+}
+
+
+
+void QuantizedMeshTilesPyramidBuilder::reportStopCriteria()
+{
+    std::vector<unsigned int> counts( TinCreation::NumStopCriteria, 0 ) ;
+    for ( int t = 0; t < m_numThreads; t++ ) {
+        const std::vector<unsigned int>& tilerCounts = m_tilers[t].getStopCriteriaCounts() ;
+        for ( int c = 0; c < TinCreation::NumStopCriteria; c++ )
+            counts[c] += tilerCounts[c] ;
+        m_tilers[t].resetStopCriteriaCounts() ;
+    }
+
+    // Only the strategies refining the TIN incrementally report a stop criterion
+    unsigned int numRefined = 0 ;
+    for ( int c = TinCreation::StopNotApplicable + 1; c < TinCreation::NumStopCriteria; c++ )
+        numRefined += counts[c] ;
+    if ( numRefined == 0 )
+        return ;
+
+    std::cout << "TIN creation stop criteria:" ;
+    for ( int c = TinCreation::StopNotApplicable + 1; c < TinCreation::NumStopCriteria; c++ )
+        std::cout << " " << TinCreation::stopCriterionName(c) << " = " << counts[c] << ( c < TinCreation::NumStopCriteria-1 ? "," : "" ) ;
+    std::cout << std::endl ;
+}
+
+
+
+void QuantizedMeshTilesPyramidBuilder::writeAvailability( const std::string& outDir ) const
+{
+    using json = nlohmann::json;
+
+    fs::path fileNamePath = fs::path(outDir) / fs::path("availability.json") ;
+
+    // Maintain the zooms created in previous runs
+    json availability ;
+    if ( fs::exists( fileNamePath ) ) {
+        std::ifstream ifs( fileNamePath.string() ) ;
+        try {
+            ifs >> availability ;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not parse " << fileNamePath << ", overwriting it" << std::endl ;
+            availability = json() ;
+        }
+    }
+
+    for ( std::map<int, std::vector<ctb::TileBounds>>::const_iterator it = m_availableTiles.begin(); it != m_availableTiles.end(); ++it ) {
+        json ranges = json::array() ;
+        for ( std::vector<ctb::TileBounds>::const_iterator itB = it->second.begin(); itB != it->second.end(); ++itB ) {
+            ranges.push_back( { {"startX", (int)itB->getMinX()}, {"startY", (int)itB->getMinY()},
+                                {"endX", (int)itB->getMaxX()}, {"endY", (int)itB->getMaxY()} } ) ;
+        }
+        availability["available"][std::to_string(it->first)] = ranges ;
+    }
+
+    std::ofstream ofs( fileNamePath.string() ) ;
+    if ( !ofs.good() ) {
+        std::cerr << "[ERROR] Cannot write the availability file " << fileNamePath << std::endl ;
+        return ;
+    }
+    ofs << availability.dump(4) << std::endl ;
+}
+
+
+
 std::string QuantizedMeshTilesPyramidBuilder::getTileFileAndCreateDirs( const ctb::TileCoordinate &coord,
                                                                                 const std::string &mainOutDir )
 {
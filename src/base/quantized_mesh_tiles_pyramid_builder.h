@@ -30,6 +30,10 @@
 #include <vector>
 #include <mutex>
 #include "borders_data.h"
+#include "dataset_coverage.h"
+#include "tile_workers.h"
+#include <memory>
+#include <map>
 
 
 
@@ -46,15 +50,26 @@ class QuantizedMeshTilesPyramidBuilder
     typedef typename TinCreation::Point_3 Point_3;
 
 public:
+    enum EmptyTilesPolicy { EmptyTilesProcess = 0, EmptyTilesFlat, EmptyTilesSkip } ; //!< What to do with the tiles containing only no data values
 
     /**
      * Constructor
-     * @param qmTilers Vector of tilers, one for each desired thread (they should be the same!)
+     * @param qmTilers Vector of tilers, one for each desired thread (they should be the same!). Each tiler is always run in the same thread (see TileWorkers)
      * @param scheduler The desired scheduler defining a preferred order for processing the tiles
      */
     QuantizedMeshTilesPyramidBuilder(const std::vector<QuantizedMeshTiler>& qmTilers,
                                              const ZoomTilesScheduler& scheduler);
 
+    /**
+     * @brief Sets the coverage of the input dataset, used to detect the tiles containing only no data values
+     * @param coverage The coverage index of the input dataset
+     * @param emptyTilesPolicy What to do with the empty tiles (EmptyTilesPolicy): process them as any other tile, create a flat tile without reading the raster, or skip them (i.e., no tile file is created)
+     */
+    void setDatasetCoverage(const DatasetCoverage& coverage, const int& emptyTilesPolicy) {
+        m_coverage = coverage ;
+        m_emptyTilesPolicy = emptyTilesPolicy ;
+    }
+
     /**
      * @brief Creates the tile pyramid in quantized-mesh format
      *
@@ -109,6 +124,46 @@ private:
     bool m_debugMode ;
     std::string m_debugDir ;
     std::mutex m_diskWriteMutex;
+    DatasetCoverage m_coverage ;
+    int m_emptyTilesPolicy ;
+    ctb::TileBounds m_zoomBounds ;                          //!< Bounds of the zoom being processed
+    std::vector<std::vector<bool>> m_zoomTilesWithData ;    //!< Tiles of the current zoom that may contain data (indexed as [x-minX][y-minY])
+    std::map<int, std::vector<ctb::TileBounds>> m_availableTiles ; //!< Ranges of tiles created for each zoom level
+    std::unique_ptr<TileWorkers> m_workers ;                 //!< Persistent threads running the tiles, one per tiler
+
+    /**
+     * @brief Computes which tiles of the zoom may contain data, and the ranges of tiles that will be created
+     * @param zoom The zoom level
+     * @param zoomBounds The tile bounds of the zoom level
+     */
+    void initZoomCoverage( const int& zoom, const ctb::TileBounds& zoomBounds ) ;
+
+    /**
+     * @brief Checks if a tile of the current zoom may contain data
+     */
+    bool tileHasData( const int& tileX, const int& tileY ) const {
+        return m_zoomTilesWithData[tileX-m_zoomBounds.getMinX()][tileY-m_zoomBounds.getMinY()] ;
+    }
+
+    /**
+     * @brief Checks if a tile of the current zoom should be skipped (i.e., no file created for it)
+     */
+    bool skipTile( const int& tileX, const int& tileY ) const {
+        return m_emptyTilesPolicy == EmptyTilesSkip && !tileHasData(tileX, tileY) ;
+    }
+
+    /**
+     * @brief Writes the ranges of tiles created for each zoom level (as required by the "available" field of
+     * layer.json) in the availability.json file of the output directory. The zooms already in the file and not
+     * processed in this run are maintained.
+     */
+    void writeAvailability( const std::string& outDir ) const ;
+
+    /**
+     * @brief Prints how many tiles of the zoom just processed stopped their TIN creation due to each criterion (error
+     * tolerance or any of the budgets), and resets the counts of the tilers
+     */
+    void reportStopCriteria() ;
 
     /**
     * @brief Check that the DEBUG tile folder (zoom/x) exists, and creates it otherwise.
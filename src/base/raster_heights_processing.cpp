@@ -0,0 +1,160 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "raster_heights_processing.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+
+void processRasterHeightsScalar( const float* in, float* out, std::size_t n,
+                                 const RasterHeightsProcessingParams& params,
+                                 float& minHeight, float& maxHeight )
+{
+    float minH = minHeight, maxH = maxHeight ;
+    for ( std::size_t k = 0; k < n; k++ ) {
+        float height = in[k] ;
+
+        // Skip no data values, if required to
+        if ( params.ignoreNoData && height == params.noDataValue ) {
+            out[k] = std::numeric_limits<float>::quiet_NaN() ;
+            continue ;
+        }
+
+        // Clipping
+        height = std::max( params.clippingLowValue, std::min( height, params.clippingHighValue ) ) ;
+
+        // When no data is available, and no skipping is required, we assume ground data
+        if ( height == params.noDataValue )
+            height = 0 ;
+
+        // If the input DEM contains bathymetry, consider the data as depth instead of altitude (negative value!)
+        if ( params.isBathymetry )
+            height = -height ;
+
+        // Apply scales
+        if ( height < 0 && params.belowSeaLevelScaleFactor > 0 )
+            height *= params.belowSeaLevelScaleFactor ;
+        else if ( height > 0 && params.aboveSeaLevelScaleFactor > 0 )
+            height *= params.aboveSeaLevelScaleFactor ;
+
+        out[k] = height ;
+
+        if ( height < minH )
+            minH = height ;
+        if ( height > maxH )
+            maxH = height ;
+    }
+    minHeight = minH ;
+    maxHeight = maxH ;
+}
+
+
+
+#if defined(__AVX2__)
+
+void processRasterHeights( const float* in, float* out, std::size_t n,
+                           const RasterHeightsProcessingParams& params,
+                           float& minHeight, float& maxHeight )
+{
+    // The scalar code compares the (float) height against the (double) no data value. When the no data value cannot be
+    // represented as a float, that comparison never holds, so we just disable it in the vectorized version
+    const float noDataF = (float)params.noDataValue ;
+    const bool noDataRepresentable = (double)noDataF == params.noDataValue ;
+
+    const __m256 noData = _mm256_set1_ps( noDataF ) ;
+    const __m256 clipLow = _mm256_set1_ps( params.clippingLowValue ) ;
+    const __m256 clipHigh = _mm256_set1_ps( params.clippingHighValue ) ;
+    const __m256 zero = _mm256_setzero_ps() ;
+    const __m256 one = _mm256_set1_ps( 1.0f ) ;
+    const __m256 signMask = _mm256_set1_ps( params.isBathymetry ? -0.0f : 0.0f ) ;
+    const __m256 belowScale = _mm256_set1_ps( params.belowSeaLevelScaleFactor > 0 ? params.belowSeaLevelScaleFactor : 1.0f ) ;
+    const __m256 aboveScale = _mm256_set1_ps( params.aboveSeaLevelScaleFactor > 0 ? params.aboveSeaLevelScaleFactor : 1.0f ) ;
+    const __m256 nan = _mm256_set1_ps( std::numeric_limits<float>::quiet_NaN() ) ;
+    const __m256 posInf = _mm256_set1_ps( std::numeric_limits<float>::infinity() ) ;
+    const __m256 negInf = _mm256_set1_ps( -std::numeric_limits<float>::infinity() ) ;
+    const bool checkNoData = noDataRepresentable ;
+    const bool ignoreNoData = params.ignoreNoData && noDataRepresentable ;
+
+    __m256 minV = _mm256_set1_ps( minHeight ) ;
+    __m256 maxV = _mm256_set1_ps( maxHeight ) ;
+
+    std::size_t k = 0 ;
+    for ( ; k + 8 <= n; k += 8 ) {
+        __m256 h = _mm256_loadu_ps( in + k ) ;
+
+        // Samples to skip (no data, if required to)
+        __m256 skip = ignoreNoData ? _mm256_cmp_ps( h, noData, _CMP_EQ_OQ ) : zero ;
+
+        // Clipping (operands ordered to reproduce std::max(low, std::min(h, high)), also for NaN inputs)
+        h = _mm256_min_ps( clipHigh, h ) ;
+        h = _mm256_max_ps( h, clipLow ) ;
+
+        // No data to ground
+        if ( checkNoData )
+            h = _mm256_andnot_ps( _mm256_cmp_ps( h, noData, _CMP_EQ_OQ ), h ) ;
+
+        // Bathymetry
+        h = _mm256_xor_ps( h, signMask ) ;
+
+        // Scales
+        __m256 scale = _mm256_blendv_ps( one, belowScale, _mm256_cmp_ps( h, zero, _CMP_LT_OQ ) ) ;
+        scale = _mm256_blendv_ps( scale, aboveScale, _mm256_cmp_ps( h, zero, _CMP_GT_OQ ) ) ;
+        h = _mm256_mul_ps( h, scale ) ;
+
+        // Min/max, not considering the skipped samples
+        minV = _mm256_min_ps( minV, _mm256_blendv_ps( h, posInf, skip ) ) ;
+        maxV = _mm256_max_ps( maxV, _mm256_blendv_ps( h, negInf, skip ) ) ;
+
+        _mm256_storeu_ps( out + k, _mm256_blendv_ps( h, nan, skip ) ) ;
+    }
+
+    // Horizontal reduction of min/max
+    float mins[8], maxs[8] ;
+    _mm256_storeu_ps( mins, minV ) ;
+    _mm256_storeu_ps( maxs, maxV ) ;
+    for ( int l = 0; l < 8; l++ ) {
+        if ( mins[l] < minHeight )
+            minHeight = mins[l] ;
+        if ( maxs[l] > maxHeight )
+            maxHeight = maxs[l] ;
+    }
+
+    // Remaining samples
+    processRasterHeightsScalar( in + k, out + k, n - k, params, minHeight, maxHeight ) ;
+}
+
+bool processRasterHeightsIsVectorized() { return true ; }
+
+#else
+
+void processRasterHeights( const float* in, float* out, std::size_t n,
+                           const RasterHeightsProcessingParams& params,
+                           float& minHeight, float& maxHeight )
+{
+    processRasterHeightsScalar( in, out, n, params, minHeight, maxHeight ) ;
+}
+
+bool processRasterHeightsIsVectorized() { return false ; }
+
+#endif
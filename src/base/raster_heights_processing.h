@@ -0,0 +1,75 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_RASTER_HEIGHTS_PROCESSING_H
+#define EMODNET_QMGC_RASTER_HEIGHTS_PROCESSING_H
+
+#include <cstddef>
+#include <limits>
+
+/**
+ * @struct RasterHeightsProcessingParams
+ * @brief Parameters of the per-sample transformation applied to the heights read from the raster
+ */
+struct RasterHeightsProcessingParams
+{
+    double noDataValue = -std::numeric_limits<double>::max() ;          //!< No data value of the raster band
+    bool ignoreNoData = false ;                                         //!< If set, no data samples are marked as NaN (and not considered in the min/max) instead of being set to 0
+    float clippingLowValue = -std::numeric_limits<float>::infinity() ;  //!< Minimum value allowed on the raster, clip values if smaller
+    float clippingHighValue = std::numeric_limits<float>::infinity() ;  //!< Maximum value allowed on the raster, clip values if larger
+    bool isBathymetry = false ;                                         //!< Consider the values as depths (i.e., negate them)
+    float aboveSeaLevelScaleFactor = -1 ;                               //!< Scale factor to apply to the readings above sea level (ignored if < 0)
+    float belowSeaLevelScaleFactor = -1 ;                               //!< Scale factor to apply to the readings below sea level (ignored if < 0)
+};
+
+/**
+ * @brief Transform a span of raw raster heights into the heights used to build the tile, updating the min/max heights.
+ *
+ * For each sample, in this order: no data samples are marked as NaN if \p params.ignoreNoData is set, the value is
+ * clipped, no data values are set to 0 (ground), the sign is changed for bathymetry and the above/below sea level
+ * scale factors are applied. The min/max of the resulting heights are folded into \p minHeight / \p maxHeight in the
+ * same pass (NaN samples are not considered).
+ *
+ * Uses AVX2 when the code is compiled with support for it, and falls back to a scalar loop otherwise.
+ *
+ * @param in Raw heights, as read from the raster
+ * @param out Output heights (can be the same array as \p in)
+ * @param n Number of samples to process
+ * @param params Transformation parameters
+ * @param[in,out] minHeight Minimum height, updated with the processed samples
+ * @param[in,out] maxHeight Maximum height, updated with the processed samples
+ */
+void processRasterHeights( const float* in, float* out, std::size_t n,
+                           const RasterHeightsProcessingParams& params,
+                           float& minHeight, float& maxHeight ) ;
+
+/**
+ * @brief Scalar version of processRasterHeights, always available (used as fallback and as reference)
+ */
+void processRasterHeightsScalar( const float* in, float* out, std::size_t n,
+                                 const RasterHeightsProcessingParams& params,
+                                 float& minHeight, float& maxHeight ) ;
+
+/**
+ * @brief Check if processRasterHeights was compiled using SIMD instructions
+ */
+bool processRasterHeightsIsVectorized() ;
+
+#endif //EMODNET_QMGC_RASTER_HEIGHTS_PROCESSING_H
@@ -0,0 +1,128 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_TILE_WORKERS_H
+#define EMODNET_QMGC_TILE_WORKERS_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class TileWorkers
+ * @brief Set of persistent threads, each one running the tasks submitted to it in order.
+ *
+ * The pyramid builder runs all the tiles of tiler i in worker i. Thus, the per-thread state of the TIN creation (the
+ * free lists of ThreadPoolAllocator and the buffers of the grid triangulation) lives as long as the workers, instead of
+ * being released after each tile as it happens when each tile is run in a new thread (e.g., with std::async).
+ */
+class TileWorkers
+{
+public:
+    /// Starts the workers
+    explicit TileWorkers( const int& numWorkers )
+    {
+        for ( int i = 0; i < std::max( numWorkers, 1 ); i++ ) {
+            m_workers.push_back( std::unique_ptr<Worker>( new Worker ) ) ;
+            m_workers.back()->thread = std::thread( &TileWorkers::run, m_workers.back().get() ) ;
+        }
+    }
+
+    /// Waits for the tasks already submitted and stops the workers
+    ~TileWorkers()
+    {
+        for ( std::size_t i = 0; i < m_workers.size(); i++ ) {
+            {
+                std::lock_guard<std::mutex> lock( m_workers[i]->mutex ) ;
+                m_workers[i]->stop = true ;
+            }
+            m_workers[i]->cv.notify_one() ;
+        }
+        for ( std::size_t i = 0; i < m_workers.size(); i++ )
+            m_workers[i]->thread.join() ;
+    }
+
+    /// Number of workers
+    int size() const { return (int)m_workers.size() ; }
+
+    /**
+     * @brief Runs a task in a given worker, after the ones already submitted to it
+     * @param worker Index of the worker
+     * @param f Function to call, without arguments
+     * @return The future result of the task. As with std::async, the exceptions thrown by the task are rethrown by get()
+     */
+    template <class Function>
+    std::future<typename std::result_of<Function()>::type> submit( const int& worker, Function f )
+    {
+        typedef typename std::result_of<Function()>::type Result ;
+        std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>( std::move( f ) ) ;
+        std::future<Result> result = task->get_future() ;
+
+        Worker& w = *m_workers[worker % m_workers.size()] ;
+        {
+            std::lock_guard<std::mutex> lock( w.mutex ) ;
+            w.tasks.push_back( [task]() { (*task)() ; } ) ;
+        }
+        w.cv.notify_one() ;
+
+        return result ;
+    }
+
+private:
+    struct Worker {
+        std::thread thread ;
+        std::mutex mutex ;
+        std::condition_variable cv ;
+        std::deque<std::function<void()>> tasks ;
+        bool stop = false ;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers ;
+
+    /// Main loop of a worker
+    static void run( Worker* w )
+    {
+        for (;;) {
+            std::function<void()> task ;
+            {
+                std::unique_lock<std::mutex> lock( w->mutex ) ;
+                w->cv.wait( lock, [w]() { return w->stop || !w->tasks.empty() ; } ) ;
+                if ( w->tasks.empty() )
+                    return ; // Stopped, and nothing left to do
+                task = std::move( w->tasks.front() ) ;
+                w->tasks.pop_front() ;
+            }
+            task() ;
+        }
+    }
+
+    /// Prevent copies (the threads are not copyable)
+    TileWorkers( const TileWorkers& ) ;
+    TileWorkers& operator=( const TileWorkers& ) ;
+};
+
+#endif //EMODNET_QMGC_TILE_WORKERS_H
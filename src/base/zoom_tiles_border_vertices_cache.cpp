@@ -101,6 +101,16 @@ bool ZoomTilesBorderVerticesCache::getConstrainedBorderVerticesForTile(const int
 
 
 
+void ZoomTilesBorderVerticesCache::setTileSkipped(const int& tileX, const int& tileY)
+{
+    m_mapTileToBorderVertices.erase( std::make_pair( tileX, tileY ) ) ;
+    setVisited(tileX, tileY, true);
+    m_numProcessedTiles++ ;
+    setBeingProcessed(tileX, tileY, false);
+}
+
+
+
 bool ZoomTilesBorderVerticesCache::setConstrainedBorderVerticesForTile(const int& tileX, const int& tileY,
                                                                        BordersData &bd)
 {
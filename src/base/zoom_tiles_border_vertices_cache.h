@@ -99,6 +99,15 @@ public:
      */
     bool setConstrainedBorderVerticesForTile( const int& tileX, const int& tileY, BordersData& bd ) ;
 
+    /**
+     * Marks a tile as processed without storing any border to preserve for its neighbors (e.g., a tile not generated
+     * because it is empty). Any constraint stored for the tile is discarded.
+     *
+     * @param tileX The X coordinate of the tile
+     * @param tileY The Y coordinate of the tile
+     */
+    void setTileSkipped( const int& tileX, const int& tileY ) ;
+
     /**
      * Get the number of cache entries
      *
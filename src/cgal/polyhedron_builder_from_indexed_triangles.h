@@ -0,0 +1,68 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_POLYHEDRON_BUILDER_FROM_INDEXED_TRIANGLES_H
+#define EMODNET_QMGC_POLYHEDRON_BUILDER_FROM_INDEXED_TRIANGLES_H
+
+#include <vector>
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+
+/**
+ * @class PolyhedronBuilderFromIndexedTriangles
+ * @brief A modifier creating a Polyhedron_3 structure with the incremental builder from a list of vertices and a list
+ * of triangles, each of them defined by the indices of its three vertices (counterclockwise order).
+ */
+template<class HDS, class Point>
+class PolyhedronBuilderFromIndexedTriangles : public CGAL::Modifier_base<HDS> {
+public:
+    const std::vector<Point>& m_vertices ;
+    const std::vector<std::size_t>& m_triangles ;
+
+    /**
+     * Constructor
+     * @param vertices The vertices of the mesh
+     * @param triangles The indices of the vertices of each triangle (3 consecutive indices per triangle)
+     */
+    PolyhedronBuilderFromIndexedTriangles( const std::vector<Point>& vertices,
+                                           const std::vector<std::size_t>& triangles )
+            : m_vertices(vertices), m_triangles(triangles) {}
+
+    void operator()( HDS& hds ) {
+        // Polyhedron_3 incremental builder
+        CGAL::Polyhedron_incremental_builder_3<HDS> B( hds, true );
+        B.begin_surface( m_vertices.size(), m_triangles.size()/3 );
+
+        for ( typename std::vector<Point>::const_iterator it = m_vertices.begin(); it != m_vertices.end(); ++it )
+            B.add_vertex( *it );
+
+        for ( std::size_t i = 0; i+2 < m_triangles.size(); i += 3 ) {
+            B.begin_facet();
+            B.add_vertex_to_facet( m_triangles[i] );
+            B.add_vertex_to_facet( m_triangles[i+1] );
+            B.add_vertex_to_facet( m_triangles[i+2] );
+            B.end_facet();
+        }
+
+        // End the surface
+        B.end_surface();
+    }
+};
+
+#endif //EMODNET_QMGC_POLYHEDRON_BUILDER_FROM_INDEXED_TRIANGLES_H
@@ -21,17 +21,21 @@
 #ifndef EMODNET_QMGC_POLYHEDRON_BUILDER_FROM_PROJECTED_TRIANGULATION_H
 #define EMODNET_QMGC_POLYHEDRON_BUILDER_FROM_PROJECTED_TRIANGULATION_H
 
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+#include <CGAL/Unique_hash_map.h>
+
 /**
  * @class PolyhedronBuilderFromProjectedTriangulation
  * @brief A modifier creating a Polyhedron_3 structure with the incremental builder from a projected triangulation.
  * A "projected triangulation" is a Triangulation_2 with projection traits. That is, the triangulation was made on the plane, but the internal points are 3D.
+ * The triangulation is referenced, not copied, so it must outlive the builder.
  */
 template<class ProjectedTriangulation2, class HDS>
 class PolyhedronBuilderFromProjectedTriangulation : public CGAL::Modifier_base<HDS> {
 public:
     typedef ProjectedTriangulation2 Tri;
 
-    Tri m_dt ;
+    const Tri& m_dt ;
 
     PolyhedronBuilderFromProjectedTriangulation( const Tri &dt ) : m_dt(dt) {}
 
@@ -43,13 +47,13 @@ public:
         CGAL::Polyhedron_incremental_builder_3<HDS> B( hds, true);
         B.begin_surface( m_dt.number_of_vertices(), m_dt.number_of_faces() );
 
-        std::map<typename Tri::Vertex_handle,int> indices;
+        CGAL::Unique_hash_map<typename Tri::Vertex_handle,int> indices(0, m_dt.number_of_vertices());
         int counter = 0 ;
         for(typename Tri::Finite_vertices_iterator it = m_dt.finite_vertices_begin();
             it != m_dt.finite_vertices_end(); ++it)
         {
             B.add_vertex( it->point() );
-            indices.insert(std::pair<typename Tri::Vertex_handle,int>(it, counter++));
+            indices[it] = counter++;
         }
 
         for(typename Tri::Finite_faces_iterator it = m_dt.finite_faces_begin();
@@ -0,0 +1,118 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_SURFACE_MESH_CONSTRAINT_MAPS_H
+#define EMODNET_QMGC_SURFACE_MESH_CONSTRAINT_MAPS_H
+
+#include <cmath>
+#include <boost/foreach.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <CGAL/boost/graph/properties.h>
+#include <CGAL/boost/graph/helpers.h>
+
+
+/**
+ * @brief Mark the border edges of a tile that must be preserved when simplifying it.
+ *
+ * Port of BorderEdgesAreConstrainedEdgeMap for index-based meshes (e.g., CGAL::Surface_mesh): the same criterion is
+ * evaluated once per edge and stored in a writable property map, so that the simplification just reads a flag from an
+ * array instead of looking at the geometry of the edge each time.
+ *
+ * @param sm The mesh of the tile, in u/v/h coordinates
+ * @param isConstrained Edge property map where the flags are stored (it should be initialized to false)
+ * @param constrainEastBorder Constrain the edges in the eastern border (u = 1)
+ * @param constrainWestBorder Constrain the edges in the western border (u = 0)
+ * @param constrainNorthBorder Constrain the edges in the northern border (v = 1)
+ * @param constrainSouthBorder Constrain the edges in the southern border (v = 0)
+ * @return The number of constrained edges
+ */
+template <class SurfaceMesh, class EdgeIsConstrainedMap>
+std::size_t markConstrainedBorderEdges( const SurfaceMesh& sm,
+                                        EdgeIsConstrainedMap isConstrained,
+                                        const bool& constrainEastBorder,
+                                        const bool& constrainWestBorder,
+                                        const bool& constrainNorthBorder,
+                                        const bool& constrainSouthBorder )
+{
+    typedef typename boost::graph_traits<SurfaceMesh>::halfedge_descriptor halfedge_descriptor;
+    typedef typename boost::property_map<SurfaceMesh, CGAL::vertex_point_t>::const_type VertexPointMap;
+    typedef typename boost::property_traits<VertexPointMap>::value_type Point_3;
+
+    std::size_t numConstrained = 0;
+    if ( !constrainEastBorder && !constrainWestBorder && !constrainNorthBorder && !constrainSouthBorder )
+        return numConstrained;
+
+    VertexPointMap vpm = get( CGAL::vertex_point, sm );
+    BOOST_FOREACH( halfedge_descriptor h, halfedges(sm) ) {
+        if ( !CGAL::is_border(h, sm) )
+            continue;
+
+        const Point_3& p0 = get( vpm, target(h, sm) );
+        const Point_3& p1 = get( vpm, source(h, sm) );
+
+        double diffX = fabs( p1.x() - p0.x() );
+        double diffY = fabs( p1.y() - p0.y() );
+
+        if ( ( constrainEastBorder && diffX < diffY && p0.x() > 0.5 ) ||
+             ( constrainWestBorder && diffX < diffY && p0.x() < 0.5 ) ||
+             ( constrainNorthBorder && diffY < diffX && p0.y() > 0.5 ) ||
+             ( constrainSouthBorder && diffY < diffX && p0.y() < 0.5 ) ) {
+            put( isConstrained, edge(h, sm), true );
+            numConstrained++;
+        }
+    }
+
+    return numConstrained;
+}
+
+
+
+/**
+ * @struct TileCornerVerticesAreConstrainedVertexMap
+ *
+ * @brief BGL property map indicating whether a given vertex is one of the 4 corners of the tile.
+ *
+ * Index-based counterpart of CornerVerticesAreConstrainedVertexMap. The corners are identified by their position (u and
+ * v in {0, 1}) instead of by the topology of the border around them, which only needs a read from the point array. Since
+ * the placement of an edge containing a corner is the corner itself, this flag moves with the corner point regardless
+ * of which vertex of the edge the collapse keeps, which a flag stored per vertex would not.
+ */
+template <class VertexPointMap>
+struct TileCornerVerticesAreConstrainedVertexMap
+{
+    typedef typename boost::property_traits<VertexPointMap>::key_type key_type;
+    typedef bool value_type;
+    typedef value_type reference;
+    typedef boost::readable_property_map_tag category;
+
+    VertexPointMap m_vpm;
+
+    TileCornerVerticesAreConstrainedVertexMap( const VertexPointMap& vpm = VertexPointMap() ) : m_vpm(vpm) {}
+
+    friend bool get( const TileCornerVerticesAreConstrainedVertexMap& m, const key_type& vertex )
+    {
+        const double u = get( m.m_vpm, vertex ).x();
+        const double v = get( m.m_vpm, vertex ).y();
+        return ( u == 0.0 || u == 1.0 ) && ( v == 0.0 || v == 1.0 );
+    }
+};
+
+#endif //EMODNET_QMGC_SURFACE_MESH_CONSTRAINT_MAPS_H
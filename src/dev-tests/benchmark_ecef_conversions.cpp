@@ -0,0 +1,113 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <GeographicLib/Geocentric.hpp>
+#include "base/crs_conversions.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+
+
+int main ( int argc, char **argv)
+{
+    // Parse input parameters
+    int numSteps, numIterations ;
+    double minLon, minLat, tileSize ;
+    po::options_description options("Benchmarks the geodetic to ECEF conversion of the vertices of a tile (GeographicLib::Geocentric point by point vs. the batched converter) on synthetic data");
+    options.add_options()
+            ("help,h", "Produce help message")
+            ("steps", po::value<int>(&numSteps)->default_value(256),
+             "Heightmap sampling steps (i.e., the tile contains steps x steps samples)")
+            ("iterations", po::value<int>(&numIterations)->default_value(200),
+             "Number of tiles to process for each version")
+            ("min-lon", po::value<double>(&minLon)->default_value(2.8125),
+             "Longitude of the western border of the tile (in degrees)")
+            ("min-lat", po::value<double>(&minLat)->default_value(39.375),
+             "Latitude of the southern border of the tile (in degrees)")
+            ("tile-size", po::value<double>(&tileSize)->default_value(1.40625),
+             "Size of the tile (in degrees)");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        cout << options << "\n";
+        return 1;
+    }
+
+    // Synthetic tile, with the vertices in the same order as in QuantizedMeshTiler (column by column)
+    std::mt19937 rng(42) ;
+    std::uniform_real_distribution<double> heightDist(-3000.0, 1500.0) ;
+    std::size_t n = numSteps*numSteps ;
+    std::vector<double> lons, lats, heights ;
+    lons.reserve(n) ;
+    lats.reserve(n) ;
+    heights.reserve(n) ;
+    for ( int i = 0; i < numSteps; i++ ) {
+        for ( int j = 0; j < numSteps; j++ ) {
+            lons.push_back( minLon + tileSize * i / (numSteps-1) ) ;
+            lats.push_back( std::min( minLat + tileSize * j / (numSteps-1), 90.0 ) ) ;
+            heights.push_back( heightDist(rng) ) ;
+        }
+    }
+
+    cout << "Vectorized kernel: " << ( crs_conversions::GeodeticECEFConverter::isVectorized() ? "yes" : "no" ) << endl ;
+
+    // GeographicLib
+    std::vector<double> xRef(n), yRef(n), zRef(n) ;
+    GeographicLib::Geocentric earth(GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f()) ;
+    auto start = std::chrono::high_resolution_clock::now() ;
+    for ( int it = 0; it < numIterations; it++ ) {
+        for ( std::size_t k = 0; k < n; k++ )
+            earth.Forward( lats[k], lons[k], heights[k], xRef[k], yRef[k], zRef[k] ) ;
+    }
+    double legacyMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    // Batched converter (the same instance is reused between tiles, as done in QuantizedMeshTiler)
+    std::vector<double> x(n), y(n), z(n) ;
+    crs_conversions::GeodeticECEFConverter converter ;
+    start = std::chrono::high_resolution_clock::now() ;
+    for ( int it = 0; it < numIterations; it++ )
+        converter.geodeticToECEF( lons.data(), lats.data(), heights.data(), n, x.data(), y.data(), z.data() ) ;
+    double kernelMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    // Check that both versions agree
+    double maxDiff = 0.0 ;
+    for ( std::size_t k = 0; k < n; k++ ) {
+        double d = std::sqrt( (x[k]-xRef[k])*(x[k]-xRef[k]) + (y[k]-yRef[k])*(y[k]-yRef[k]) + (z[k]-zRef[k])*(z[k]-zRef[k]) ) ;
+        maxDiff = std::max( maxDiff, d ) ;
+    }
+
+    cout << "GeographicLib: " << legacyMs / numIterations << " ms/tile (" << n << " points)" << endl ;
+    cout << "Kernel: " << kernelMs / numIterations << " ms/tile (" << n << " points)" << endl ;
+    cout << "Speedup: " << legacyMs / kernelMs << "x" << endl ;
+    cout << "Maximum difference: " << maxDiff << " m" << endl ;
+
+    return maxDiff < 1e-6 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <boost/program_options.hpp>
+#include "tin_creation/tin_creation_cgal_types.h"
+#include "base/raster_heights_processing.h"
+#include "base/misc_utils.h"
+
+using namespace std;
+namespace po = boost::program_options;
+typedef TinCreation::Point_3 Point_3;
+
+
+
+// Per-sample processing + separate min/max and normalization passes, as done in QuantizedMeshTiler before the vectorized kernel
+std::vector<Point_3> legacyUVHPoints( const std::vector<float>& rasterHeights, const int& n,
+                                      const RasterHeightsProcessingParams& p, float& minHeight, float& maxHeight )
+{
+    std::vector<Point_3> heightMapPoints ;
+    for ( int i = 0; i < n; i++ ) {
+        for ( int j = 0; j < n; j++ ) {
+            int y = n - 1 - j;
+            float height = rasterHeights[j * n + i];
+            if (p.ignoreNoData && height == p.noDataValue)
+                continue;
+            height = std::max(p.clippingLowValue, std::min(height, p.clippingHighValue));
+            if ( height == p.noDataValue )
+                height = 0 ;
+            if ( p.isBathymetry )
+                height = -height ;
+            if (height < 0 && p.belowSeaLevelScaleFactor > 0)
+                height *= p.belowSeaLevelScaleFactor;
+            else if (height > 0 && p.aboveSeaLevelScaleFactor > 0)
+                height *= p.aboveSeaLevelScaleFactor;
+            heightMapPoints.push_back(Point_3(i, y, height));
+        }
+    }
+
+    minHeight =  std::numeric_limits<float>::infinity() ;
+    maxHeight = -std::numeric_limits<float>::infinity() ;
+    for ( std::vector<Point_3>::iterator it = heightMapPoints.begin(); it != heightMapPoints.end(); ++it ) {
+        if (it->z() < minHeight)
+            minHeight = it->z();
+        if (it->z() > maxHeight)
+            maxHeight = it->z();
+    }
+
+    std::vector< Point_3 > uvhPts ;
+    for ( std::vector<Point_3>::iterator it = heightMapPoints.begin(); it != heightMapPoints.end(); ++it ) {
+        double u = remap( it->x(), 0.0, n-1, 0.0, 1.0 ) ;
+        double v = remap( it->y(), 0.0, n-1, 0.0, 1.0 ) ;
+        double h = remap( it->z(), minHeight, maxHeight, 0.0, 1.0 ) ;
+        uvhPts.push_back( Point_3( u, v, h ) ) ;
+    }
+    return uvhPts ;
+}
+
+
+
+// Fused kernel over a reused buffer + single normalization pass, as currently done in QuantizedMeshTiler
+std::vector<Point_3> kernelUVHPoints( const std::vector<float>& rasterHeights, std::vector<float>& buffer, const int& n,
+                                      const RasterHeightsProcessingParams& p, float& minHeight, float& maxHeight )
+{
+    buffer.assign( rasterHeights.begin(), rasterHeights.end() ) ;
+
+    minHeight =  std::numeric_limits<float>::infinity() ;
+    maxHeight = -std::numeric_limits<float>::infinity() ;
+    processRasterHeights( buffer.data(), buffer.data(), buffer.size(), p, minHeight, maxHeight ) ;
+
+    std::vector< Point_3 > uvhPts ;
+    uvhPts.reserve( buffer.size() ) ;
+    for ( int i = 0; i < n; i++ ) {
+        double u = remap( i, 0.0, n-1, 0.0, 1.0 ) ;
+        for ( int j = 0; j < n; j++ ) {
+            float height = buffer[j * n + i] ;
+            if ( p.ignoreNoData && std::isnan(height) )
+                continue ;
+            double v = remap( n - 1 - j, 0.0, n-1, 0.0, 1.0 ) ;
+            double h = remap( height, minHeight, maxHeight, 0.0, 1.0 ) ;
+            uvhPts.push_back( Point_3( u, v, h ) ) ;
+        }
+    }
+    return uvhPts ;
+}
+
+
+
+int main ( int argc, char **argv)
+{
+    // Parse input parameters
+    int numSteps, numIterations ;
+    float noDataRatio ;
+    bool ignoreNoData, isBathymetry ;
+    po::options_description options("Benchmarks the preprocessing of the heights read from the raster for each tile (legacy per-sample loop vs. the fused kernel) on synthetic data");
+    options.add_options()
+            ("help,h", "Produce help message")
+            ("steps", po::value<int>(&numSteps)->default_value(256),
+             "Heightmap sampling steps (i.e., the tile contains steps x steps samples)")
+            ("iterations", po::value<int>(&numIterations)->default_value(200),
+             "Number of tiles to process for each version")
+            ("no-data-ratio", po::value<float>(&noDataRatio)->default_value(0.1f),
+             "Ratio of no data samples in the synthetic raster")
+            ("ignore-no-data", po::bool_switch(&ignoreNoData),
+             "Skip the no data samples")
+            ("bathymetry", po::bool_switch(&isBathymetry),
+             "Consider the input data as bathymetry");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        cout << options << "\n";
+        return 1;
+    }
+
+    RasterHeightsProcessingParams params ;
+    params.noDataValue = -9999.0 ;
+    params.ignoreNoData = ignoreNoData ;
+    params.isBathymetry = isBathymetry ;
+    params.clippingLowValue = -5000.0f ;
+    params.belowSeaLevelScaleFactor = 2.0f ;
+
+    // Synthetic raster
+    std::mt19937 rng(42) ;
+    std::uniform_real_distribution<float> heightDist(-3000.0f, 1500.0f) ;
+    std::uniform_real_distribution<float> unitDist(0.0f, 1.0f) ;
+    std::vector<float> rasterHeights( numSteps*numSteps ) ;
+    for ( std::size_t k = 0; k < rasterHeights.size(); k++ )
+        rasterHeights[k] = unitDist(rng) < noDataRatio ? (float)params.noDataValue : heightDist(rng) ;
+
+    cout << "Vectorized kernel: " << ( processRasterHeightsIsVectorized() ? "yes" : "no" ) << endl ;
+
+    // Legacy
+    float minLegacy = 0, maxLegacy = 0 ;
+    std::size_t numPtsLegacy = 0 ;
+    auto start = std::chrono::high_resolution_clock::now() ;
+    for ( int it = 0; it < numIterations; it++ ) {
+        std::vector<Point_3> pts = legacyUVHPoints( rasterHeights, numSteps, params, minLegacy, maxLegacy ) ;
+        numPtsLegacy = pts.size() ;
+    }
+    double legacyMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    // Kernel
+    float minKernel = 0, maxKernel = 0 ;
+    std::size_t numPtsKernel = 0 ;
+    std::vector<float> buffer ;
+    start = std::chrono::high_resolution_clock::now() ;
+    for ( int it = 0; it < numIterations; it++ ) {
+        std::vector<Point_3> pts = kernelUVHPoints( rasterHeights, buffer, numSteps, params, minKernel, maxKernel ) ;
+        numPtsKernel = pts.size() ;
+    }
+    double kernelMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    // Check that both versions agree
+    std::vector<Point_3> ptsLegacy = legacyUVHPoints( rasterHeights, numSteps, params, minLegacy, maxLegacy ) ;
+    std::vector<Point_3> ptsKernel = kernelUVHPoints( rasterHeights, buffer, numSteps, params, minKernel, maxKernel ) ;
+    bool equal = ptsLegacy == ptsKernel && minLegacy == minKernel && maxLegacy == maxKernel ;
+
+    cout << "Legacy: " << legacyMs / numIterations << " ms/tile (" << numPtsLegacy << " points)" << endl ;
+    cout << "Kernel: " << kernelMs / numIterations << " ms/tile (" << numPtsKernel << " points)" << endl ;
+    cout << "Speedup: " << legacyMs / kernelMs << "x" << endl ;
+    cout << "Results match: " << ( equal ? "yes" : "NO" ) << endl ;
+
+    return equal ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
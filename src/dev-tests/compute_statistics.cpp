@@ -46,8 +46,6 @@
 // Boost
 #include <boost/program_options.hpp>
 #include <boost/foreach.hpp>
-// GeographicLib
-#include <GeographicLib/Geocentric.hpp>
 // OpenMP
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -183,28 +181,32 @@ void computeErrorsInECEF(const QuantizedMeshTile& qmt, const Delaunay& dtRaster,
     // Translate to a surface mesh
     SurfaceMesh meshRaster = surfaceMeshFromProjectedTriangulation<Delaunay, SurfaceMesh>(dtRaster);
 
-    GeographicLib::Geocentric earth(GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f());
+    crs_conversions::GeodeticECEFConverter ecefConverter;
 
     // Transform vertices to ECEF (preserve connectivity)
-    std::vector<Point_3> ptsRaster;
+    std::size_t numRasterVertices = meshRaster.number_of_vertices();
+    std::vector<double> lons, lats, heights;
+    lons.reserve(numRasterVertices);
+    lats.reserve(numRasterVertices);
+    heights.reserve(numRasterVertices);
     BOOST_FOREACH(vertex_descriptor vd, vertices(meshRaster)){
                     Point_3 p = meshRaster.point(vd);
 
                     // From UV to lat/lon (height already in the correct units)
-                    double lat = tileBoundsRaster.getMinY() + fabs(tileBoundsRaster.getMaxY() - tileBoundsRaster.getMinY()) * p.y();
-                    double lon = tileBoundsRaster.getMinX() + fabs(tileBoundsRaster.getMaxX() - tileBoundsRaster.getMinX()) * p.x();
-
-//                    if (lat == tileBoundsRaster.getMaxY())
-//                        std::cout << "Maximum latitude achieved!" << std::endl;
-//                    if (lon == tileBoundsRaster.getMaxX())
-//                        std::cout << "Maximum longitude achieved!" << std::endl;
-
-                    double tmpx, tmpy, tmpz;
-//                    crs_conversions::llh2ecef(lat, lon, p.z(), tmpx, tmpy, tmpz);
-                    earth.Forward(lat, lon, p.z(), tmpx, tmpy, tmpz);
+                    lats.push_back(tileBoundsRaster.getMinY() + fabs(tileBoundsRaster.getMaxY() - tileBoundsRaster.getMinY()) * p.y());
+                    lons.push_back(tileBoundsRaster.getMinX() + fabs(tileBoundsRaster.getMaxX() - tileBoundsRaster.getMinX()) * p.x());
+                    heights.push_back(p.z());
+                }
+    std::vector<double> xs(lons.size()), ys(lons.size()), zs(lons.size());
+    ecefConverter.geodeticToECEF(lons.data(), lats.data(), heights.data(), lons.size(), xs.data(), ys.data(), zs.data());
 
-                    meshRaster.point(vd) = Point_3(tmpx, tmpy, tmpz);
-                    ptsRaster.push_back(Point_3(tmpx, tmpy, tmpz));
+    std::vector<Point_3> ptsRaster;
+    ptsRaster.reserve(lons.size());
+    std::size_t k = 0;
+    BOOST_FOREACH(vertex_descriptor vd, vertices(meshRaster)){
+                    meshRaster.point(vd) = Point_3(xs[k], ys[k], zs[k]);
+                    ptsRaster.push_back(Point_3(xs[k], ys[k], zs[k]));
+                    k++;
                 }
     // --- Debug (begin) ---
 //    ofstream ofMeshRaster("mesh_raster.off");
@@ -217,22 +219,21 @@ void computeErrorsInECEF(const QuantizedMeshTile& qmt, const Delaunay& dtRaster,
     // --> TIN mesh
     SurfaceMesh meshTin;
     std::map<int, SurfaceMesh::Vertex_index> indToVertIndMap;
+    lons.resize(vertexData.vertexCount);
+    lats.resize(vertexData.vertexCount);
+    heights.resize(vertexData.vertexCount);
     for ( int i = 0; i < vertexData.vertexCount; i++ ) {
-        double lat, lon, height;
-//        qmt.convertUVHToLonLatHeight(vertexData.u[i], vertexData.v[i], vertexData.height[i], lon, lat, height );
-
-        lon = tileBoundsTIN.getMinX() + fabs( tileBoundsTIN.getMaxX() - tileBoundsTIN.getMinX() ) * (double)vertexData.u[i]/(double)QuantizedMesh::MAX_VERTEX_DATA ;
-        lat = tileBoundsTIN.getMinY() + fabs( tileBoundsTIN.getMaxY() - tileBoundsTIN.getMinY() ) * (double)vertexData.v[i]/(double)QuantizedMesh::MAX_VERTEX_DATA ;
-        height = qmt.getHeader().MinimumHeight + fabs( qmt.getHeader().MaximumHeight - qmt.getHeader().MinimumHeight ) * (double)vertexData.height[i]/(double)QuantizedMesh::MAX_VERTEX_DATA ;
-
-//        double tmpx, tmpy, tmpz;
-//        crs_conversions::llh2ecef(lat, lon, height, tmpx, tmpy, tmpz);
-
-
-        double tmpx, tmpy, tmpz;
-        earth.Forward(lat, lon, height, tmpx, tmpy, tmpz);
+        lons[i] = tileBoundsTIN.getMinX() + fabs( tileBoundsTIN.getMaxX() - tileBoundsTIN.getMinX() ) * (double)vertexData.u[i]/(double)QuantizedMesh::MAX_VERTEX_DATA ;
+        lats[i] = tileBoundsTIN.getMinY() + fabs( tileBoundsTIN.getMaxY() - tileBoundsTIN.getMinY() ) * (double)vertexData.v[i]/(double)QuantizedMesh::MAX_VERTEX_DATA ;
+        heights[i] = qmt.getHeader().MinimumHeight + fabs( qmt.getHeader().MaximumHeight - qmt.getHeader().MinimumHeight ) * (double)vertexData.height[i]/(double)QuantizedMesh::MAX_VERTEX_DATA ;
+    }
+    xs.resize(vertexData.vertexCount);
+    ys.resize(vertexData.vertexCount);
+    zs.resize(vertexData.vertexCount);
+    ecefConverter.geodeticToECEF(lons.data(), lats.data(), heights.data(), lons.size(), xs.data(), ys.data(), zs.data());
 
-        SurfaceMesh::Vertex_index vi = meshTin.add_vertex(Point_3(tmpx, tmpy, tmpz));
+    for ( int i = 0; i < vertexData.vertexCount; i++ ) {
+        SurfaceMesh::Vertex_index vi = meshTin.add_vertex(Point_3(xs[i], ys[i], zs[i]));
         indToVertIndMap.insert(std::pair<int, SurfaceMesh::Vertex_index>(i, vi));
     }
     QuantizedMeshTile::IndexData triIndices = qmt.getIndexData();
@@ -0,0 +1,221 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <gdal_priv.h>
+#include <ogr_spatialref.h>
+#include <ctb.hpp>
+#include "quantized_mesh_tiler.h"
+#include "quantized_mesh_tiles_pyramid_builder.h"
+#include "zoom_tiles_scheduler.h"
+#include "tin_creation/tin_creator.h"
+#include "tin_creation/tin_creation_delaunay_strategy.h"
+#include "tin_creation/tin_creation_greedy_insertion_strategy.h"
+#include "tin_creation/tin_creation_rtin_strategy.h"
+#include "tin_creation/tin_creation_simplification_lindstrom_turk_strategy.h"
+#include "tin_creation/tin_creation_simplification_meshopt_strategy.h"
+
+using namespace std;
+using namespace TinCreation;
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+
+
+// Count all the allocations going through operator new (from all the threads)
+static std::atomic<std::size_t> g_numAllocations(0);
+static std::atomic<std::size_t> g_allocatedBytes(0);
+
+void* operator new(std::size_t size)
+{
+    g_numAllocations++;
+    g_allocatedBytes += size;
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+
+
+
+// In-memory geographic (WGS84) raster with a synthetic terrain: a few waves plus some noise
+GDALDataset* createSyntheticDataset(const int& size, const double& extent)
+{
+    GDALDriver* memDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+    GDALDataset* dataset = memDriver->Create("", size, size, 1, GDT_Float32, NULL);
+    if (dataset == NULL)
+        return NULL;
+
+    const double pixelSize = extent/size;
+    double geoTransform[6] = { 0.0, pixelSize, 0.0, extent, 0.0, -pixelSize };
+    dataset->SetGeoTransform(geoTransform);
+    OGRSpatialReference srs;
+    srs.SetWellKnownGeogCS("WGS84");
+    char* wkt = NULL;
+    srs.exportToWkt(&wkt);
+    dataset->SetProjection(wkt);
+    CPLFree(wkt);
+
+    std::vector<float> row(size);
+    for (int r = 0; r < size; r++) {
+        for (int c = 0; c < size; c++) {
+            double x = (double)c/size*extent, y = (double)r/size*extent;
+            row[c] = (float)(-1500.0 + 400.0*std::sin(3.0*x + 1.0)*std::cos(2.0*y) + 150.0*std::sin(11.0*x*y) +
+                             2.0*std::sin(197.0*x)*std::sin(173.0*y));
+        }
+        if (dataset->GetRasterBand(1)->RasterIO(GF_Write, 0, r, size, 1, row.data(), size, 1, GDT_Float32, 0, 0) != CE_None) {
+            GDALClose(dataset);
+            return NULL;
+        }
+    }
+
+    return dataset;
+}
+
+
+
+std::shared_ptr<TinCreationStrategy> createStrategy(const std::string& strategy, const double& errorTol, const int& stopEdgesCount)
+{
+    if (strategy.compare("greedy") == 0)
+        return std::make_shared<TinCreationGreedyInsertionStrategy>(std::vector<FT>{errorTol});
+    else if (strategy.compare("rtin") == 0)
+        return std::make_shared<TinCreationRtinStrategy>(std::vector<FT>{errorTol});
+    else if (strategy.compare("lt") == 0)
+        return std::make_shared<TinCreationSimplificationLindstromTurkStrategy>(std::vector<int>{stopEdgesCount});
+    else if (strategy.compare("meshopt") == 0)
+        return std::make_shared<TinCreationSimplificationMeshoptStrategy>(std::vector<int>{stopEdgesCount});
+    else if (strategy.compare("delaunay") == 0)
+        return std::make_shared<TinCreationDelaunayStrategy>();
+    return std::shared_ptr<TinCreationStrategy>();
+}
+
+
+
+int main ( int argc, char **argv)
+{
+    // Parse input parameters
+    std::string strategy;
+    int numThreads, zoom, numPasses;
+    double extent, errorTol;
+    int stopEdgesCount;
+    po::options_description options("Counts the memory allocations done per tile when creating a zoom of the pyramid with QuantizedMeshTilesPyramidBuilder, on a synthetic raster. The zoom is created several times with the same builder: after the first pass, the memory reused between tiles (per thread) should keep this number low");
+    options.add_options()
+            ("help,h", "Produce help message")
+            ("strategy", po::value<std::string>(&strategy)->default_value("greedy"),
+             "TIN creation strategy. OPTIONS: greedy, rtin, lt, meshopt, delaunay")
+            ("num-threads", po::value<int>(&numThreads)->default_value(4),
+             "Number of threads (i.e., tilers)")
+            ("zoom", po::value<int>(&zoom)->default_value(8),
+             "Zoom of the pyramid to create")
+            ("extent", po::value<double>(&extent)->default_value(4.0),
+             "Size of the synthetic raster, in degrees (its resolution is the one of the tiles at the zoom)")
+            ("passes", po::value<int>(&numPasses)->default_value(3),
+             "Number of times the zoom is created")
+            ("error-tol", po::value<double>(&errorTol)->default_value(10.0),
+             "Error tolerance, in meters, for the greedy and rtin strategies")
+            ("stop-edges-count", po::value<int>(&stopEdgesCount)->default_value(500),
+             "Number of edges to stop at, for the lt and meshopt strategies");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        cout << options << "\n";
+        return 1;
+    }
+    numThreads = std::max(numThreads, 1);
+
+    GDALAllRegister();
+
+    // Geodetic profile, the resolution of the raster is the one of the tiles at the zoom
+    const int tileSize = 256;
+    const int rasterSize = (int)std::ceil(extent/(180.0/std::pow(2.0, zoom))*tileSize);
+
+    fs::path outDir = fs::temp_directory_path() / fs::unique_path("count_pyramid_allocations_%%%%-%%%%");
+    std::vector<GDALDataset*> datasets;
+    {
+        // As in qm_tiler, a dataset, a tiler and a TIN creation strategy per thread
+        std::vector<QuantizedMeshTiler> tilers;
+        for (int i = 0; i < numThreads; i++) {
+            datasets.push_back(createSyntheticDataset(rasterSize, extent));
+            if (datasets.back() == NULL) {
+                cerr << "[ERROR] Could not create the synthetic raster" << endl;
+                return 1;
+            }
+
+            std::shared_ptr<TinCreationStrategy> tcStrategy = createStrategy(strategy, errorTol, stopEdgesCount);
+            if (!tcStrategy) {
+                cerr << "[ERROR] Unknown TIN creation strategy \"" << strategy << "\"" << endl;
+                return 1;
+            }
+            TinCreator tinCreator;
+            tinCreator.setCreator(tcStrategy, strategy);
+
+            QuantizedMeshTiler::QMTOptions qmtOptions;
+            qmtOptions.IsBathymetry = true;
+            tilers.push_back(QuantizedMeshTiler(datasets.back(), ctb::GlobalGeodetic(tileSize), ctb::TilerOptions(),
+                                                qmtOptions, tinCreator));
+        }
+
+        ZoomTilesScheduler scheduler;
+        scheduler.setScheduler(std::make_shared<ZoomTilesSchedulerRowwiseStrategy>());
+        QuantizedMeshTilesPyramidBuilder builder(tilers, scheduler);
+
+        std::vector<std::size_t> passAllocations, passBytes;
+        for (int p = 0; p < numPasses; p++) {
+            std::size_t allocationsBefore = g_numAllocations, bytesBefore = g_allocatedBytes;
+            builder.createTmsPyramid(zoom, zoom, outDir.string());
+            passAllocations.push_back(g_numAllocations - allocationsBefore);
+            passBytes.push_back(g_allocatedBytes - bytesBefore);
+        }
+
+        // The tiles created in each pass
+        std::size_t numTiles = 0;
+        for (fs::recursive_directory_iterator it(outDir), end; it != end; ++it)
+            numTiles += it->path().extension() == ".terrain";
+
+        cout << "Strategy: " << strategy << ", threads: " << numThreads << ", tiles per pass: " << numTiles << endl;
+        for (int p = 0; p < numPasses && numTiles > 0; p++) {
+            cout << "Pass " << p << ": average allocations per tile = " << (double)passAllocations[p]/numTiles
+                 << " (" << (double)passBytes[p]/numTiles/1024.0 << " KiB)" << endl;
+        }
+    }
+
+    for (std::size_t i = 0; i < datasets.size(); i++)
+        GDALClose(datasets[i]);
+    fs::remove_all(outDir);
+
+    return 0;
+}
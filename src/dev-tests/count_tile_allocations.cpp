@@ -0,0 +1,171 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+#include <new>
+#include <boost/program_options.hpp>
+#include "tin_creation/tin_creator.h"
+#include "tin_creation/tin_creation_delaunay_strategy.h"
+#include "tin_creation/tin_creation_greedy_insertion_strategy.h"
+#include "tin_creation/tin_creation_rtin_strategy.h"
+#include "tin_creation/tin_creation_simplification_lindstrom_turk_strategy.h"
+#include "tin_creation/tin_creation_simplification_meshopt_strategy.h"
+
+using namespace std;
+using namespace TinCreation;
+namespace po = boost::program_options;
+
+
+
+// Count all the allocations going through operator new
+static std::atomic<std::size_t> g_numAllocations(0);
+static std::atomic<std::size_t> g_allocatedBytes(0);
+
+void* operator new(std::size_t size)
+{
+    g_numAllocations++;
+    g_allocatedBytes += size;
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+
+
+
+// Synthetic terrain for a tile: a few waves plus some noise, different for each tile
+void syntheticTileHeights(const int& n, const int& tile, std::vector<float>& heights, float& minHeight, float& maxHeight)
+{
+    std::mt19937 rng(tile);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+    heights.resize(n*n);
+    minHeight = std::numeric_limits<float>::infinity();
+    maxHeight = -std::numeric_limits<float>::infinity();
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            double x = (double)(c + tile*(n-1))/(n-1), y = (double)r/(n-1);
+            float h = (float)(-1500.0 + 400.0*std::sin(3.0*x + 1.0)*std::cos(2.0*y) + 150.0*std::sin(11.0*x*y)) + noise(rng);
+            heights[r*n + c] = h;
+            minHeight = std::min(minHeight, h);
+            maxHeight = std::max(maxHeight, h);
+        }
+    }
+}
+
+
+
+int main ( int argc, char **argv)
+{
+    // Parse input parameters
+    std::string strategy;
+    int numSteps, numTiles, zoom;
+    double errorTol;
+    int stopEdgesCount;
+    po::options_description options("Counts the memory allocations done to create the TIN of each tile, on synthetic data. After the first tiles, the buffers reused between tiles should keep this number low");
+    options.add_options()
+            ("help,h", "Produce help message")
+            ("strategy", po::value<std::string>(&strategy)->default_value("greedy"),
+             "TIN creation strategy. OPTIONS: greedy, rtin, lt, meshopt, delaunay")
+            ("steps", po::value<int>(&numSteps)->default_value(256),
+             "Heightmap sampling steps (i.e., the tile contains steps x steps samples)")
+            ("tiles", po::value<int>(&numTiles)->default_value(20),
+             "Number of tiles to create")
+            ("zoom", po::value<int>(&zoom)->default_value(10),
+             "Zoom of the tiles (only their geographic size depends on it)")
+            ("error-tol", po::value<double>(&errorTol)->default_value(10.0),
+             "Error tolerance, in meters, for the greedy and rtin strategies")
+            ("stop-edges-count", po::value<int>(&stopEdgesCount)->default_value(500),
+             "Number of edges to stop at, for the lt and meshopt strategies");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        cout << options << "\n";
+        return 1;
+    }
+
+    std::shared_ptr<TinCreationStrategy> tcStrategy;
+    if (strategy.compare("greedy") == 0)
+        tcStrategy = std::make_shared<TinCreationGreedyInsertionStrategy>(std::vector<FT>{errorTol});
+    else if (strategy.compare("rtin") == 0)
+        tcStrategy = std::make_shared<TinCreationRtinStrategy>(std::vector<FT>{errorTol});
+    else if (strategy.compare("lt") == 0)
+        tcStrategy = std::make_shared<TinCreationSimplificationLindstromTurkStrategy>(std::vector<int>{stopEdgesCount});
+    else if (strategy.compare("meshopt") == 0)
+        tcStrategy = std::make_shared<TinCreationSimplificationMeshoptStrategy>(std::vector<int>{stopEdgesCount});
+    else if (strategy.compare("delaunay") == 0)
+        tcStrategy = std::make_shared<TinCreationDelaunayStrategy>();
+    else {
+        cerr << "[ERROR] Unknown TIN creation strategy \"" << strategy << "\"" << endl;
+        return 1;
+    }
+
+    TinCreator tinCreator;
+    tinCreator.setCreator(tcStrategy, strategy);
+    tinCreator.setParamsForZoom(zoom);
+
+    // Geographic size of the tile at this zoom (geodetic profile), at the equator
+    const double tileSize = 180.0/std::pow(2.0, zoom);
+
+    std::vector<float> heights;
+    IndexedMesh mesh; // Reused between tiles, as in QuantizedMeshTiler
+    std::size_t firstAllocations = 0, steadyAllocations = 0, steadyBytes = 0, numVertices = 0;
+    for (int t = 0; t < numTiles; t++) {
+        float minHeight, maxHeight;
+        syntheticTileHeights(numSteps, t, heights, minHeight, maxHeight);
+
+        std::size_t allocationsBefore = g_numAllocations, bytesBefore = g_allocatedBytes;
+        {
+            HeightGridView grid(heights.data(), numSteps, numSteps, numSteps, minHeight, maxHeight);
+            tinCreator.setBounds(t*tileSize, 0.0, minHeight, (t+1)*tileSize, tileSize, maxHeight);
+            tinCreator.createIndexedMesh(grid, HeightGridBorders(), mesh);
+            numVertices += mesh.numVertices();
+        }
+        std::size_t allocations = g_numAllocations - allocationsBefore, bytes = g_allocatedBytes - bytesBefore;
+
+        if (t == 0)
+            firstAllocations = allocations;
+        else {
+            steadyAllocations += allocations;
+            steadyBytes += bytes;
+        }
+    }
+
+    cout << "Strategy: " << strategy << endl;
+    cout << "Average vertices per tile: " << (double)numVertices/numTiles << endl;
+    cout << "Allocations in the first tile: " << firstAllocations << endl;
+    if (numTiles > 1) {
+        cout << "Average allocations per tile afterwards: " << (double)steadyAllocations/(numTiles-1)
+             << " (" << (double)steadyBytes/(numTiles-1)/1024.0 << " KiB)" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,400 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "height_field_simplifier.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace TinCreation {
+
+static const unsigned int NoVertex = ~0u;
+static const int NextInTriangle[3] = { 1, 2, 0 };
+
+
+static inline float normalize(float& x, float& y, float& z)
+{
+    const float length = std::sqrt(x*x + y*y + z*z);
+    if (length > 0) {
+        x /= length;
+        y /= length;
+        z /= length;
+    }
+    return length;
+}
+
+
+template <typename Vector3>
+static inline double orient2D(const Vector3& a, const Vector3& b, const Vector3& c)
+{
+    return ((double)b.x - a.x)*((double)c.y - a.y) - ((double)b.y - a.y)*((double)c.x - a.x);
+}
+
+
+template <typename Vector3>
+static inline double squaredDistance2D(const Vector3& a, const Vector3& b)
+{
+    return ((double)b.x - a.x)*((double)b.x - a.x) + ((double)b.y - a.y)*((double)b.y - a.y);
+}
+
+
+template <typename Quadric>
+static inline void quadricFromPlane(Quadric& q, const float& a, const float& b, const float& c, const float& d, const float& weight)
+{
+    q.a00 = (double)(a*a)*weight;
+    q.a10 = (double)(b*a)*weight;
+    q.a11 = (double)(b*b)*weight;
+    q.a20 = (double)(c*a)*weight;
+    q.a21 = (double)(c*b)*weight;
+    q.a22 = (double)(c*c)*weight;
+    q.b0 = (double)(d*a)*weight;
+    q.b1 = (double)(d*b)*weight;
+    q.b2 = (double)(d*c)*weight;
+    q.c = (double)(d*d)*weight;
+}
+
+
+template <typename Quadric>
+static inline void quadricAdd(Quadric& q, const Quadric& r)
+{
+    q.a00 += r.a00;
+    q.a10 += r.a10;
+    q.a11 += r.a11;
+    q.a20 += r.a20;
+    q.a21 += r.a21;
+    q.a22 += r.a22;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+}
+
+
+template <typename Quadric, typename Vector3>
+static inline float quadricError(const Quadric& q, const Vector3& v)
+{
+    const double x = v.x, y = v.y, z = v.z;
+    const double vTQv = q.a00*x*x + q.a10*x*y*2 + q.a11*y*y + q.a20*x*z*2 + q.a21*y*z*2 + q.a22*z*z +
+                        q.b0*x*2 + q.b1*y*2 + q.b2*z*2 + q.c;
+    return (float)std::fabs(vTQv);
+}
+
+
+std::size_t HeightFieldSimplifier::simplify(unsigned int* destination, const unsigned int* indices, const std::size_t& indexCount,
+                                            const float* vertexPositions, const std::size_t& vertexCount,
+                                            const std::size_t& targetIndexCount, const float& targetError,
+                                            const unsigned char* vertexLock, float* resultError)
+{
+    assert(indexCount % 3 == 0);
+    assert(targetIndexCount <= indexCount);
+    assert(targetError >= 0);
+
+    m_positions.resize(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; i++) {
+        m_positions[i].x = vertexPositions[3*i];
+        m_positions[i].y = vertexPositions[3*i+1];
+        m_positions[i].z = vertexPositions[3*i+2];
+    }
+
+    // Quadrics of the planes of the triangles, weighted by their area
+    const Quadric zero = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    m_quadrics.assign(vertexCount, zero);
+    m_weights.assign(vertexCount, 0.0);
+    for (std::size_t i = 0; i < indexCount; i += 3) {
+        const Vector3& p0 = m_positions[indices[i]];
+        const Vector3& p1 = m_positions[indices[i+1]];
+        const Vector3& p2 = m_positions[indices[i+2]];
+        float nx = (p1.y - p0.y)*(p2.z - p0.z) - (p1.z - p0.z)*(p2.y - p0.y);
+        float ny = (p1.z - p0.z)*(p2.x - p0.x) - (p1.x - p0.x)*(p2.z - p0.z);
+        float nz = (p1.x - p0.x)*(p2.y - p0.y) - (p1.y - p0.y)*(p2.x - p0.x);
+        const float area = normalize(nx, ny, nz);
+
+        Quadric q;
+        quadricFromPlane(q, nx, ny, nz, -(nx*p0.x + ny*p0.y + nz*p0.z), area);
+        for (int k = 0; k < 3; k++) {
+            quadricAdd(m_quadrics[indices[i+k]], q);
+            m_weights[indices[i+k]] += area;
+        }
+    }
+
+    // Per-vertex buffers, only the entries of the vertices referenced by the current mesh are used
+    m_triangleStart.resize(vertexCount);
+    m_triangleCount.resize(vertexCount);
+    m_borderNext.resize(vertexCount);
+    m_borderPrev.resize(vertexCount);
+    m_kinds.resize(vertexCount);
+    m_remap.resize(vertexCount);
+    m_collapsed.resize(vertexCount);
+
+    // Quadrics of the planes perpendicular to the triangles through the open border edges, heavily weighted so that the
+    // borders are preserved
+    buildVertexTriangles(indices, indexCount);
+    for (std::size_t i = 0; i < indexCount; i += 3) {
+        for (int e = 0; e < 3; e++) {
+            const unsigned int i0 = indices[i+e];
+            const unsigned int i1 = indices[i+NextInTriangle[e]];
+            if (hasHalfEdge(i1, i0, indices))
+                continue;
+
+            const Vector3& p0 = m_positions[i0];
+            const Vector3& p1 = m_positions[i1];
+            const Vector3& p2 = m_positions[indices[i+NextInTriangle[NextInTriangle[e]]]];
+            float ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+            const float length = normalize(ex, ey, ez);
+            const float dx = p2.x - p0.x, dy = p2.y - p0.y, dz = p2.z - p0.z;
+            const float proj = dx*ex + dy*ey + dz*ez;
+            float nx = dx - ex*proj, ny = dy - ey*proj, nz = dz - ez*proj;
+            normalize(nx, ny, nz);
+
+            Quadric q;
+            quadricFromPlane(q, nx, ny, nz, -(nx*p0.x + ny*p0.y + nz*p0.z), length*1000);
+            quadricAdd(m_quadrics[i0], q);
+            quadricAdd(m_quadrics[i1], q);
+        }
+    }
+
+    std::size_t numIndices = indexCount;
+    if (destination != indices)
+        std::copy(indices, indices + indexCount, destination);
+
+    // The errors are compared squared
+    const float targetErrorSq = targetError*targetError;
+    float worstError = 0;
+
+    while (numIndices > targetIndexCount) {
+        // Adjacency of the current mesh
+        buildVertexTriangles(destination, numIndices);
+        classifyVertices(destination, numIndices, vertexLock);
+
+        // Candidate collapses, the cheapest allowed direction of each edge
+        m_collapses.clear();
+        for (std::size_t i = 0; i < numIndices; i += 3) {
+            for (int e = 0; e < 3; e++) {
+                const unsigned int i0 = destination[i+e];
+                const unsigned int i1 = destination[i+NextInTriangle[e]];
+
+                // Consider each edge once: interior edges appear in two triangles
+                if (i0 > i1 && m_borderNext[i0] != i1)
+                    continue;
+
+                const bool allowed = isCollapseAllowed(i0, i1);
+                const bool allowedRev = isCollapseAllowed(i1, i0);
+                const Collapse c01 = { i0, i1, allowed ? collapseError(i0, i1) : 0 };
+                const Collapse c10 = { i1, i0, allowedRev ? collapseError(i1, i0) : 0 };
+                if (allowed && (!allowedRev || c01.error <= c10.error))
+                    m_collapses.push_back(c01);
+                else if (allowedRev)
+                    m_collapses.push_back(c10);
+            }
+        }
+
+        // Everything is locked
+        if (m_collapses.empty())
+            break;
+
+        std::sort(m_collapses.begin(), m_collapses.end());
+
+        // Only the vertices of the current mesh are used, so only their entries need to be reset
+        for (std::size_t i = 0; i < numIndices; i++) {
+            m_remap[destination[i]] = destination[i];
+            m_collapsed[destination[i]] = 0;
+        }
+
+        // Each collapse removes 2 triangles
+        const std::size_t collapseGoal = (numIndices - targetIndexCount)/6 + 1;
+        const float errorGoal = collapseGoal < m_collapses.size() ? m_collapses[collapseGoal].error : m_collapses.back().error;
+        const float errorLimit = errorGoal*1.5f;
+
+        std::size_t numCollapses = 0;
+        float passError = 0;
+        for (std::vector<Collapse>::const_iterator it = m_collapses.begin(); it != m_collapses.end(); ++it) {
+            const Collapse& c = *it;
+            if (m_collapsed[c.v0] || m_collapsed[c.v1])
+                continue;
+
+            // Many candidates may be rejected by the flip checks, do not let the limit stall the simplification
+            if (c.error > errorLimit && numCollapses > 0)
+                break;
+            if (c.error > targetErrorSq)
+                break;
+            if (hasTriangleFlips(c.v0, c.v1, destination))
+                continue;
+
+            assert(m_remap[c.v0] == c.v0);
+            assert(m_remap[c.v1] == c.v1);
+
+            quadricAdd(m_quadrics[c.v1], m_quadrics[c.v0]);
+            m_weights[c.v1] += m_weights[c.v0];
+            m_remap[c.v0] = c.v1;
+            m_collapsed[c.v0] = 1;
+            m_collapsed[c.v1] = 1;
+
+            numCollapses++;
+            passError = c.error;
+            if (numCollapses >= collapseGoal)
+                break;
+        }
+
+        worstError = std::max(worstError, passError);
+
+        // No edges can be collapsed any more
+        if (numCollapses == 0)
+            break;
+
+        // Remove the triangles collapsed in this pass
+        std::size_t write = 0;
+        for (std::size_t i = 0; i < numIndices; i += 3) {
+            const unsigned int v0 = m_remap[destination[i]];
+            const unsigned int v1 = m_remap[destination[i+1]];
+            const unsigned int v2 = m_remap[destination[i+2]];
+            if (v0 != v1 && v0 != v2 && v1 != v2) {
+                destination[write] = v0;
+                destination[write+1] = v1;
+                destination[write+2] = v2;
+                write += 3;
+            }
+        }
+        numIndices = write;
+    }
+
+    if (resultError)
+        *resultError = std::sqrt(worstError);
+
+    return numIndices;
+}
+
+
+void HeightFieldSimplifier::buildVertexTriangles(const unsigned int* indices, const std::size_t& indexCount)
+{
+    for (std::size_t i = 0; i < indexCount; i++) {
+        m_triangleStart[indices[i]] = NoVertex;
+        m_triangleCount[indices[i]] = 0;
+    }
+    for (std::size_t i = 0; i < indexCount; i++)
+        m_triangleCount[indices[i]]++;
+
+    unsigned int offset = 0;
+    for (std::size_t i = 0; i < indexCount; i++) {
+        const unsigned int v = indices[i];
+        if (m_triangleStart[v] == NoVertex) {
+            m_triangleStart[v] = offset;
+            offset += m_triangleCount[v];
+            m_triangleCount[v] = 0;
+        }
+    }
+
+    m_triangleData.resize(indexCount);
+    for (std::size_t i = 0; i < indexCount; i++)
+        m_triangleData[m_triangleStart[indices[i]] + m_triangleCount[indices[i]]++] = (unsigned int)(i/3);
+}
+
+
+bool HeightFieldSimplifier::hasHalfEdge(const unsigned int& v0, const unsigned int& v1, const unsigned int* indices) const
+{
+    for (unsigned int k = m_triangleStart[v0]; k < m_triangleStart[v0] + m_triangleCount[v0]; k++) {
+        const unsigned int* tri = indices + 3*m_triangleData[k];
+        if ((tri[0] == v0 && tri[1] == v1) || (tri[1] == v0 && tri[2] == v1) || (tri[2] == v0 && tri[0] == v1))
+            return true;
+    }
+    return false;
+}
+
+
+void HeightFieldSimplifier::classifyVertices(const unsigned int* indices, const std::size_t& indexCount,
+                                             const unsigned char* vertexLock)
+{
+    for (std::size_t i = 0; i < indexCount; i++) {
+        m_borderNext[indices[i]] = NoVertex;
+        m_borderPrev[indices[i]] = NoVertex;
+    }
+
+    // The open borders are the half-edges without an opposite one
+    for (std::size_t i = 0; i < indexCount; i += 3) {
+        for (int e = 0; e < 3; e++) {
+            const unsigned int i0 = indices[i+e];
+            const unsigned int i1 = indices[i+NextInTriangle[e]];
+            if (!hasHalfEdge(i1, i0, indices)) {
+                m_borderNext[i0] = i1;
+                m_borderPrev[i1] = i0;
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < indexCount; k++) {
+        const unsigned int i = indices[k];
+        const unsigned int prev = m_borderPrev[i], next = m_borderNext[i];
+        if (vertexLock && vertexLock[i])
+            m_kinds[i] = KindFixed;
+        else if (prev == NoVertex && next == NoVertex)
+            m_kinds[i] = KindInterior;
+        else if (prev == NoVertex || next == NoVertex)
+            m_kinds[i] = KindFixed;
+        else {
+            // Border vertices only slide along a straight border, so that the covered region does not change
+            const Vector3& p = m_positions[i];
+            const Vector3& pp = m_positions[prev];
+            const Vector3& pn = m_positions[next];
+            const double lp = std::sqrt(squaredDistance2D(pp, p)), ln = std::sqrt(squaredDistance2D(pn, p));
+            m_kinds[i] = std::fabs(orient2D(pp, p, pn)) <= 1e-6*lp*ln ? KindBorder : KindFixed;
+        }
+    }
+}
+
+
+bool HeightFieldSimplifier::isCollapseAllowed(const unsigned int& v0, const unsigned int& v1) const
+{
+    return m_kinds[v0] == KindInterior ||
+           (m_kinds[v0] == KindBorder && (m_borderNext[v0] == v1 || m_borderPrev[v0] == v1));
+}
+
+
+bool HeightFieldSimplifier::hasTriangleFlips(const unsigned int& v0, const unsigned int& v1, const unsigned int* indices) const
+{
+    for (unsigned int k = m_triangleStart[v0]; k < m_triangleStart[v0] + m_triangleCount[v0]; k++) {
+        const unsigned int* tri = indices + 3*m_triangleData[k];
+        const unsigned int t0 = m_remap[tri[0]], t1 = m_remap[tri[1]], t2 = m_remap[tri[2]];
+
+        // Triangles removed by this collapse or by a previous one
+        if (t0 == v1 || t1 == v1 || t2 == v1 || t0 == t1 || t0 == t2 || t1 == t2)
+            continue;
+
+        const Vector3& a = m_positions[t0 == v0 ? v1 : t0];
+        const Vector3& b = m_positions[t1 == v0 ? v1 : t1];
+        const Vector3& c = m_positions[t2 == v0 ? v1 : t2];
+
+        // Reject slivers too, since their orientation is not reliable once the positions are converted back to double
+        const double perimeterSq = squaredDistance2D(a, b) + squaredDistance2D(b, c) + squaredDistance2D(c, a);
+        if (orient2D(a, b, c) <= 1e-5*perimeterSq)
+            return true;
+    }
+    return false;
+}
+
+
+float HeightFieldSimplifier::collapseError(const unsigned int& v0, const unsigned int& v1) const
+{
+    // Error of the merged vertex, normalized by the area of the triangles that contributed to it
+    const double weight = m_weights[v0] + m_weights[v1];
+    if (weight <= 0)
+        return 0;
+    return (float)(((double)quadricError(m_quadrics[v0], m_positions[v1]) + quadricError(m_quadrics[v1], m_positions[v1]))/weight);
+}
+
+} // End namespace TinCreation
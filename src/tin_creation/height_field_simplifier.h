@@ -0,0 +1,135 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_FIELD_SIMPLIFIER_H
+#define EMODNET_QMGC_HEIGHT_FIELD_SIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace TinCreation {
+
+/**
+ * @class HeightFieldSimplifier
+ * @brief Quadric edge-collapse simplifier for indexed meshes that are a valid triangulation when projected to the xy
+ * plane (counterclockwise triangles), such as the triangulation of a height grid.
+ *
+ * The simplification runs in passes, each of them collapsing the cheapest edges of the current mesh, as in [1]. On top
+ * of that, to keep the mesh a valid height field:
+ * - Collapses that would flip or degenerate a triangle in the xy projection are rejected.
+ * - The vertices on the open borders only slide along straight border segments, so the region covered in xy does not
+ *   change, and the corners of the borders are never removed.
+ * - Locked vertices are never removed.
+ * - The simplification stops before exceeding a target error: the square root of the quadric error of a vertex,
+ *   normalized by the area of the triangles it replaces (roughly, the RMS distance to their planes).
+ *
+ * The quadrics are accumulated in double precision, since the heights of a tile span a small range compared to the
+ * coordinates. The working buffers are kept between calls, so that their memory is reused between tiles.
+ *
+ * Based on the simplifier of the meshoptimizer library (https://github.com/zeux/meshoptimizer, MIT license,
+ * Copyright (c) 2016-2017 Arseny Kapoulkine), which implements:
+ *
+ * [1] M. Garland and P. S. Heckbert, Surface simplification using quadric error metrics, SIGGRAPH 1997.
+ */
+class HeightFieldSimplifier
+{
+public:
+    /**
+     * @brief Simplify an indexed mesh
+     * @param[out] destination Indices of the simplified mesh (at least \p indexCount elements, may be \p indices)
+     * @param indices Indices of the triangles of the mesh, three per triangle, counterclockwise in the xy plane
+     * @param indexCount Number of indices
+     * @param vertexPositions Coordinates of the vertices, three per vertex (x, y, z)
+     * @param vertexCount Number of vertices
+     * @param targetIndexCount The simplification stops when the number of indices drops to this value
+     * @param targetError The simplification stops before exceeding this error, in the units of the positions
+     * @param vertexLock Vertices that must not be removed, flagged with a non-zero value (NULL if none)
+     * @param[out] resultError Largest error of the collapses performed (ignored if NULL)
+     * @return Number of indices of the simplified mesh
+     */
+    std::size_t simplify(unsigned int* destination, const unsigned int* indices, const std::size_t& indexCount,
+                         const float* vertexPositions, const std::size_t& vertexCount,
+                         const std::size_t& targetIndexCount, const float& targetError,
+                         const unsigned char* vertexLock = NULL, float* resultError = NULL);
+
+private:
+    // --- Private Types ---
+    struct Vector3 {
+        float x, y, z;
+    };
+
+    struct Quadric {
+        double a00;
+        double a10, a11;
+        double a20, a21, a22;
+        double b0, b1, b2, c;
+    };
+
+    struct Collapse {
+        unsigned int v0, v1;
+        float error;
+
+        bool operator<(const Collapse& other) const { return error < other.error; }
+    };
+
+    /// Kinds of vertices, depending on how they can be collapsed
+    enum VertexKind {
+        KindInterior, //!< Can be collapsed onto any neighbor
+        KindBorder,   //!< On a straight part of an open border, can only be collapsed onto its neighbors along it
+        KindFixed     //!< Locked, or on a corner of an open border
+    };
+
+    // --- Attributes (working buffers) ---
+    std::vector<Vector3> m_positions;
+    std::vector<Quadric> m_quadrics;
+    std::vector<double> m_weights;                  //!< Sum of the areas of the triangles contributing to each quadric
+    std::vector<unsigned int> m_triangleStart, m_triangleCount, m_triangleData; //!< Triangles incident to each vertex
+    std::vector<unsigned int> m_borderNext, m_borderPrev;
+    std::vector<unsigned char> m_kinds;
+    std::vector<unsigned int> m_remap;
+    std::vector<char> m_collapsed;                  //!< Vertices already involved in a collapse of the current pass
+    std::vector<Collapse> m_collapses;
+
+    // --- Private Methods ---
+    /// Triangles incident to each vertex referenced by the indices (the rest of the entries are not updated, so the cost only depends on the size of the current mesh)
+    void buildVertexTriangles(const unsigned int* indices, const std::size_t& indexCount);
+
+    /// Check if the half-edge v0->v1 is part of one of the triangles incident to v0
+    bool hasHalfEdge(const unsigned int& v0, const unsigned int& v1, const unsigned int* indices) const;
+
+    /// Classify the vertices referenced by the indices, and find the next/previous vertex along the open borders
+    void classifyVertices(const unsigned int* indices, const std::size_t& indexCount, const unsigned char* vertexLock);
+
+    /// Check if a vertex can be collapsed onto another one, regardless of the geometry of the triangles
+    bool isCollapseAllowed(const unsigned int& v0, const unsigned int& v1) const;
+
+    /**
+     * Check if moving v0 to v1 makes any of the remaining triangles around v0 clockwise or degenerate in the xy plane.
+     * The triangles are the ones at the start of the pass, with the collapses already performed in it applied through m_remap
+     */
+    bool hasTriangleFlips(const unsigned int& v0, const unsigned int& v1, const unsigned int* indices) const;
+
+    /// Error of collapsing v0 onto v1 (squared, normalized by the area of the triangles)
+    float collapseError(const unsigned int& v0, const unsigned int& v1) const;
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_FIELD_SIMPLIFIER_H
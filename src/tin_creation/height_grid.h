@@ -0,0 +1,255 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_GRID_H
+#define EMODNET_QMGC_HEIGHT_GRID_H
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "tin_creation_cgal_types.h"
+#include "base/misc_utils.h"
+
+namespace TinCreation {
+
+/**
+ * @class HeightGridView
+ * @brief Non-owning view of a regular grid of heights covering a tile, seen in u/v/h coordinates.
+ *
+ * The heights are stored as floats in any units (e.g., meters) and normalized to [0..1] on access using the
+ * min/max heights of the tile, so that the points obtained are the same as the ones we would get in the scattered u/v/h
+ * input of TinCreationStrategy::create. Columns run from west (u = 0) to east (u = 1) and rows from south (v = 0) to
+ * north (v = 1). The row stride may be negative, which allows viewing rasters stored north-up without copying them.
+ * Samples with a NaN height are not valid (e.g., no data values to ignore).
+ */
+class HeightGridView
+{
+public:
+    /// Default constructor (empty view)
+    HeightGridView()
+            : m_data(NULL), m_numCols(0), m_numRows(0), m_rowStride(0), m_minHeight(0.0), m_maxHeight(0.0) {}
+
+    /**
+     * @brief Constructor
+     * @param southWest Pointer to the height of the south-west sample (column 0, row 0)
+     * @param numCols Number of columns
+     * @param numRows Number of rows
+     * @param rowStride Distance, in number of elements, between two consecutive rows (from south to north)
+     * @param minHeight Height mapped to h = 0
+     * @param maxHeight Height mapped to h = 1
+     */
+    HeightGridView(const float* southWest, const int& numCols, const int& numRows, const std::ptrdiff_t& rowStride,
+                   const double& minHeight, const double& maxHeight)
+            : m_data(southWest), m_numCols(numCols), m_numRows(numRows), m_rowStride(rowStride)
+            , m_minHeight(minHeight), m_maxHeight(maxHeight) {}
+
+    /// Number of columns of the grid
+    int numCols() const { return m_numCols; }
+    /// Number of rows of the grid
+    int numRows() const { return m_numRows; }
+    /// Distance between consecutive rows, in number of elements
+    std::ptrdiff_t rowStride() const { return m_rowStride; }
+    /// Height mapped to h = 0
+    double minHeight() const { return m_minHeight; }
+    /// Height mapped to h = 1
+    double maxHeight() const { return m_maxHeight; }
+    /// Check whether the view contains data
+    bool empty() const { return m_data == NULL || m_numCols == 0 || m_numRows == 0; }
+
+    /// Pointer to the first element of a row (0 = southern row)
+    const float* row(const int& r) const { return m_data + r*m_rowStride; }
+
+    /// Raw (not normalized) height at a given column/row
+    float rawHeight(const int& c, const int& r) const { return m_data[r*m_rowStride + c]; }
+
+    /// Check if the sample at a given column/row is valid
+    bool isValid(const int& c, const int& r) const { return !std::isnan(rawHeight(c, r)); }
+
+    /// u coordinate of a column
+    double u(const int& c) const { return remap(c, 0.0, m_numCols-1, 0.0, 1.0); }
+
+    /// v coordinate of a row
+    double v(const int& r) const { return remap(r, 0.0, m_numRows-1, 0.0, 1.0); }
+
+    /// Normalized height, in [0..1], at a given column/row
+    double h(const int& c, const int& r) const { return normalizeHeight(rawHeight(c, r)); }
+
+    /// Normalize a height in the units of the raw data to [0..1]
+    double normalizeHeight(const double& height) const { return remap(height, m_minHeight, m_maxHeight, 0.0, 1.0); }
+
+    /// The sample at a given column/row, in u/v/h coordinates
+    Point_3 point(const int& c, const int& r) const { return Point_3(u(c), v(r), h(c, r)); }
+
+private:
+    const float* m_data;
+    int m_numCols, m_numRows;
+    std::ptrdiff_t m_rowStride;
+    double m_minHeight, m_maxHeight;
+};
+
+
+
+/**
+ * @struct HeightGridBorders
+ * @brief Constraints on the borders of a tile described by a HeightGridView.
+ *
+ * A non-empty border polyline means that the corresponding border is constrained: the samples of the grid in that
+ * border must be ignored, and the vertices in the polyline must be part of the resulting TIN (they are not required to
+ * be sorted). Constrained corners are also given explicitly, and override the values of the corner samples in the grid.
+ * All points are in u/v/h coordinates.
+ */
+struct HeightGridBorders
+{
+    Polyline eastern;   //!< Vertices to maintain in the eastern border (u = 1)
+    Polyline western;   //!< Vertices to maintain in the western border (u = 0)
+    Polyline northern;  //!< Vertices to maintain in the northern border (v = 1)
+    Polyline southern;  //!< Vertices to maintain in the southern border (v = 0)
+    bool constrainNorthWestCorner = false; //!< Flag indicating whether the north-west corner is constrained
+    bool constrainNorthEastCorner = false; //!< Flag indicating whether the north-east corner is constrained
+    bool constrainSouthWestCorner = false; //!< Flag indicating whether the south-west corner is constrained
+    bool constrainSouthEastCorner = false; //!< Flag indicating whether the south-east corner is constrained
+    Point_3 northWestCorner; //!< The north-west corner to maintain (if constrainNorthWestCorner is set)
+    Point_3 northEastCorner; //!< The north-east corner to maintain (if constrainNorthEastCorner is set)
+    Point_3 southWestCorner; //!< The south-west corner to maintain (if constrainSouthWestCorner is set)
+    Point_3 southEastCorner; //!< The south-east corner to maintain (if constrainSouthEastCorner is set)
+
+    bool constrainEast() const { return !eastern.empty(); }
+    bool constrainWest() const { return !western.empty(); }
+    bool constrainNorth() const { return !northern.empty(); }
+    bool constrainSouth() const { return !southern.empty(); }
+};
+
+
+
+/**
+ * @brief Check if a sample of the grid is a constrained corner (and thus its value is given by the borders structure)
+ */
+inline bool isConstrainedCornerSample(const HeightGridView& grid, const HeightGridBorders& borders,
+                                      const int& c, const int& r)
+{
+    const int lastCol = grid.numCols()-1, lastRow = grid.numRows()-1;
+    return ( c == 0 && r == 0 && borders.constrainSouthWestCorner ) ||
+           ( c == 0 && r == lastRow && borders.constrainNorthWestCorner ) ||
+           ( c == lastCol && r == lastRow && borders.constrainNorthEastCorner ) ||
+           ( c == lastCol && r == 0 && borders.constrainSouthEastCorner );
+}
+
+
+
+/**
+ * @brief Height of the grid at a given u/v position, interpolated bilinearly from the valid samples around it
+ * @param grid The height grid
+ * @param u u coordinate, in [0..1]
+ * @param v v coordinate, in [0..1]
+ * @param[out] h The normalized height, in [0..1]
+ * @return False if none of the samples around the position is valid
+ * \pre The grid has at least 2 columns and 2 rows
+ */
+inline bool interpolateGridHeight(const HeightGridView& grid, const double& u, const double& v, double& h)
+{
+    double x = u*(grid.numCols()-1), y = v*(grid.numRows()-1);
+    int c = std::min(std::max((int)std::floor(x), 0), grid.numCols()-2);
+    int r = std::min(std::max((int)std::floor(y), 0), grid.numRows()-2);
+    double fx = x-c, fy = y-r;
+
+    double sumW = 0.0, sumH = 0.0;
+    for (int dc = 0; dc <= 1; dc++) {
+        for (int dr = 0; dr <= 1; dr++) {
+            double w = (dc ? fx : 1.0-fx)*(dr ? fy : 1.0-fy);
+            if (w <= 0.0 || !grid.isValid(c+dc, r+dr))
+                continue;
+            sumW += w;
+            sumH += w*grid.h(c+dc, r+dr);
+        }
+    }
+    if (sumW <= 0.0)
+        return false;
+    h = sumH/sumW;
+    return true;
+}
+
+
+
+/**
+ * @brief Convert a height grid and its border constraints to the scattered set of u/v/h points used by
+ * TinCreationStrategy::create.
+ *
+ * This is the adapter allowing the strategies that are not aware of the grid structure to be used with it. The points
+ * are generated in the same order as QuantizedMeshTiler used to: the valid grid samples not in a constrained border
+ * (column by column, from north to south), then the eastern, western, northern and southern border vertices, and finally
+ * the constrained corners.
+ *
+ * @param grid The height grid
+ * @param borders The constraints on the borders
+ * @param[out] pts The u/v/h points (the previous contents are replaced, but its memory is reused)
+ */
+inline void heightGridToPoints(const HeightGridView& grid, const HeightGridBorders& borders, std::vector<Point_3>& pts)
+{
+    int startCol = borders.constrainWest() ? 1 : 0;
+    int endCol = borders.constrainEast() ? grid.numCols()-1 : grid.numCols();
+    int startRow = borders.constrainSouth() ? 1 : 0;
+    int endRow = borders.constrainNorth() ? grid.numRows()-1 : grid.numRows();
+
+    pts.clear();
+    pts.reserve( std::max(endCol-startCol, 0)*std::max(endRow-startRow, 0)
+                 + borders.eastern.size() + borders.western.size() + borders.northern.size() + borders.southern.size() + 4 );
+
+    for ( int c = startCol; c < endCol; c++ ) {
+        for ( int r = endRow-1; r >= startRow; r-- ) {
+            if ( isConstrainedCornerSample(grid, borders, c, r) || !grid.isValid(c, r) )
+                continue;
+            pts.push_back( grid.point(c, r) );
+        }
+    }
+
+    pts.insert( pts.end(), borders.eastern.begin(), borders.eastern.end() );
+    pts.insert( pts.end(), borders.western.begin(), borders.western.end() );
+    pts.insert( pts.end(), borders.northern.begin(), borders.northern.end() );
+    pts.insert( pts.end(), borders.southern.begin(), borders.southern.end() );
+
+    if ( borders.constrainSouthWestCorner )
+        pts.push_back( borders.southWestCorner );
+    if ( borders.constrainSouthEastCorner )
+        pts.push_back( borders.southEastCorner );
+    if ( borders.constrainNorthWestCorner )
+        pts.push_back( borders.northWestCorner );
+    if ( borders.constrainNorthEastCorner )
+        pts.push_back( borders.northEastCorner );
+}
+
+/**
+ * @brief Convert a height grid and its border constraints to the scattered set of u/v/h points used by
+ * TinCreationStrategy::create (see above)
+ *
+ * @param grid The height grid
+ * @param borders The constraints on the borders
+ * @return The u/v/h points
+ */
+inline std::vector<Point_3> heightGridToPoints(const HeightGridView& grid, const HeightGridBorders& borders)
+{
+    std::vector<Point_3> pts;
+    heightGridToPoints(grid, borders, pts);
+    return pts;
+}
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_GRID_H
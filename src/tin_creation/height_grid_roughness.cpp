@@ -0,0 +1,73 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "height_grid_roughness.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace TinCreation {
+
+HeightGridRoughness computeHeightGridRoughness(const HeightGridView& grid)
+{
+    HeightGridRoughness roughness;
+    if (grid.empty())
+        return roughness;
+
+    // Height range
+    float minHeight = std::numeric_limits<float>::infinity();
+    float maxHeight = -std::numeric_limits<float>::infinity();
+    for (int r = 0; r < grid.numRows(); r++) {
+        const float* row = grid.row(r);
+        for (int c = 0; c < grid.numCols(); c++) {
+            // NaN (invalid) samples never pass the comparisons
+            if (row[c] < minHeight)
+                minHeight = row[c];
+            if (row[c] > maxHeight)
+                maxHeight = row[c];
+        }
+    }
+    if (minHeight > maxHeight)
+        return roughness; // No valid samples
+    roughness.heightRange = (double)maxHeight - (double)minHeight;
+
+    // Detail, from the discrete Laplacian. Invalid samples propagate as NaN to the deviation and are skipped
+    double sumSqDev = 0.0;
+    int numSamples = 0;
+    for (int r = 1; r < grid.numRows()-1; r++) {
+        const float* south = grid.row(r-1);
+        const float* row = grid.row(r);
+        const float* north = grid.row(r+1);
+        for (int c = 1; c < grid.numCols()-1; c++) {
+            double dev = (double)row[c] - 0.25*((double)row[c-1] + (double)row[c+1] + (double)south[c] + (double)north[c]);
+            if (std::isnan(dev))
+                continue;
+            sumSqDev += dev*dev;
+            numSamples++;
+        }
+    }
+    if (numSamples > 0)
+        roughness.rmsDetail = std::sqrt(sumSqDev/numSamples);
+    roughness.numSamples = numSamples;
+
+    return roughness;
+}
+
+} // End namespace TinCreation
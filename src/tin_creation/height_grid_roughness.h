@@ -0,0 +1,55 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_GRID_ROUGHNESS_H
+#define EMODNET_QMGC_HEIGHT_GRID_ROUGHNESS_H
+
+#include "height_grid.h"
+
+namespace TinCreation {
+
+/**
+ * @struct HeightGridRoughness
+ * @brief Cheap statistics describing how rough the terrain in a tile is, used to choose the TIN creation strategy
+ * for each tile (see TinCreator::selectCreator)
+ */
+struct HeightGridRoughness
+{
+    double heightRange = 0.0; //!< Difference between the maximum and minimum valid heights, in the units of the heights
+    double rmsDetail = 0.0;   //!< RMS of the deviation of each sample from the mean of its 4 neighbors, in the units of the heights
+    int numSamples = 0;       //!< Number of samples contributing to rmsDetail
+};
+
+/**
+ * @brief Compute the roughness statistics of a height grid
+ *
+ * The detail measures how far the terrain is from being locally planar at the resolution of the grid (it is zero for
+ * any plane, whatever its slope), which is what drives the number of vertices a TIN needs to approximate it. Only the
+ * interior samples whose 4 neighbors are valid contribute to it. The heights are taken as they are in the grid, not
+ * normalized, so that the statistics are comparable between tiles.
+ *
+ * @param grid The height grid
+ * @return The roughness statistics
+ */
+HeightGridRoughness computeHeightGridRoughness(const HeightGridView& grid);
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_GRID_ROUGHNESS_H
@@ -0,0 +1,251 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "height_grid_sharp_edges.h"
+#include <cmath>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace TinCreation {
+
+// Unit normals of the two triangles of each cell of the triangulation of the grid, stored as structure of arrays. Each
+// cell is split along its south-west to north-east diagonal (as in triangulateHeightGrid): the lower triangle is
+// (sw, se, ne) and the upper one is (sw, ne, nw)
+struct CellNormals
+{
+    std::vector<float> lowerX, lowerY, lowerZ;
+    std::vector<float> upperX, upperY, upperZ;
+
+    void resize(const std::size_t& n) {
+        lowerX.resize(n); lowerY.resize(n); lowerZ.resize(n);
+        upperX.resize(n); upperY.resize(n); upperZ.resize(n);
+    }
+};
+
+
+// Normals of the cells [first, last) of a row. The heights of the southern and northern samples of the row are in
+// south and north, and the cells are scaled to size 1/scaleU x 1/scaleV
+static void computeCellNormalsScalar(const float* south, const float* north, const std::size_t& first,
+                                     const std::size_t& last, const float& scaleU, const float& scaleV,
+                                     float* lowerX, float* lowerY, float* lowerZ,
+                                     float* upperX, float* upperY, float* upperZ)
+{
+    for (std::size_t i = first; i < last; i++) {
+        const float sw = south[i], se = south[i+1], nw = north[i], ne = north[i+1];
+
+        // Cross products of the edges of each triangle, divided by the area of the cell (so that the z component is 1)
+        float x = (sw-se)*scaleU, y = (se-ne)*scaleV;
+        float invNorm = 1.0f/std::sqrt(x*x + y*y + 1.0f);
+        lowerX[i] = x*invNorm; lowerY[i] = y*invNorm; lowerZ[i] = invNorm;
+
+        x = (nw-ne)*scaleU; y = (sw-nw)*scaleV;
+        invNorm = 1.0f/std::sqrt(x*x + y*y + 1.0f);
+        upperX[i] = x*invNorm; upperY[i] = y*invNorm; upperZ[i] = invNorm;
+    }
+}
+
+
+#if defined(__AVX2__)
+
+static void computeCellNormals(const float* south, const float* north, const std::size_t& numCells,
+                               const float& scaleU, const float& scaleV,
+                               float* lowerX, float* lowerY, float* lowerZ,
+                               float* upperX, float* upperY, float* upperZ)
+{
+    const __m256 su = _mm256_set1_ps(scaleU);
+    const __m256 sv = _mm256_set1_ps(scaleV);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= numCells; i += 8) {
+        const __m256 sw = _mm256_loadu_ps(south + i), se = _mm256_loadu_ps(south + i + 1);
+        const __m256 nw = _mm256_loadu_ps(north + i), ne = _mm256_loadu_ps(north + i + 1);
+
+        __m256 x = _mm256_mul_ps(_mm256_sub_ps(sw, se), su);
+        __m256 y = _mm256_mul_ps(_mm256_sub_ps(se, ne), sv);
+        __m256 invNorm = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x),
+                                                                                       _mm256_mul_ps(y, y)), one)));
+        _mm256_storeu_ps(lowerX + i, _mm256_mul_ps(x, invNorm));
+        _mm256_storeu_ps(lowerY + i, _mm256_mul_ps(y, invNorm));
+        _mm256_storeu_ps(lowerZ + i, invNorm);
+
+        x = _mm256_mul_ps(_mm256_sub_ps(nw, ne), su);
+        y = _mm256_mul_ps(_mm256_sub_ps(sw, nw), sv);
+        invNorm = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x),
+                                                                              _mm256_mul_ps(y, y)), one)));
+        _mm256_storeu_ps(upperX + i, _mm256_mul_ps(x, invNorm));
+        _mm256_storeu_ps(upperY + i, _mm256_mul_ps(y, invNorm));
+        _mm256_storeu_ps(upperZ + i, invNorm);
+    }
+
+    // Remaining cells
+    computeCellNormalsScalar(south, north, i, numCells, scaleU, scaleV,
+                             lowerX, lowerY, lowerZ, upperX, upperY, upperZ);
+}
+
+#else
+
+static void computeCellNormals(const float* south, const float* north, const std::size_t& numCells,
+                               const float& scaleU, const float& scaleV,
+                               float* lowerX, float* lowerY, float* lowerZ,
+                               float* upperX, float* upperY, float* upperZ)
+{
+    computeCellNormalsScalar(south, north, 0, numCells, scaleU, scaleV,
+                             lowerX, lowerY, lowerZ, upperX, upperY, upperZ);
+}
+
+#endif
+
+
+// Sharp edges of the block of samples, indexed by their south-western vertex: the ones along the rows (going east),
+// along the columns (going north), and along the diagonals of the cells (going north-east). The flags are cleared as
+// the edges are traced
+struct SharpEdgeFlags
+{
+    int numCols, numRows;
+    std::vector<unsigned char> east, north, northEast;
+
+    // Take a sharp edge incident to vertex k not traced yet, if any
+    bool take(const std::size_t& k, std::size_t& next) {
+        const int c = (int)(k % numCols), r = (int)(k / numCols);
+        if (east[k])                           { east[k] = 0; next = k+1; return true; }
+        if (north[k])                          { north[k] = 0; next = k+numCols; return true; }
+        if (northEast[k])                      { northEast[k] = 0; next = k+numCols+1; return true; }
+        if (c > 0 && east[k-1])                { east[k-1] = 0; next = k-1; return true; }
+        if (r > 0 && north[k-numCols])         { north[k-numCols] = 0; next = k-numCols; return true; }
+        if (c > 0 && r > 0 && northEast[k-numCols-1]) { northEast[k-numCols-1] = 0; next = k-numCols-1; return true; }
+        return false;
+    }
+
+    // Number of sharp edges incident to vertex k
+    int degree(const std::size_t& k) const {
+        const int c = (int)(k % numCols), r = (int)(k / numCols);
+        return east[k] + north[k] + northEast[k] +
+               (c > 0 ? east[k-1] : 0) +
+               (r > 0 ? north[k-numCols] : 0) +
+               (c > 0 && r > 0 ? northEast[k-numCols-1] : 0);
+    }
+};
+
+
+void extractHeightGridSharpEdgePolylines(const HeightGridView& grid,
+                                         const HeightGridBorders& borders,
+                                         const double& angleInDeg,
+                                         Polylines& polylines)
+{
+    polylines.clear();
+
+    // Block of grid samples not in a constrained border (as in triangulateHeightGrid)
+    const int c0 = borders.constrainWest() ? 1 : 0;
+    const int c1 = borders.constrainEast() ? grid.numCols()-2 : grid.numCols()-1;
+    const int r0 = borders.constrainSouth() ? 1 : 0;
+    const int r1 = borders.constrainNorth() ? grid.numRows()-2 : grid.numRows()-1;
+    if (c1-c0 < 1 || r1-r0 < 1)
+        return;
+    const int numCols = c1-c0+1, numRows = r1-r0+1;
+    const std::size_t numCellCols = numCols-1;
+
+    // Normalized heights of the block, contiguous (constrained corners override the samples of the grid)
+    const Point_3* cornerPoints[4] = { &borders.southWestCorner, &borders.southEastCorner,
+                                       &borders.northWestCorner, &borders.northEastCorner };
+    std::vector<double> heights((std::size_t)numCols*numRows);
+    for (int r = 0; r < numRows; r++) {
+        for (int c = 0; c < numCols; c++) {
+            double& h = heights[(std::size_t)r*numCols + c];
+            if (isConstrainedCornerSample(grid, borders, c0+c, r0+r))
+                h = cornerPoints[(r0+r == 0 ? 0 : 2) + (c0+c == 0 ? 0 : 1)]->z();
+            else
+                h = grid.h(c0+c, r0+r);
+        }
+    }
+    std::vector<float> heightsF(heights.begin(), heights.end());
+
+    // Normals of all the triangles, computed once
+    const float scaleU = (float)(grid.numCols()-1), scaleV = (float)(grid.numRows()-1);
+    CellNormals normals;
+    normals.resize(numCellCols*(numRows-1));
+    for (int r = 0; r < numRows-1; r++) {
+        const std::size_t offset = (std::size_t)r*numCellCols;
+        computeCellNormals(&heightsF[(std::size_t)r*numCols], &heightsF[(std::size_t)(r+1)*numCols],
+                           numCellCols, scaleU, scaleV,
+                           &normals.lowerX[offset], &normals.lowerY[offset], &normals.lowerZ[offset],
+                           &normals.upperX[offset], &normals.upperY[offset], &normals.upperZ[offset]);
+    }
+
+    // Sharp edges: those where the normals of the adjacent triangles form an angle larger than the threshold
+    const float cosAngle = (float)std::cos(angleInDeg*M_PI/180.0);
+    auto isSharp = [&](const std::size_t& a, const bool& aUpper, const std::size_t& b, const bool& bUpper) -> unsigned char {
+        const float dot = (aUpper ? normals.upperX[a] : normals.lowerX[a])*(bUpper ? normals.upperX[b] : normals.lowerX[b]) +
+                          (aUpper ? normals.upperY[a] : normals.lowerY[a])*(bUpper ? normals.upperY[b] : normals.lowerY[b]) +
+                          (aUpper ? normals.upperZ[a] : normals.lowerZ[a])*(bUpper ? normals.upperZ[b] : normals.lowerZ[b]);
+        return dot <= cosAngle ? 1 : 0;
+    };
+    SharpEdgeFlags sharp;
+    sharp.numCols = numCols;
+    sharp.numRows = numRows;
+    sharp.east.assign((std::size_t)numCols*numRows, 0);
+    sharp.north.assign((std::size_t)numCols*numRows, 0);
+    sharp.northEast.assign((std::size_t)numCols*numRows, 0);
+    for (int r = 0; r < numRows-1; r++) {
+        for (int c = 0; c < numCols-1; c++) {
+            const std::size_t cell = (std::size_t)r*numCellCols + c;
+            const std::size_t k = (std::size_t)r*numCols + c;
+            // Diagonal, between both triangles of the cell
+            sharp.northEast[k] = isSharp(cell, false, cell, true);
+            // Southern edge, between the lower triangle of the cell and the upper one of the cell to the south
+            if (r > 0)
+                sharp.east[k] = isSharp(cell, false, cell-numCellCols, true);
+            // Western edge, between the upper triangle of the cell and the lower one of the cell to the west
+            if (c > 0)
+                sharp.north[k] = isSharp(cell, true, cell-1, false);
+        }
+    }
+
+    // Trace the polylines, first from the vertices where they end or branch, and then the closed ones
+    std::vector<int> degrees((std::size_t)numCols*numRows);
+    for (std::size_t k = 0; k < degrees.size(); k++)
+        degrees[k] = sharp.degree(k);
+    auto point = [&](const std::size_t& k) -> Point_3 {
+        const int c = (int)(k % numCols), r = (int)(k / numCols);
+        return Point_3(grid.u(c0+c), grid.v(r0+r), heights[k]);
+    };
+    for (int pass = 0; pass < 2; pass++) {
+        for (std::size_t start = 0; start < degrees.size(); start++) {
+            if (degrees[start] == 0 || (pass == 0) == (degrees[start] == 2))
+                continue;
+
+            std::size_t next;
+            while (sharp.take(start, next)) {
+                Polyline polyline;
+                polyline.push_back(point(start));
+                std::size_t current;
+                do {
+                    current = next;
+                    polyline.push_back(point(current));
+                } while (degrees[current] == 2 && current != start && sharp.take(current, next));
+                polylines.push_back(polyline);
+            }
+        }
+    }
+}
+
+} // End namespace TinCreation
@@ -0,0 +1,55 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_GRID_SHARP_EDGES_H
+#define EMODNET_QMGC_HEIGHT_GRID_SHARP_EDGES_H
+
+#include "tin_creation_cgal_types.h"
+#include "height_grid.h"
+
+namespace TinCreation {
+
+/**
+ * @brief Detect the sharp edges of the triangulation of a height grid, and trace the polylines they form.
+ *
+ * This is the grid counterpart of running detect_sharp_edges_without_borders and extract_polylines_from_sharp_edges on
+ * the mesh obtained with triangulateHeightGrid, without building the mesh. The normals of the two triangles of each cell
+ * are computed once, in a single pass over the grid (vectorized when compiled with AVX2 support), and an edge is sharp
+ * if the angle between the normals of the triangles sharing it is larger than the threshold. As in
+ * detect_sharp_edges_without_borders, the edges in the border of the mesh are not considered. The edges between the
+ * block of grid samples and the strips of constrained border vertices (see triangulateHeightGrid) are not considered
+ * either.
+ *
+ * The polylines are split at the vertices where a number of sharp edges other than 2 meet, and closed loops of sharp
+ * edges are returned as polylines whose first and last vertices are the same.
+ *
+ * @param grid The height grid (all the samples outside the constrained borders are expected to be valid)
+ * @param borders The constraints on the borders
+ * @param angleInDeg Angle threshold to consider an edge as sharp (in degrees)
+ * @param[out] polylines The polylines of sharp edges, in u/v/h coordinates
+ */
+void extractHeightGridSharpEdgePolylines(const HeightGridView& grid,
+                                         const HeightGridBorders& borders,
+                                         const double& angleInDeg,
+                                         Polylines& polylines);
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_GRID_SHARP_EDGES_H
@@ -0,0 +1,373 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "height_grid_triangulation.h"
+#include "lattice_delaunay.h"
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace TinCreation {
+
+// Tolerance to consider that a border vertex is at a corner of the tile
+static const double kCornerTolerance = 1e-9;
+
+// Sides of the tile
+enum GridSide { SideWest = 0, SideEast, SideSouth, SideNorth };
+
+// Corners of the tile
+enum GridCorner { CornerSouthWest = 0, CornerSouthEast, CornerNorthWest, CornerNorthEast };
+
+// Vertices along a constrained border: position along it (v for the western/eastern borders, u for the southern/
+// northern ones) and index in the vertices of the mesh
+typedef std::vector<std::pair<double, std::size_t> > BorderChain;
+
+
+// Position of a point along a side of the tile
+static inline double positionAlongSide(const Point_3& p, const int& side)
+{
+    return (side == SideWest || side == SideEast) ? p.y() : p.x();
+}
+
+
+// Add the triangle (a, b, c), or (a, c, b) if flipped
+static inline void addTriangle(std::vector<std::size_t>& triangles,
+                               const std::size_t& a, const std::size_t& b, const std::size_t& c,
+                               const bool& flip)
+{
+    triangles.push_back(a);
+    triangles.push_back(flip ? c : b);
+    triangles.push_back(flip ? b : c);
+}
+
+
+// Triangulate the strip between the outer chain (from lo to hi) and the inner chain, both sorted along the border, by
+// advancing on the chain whose next vertex comes first
+static void zipChains(const BorderChain& outer, const std::size_t& lo, const std::size_t& hi,
+                      const BorderChain& inner, const bool& flip,
+                      std::vector<std::size_t>& triangles)
+{
+    std::size_t p = lo, q = 0;
+    const std::size_t last = inner.size()-1;
+    while (p < hi || q < last) {
+        if (q < last && (p == hi || inner[q+1].first <= outer[p+1].first)) {
+            addTriangle(triangles, outer[p].second, inner[q].second, inner[q+1].second, flip);
+            q++;
+        }
+        else {
+            addTriangle(triangles, outer[p].second, inner[q].second, outer[p+1].second, flip);
+            p++;
+        }
+    }
+}
+
+
+bool triangulateHeightGrid(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           std::vector<Point_3>& vertices,
+                           std::vector<std::size_t>& triangles,
+                           std::size_t& numGridSamples)
+{
+    vertices.clear();
+    triangles.clear();
+    numGridSamples = 0;
+
+    const int numCols = grid.numCols(), numRows = grid.numRows();
+    if (numCols < 2 || numRows < 2)
+        return false;
+
+    const bool constrained[4] = { borders.constrainWest(), borders.constrainEast(),
+                                  borders.constrainSouth(), borders.constrainNorth() };
+
+    // Block of grid samples not in a constrained border
+    const int c0 = constrained[SideWest] ? 1 : 0;
+    const int c1 = constrained[SideEast] ? numCols-2 : numCols-1;
+    const int r0 = constrained[SideSouth] ? 1 : 0;
+    const int r1 = constrained[SideNorth] ? numRows-2 : numRows-1;
+    if (c1 <= c0 || r1 <= r0)
+        return false;
+    const int blockCols = c1-c0+1, blockRows = r1-r0+1;
+
+    const bool constrainCorner[4] = { borders.constrainSouthWestCorner, borders.constrainSouthEastCorner,
+                                      borders.constrainNorthWestCorner, borders.constrainNorthEastCorner };
+    const Point_3* cornerPoints[4] = { &borders.southWestCorner, &borders.southEastCorner,
+                                       &borders.northWestCorner, &borders.northEastCorner };
+
+    vertices.reserve((std::size_t)blockCols*blockRows + borders.eastern.size() + borders.western.size() +
+                     borders.northern.size() + borders.southern.size() + 4);
+    triangles.reserve(6*(std::size_t)(blockCols-1)*(blockRows-1) +
+                      3*(borders.eastern.size() + borders.western.size() +
+                         borders.northern.size() + borders.southern.size() + 2*(blockCols + blockRows) + 8));
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            if (isConstrainedCornerSample(grid, borders, c, r)) {
+                const int corner = (r == 0 ? 0 : 2) + (c == 0 ? 0 : 1);
+                vertices.push_back(*cornerPoints[corner]);
+            }
+            else if (grid.isValid(c, r))
+                vertices.push_back(grid.point(c, r));
+            else
+                return false;
+        }
+    }
+    numGridSamples = vertices.size();
+
+    for (int r = 0; r < blockRows-1; r++) {
+        for (int c = 0; c < blockCols-1; c++) {
+            const std::size_t sw = (std::size_t)r*blockCols + c;
+            const std::size_t se = sw+1, nw = sw+blockCols, ne = nw+1;
+            addTriangle(triangles, sw, se, ne, false);
+            addTriangle(triangles, sw, ne, nw, false);
+        }
+    }
+
+    if (!constrained[SideWest] && !constrained[SideEast] && !constrained[SideSouth] && !constrained[SideNorth])
+        return true;
+
+    // Corners of the constrained borders, taken from the explicit corners, the border vertices or the grid
+    const Polyline* borderPolylines[4] = { &borders.western, &borders.eastern, &borders.southern, &borders.northern };
+    const int cornerCols[4] = { 0, numCols-1, 0, numCols-1 };
+    const int cornerRows[4] = { 0, 0, numRows-1, numRows-1 };
+    const int cornerSides[4][2] = { { SideWest, SideSouth }, { SideEast, SideSouth },
+                                    { SideWest, SideNorth }, { SideEast, SideNorth } };
+    std::size_t cornerIndices[4];
+    for (int k = 0; k < 4; k++) {
+        if (!constrained[cornerSides[k][0]] && !constrained[cornerSides[k][1]])
+            continue;
+
+        const double cu = (k == CornerSouthWest || k == CornerNorthWest) ? 0.0 : 1.0;
+        const double cv = (k == CornerSouthWest || k == CornerSouthEast) ? 0.0 : 1.0;
+        bool found = constrainCorner[k];
+        Point_3 corner = *cornerPoints[k];
+        for (int b = 0; b < 4 && !found; b++) {
+            for (Polyline::const_iterator it = borderPolylines[b]->begin(); it != borderPolylines[b]->end(); ++it) {
+                if (std::fabs(it->x()-cu) <= kCornerTolerance && std::fabs(it->y()-cv) <= kCornerTolerance) {
+                    corner = *it;
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found && grid.isValid(cornerCols[k], cornerRows[k])) {
+            corner = grid.point(cornerCols[k], cornerRows[k]);
+            found = true;
+        }
+        if (!found)
+            return false;
+
+        cornerIndices[k] = vertices.size();
+        vertices.push_back(Point_3(cu, cv, corner.z()));
+    }
+
+    // Vertices of each constrained border, sorted along it (corners included)
+    const int sideStartCorner[4] = { CornerSouthWest, CornerSouthEast, CornerSouthWest, CornerNorthWest };
+    const int sideEndCorner[4] = { CornerNorthWest, CornerNorthEast, CornerSouthEast, CornerNorthEast };
+    BorderChain outer[4];
+    std::vector<std::pair<double, Point_3> > sorted;
+    for (int s = 0; s < 4; s++) {
+        if (!constrained[s])
+            continue;
+
+        sorted.clear();
+        sorted.reserve(borderPolylines[s]->size());
+        for (Polyline::const_iterator it = borderPolylines[s]->begin(); it != borderPolylines[s]->end(); ++it) {
+            const double t = positionAlongSide(*it, s);
+            if (t > kCornerTolerance && t < 1.0-kCornerTolerance)
+                sorted.push_back(std::make_pair(t, *it));
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const std::pair<double, Point_3>& a, const std::pair<double, Point_3>& b) { return a.first < b.first; });
+
+        outer[s].reserve(sorted.size()+2);
+        outer[s].push_back(std::make_pair(0.0, cornerIndices[sideStartCorner[s]]));
+        for (std::size_t i = 0; i < sorted.size(); i++) {
+            if (sorted[i].first <= outer[s].back().first)
+                continue; // Repeated vertex
+            outer[s].push_back(std::make_pair(sorted[i].first, vertices.size()));
+            vertices.push_back(sorted[i].second);
+        }
+        outer[s].push_back(std::make_pair(1.0, cornerIndices[sideEndCorner[s]]));
+    }
+
+    // Strips between each constrained border and the outermost samples of the block next to it
+    std::size_t lo[4] = { 0, 0, 0, 0 }, hi[4] = { 0, 0, 0, 0 };
+    BorderChain inner;
+    for (int s = 0; s < 4; s++) {
+        if (!constrained[s])
+            continue;
+
+        inner.clear();
+        if (s == SideWest || s == SideEast) {
+            const int c = (s == SideWest) ? 0 : blockCols-1;
+            for (int r = 0; r < blockRows; r++)
+                inner.push_back(std::make_pair(grid.v(r0+r), (std::size_t)r*blockCols + c));
+        }
+        else {
+            const int r = (s == SideSouth) ? 0 : blockRows-1;
+            for (int c = 0; c < blockCols; c++)
+                inner.push_back(std::make_pair(grid.u(c0+c), (std::size_t)r*blockCols + c));
+        }
+
+        // The part of the border beyond the block is covered by the corner fans (or it is the first/last vertex)
+        const double tStart = inner.front().first, tEnd = inner.back().first;
+        while (lo[s]+1 < outer[s].size() && outer[s][lo[s]+1].first <= tStart)
+            lo[s]++;
+        hi[s] = outer[s].size()-1;
+        while (hi[s] > 0 && outer[s][hi[s]-1].first >= tEnd)
+            hi[s]--;
+
+        zipChains(outer[s], lo[s], hi[s], inner, s == SideEast || s == SideSouth, triangles);
+    }
+
+    // Fans at the corners between two constrained borders, from the closest sample of the block and going
+    // counterclockwise around it
+    std::vector<std::size_t> fan;
+    if (constrained[SideWest] && constrained[SideSouth]) {
+        fan.clear();
+        for (std::size_t i = lo[SideWest]+1; i-- > 0; )
+            fan.push_back(outer[SideWest][i].second);
+        for (std::size_t i = 1; i <= lo[SideSouth]; i++)
+            fan.push_back(outer[SideSouth][i].second);
+        for (std::size_t i = 0; i+1 < fan.size(); i++)
+            addTriangle(triangles, 0, fan[i], fan[i+1], false);
+    }
+    if (constrained[SideSouth] && constrained[SideEast]) {
+        fan.clear();
+        for (std::size_t i = hi[SideSouth]; i < outer[SideSouth].size(); i++)
+            fan.push_back(outer[SideSouth][i].second);
+        for (std::size_t i = 1; i <= lo[SideEast]; i++)
+            fan.push_back(outer[SideEast][i].second);
+        for (std::size_t i = 0; i+1 < fan.size(); i++)
+            addTriangle(triangles, blockCols-1, fan[i], fan[i+1], false);
+    }
+    if (constrained[SideEast] && constrained[SideNorth]) {
+        fan.clear();
+        for (std::size_t i = hi[SideEast]; i < outer[SideEast].size(); i++)
+            fan.push_back(outer[SideEast][i].second);
+        for (std::size_t i = outer[SideNorth].size()-1; i-- > hi[SideNorth]; )
+            fan.push_back(outer[SideNorth][i].second);
+        for (std::size_t i = 0; i+1 < fan.size(); i++)
+            addTriangle(triangles, (std::size_t)blockRows*blockCols-1, fan[i], fan[i+1], false);
+    }
+    if (constrained[SideNorth] && constrained[SideWest]) {
+        fan.clear();
+        for (std::size_t i = lo[SideNorth]+1; i-- > 0; )
+            fan.push_back(outer[SideNorth][i].second);
+        for (std::size_t i = outer[SideWest].size()-1; i-- > hi[SideWest]; )
+            fan.push_back(outer[SideWest][i].second);
+        for (std::size_t i = 0; i+1 < fan.size(); i++)
+            addTriangle(triangles, (std::size_t)(blockRows-1)*blockCols, fan[i], fan[i+1], false);
+    }
+
+    return true;
+}
+
+
+// Working buffers of the functions below, reused between tiles so that they do not allocate memory in steady state.
+// Since each thread tiles on its own, there is one set per thread
+struct TriangulationBuffers
+{
+    std::vector<Point_3> vertices;
+    std::vector<std::size_t> triangles;
+    std::vector<std::size_t> newIndex;
+    LatticeDelaunay ldt;
+};
+
+static TriangulationBuffers& triangulationBuffers()
+{
+    static thread_local TriangulationBuffers buffers;
+    return buffers;
+}
+
+
+bool triangulateHeightGrid(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           Polyhedron& surface)
+{
+    std::vector<Point_3>& vertices = triangulationBuffers().vertices;
+    std::vector<std::size_t>& triangles = triangulationBuffers().triangles;
+    std::size_t numGridSamples;
+    if (!triangulateHeightGrid(grid, borders, vertices, triangles, numGridSamples))
+        return false;
+
+    surface.clear();
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(vertices, triangles);
+    surface.delegate(builder);
+
+    return true;
+}
+
+
+void triangulatePoints(const std::vector<Point_3>& pts,
+                       std::vector<std::size_t>& triangles)
+{
+    // Points sampled from the heightmap can be triangulated with exact integer arithmetic
+    LatticeDelaunay& ldt = triangulationBuffers().ldt;
+    if (ldt.triangulate(pts)) {
+        triangles.assign(ldt.triangles().begin(), ldt.triangles().end());
+        return;
+    }
+
+    std::vector<std::pair<Point_3, std::size_t> > indexedPts;
+    indexedPts.reserve(pts.size());
+    for (std::size_t i = 0; i < pts.size(); i++)
+        indexedPts.push_back(std::make_pair(pts[i], i));
+    IndexedDelaunay dt(indexedPts.begin(), indexedPts.end());
+
+    triangles.clear();
+    triangles.reserve(3*dt.number_of_faces());
+    for (IndexedDelaunay::Finite_faces_iterator it = dt.finite_faces_begin(); it != dt.finite_faces_end(); ++it) {
+        triangles.push_back(it->vertex(0)->info());
+        triangles.push_back(it->vertex(1)->info());
+        triangles.push_back(it->vertex(2)->info());
+    }
+}
+
+
+void triangulatePoints(const std::vector<Point_3>& pts,
+                       Polyhedron& surface)
+{
+    std::vector<std::size_t>& triangles = triangulationBuffers().triangles;
+    triangulatePoints(pts, triangles);
+
+    // Keep only the referenced points
+    const std::size_t unused = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t>& newIndex = triangulationBuffers().newIndex;
+    newIndex.assign(pts.size(), unused);
+    std::vector<Point_3>& vertices = triangulationBuffers().vertices;
+    vertices.clear();
+    for (std::size_t i = 0; i < triangles.size(); i++) {
+        std::size_t& ind = newIndex[triangles[i]];
+        if (ind == unused) {
+            ind = vertices.size();
+            vertices.push_back(pts[triangles[i]]);
+        }
+        triangles[i] = ind;
+    }
+
+    surface.clear();
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(vertices, triangles);
+    surface.delegate(builder);
+}
+
+} // End namespace TinCreation
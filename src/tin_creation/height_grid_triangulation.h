@@ -0,0 +1,98 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_GRID_TRIANGULATION_H
+#define EMODNET_QMGC_HEIGHT_GRID_TRIANGULATION_H
+
+#include <cstddef>
+#include <vector>
+#include "tin_creation_cgal_types.h"
+#include "height_grid.h"
+
+namespace TinCreation {
+
+/**
+ * @brief Triangulate a height grid directly, with two triangles per cell, in linear time.
+ *
+ * The samples of the grid not in a constrained border (see HeightGridBorders) are the vertices of a regular mesh. The
+ * vertices to preserve in each constrained border are sorted along it and connected to the outermost row/column of
+ * samples in a strip, and the regions at the corners where two constrained borders meet are filled with a fan. The
+ * result is a valid triangulation of the whole tile when projected to the u/v plane, with the triangles in
+ * counterclockwise order.
+ *
+ * Constrained corners override the value of the corresponding grid sample. A corner of a constrained border not given
+ * explicitly is taken from the border vertices or, failing that, from the grid.
+ *
+ * @param grid The height grid
+ * @param borders The constraints on the borders
+ * @param[out] vertices The vertices of the mesh, in u/v/h coordinates. The first \p numGridSamples ones are the samples
+ * of the grid (row by row, from south to north), the rest are on the constrained borders
+ * @param[out] triangles Indices of the vertices of each triangle (3 consecutive indices per triangle)
+ * @param[out] numGridSamples Number of vertices taken from the samples of the grid
+ * @return False if the grid can not be triangulated this way (it contains no data samples, it has not enough samples,
+ * or a corner of a constrained border is missing), and a Delaunay triangulation of the points should be used instead
+ */
+bool triangulateHeightGrid(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           std::vector<Point_3>& vertices,
+                           std::vector<std::size_t>& triangles,
+                           std::size_t& numGridSamples);
+
+/**
+ * @brief Triangulate a height grid directly (see above) into a Polyhedron.
+ *
+ * This is the base mesh to use instead of a Delaunay triangulation of the points of the grid, which is known in advance.
+ *
+ * @param grid The height grid
+ * @param borders The constraints on the borders
+ * @param[out] surface The triangulated surface, in u/v/h coordinates
+ * @return False if the grid can not be triangulated this way (see above)
+ */
+bool triangulateHeightGrid(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           Polyhedron& surface);
+
+/**
+ * @brief Delaunay triangulation (in the u/v plane) of a scattered set of points, as an indexed mesh.
+ *
+ * Alternative to triangulateHeightGrid when the input is not a grid. Repeated points are only used once, so some of
+ * them may not be referenced by any triangle. When the points lie on the lattice of the heightmap samples, the
+ * triangulation is computed with LatticeDelaunay, and with CGAL otherwise.
+ *
+ * @param pts The points, in u/v/h coordinates
+ * @param[out] triangles Indices of the points of each triangle (3 consecutive indices per triangle, counterclockwise)
+ */
+void triangulatePoints(const std::vector<Point_3>& pts,
+                       std::vector<std::size_t>& triangles);
+
+/**
+ * @brief Delaunay triangulation (in the u/v plane) of a scattered set of points, as a Polyhedron.
+ *
+ * Same as above, but the repeated points are removed from the resulting surface.
+ *
+ * @param pts The points, in u/v/h coordinates
+ * @param[out] surface The triangulated surface, in u/v/h coordinates
+ */
+void triangulatePoints(const std::vector<Point_3>& pts,
+                       Polyhedron& surface);
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_GRID_TRIANGULATION_H
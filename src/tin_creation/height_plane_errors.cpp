@@ -0,0 +1,113 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "height_plane_errors.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace TinCreation {
+
+std::size_t maxPlaneErrorScalar(const double* x, const double* y, const double* z, const std::size_t& n,
+                                const HeightPlane& plane, const double& scale, double& maxError)
+{
+    std::size_t best = n;
+    maxError = 0.0;
+    for (std::size_t i = 0; i < n; i++) {
+        const double d = z[i] - (plane.a + plane.b*x[i] + plane.c*y[i]);
+        const double e = d*d*scale;
+        if (e > maxError) {
+            maxError = e;
+            best = i;
+        }
+    }
+    return best;
+}
+
+
+
+#if defined(__AVX2__)
+
+std::size_t maxPlaneError(const double* x, const double* y, const double* z, const std::size_t& n,
+                          const HeightPlane& plane, const double& scale, double& maxError)
+{
+    const __m256d a = _mm256_set1_pd(plane.a);
+    const __m256d b = _mm256_set1_pd(plane.b);
+    const __m256d c = _mm256_set1_pd(plane.c);
+    const __m256d s = _mm256_set1_pd(scale);
+    const __m256d four = _mm256_set1_pd(4.0);
+
+    // Per-lane maximum and index of the point reaching it (indices stored as doubles, exact below 2^53)
+    __m256d maxV = _mm256_setzero_pd();
+    __m256d bestV = _mm256_set1_pd(-1.0);
+    __m256d idxV = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // Same operations as the scalar version, to get the same results
+        __m256d h = _mm256_add_pd(a, _mm256_mul_pd(b, _mm256_loadu_pd(x + i)));
+        h = _mm256_add_pd(h, _mm256_mul_pd(c, _mm256_loadu_pd(y + i)));
+        const __m256d d = _mm256_sub_pd(_mm256_loadu_pd(z + i), h);
+        const __m256d e = _mm256_mul_pd(_mm256_mul_pd(d, d), s);
+
+        const __m256d greater = _mm256_cmp_pd(e, maxV, _CMP_GT_OQ);
+        maxV = _mm256_blendv_pd(maxV, e, greater);
+        bestV = _mm256_blendv_pd(bestV, idxV, greater);
+        idxV = _mm256_add_pd(idxV, four);
+    }
+
+    // Reduction: largest error, and the first point reaching it in case of ties
+    double maxs[4], bests[4];
+    _mm256_storeu_pd(maxs, maxV);
+    _mm256_storeu_pd(bests, bestV);
+    std::size_t best = n;
+    maxError = 0.0;
+    for (int l = 0; l < 4; l++) {
+        if (bests[l] < 0.0)
+            continue;
+        const std::size_t lb = (std::size_t)bests[l];
+        if (maxs[l] > maxError || (maxs[l] == maxError && lb < best)) {
+            maxError = maxs[l];
+            best = lb;
+        }
+    }
+
+    // Remaining points (after all the others, so only a strictly larger error replaces the current best)
+    double remMaxError;
+    std::size_t remBest = maxPlaneErrorScalar(x + i, y + i, z + i, n - i, plane, scale, remMaxError);
+    if (remBest < n - i && remMaxError > maxError) {
+        maxError = remMaxError;
+        best = i + remBest;
+    }
+
+    return best;
+}
+
+#else
+
+std::size_t maxPlaneError(const double* x, const double* y, const double* z, const std::size_t& n,
+                          const HeightPlane& plane, const double& scale, double& maxError)
+{
+    return maxPlaneErrorScalar(x, y, z, n, plane, scale, maxError);
+}
+
+#endif
+
+} // End namespace TinCreation
@@ -0,0 +1,89 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_PLANE_ERRORS_H
+#define EMODNET_QMGC_HEIGHT_PLANE_ERRORS_H
+
+#include <cstddef>
+
+namespace TinCreation {
+
+/**
+ * @struct HeightPlane
+ * @brief Non-vertical plane, expressed as a height function z = a + b*x + c*y
+ */
+struct HeightPlane
+{
+    double a, b, c;
+
+    HeightPlane() : a(0.0), b(0.0), c(0.0) {}
+
+    /**
+     * @brief Plane passing through three points
+     * \pre The XY projection of the points is not degenerate (i.e., the points are not aligned in XY)
+     */
+    HeightPlane(const double& x0, const double& y0, const double& z0,
+                const double& x1, const double& y1, const double& z1,
+                const double& x2, const double& y2, const double& z2)
+    {
+        const double dx1 = x1-x0, dy1 = y1-y0, dz1 = z1-z0;
+        const double dx2 = x2-x0, dy2 = y2-y0, dz2 = z2-z0;
+        const double invDet = 1.0/(dx1*dy2 - dx2*dy1);
+        b = (dz1*dy2 - dz2*dy1)*invDet;
+        c = (dx1*dz2 - dx2*dz1)*invDet;
+        a = z0 - b*x0 - c*y0;
+    }
+
+    /// Height of the plane at a given XY position
+    double eval(const double& x, const double& y) const { return a + b*x + c*y; }
+
+    /// Factor converting squared vertical distances to this plane into squared orthogonal distances
+    double sqVerticalToOrthogonalFactor() const { return 1.0/(1.0 + b*b + c*c); }
+};
+
+/**
+ * @brief Find the point inducing the largest error with respect to a plane, among a set of points in SoA layout.
+ *
+ * The error is the squared vertical distance to the plane multiplied by \p scale (use 1 for the vertical error, or
+ * HeightPlane::sqVerticalToOrthogonalFactor for the squared orthogonal distance).
+ *
+ * Uses AVX2 when the code is compiled with support for it, and falls back to a scalar loop otherwise.
+ *
+ * @param x X coordinates of the points
+ * @param y Y coordinates of the points
+ * @param z Z coordinates of the points
+ * @param n Number of points
+ * @param plane The plane
+ * @param scale Scale applied to the squared vertical distances
+ * @param[out] maxError The largest error (0 if there are no points)
+ * @return The index of the (first) point with the largest error, or \p n if all errors are 0 (or there are no points)
+ */
+std::size_t maxPlaneError(const double* x, const double* y, const double* z, const std::size_t& n,
+                          const HeightPlane& plane, const double& scale, double& maxError);
+
+/**
+ * @brief Scalar version of maxPlaneError, always available (used as fallback and as reference)
+ */
+std::size_t maxPlaneErrorScalar(const double* x, const double* y, const double* z, const std::size_t& n,
+                                const HeightPlane& plane, const double& scale, double& maxError);
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_PLANE_ERRORS_H
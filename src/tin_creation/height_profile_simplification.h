@@ -0,0 +1,112 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_HEIGHT_PROFILE_SIMPLIFICATION_H
+#define EMODNET_QMGC_HEIGHT_PROFILE_SIMPLIFICATION_H
+
+#include <cstddef>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "tin_creation_cgal_types.h"
+
+namespace TinCreation {
+
+/**
+ * @brief Simplify a polyline contained in a vertical plane parallel to the X or Y axis (e.g., a border of a tile) as a
+ * 1D height profile, using the Douglas-Peucker algorithm.
+ *
+ * The error of removing a vertex is its vertical distance to the simplified polyline, as in
+ * PS::PointSetFeaturesSimplificationCost, but no triangulation is required. A segment of the simplified polyline is
+ * split at its farthest vertex while the error is larger than the threshold, or while it is longer than the maximum
+ * length, so that it runs in O(n log n) time for typical profiles.
+ *
+ * @param pts Vertices of the polyline, sorted along it. On output, only the vertices surviving the simplification are
+ * kept (the endpoints always survive)
+ * @param alongX True if the polyline runs along the X axis (i.e., the position along it is the x coordinate), false if
+ * it runs along the Y axis
+ * @param maxSqHeightError Maximum squared vertical distance between a removed vertex and the simplified polyline
+ * @param maxLength Maximum length of the segments of the simplified polyline
+ */
+inline void simplifyHeightProfile(Polyline& pts,
+                                  const bool& alongX,
+                                  const double& maxSqHeightError,
+                                  const double& maxLength)
+{
+    const std::size_t n = pts.size();
+    if (n < 3)
+        return;
+
+    std::vector<double> position(n);
+    for (std::size_t i = 0; i < n; i++)
+        position[i] = alongX ? pts[i].x() : pts[i].y();
+
+    std::vector<char> keep(n, 0);
+    keep[0] = keep[n-1] = 1;
+
+    std::vector<std::pair<std::size_t, std::size_t> > segments;
+    segments.push_back(std::make_pair(std::size_t(0), n-1));
+    while (!segments.empty()) {
+        const std::size_t first = segments.back().first, last = segments.back().second;
+        segments.pop_back();
+        if (last - first < 2)
+            continue;
+
+        // Farthest vertex (in height) from the segment
+        const double length = position[last] - position[first];
+        const double slope = std::fabs(length) > 0.0 ? (pts[last].z() - pts[first].z())/length : 0.0;
+        double maxSqError = -1.0;
+        std::size_t farthest = first+1;
+        for (std::size_t i = first+1; i < last; i++) {
+            const double error = pts[i].z() - (pts[first].z() + slope*(position[i] - position[first]));
+            if (error*error > maxSqError) {
+                maxSqError = error*error;
+                farthest = i;
+            }
+        }
+
+        if (maxSqError <= maxSqHeightError) {
+            if (std::fabs(length) <= maxLength)
+                continue;
+            // Too long, split at the vertex closest to the middle instead
+            const double middle = position[first] + length/2.0;
+            farthest = first+1;
+            for (std::size_t i = first+2; i < last; i++) {
+                if (std::fabs(position[i] - middle) < std::fabs(position[farthest] - middle))
+                    farthest = i;
+            }
+        }
+
+        keep[farthest] = 1;
+        segments.push_back(std::make_pair(first, farthest));
+        segments.push_back(std::make_pair(farthest, last));
+    }
+
+    std::size_t numKept = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        if (keep[i])
+            pts[numKept++] = pts[i];
+    }
+    pts.resize(numKept);
+}
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_HEIGHT_PROFILE_SIMPLIFICATION_H
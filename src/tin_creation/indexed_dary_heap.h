@@ -0,0 +1,175 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_INDEXED_DARY_HEAP_H
+#define EMODNET_QMGC_INDEXED_DARY_HEAP_H
+
+#include <vector>
+#include <cstddef>
+
+namespace TinCreation {
+
+/**
+ * @class IndexedDaryHeap
+ * @brief Max-heap with a branching factor of D, stored in contiguous arrays, whose entries can be erased/updated.
+ *
+ * Each pushed entry gets an integer handle, valid until the entry is popped or erased, that can be used to index
+ * arrays with additional data on the entries. The handles of the removed entries are reused, so that the memory
+ * allocated by the heap is kept between runs (call clear() to reuse it).
+ *
+ * @tparam Priority Type of the priority (any type with operator<)
+ * @tparam D Branching factor
+ */
+template <class Priority, int D = 4>
+class IndexedDaryHeap
+{
+public:
+    typedef int Handle;
+
+    IndexedDaryHeap() {}
+
+    /// Remove all the entries (the allocated memory is kept)
+    void clear() {
+        m_heap.clear();
+        m_priorities.clear();
+        m_positions.clear();
+        m_freeHandles.clear();
+    }
+
+    /// Reserve space for a number of entries
+    void reserve(const std::size_t& n) {
+        m_heap.reserve(n);
+        m_priorities.reserve(n);
+        m_positions.reserve(n);
+        m_freeHandles.reserve(n);
+    }
+
+    bool empty() const { return m_heap.empty(); }
+    std::size_t size() const { return m_heap.size(); }
+
+    /// Maximum number of simultaneous entries since the last clear() (i.e., handles are in [0..capacity()))
+    std::size_t capacity() const { return m_priorities.size(); }
+
+    /// Handle of the entry with the largest priority
+    Handle top() const { return m_heap[0]; }
+
+    /// Largest priority
+    const Priority& topPriority() const { return m_priorities[m_heap[0]]; }
+
+    /// Priority of an entry
+    const Priority& priority(const Handle& h) const { return m_priorities[h]; }
+
+    /// Insert a new entry, returning its handle
+    Handle push(const Priority& p) {
+        Handle h;
+        if (!m_freeHandles.empty()) {
+            h = m_freeHandles.back();
+            m_freeHandles.pop_back();
+            m_priorities[h] = p;
+        }
+        else {
+            h = (Handle)m_priorities.size();
+            m_priorities.push_back(p);
+            m_positions.push_back(0);
+        }
+        m_positions[h] = m_heap.size();
+        m_heap.push_back(h);
+        siftUp(m_heap.size()-1);
+        return h;
+    }
+
+    /// Remove the entry with the largest priority
+    void pop() { erase(m_heap[0]); }
+
+    /// Remove an entry
+    void erase(const Handle& h) {
+        std::size_t pos = m_positions[h];
+        Handle last = m_heap.back();
+        m_heap.pop_back();
+        m_freeHandles.push_back(h);
+        if (last == h)
+            return;
+        m_heap[pos] = last;
+        m_positions[last] = pos;
+        if (pos > 0 && m_priorities[m_heap[(pos-1)/D]] < m_priorities[last])
+            siftUp(pos);
+        else
+            siftDown(pos);
+    }
+
+    /// Change the priority of an entry
+    void update(const Handle& h, const Priority& p) {
+        bool increased = m_priorities[h] < p;
+        m_priorities[h] = p;
+        if (increased)
+            siftUp(m_positions[h]);
+        else
+            siftDown(m_positions[h]);
+    }
+
+private:
+    std::vector<Handle> m_heap;         //!< The heap, as an array of handles
+    std::vector<Priority> m_priorities; //!< Priority of each handle
+    std::vector<std::size_t> m_positions; //!< Position of each handle in the heap array
+    std::vector<Handle> m_freeHandles;  //!< Handles of removed entries, to be reused
+
+    void siftUp(std::size_t pos) {
+        Handle h = m_heap[pos];
+        const Priority p = m_priorities[h];
+        while (pos > 0) {
+            std::size_t parent = (pos-1)/D;
+            if (!(m_priorities[m_heap[parent]] < p))
+                break;
+            m_heap[pos] = m_heap[parent];
+            m_positions[m_heap[pos]] = pos;
+            pos = parent;
+        }
+        m_heap[pos] = h;
+        m_positions[h] = pos;
+    }
+
+    void siftDown(std::size_t pos) {
+        Handle h = m_heap[pos];
+        const Priority p = m_priorities[h];
+        const std::size_t n = m_heap.size();
+        while (true) {
+            std::size_t first = pos*D+1;
+            if (first >= n)
+                break;
+            std::size_t last = first+D < n ? first+D : n;
+            std::size_t best = first;
+            for (std::size_t c = first+1; c < last; c++) {
+                if (m_priorities[m_heap[best]] < m_priorities[m_heap[c]])
+                    best = c;
+            }
+            if (!(p < m_priorities[m_heap[best]]))
+                break;
+            m_heap[pos] = m_heap[best];
+            m_positions[m_heap[pos]] = pos;
+            pos = best;
+        }
+        m_heap[pos] = h;
+        m_positions[h] = pos;
+    }
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_INDEXED_DARY_HEAP_H
@@ -0,0 +1,145 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "indexed_mesh.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+
+namespace TinCreation {
+
+// Scratch buffers of computeBorderFlags and removeUnreferencedVertices, kept per thread to be reused between tiles
+struct IndexedMeshBuffers
+{
+    std::vector<std::pair<std::size_t, std::size_t> > edges;
+    std::vector<std::size_t> newIndex;
+};
+
+static IndexedMeshBuffers& indexedMeshBuffers()
+{
+    static thread_local IndexedMeshBuffers buffers;
+    return buffers;
+}
+
+
+
+void computeBorderFlags(IndexedMesh& mesh)
+{
+    mesh.borderFlags.assign(mesh.vertices.size(), 0);
+
+    // Undirected edges of all the triangles, sorted so that the copies of the same edge are consecutive
+    std::vector<std::pair<std::size_t, std::size_t> >& edges = indexedMeshBuffers().edges;
+    edges.clear();
+    edges.reserve(mesh.triangles.size());
+    for (std::size_t t = 0; t+2 < mesh.triangles.size(); t += 3) {
+        for (int k = 0; k < 3; k++) {
+            const std::size_t a = mesh.triangles[t+k], b = mesh.triangles[t+(k+1)%3];
+            edges.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (std::size_t i = 0; i < edges.size(); ) {
+        std::size_t j = i+1;
+        while (j < edges.size() && edges[j] == edges[i])
+            j++;
+
+        if (j-i == 1) {
+            // Boundary edge (no opposite half-edge): flag its vertices with the side closest to its midpoint
+            const std::size_t a = edges[i].first, b = edges[i].second;
+            const double mx = 0.5*(mesh.vertices[a].x() + mesh.vertices[b].x());
+            const double my = 0.5*(mesh.vertices[a].y() + mesh.vertices[b].y());
+            const double dists[4] = { mx, 1.0-mx, my, 1.0-my };
+            const unsigned char sides[4] = { IndexedMesh::BorderWest, IndexedMesh::BorderEast,
+                                             IndexedMesh::BorderSouth, IndexedMesh::BorderNorth };
+            const int side = (int)(std::min_element(dists, dists+4) - dists);
+            mesh.borderFlags[a] |= sides[side];
+            mesh.borderFlags[b] |= sides[side];
+        }
+
+        i = j;
+    }
+}
+
+
+
+void removeUnreferencedVertices(IndexedMesh& mesh)
+{
+    const std::size_t noIndex = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t>& newIndex = indexedMeshBuffers().newIndex;
+    newIndex.assign(mesh.vertices.size(), noIndex);
+    for (std::size_t i = 0; i < mesh.triangles.size(); i++)
+        newIndex[mesh.triangles[i]] = 0;
+
+    std::size_t numUsed = 0;
+    for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+        if (newIndex[i] == noIndex)
+            continue;
+        newIndex[i] = numUsed;
+        mesh.vertices[numUsed] = mesh.vertices[i];
+        if (!mesh.borderFlags.empty())
+            mesh.borderFlags[numUsed] = mesh.borderFlags[i];
+        numUsed++;
+    }
+    if (numUsed == mesh.vertices.size())
+        return;
+
+    mesh.vertices.resize(numUsed);
+    if (!mesh.borderFlags.empty())
+        mesh.borderFlags.resize(numUsed);
+    for (std::size_t i = 0; i < mesh.triangles.size(); i++)
+        mesh.triangles[i] = newIndex[mesh.triangles[i]];
+}
+
+
+
+void polyhedronToIndexedMesh(const Polyhedron& surface, IndexedMesh& mesh)
+{
+    mesh.clear();
+    mesh.vertices.reserve(surface.size_of_vertices());
+    mesh.triangles.reserve(3*surface.size_of_facets());
+
+    CGAL::Unique_hash_map<Polyhedron::Vertex_const_handle, std::size_t> indices(0, surface.size_of_vertices());
+    for (Polyhedron::Vertex_const_iterator it = surface.vertices_begin(); it != surface.vertices_end(); ++it) {
+        indices[it] = mesh.vertices.size();
+        mesh.vertices.push_back(it->point());
+    }
+
+    for (Polyhedron::Facet_const_iterator it = surface.facets_begin(); it != surface.facets_end(); ++it) {
+        Polyhedron::Halfedge_around_facet_const_circulator j = it->facet_begin();
+        // Facets in our polyhedral surfaces should be triangles
+        CGAL_assertion(CGAL::circulator_size(j) == 3);
+        do {
+            mesh.triangles.push_back(indices[j->vertex()]);
+        } while (++j != it->facet_begin());
+    }
+}
+
+
+
+void indexedMeshToPolyhedron(const IndexedMesh& mesh, Polyhedron& surface)
+{
+    surface.clear();
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(mesh.vertices, mesh.triangles);
+    surface.delegate(builder);
+}
+
+} // End namespace TinCreation
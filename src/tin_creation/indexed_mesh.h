@@ -0,0 +1,113 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_INDEXED_MESH_H
+#define EMODNET_QMGC_INDEXED_MESH_H
+
+#include <cstddef>
+#include <vector>
+#include <CGAL/Unique_hash_map.h>
+#include "tin_creation_cgal_types.h"
+
+namespace TinCreation {
+
+/**
+ * @struct IndexedMesh
+ * @brief Compact triangle mesh of a tile: flat arrays of vertices and triangles, plus the sides of the tile where each
+ * vertex lies.
+ *
+ * This is the output of TinCreationStrategy::createIndexedMesh, consumed directly by QuantizedMeshTiler to encode the
+ * tiles, so that no Polyhedron has to be built (and traversed) for each tile. Strategies may leave vertices not
+ * referenced by any triangle (e.g., repeated input points), TinCreator removes them (see removeUnreferencedVertices).
+ */
+struct IndexedMesh
+{
+    /// Sides of the tile where a vertex may lie (combined as bit flags)
+    enum BorderFlag { BorderWest = 1, BorderEast = 2, BorderSouth = 4, BorderNorth = 8 };
+
+    std::vector<Point_3> vertices;          //!< Vertices, in u/v/h coordinates
+    std::vector<std::size_t> triangles;     //!< Indices of the vertices of each triangle (3 consecutive indices per triangle, counterclockwise)
+    std::vector<unsigned char> borderFlags; //!< Sides of the tile where each vertex lies (combination of BorderFlag, see computeBorderFlags)
+
+    std::size_t numVertices() const { return vertices.size(); }
+    std::size_t numTriangles() const { return triangles.size()/3; }
+
+    void clear() { vertices.clear(); triangles.clear(); borderFlags.clear(); }
+};
+
+/**
+ * @brief Flag the vertices of the mesh lying on the sides of the tile.
+ *
+ * The sides are taken from the topology of the mesh instead of the coordinates of the vertices, which the simplification
+ * methods may have moved slightly off the sides: the vertices on the sides are the ones of the boundary edges (i.e.,
+ * edges of a single triangle), and each boundary edge lies on the side of the tile closest to its midpoint.
+ * Unreferenced vertices are not flagged.
+ *
+ * \pre The mesh covers the tile without holes, so all its boundary edges are on the sides of the tile
+ */
+void computeBorderFlags(IndexedMesh& mesh);
+
+/**
+ * @brief Remove the vertices not referenced by any triangle, keeping the order of the remaining ones
+ */
+void removeUnreferencedVertices(IndexedMesh& mesh);
+
+/**
+ * @brief Convert a Polyhedron to an indexed mesh (without border flags)
+ * \pre All the faces of the Polyhedron are triangles
+ */
+void polyhedronToIndexedMesh(const Polyhedron& surface, IndexedMesh& mesh);
+
+/**
+ * @brief Build a Polyhedron from an indexed mesh
+ */
+void indexedMeshToPolyhedron(const IndexedMesh& mesh, Polyhedron& surface);
+
+/**
+ * @brief Convert a projected triangulation (see PolyhedronBuilderFromProjectedTriangulation) to an indexed mesh
+ * (without border flags)
+ */
+template <class ProjectedTriangulation2>
+void projectedTriangulationToIndexedMesh(const ProjectedTriangulation2& tri, IndexedMesh& mesh)
+{
+    typedef typename ProjectedTriangulation2::Vertex_handle VertexHandle;
+
+    mesh.clear();
+    mesh.vertices.reserve(tri.number_of_vertices());
+    mesh.triangles.reserve(3*tri.number_of_faces());
+
+    CGAL::Unique_hash_map<VertexHandle, std::size_t> indices(0, tri.number_of_vertices());
+    for (typename ProjectedTriangulation2::Finite_vertices_iterator it = tri.finite_vertices_begin();
+         it != tri.finite_vertices_end(); ++it) {
+        indices[it] = mesh.vertices.size();
+        mesh.vertices.push_back(it->point());
+    }
+
+    for (typename ProjectedTriangulation2::Finite_faces_iterator it = tri.finite_faces_begin();
+         it != tri.finite_faces_end(); ++it) {
+        mesh.triangles.push_back(indices[it->vertex(0)]);
+        mesh.triangles.push_back(indices[it->vertex(1)]);
+        mesh.triangles.push_back(indices[it->vertex(2)]);
+    }
+}
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_INDEXED_MESH_H
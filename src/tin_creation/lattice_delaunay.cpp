@@ -0,0 +1,375 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "lattice_delaunay.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace TinCreation {
+
+const std::uint32_t LatticeDelaunay::InvalidIndex;
+const std::int32_t LatticeDelaunay::MaxCoordinate;
+
+// Tolerance, in lattice units, to consider that a coordinate is an integer
+static const double kLatticeTolerance = 1e-6;
+
+// Order of the Hilbert curve used to sort the insertions (covers [0..MaxCoordinate])
+static const std::uint32_t kHilbertSide = 1 << 14;
+
+static inline std::uint32_t nextHalfEdge(const std::uint32_t& e) { return e % 3 == 2 ? e-2 : e+1; }
+static inline std::uint32_t prevHalfEdge(const std::uint32_t& e) { return e % 3 == 0 ? e+2 : e-1; }
+
+// Twice the signed area of triangle (a, b, p): positive if counterclockwise
+static inline std::int64_t orientation(const std::int32_t* a, const std::int32_t* b, const std::int32_t* p)
+{
+    return (std::int64_t)(b[0]-a[0])*(p[1]-a[1]) - (std::int64_t)(b[1]-a[1])*(p[0]-a[0]);
+}
+
+// Positive if p is strictly inside the circumcircle of the counterclockwise triangle (a, b, c). With coordinates up to
+// 2^14, each of the three terms is below 2^59, so the result is exact in 64 bits
+static inline std::int64_t inCircle(const std::int32_t* a, const std::int32_t* b, const std::int32_t* c,
+                                    const std::int32_t* p)
+{
+    const std::int64_t dx = a[0]-p[0], dy = a[1]-p[1];
+    const std::int64_t ex = b[0]-p[0], ey = b[1]-p[1];
+    const std::int64_t fx = c[0]-p[0], fy = c[1]-p[1];
+    const std::int64_t ap = dx*dx + dy*dy;
+    const std::int64_t bp = ex*ex + ey*ey;
+    const std::int64_t cp = fx*fx + fy*fy;
+    return dx*(ey*cp - bp*fy) - dy*(ex*cp - bp*fx) + ap*(ex*fy - ey*fx);
+}
+
+// Position of a lattice point along a Hilbert curve, so that consecutive insertions are close to each other
+static std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y)
+{
+    std::uint64_t d = 0;
+    for (std::uint32_t s = kHilbertSide/2; s > 0; s /= 2) {
+        const std::uint32_t rx = (x & s) > 0 ? 1 : 0;
+        const std::uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += (std::uint64_t)s*s*((3*rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = kHilbertSide-1-x;
+                y = kHilbertSide-1-y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+
+
+bool LatticeDelaunay::triangulate(const std::vector<std::int32_t>& coords)
+{
+    clear();
+
+    const std::size_t numPts = coords.size()/2;
+    if (numPts < 4 || numPts >= InvalidIndex)
+        return false;
+    m_coords = coords.data();
+
+    // Bounding rectangle
+    std::int32_t minX = coords[0], maxX = coords[0], minY = coords[1], maxY = coords[1];
+    for (std::size_t i = 1; i < numPts; i++) {
+        minX = std::min(minX, coords[2*i]);
+        maxX = std::max(maxX, coords[2*i]);
+        minY = std::min(minY, coords[2*i+1]);
+        maxY = std::max(maxY, coords[2*i+1]);
+    }
+    if (minX < 0 || minY < 0 || maxX > MaxCoordinate || maxY > MaxCoordinate || minX == maxX || minY == maxY)
+        return false;
+
+    // Corners of the bounding rectangle (south-west, south-east, north-east, north-west)
+    std::uint32_t corners[4] = { InvalidIndex, InvalidIndex, InvalidIndex, InvalidIndex };
+    for (std::uint32_t i = 0; i < numPts; i++) {
+        const std::int32_t x = coords[2*i], y = coords[2*i+1];
+        int corner = -1;
+        if (x == minX && y == minY) corner = 0;
+        else if (x == maxX && y == minY) corner = 1;
+        else if (x == maxX && y == maxY) corner = 2;
+        else if (x == minX && y == maxY) corner = 3;
+        if (corner >= 0 && corners[corner] == InvalidIndex)
+            corners[corner] = i;
+    }
+    for (int c = 0; c < 4; c++) {
+        if (corners[c] == InvalidIndex)
+            return false;
+    }
+
+    // Initial triangulation of the rectangle, split along its south-west/north-east diagonal
+    m_triangles.reserve(6*numPts);
+    m_halfEdges.reserve(6*numPts);
+    std::uint32_t t0 = addTriangle(), t1 = addTriangle();
+    setTriangle(t0, corners[0], corners[1], corners[2], InvalidIndex);
+    setTriangle(t1, corners[0], corners[2], corners[3], InvalidIndex);
+    link(3*t0+1, InvalidIndex);
+    link(3*t1+1, InvalidIndex);
+    link(3*t0+2, 3*t1);
+
+    // Sort the remaining points along a Hilbert curve
+    m_insertionOrder.reserve(numPts);
+    for (std::uint32_t i = 0; i < numPts; i++) {
+        if (i == corners[0] || i == corners[1] || i == corners[2] || i == corners[3])
+            continue;
+        m_insertionOrder.push_back((hilbertIndex(coords[2*i], coords[2*i+1]) << 32) | i);
+    }
+    std::sort(m_insertionOrder.begin(), m_insertionOrder.end());
+
+    // Incremental insertion
+    std::uint32_t t = t1;
+    for (std::size_t k = 0; k < m_insertionOrder.size(); k++) {
+        const std::uint32_t i = (std::uint32_t)(m_insertionOrder[k] & 0xFFFFFFFF);
+        const std::int32_t* p = m_coords + 2*i;
+
+        // Walk from the last triangle created towards the point. Since the triangulation is always Delaunay, the
+        // visibility walk can not loop, but we bound it anyway for safety
+        std::uint32_t edgeOn = InvalidIndex;
+        bool duplicate = false, moved = true;
+        for (std::size_t steps = 0; moved; steps++) {
+            if (steps > m_triangles.size()) {
+                clear();
+                return false;
+            }
+            moved = duplicate = false;
+            edgeOn = InvalidIndex;
+            for (std::uint32_t e = 3*t; e < 3*t+3; e++) {
+                const std::int32_t* a = m_coords + 2*m_triangles[e];
+                const std::int32_t* b = m_coords + 2*m_triangles[nextHalfEdge(e)];
+                const std::int64_t o = orientation(a, b, p);
+                if (o < 0) {
+                    if (m_halfEdges[e] == InvalidIndex) {
+                        // Can not happen, all the points are inside the initial rectangle
+                        clear();
+                        return false;
+                    }
+                    t = m_halfEdges[e]/3;
+                    moved = true;
+                    break;
+                }
+                if (o == 0) {
+                    if ((a[0] == p[0] && a[1] == p[1]) || (b[0] == p[0] && b[1] == p[1]))
+                        duplicate = true;
+                    edgeOn = e;
+                }
+            }
+        }
+        if (duplicate)
+            continue;
+
+        t = edgeOn == InvalidIndex ? splitTriangle(t, i) : splitEdge(edgeOn, i);
+    }
+
+    m_coords = NULL;
+    m_insertionOrder.clear();
+    return true;
+}
+
+
+
+std::uint32_t LatticeDelaunay::addTriangle()
+{
+    const std::uint32_t t = (std::uint32_t)(m_triangles.size()/3);
+    m_triangles.resize(m_triangles.size()+3, InvalidIndex);
+    m_halfEdges.resize(m_halfEdges.size()+3, InvalidIndex);
+    return t;
+}
+
+
+
+void LatticeDelaunay::setTriangle(const std::uint32_t& t, const std::uint32_t& a, const std::uint32_t& b,
+                                  const std::uint32_t& p, const std::uint32_t& oppositeAB)
+{
+    m_triangles[3*t] = a;
+    m_triangles[3*t+1] = b;
+    m_triangles[3*t+2] = p;
+    link(3*t, oppositeAB);
+}
+
+
+
+void LatticeDelaunay::link(const std::uint32_t& e, const std::uint32_t& opposite)
+{
+    m_halfEdges[e] = opposite;
+    if (opposite != InvalidIndex)
+        m_halfEdges[opposite] = e;
+}
+
+
+
+std::uint32_t LatticeDelaunay::splitTriangle(const std::uint32_t& t, const std::uint32_t& p)
+{
+    const std::uint32_t v0 = m_triangles[3*t], v1 = m_triangles[3*t+1], v2 = m_triangles[3*t+2];
+    const std::uint32_t h0 = m_halfEdges[3*t], h1 = m_halfEdges[3*t+1], h2 = m_halfEdges[3*t+2];
+
+    // Fan of three triangles around p, each with its edge opposite to p in the first half-edge
+    const std::uint32_t t1 = addTriangle(), t2 = addTriangle();
+    setTriangle(t, v0, v1, p, h0);
+    setTriangle(t1, v1, v2, p, h1);
+    setTriangle(t2, v2, v0, p, h2);
+    link(3*t+1, 3*t1+2);
+    link(3*t1+1, 3*t2+2);
+    link(3*t2+1, 3*t+2);
+
+    legalize(3*t);
+    legalize(3*t1);
+    legalize(3*t2);
+
+    return t;
+}
+
+
+
+std::uint32_t LatticeDelaunay::splitEdge(const std::uint32_t& e, const std::uint32_t& p)
+{
+    // Triangle (a, b, c) containing p in its edge a-b, and triangle (b, a, d) at the other side of the edge (if any)
+    const std::uint32_t t = e/3;
+    const std::uint32_t a = m_triangles[e], b = m_triangles[nextHalfEdge(e)], c = m_triangles[prevHalfEdge(e)];
+    const std::uint32_t hbc = m_halfEdges[nextHalfEdge(e)], hca = m_halfEdges[prevHalfEdge(e)];
+    const std::uint32_t o = m_halfEdges[e];
+
+    std::uint32_t u = InvalidIndex, d = InvalidIndex, had = InvalidIndex, hdb = InvalidIndex;
+    if (o != InvalidIndex) {
+        u = o/3;
+        d = m_triangles[prevHalfEdge(o)];
+        had = m_halfEdges[nextHalfEdge(o)];
+        hdb = m_halfEdges[prevHalfEdge(o)];
+    }
+
+    const std::uint32_t t1 = addTriangle();
+    setTriangle(t, b, c, p, hbc);
+    setTriangle(t1, c, a, p, hca);
+    link(3*t+1, 3*t1+2);
+
+    if (o != InvalidIndex) {
+        const std::uint32_t u1 = addTriangle();
+        setTriangle(u, a, d, p, had);
+        setTriangle(u1, d, b, p, hdb);
+        link(3*u+1, 3*u1+2);
+        link(3*t1+1, 3*u+2);
+        link(3*u1+1, 3*t+2);
+        legalize(3*u);
+        legalize(3*u1);
+    }
+    else {
+        // p is on the border, which is kept as it is
+        m_halfEdges[3*t1+1] = InvalidIndex;
+        m_halfEdges[3*t+2] = InvalidIndex;
+    }
+    legalize(3*t);
+    legalize(3*t1);
+
+    return t;
+}
+
+
+
+void LatticeDelaunay::legalize(const std::uint32_t& e)
+{
+    // Lawson flips: e is the edge opposite to the point just inserted (which is the origin of its previous half-edge)
+    m_stack.clear();
+    m_stack.push_back(e);
+    while (!m_stack.empty()) {
+        const std::uint32_t a = m_stack.back();
+        m_stack.pop_back();
+
+        const std::uint32_t b = m_halfEdges[a];
+        if (b == InvalidIndex)
+            continue;
+
+        const std::uint32_t al = nextHalfEdge(a), ar = prevHalfEdge(a);
+        const std::uint32_t bl = prevHalfEdge(b), br = nextHalfEdge(b);
+        const std::uint32_t p0 = m_triangles[ar], pr = m_triangles[a], pl = m_triangles[al], p1 = m_triangles[bl];
+
+        // Cocircular points are left as they are, so that the flips always terminate
+        if (inCircle(m_coords + 2*pr, m_coords + 2*pl, m_coords + 2*p0, m_coords + 2*p1) <= 0)
+            continue;
+
+        // Flip edge pr-pl to p0-p1
+        const std::uint32_t hbl = m_halfEdges[bl], har = m_halfEdges[ar];
+        m_triangles[a] = p1;
+        m_triangles[b] = p0;
+        link(a, hbl);
+        link(b, har);
+        link(ar, bl);
+
+        m_stack.push_back(a);
+        m_stack.push_back(br);
+    }
+}
+
+
+
+void LatticeDelaunay::clear()
+{
+    m_coords = NULL;
+    m_triangles.clear();
+    m_halfEdges.clear();
+    m_stack.clear();
+    m_insertionOrder.clear();
+}
+
+
+
+bool LatticeDelaunay::triangulate(const std::vector<Point_3>& pts)
+{
+    clear();
+    if (pts.size() < 4)
+        return false;
+
+    // Spacing of the lattice, from the smallest difference between two consecutive values in each axis
+    double scale = 0.0;
+    m_sortedValues.resize(pts.size());
+    for (int axis = 0; axis < 2; axis++) {
+        for (std::size_t i = 0; i < pts.size(); i++)
+            m_sortedValues[i] = axis == 0 ? pts[i].x() : pts[i].y();
+        std::sort(m_sortedValues.begin(), m_sortedValues.end());
+
+        const double minDiff = kLatticeTolerance*(m_sortedValues.back()-m_sortedValues.front());
+        double minGap = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 1; i < m_sortedValues.size(); i++) {
+            const double gap = m_sortedValues[i]-m_sortedValues[i-1];
+            if (gap > minDiff && gap < minGap)
+                minGap = gap;
+        }
+        if (minGap == std::numeric_limits<double>::infinity())
+            return false;
+        scale = std::max(scale, std::floor(1.0/minGap + 0.5));
+    }
+    if (scale < 1.0 || scale > MaxCoordinate)
+        return false;
+
+    // Check that all the points are on the lattice
+    m_latticeCoords.resize(2*pts.size());
+    for (std::size_t i = 0; i < pts.size(); i++) {
+        for (int axis = 0; axis < 2; axis++) {
+            const double c = (axis == 0 ? pts[i].x() : pts[i].y())*scale;
+            const double r = std::floor(c + 0.5);
+            if (std::fabs(c-r) > kLatticeTolerance || r < 0.0 || r > MaxCoordinate)
+                return false;
+            m_latticeCoords[2*i+axis] = (std::int32_t)r;
+        }
+    }
+
+    return triangulate(m_latticeCoords);
+}
+
+} // End namespace TinCreation
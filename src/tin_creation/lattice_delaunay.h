@@ -0,0 +1,110 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_LATTICE_DELAUNAY_H
+#define EMODNET_QMGC_LATTICE_DELAUNAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "tin_creation_cgal_types.h"
+
+namespace TinCreation {
+
+/**
+ * @class LatticeDelaunay
+ * @brief Delaunay triangulation of points with integer coordinates, such as the samples of a heightmap.
+ *
+ * Lightweight alternative to the CGAL Delaunay triangulations for the points of a tile, which all come from an integer
+ * lattice before being remapped to u/v in [0..1]. Coordinates are kept as 32-bit integers, so the orientation and
+ * in-circle predicates are exact with plain 64-bit arithmetic (no filtering nor exact number types required), and the
+ * result is stored as compact arrays of 32-bit indices in a half-edge fashion: half-edges 3t, 3t+1 and 3t+2 belong to
+ * triangle t, triangles()[e] is the origin vertex of half-edge e, and halfEdges()[e] is its opposite half-edge in the
+ * neighboring triangle (or InvalidIndex at the border of the triangulation).
+ *
+ * The points are inserted incrementally, in Hilbert curve order, starting from the two triangles covering their
+ * bounding rectangle. Thus, the four corners of the bounding rectangle must be part of the input, as it is always the
+ * case for the points of a tile. Points on the sides of the rectangle split them, so that the borders of the tile are
+ * preserved as they are.
+ */
+class LatticeDelaunay
+{
+public:
+    /// Index marking the absence of an opposite half-edge (i.e., the half-edge is on the border)
+    static const std::uint32_t InvalidIndex = 0xFFFFFFFF;
+
+    /// Maximum value of a coordinate, chosen so that the in-circle predicate can not overflow in 64 bits
+    static const std::int32_t MaxCoordinate = (1 << 14) - 1;
+
+    /**
+     * @brief Triangulate a set of points
+     *
+     * Repeated points are only used once, so some of them may not be referenced by any triangle.
+     *
+     * @param coords The coordinates of the points, interleaved (x0, y0, x1, y1, ...), in [0..MaxCoordinate]
+     * @return False if the points can not be triangulated this way (coordinates out of range, corners of the bounding
+     * rectangle missing or bounding rectangle degenerated), in which case the triangulation is left empty
+     */
+    bool triangulate(const std::vector<std::int32_t>& coords);
+
+    /**
+     * @brief Triangulate a set of points in u/v/h coordinates, if they lie on an integer lattice
+     *
+     * The spacing of the lattice is deduced from the smallest difference between the u (or v) values of the points, so
+     * that the samples of a heightmap remapped to [0..1] (see HeightGridView::u) are mapped back to their column/row.
+     * The same scale is used in both axes, so that the triangulation is also Delaunay in u/v.
+     *
+     * @param pts The points, in u/v/h coordinates
+     * @return False if the points do not lie on a lattice within the range of coordinates, or can not be triangulated
+     * (see above)
+     */
+    bool triangulate(const std::vector<Point_3>& pts);
+
+    /// Indices of the points of each triangle (3 consecutive indices per triangle, counterclockwise)
+    const std::vector<std::uint32_t>& triangles() const { return m_triangles; }
+
+    /// Opposite half-edge of each half-edge, or InvalidIndex if on the border
+    const std::vector<std::uint32_t>& halfEdges() const { return m_halfEdges; }
+
+    /// Number of triangles
+    std::size_t numTriangles() const { return m_triangles.size()/3; }
+
+private:
+    std::uint32_t addTriangle();
+    void setTriangle(const std::uint32_t& t, const std::uint32_t& a, const std::uint32_t& b, const std::uint32_t& p,
+                     const std::uint32_t& oppositeAB);
+    void link(const std::uint32_t& e, const std::uint32_t& opposite);
+    std::uint32_t splitTriangle(const std::uint32_t& t, const std::uint32_t& p);
+    std::uint32_t splitEdge(const std::uint32_t& e, const std::uint32_t& p);
+    void legalize(const std::uint32_t& e);
+    void clear();
+
+    const std::int32_t* m_coords = NULL;
+    std::vector<std::uint32_t> m_triangles;
+    std::vector<std::uint32_t> m_halfEdges;
+    std::vector<std::uint32_t> m_stack;          // Half-edges pending to be legalized (kept to reuse its memory)
+    std::vector<std::uint64_t> m_insertionOrder; // Hilbert index (high bits) and point index (low bits)
+    std::vector<std::int32_t> m_latticeCoords;   // Lattice coordinates of the u/v/h points
+    std::vector<double> m_sortedValues;          // Sorted u (or v) values, to deduce the spacing of the lattice
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_LATTICE_DELAUNAY_H
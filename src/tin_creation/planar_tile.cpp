@@ -0,0 +1,191 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "planar_tile.h"
+#include <algorithm>
+#include <cmath>
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+
+namespace TinCreation {
+
+/**
+ * Apply a function to all the u/v/h samples defining a tile: the valid samples of the grid that are not in a
+ * constrained border, the vertices to preserve in the borders and the constrained corners (same points as in
+ * heightGridToPoints, without creating them). Stops when the function returns false.
+ */
+template <class Function>
+static bool forEachTileSample( const HeightGridView& grid, const HeightGridBorders& borders, Function f )
+{
+    int startCol = borders.constrainWest() ? 1 : 0;
+    int endCol = borders.constrainEast() ? grid.numCols()-1 : grid.numCols();
+    int startRow = borders.constrainSouth() ? 1 : 0;
+    int endRow = borders.constrainNorth() ? grid.numRows()-1 : grid.numRows();
+
+    for ( int r = startRow; r < endRow; r++ ) {
+        const double v = grid.v(r) ;
+        for ( int c = startCol; c < endCol; c++ ) {
+            if ( isConstrainedCornerSample(grid, borders, c, r) || !grid.isValid(c, r) )
+                continue;
+            if ( !f( grid.u(c), v, grid.h(c, r) ) )
+                return false ;
+        }
+    }
+
+    const Polyline* polylines[4] = { &borders.eastern, &borders.western, &borders.northern, &borders.southern } ;
+    for ( int b = 0; b < 4; b++ ) {
+        for ( Polyline::const_iterator it = polylines[b]->begin(); it != polylines[b]->end(); ++it ) {
+            if ( !f( it->x(), it->y(), it->z() ) )
+                return false ;
+        }
+    }
+
+    const bool constrainCorners[4] = { borders.constrainSouthWestCorner, borders.constrainSouthEastCorner,
+                                       borders.constrainNorthWestCorner, borders.constrainNorthEastCorner } ;
+    const Point_3* corners[4] = { &borders.southWestCorner, &borders.southEastCorner,
+                                  &borders.northWestCorner, &borders.northEastCorner } ;
+    for ( int i = 0; i < 4; i++ ) {
+        if ( constrainCorners[i] && !f( corners[i]->x(), corners[i]->y(), corners[i]->z() ) )
+            return false ;
+    }
+
+    return true ;
+}
+
+
+
+bool fitPlaneToHeightGrid( const HeightGridView& grid, const HeightGridBorders& borders,
+                           const double& maxDeviation, TilePlane& plane )
+{
+    // Normal equations of the least squares fit (coordinates centered on the tile)
+    double n = 0, su = 0, sv = 0, suu = 0, suv = 0, svv = 0, sh = 0, suh = 0, svh = 0 ;
+    forEachTileSample( grid, borders, [&]( const double& u, const double& v, const double& h ) {
+        const double uc = u-0.5, vc = v-0.5 ;
+        n += 1 ; su += uc ; sv += vc ;
+        suu += uc*uc ; suv += uc*vc ; svv += vc*vc ;
+        sh += h ; suh += uc*h ; svh += vc*h ;
+        return true ;
+    } ) ;
+    if ( n < 3 )
+        return false ;
+
+    // Solve using Cramer's rule
+    const double det = n*(suu*svv - suv*suv) - su*(su*svv - suv*sv) + sv*(su*suv - suu*sv) ;
+    if ( std::abs(det) < 1e-12 )
+        return false ;
+    plane.a = ( sh*(suu*svv - suv*suv) - su*(suh*svv - suv*svh) + sv*(suh*suv - suu*svh) ) / det ;
+    plane.b = ( n*(suh*svv - suv*svh) - sh*(su*svv - suv*sv) + sv*(su*svh - suh*sv) ) / det ;
+    plane.c = ( n*(suu*svh - suv*suh) - su*(su*svh - suh*sv) + sh*(su*suv - suu*sv) ) / det ;
+
+    // Check the deviations (stops at the first sample too far from the plane)
+    return forEachTileSample( grid, borders, [&]( const double& u, const double& v, const double& h ) {
+        return std::abs( h - plane.eval(u, v) ) <= maxDeviation ;
+    } ) ;
+}
+
+
+
+/// Position of a point along the border of the tile, in [0..4), counterclockwise starting from the south-west corner
+static double borderParameter( const Point_3& p )
+{
+    if ( p.y() <= 0.0 )
+        return p.x() ;          // South
+    else if ( p.x() >= 1.0 )
+        return 1.0 + p.y() ;    // East
+    else if ( p.y() >= 1.0 )
+        return 3.0 - p.x() ;    // North
+    else
+        return 4.0 - p.y() ;    // West
+}
+
+
+
+Polyhedron createFanTileMesh( const std::vector<Point_3>& borderPts, const Point_3& center )
+{
+    // Sort the border points counterclockwise (by their position along the border, and then by their index in borderPts)
+    std::vector<std::pair<double, std::size_t>> sorted ;
+    sorted.reserve( borderPts.size() ) ;
+    for ( std::size_t i = 0; i < borderPts.size(); i++ )
+        sorted.push_back( std::make_pair( borderParameter( borderPts[i] ), i ) ) ;
+    std::sort( sorted.begin(), sorted.end() ) ;
+
+    // Remove the duplicates: of each group of points at the same position, keep the first one in borderPts, so that
+    // the vertices of the neighboring tiles win over the ones sampled or evaluated in this tile
+    std::vector<Point_3> vertices ;
+    vertices.reserve( sorted.size()+1 ) ;
+    vertices.push_back( center ) ;
+    for ( std::size_t i = 0; i < sorted.size(); ) {
+        std::size_t first = sorted[i].second ;
+        std::size_t j = i+1 ;
+        for ( ; j < sorted.size() && sorted[j].first - sorted[j-1].first < 1e-12; j++ )
+            first = std::min( first, sorted[j].second ) ;
+        vertices.push_back( borderPts[first] ) ;
+        i = j ;
+    }
+
+    // Fan of triangles around the center
+    const std::size_t numBorderPts = vertices.size()-1 ;
+    std::vector<std::size_t> triangles ;
+    triangles.reserve( 3*numBorderPts ) ;
+    for ( std::size_t i = 1; i <= numBorderPts; i++ ) {
+        triangles.push_back( 0 ) ;
+        triangles.push_back( i ) ;
+        triangles.push_back( i < numBorderPts ? i+1 : 1 ) ;
+    }
+
+    Polyhedron surface ;
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder( vertices, triangles ) ;
+    surface.delegate( builder ) ;
+
+    return surface ;
+}
+
+
+
+Polyhedron createPlanarTileMesh( const HeightGridView& grid, const HeightGridBorders& borders, const TilePlane& plane )
+{
+    std::vector<Point_3> borderPts ;
+    borderPts.reserve( borders.eastern.size() + borders.western.size() + borders.northern.size() + borders.southern.size() + 4 ) ;
+    borderPts.insert( borderPts.end(), borders.eastern.begin(), borders.eastern.end() ) ;
+    borderPts.insert( borderPts.end(), borders.western.begin(), borders.western.end() ) ;
+    borderPts.insert( borderPts.end(), borders.northern.begin(), borders.northern.end() ) ;
+    borderPts.insert( borderPts.end(), borders.southern.begin(), borders.southern.end() ) ;
+
+    // Corners (SW, SE, NW, NE)
+    const bool constrainCorners[4] = { borders.constrainSouthWestCorner, borders.constrainSouthEastCorner,
+                                       borders.constrainNorthWestCorner, borders.constrainNorthEastCorner } ;
+    const Point_3* corners[4] = { &borders.southWestCorner, &borders.southEastCorner,
+                                  &borders.northWestCorner, &borders.northEastCorner } ;
+    const int cornerCols[4] = { 0, grid.numCols()-1, 0, grid.numCols()-1 } ;
+    const int cornerRows[4] = { 0, 0, grid.numRows()-1, grid.numRows()-1 } ;
+    for ( int i = 0; i < 4; i++ ) {
+        if ( constrainCorners[i] )
+            borderPts.push_back( *corners[i] ) ;
+        else {
+            const double u = cornerCols[i] > 0 ? 1.0 : 0.0 ;
+            const double v = cornerRows[i] > 0 ? 1.0 : 0.0 ;
+            const bool useSample = !grid.empty() && grid.isValid( cornerCols[i], cornerRows[i] ) ;
+            borderPts.push_back( Point_3( u, v, useSample ? grid.h( cornerCols[i], cornerRows[i] ) : plane.eval(u, v) ) ) ;
+        }
+    }
+
+    return createFanTileMesh( borderPts, Point_3( 0.5, 0.5, plane.eval( 0.5, 0.5 ) ) ) ;
+}
+
+} // End namespace TinCreation
@@ -0,0 +1,86 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_PLANAR_TILE_H
+#define EMODNET_QMGC_PLANAR_TILE_H
+
+#include <vector>
+#include "tin_creation_cgal_types.h"
+#include "height_grid.h"
+
+namespace TinCreation {
+
+/**
+ * @struct TilePlane
+ * @brief A plane in u/v/h coordinates, h = a + b*(u-0.5) + c*(v-0.5) (centered on the tile for a better conditioning)
+ */
+struct TilePlane
+{
+    double a, b, c ;
+
+    TilePlane() : a(0.0), b(0.0), c(0.0) {}
+    TilePlane( const double& a, const double& b, const double& c ) : a(a), b(b), c(c) {}
+
+    /// Height of the plane at a given u/v position
+    double eval( const double& u, const double& v ) const { return a + b*(u-0.5) + c*(v-0.5) ; }
+};
+
+/**
+ * @brief Check if a tile is planar, and get the plane
+ *
+ * Fits a plane to the valid samples of the grid and the vertices to preserve in the borders (least squares), and
+ * checks that all of them are within a given vertical distance to it.
+ *
+ * @param grid The height grid
+ * @param borders The constraints on the borders
+ * @param maxDeviation Maximum vertical distance of the samples to the plane, in normalized height units
+ * @param[out] plane The fitted plane
+ * @return True if all the samples are within \p maxDeviation of the plane
+ */
+bool fitPlaneToHeightGrid( const HeightGridView& grid, const HeightGridBorders& borders,
+                           const double& maxDeviation, TilePlane& plane ) ;
+
+/**
+ * @brief Create a minimal mesh for a tile, as a fan of triangles around a center vertex
+ *
+ * @param borderPts The vertices in the borders of the tile (u or v equal to 0 or 1), in any order. They must include the 4 corners.
+ *                  When several of them are at the same position, the first one in the vector is kept (i.e., put the
+ *                  vertices to preserve from the neighboring tiles first).
+ * @param center The central vertex of the fan
+ * @return The mesh of the tile
+ */
+Polyhedron createFanTileMesh( const std::vector<Point_3>& borderPts, const Point_3& center ) ;
+
+/**
+ * @brief Create the minimal mesh approximating a planar tile: the vertices to preserve at the borders, the 4 corners
+ * and a central vertex on the plane, triangulated as a fan.
+ *
+ * The unconstrained corners take the height of the corresponding sample of the grid, or the one of the plane if not valid.
+ *
+ * @param grid The height grid
+ * @param borders The constraints on the borders
+ * @param plane The plane approximating the tile (see fitPlaneToHeightGrid)
+ * @return The mesh of the tile
+ */
+Polyhedron createPlanarTileMesh( const HeightGridView& grid, const HeightGridBorders& borders, const TilePlane& plane ) ;
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_PLANAR_TILE_H
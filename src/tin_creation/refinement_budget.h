@@ -0,0 +1,157 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_REFINEMENT_BUDGET_H
+#define EMODNET_QMGC_REFINEMENT_BUDGET_H
+
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+namespace TinCreation {
+
+/// Criterion that stopped the refinement of the last TIN created
+enum StopCriterion {
+    StopNotApplicable = 0,  //!< The strategy does not refine the TIN incrementally (or no TIN was created)
+    StopErrorTolerance,     //!< All the samples are within the error tolerance
+    StopMaxVertices,        //!< The maximum number of vertices was reached
+    StopMaxBytes,           //!< The estimated size of the encoded tile reached the maximum
+    StopTimeBudget,         //!< The time budget was consumed
+    NumStopCriteria
+};
+
+/// Human readable name of a stop criterion
+inline std::string stopCriterionName(const int& criterion)
+{
+    switch (criterion) {
+        case StopErrorTolerance: return "error tolerance";
+        case StopMaxVertices: return "max. vertices";
+        case StopMaxBytes: return "max. bytes";
+        case StopTimeBudget: return "time budget";
+        default: return "not applicable";
+    }
+}
+
+/**
+ * @brief Estimated size, in bytes, of a tile with the given number of vertices encoded in quantized-mesh format.
+ *
+ * Accounts for the header, the vertex data and the indices of the roughly 2*numVertices triangles of the TIN (using
+ * 32-bit indices above 64k vertices, as done when writing the tile). The edge indices and the extensions are not
+ * considered, and the size is before compression.
+ */
+inline std::size_t estimateEncodedTileSize(const std::size_t& numVertices)
+{
+    const std::size_t headerSize = 88 + 4 + 1 + 4 + 16; // Header, vertex count, padding, triangle count, edge counts
+    const std::size_t bytesPerIndex = numVertices > 64*1024 ? 4 : 2;
+    return headerSize + 6*numVertices + 3*bytesPerIndex*2*numVertices;
+}
+
+/**
+ * @struct RefinementBudget
+ * @brief Limits to the refinement of a TIN, in addition to the error tolerance of the strategy.
+ *
+ * Strategies inserting points by decreasing error can be stopped at any moment, so the TIN obtained when a budget
+ * runs out is the best approximation the strategy could reach within it.
+ */
+struct RefinementBudget
+{
+    std::size_t maxVertices = 0; //!< Maximum number of vertices of the TIN (disabled if 0)
+    std::size_t maxBytes = 0;    //!< Maximum estimated size of the encoded tile, see estimateEncodedTileSize (disabled if 0)
+    double maxMilliseconds = 0;  //!< Maximum time spent refining the TIN (disabled if <= 0)
+};
+
+/**
+ * @class RefinementBudgetTracker
+ * @brief Checks the budgets during the refinement of a TIN, and records which criterion stopped it
+ */
+class RefinementBudgetTracker
+{
+public:
+    RefinementBudgetTracker() : m_vertexLimit(0), m_vertexLimitCriterion(StopMaxVertices), m_stopCriterion(StopNotApplicable) {}
+
+    /// Start tracking a new refinement (assumes it stops because of the error tolerance until a budget runs out)
+    void start(const RefinementBudget& budget)
+    {
+        m_budget = budget;
+        m_start = std::chrono::steady_clock::now();
+        m_stopCriterion = StopErrorTolerance;
+
+        // The byte budget is translated to a number of vertices
+        m_vertexLimit = budget.maxVertices;
+        m_vertexLimitCriterion = StopMaxVertices;
+        if (budget.maxBytes > 0) {
+            std::size_t n = maxVerticesForSize(budget.maxBytes);
+            if (m_vertexLimit == 0 || n < m_vertexLimit) {
+                m_vertexLimit = n;
+                m_vertexLimitCriterion = StopMaxBytes;
+            }
+        }
+    }
+
+    /// Check if any of the budgets ran out, given the current number of vertices of the TIN
+    bool exhausted(const std::size_t& numVertices)
+    {
+        if (m_vertexLimit > 0 && numVertices >= m_vertexLimit) {
+            m_stopCriterion = m_vertexLimitCriterion;
+            return true;
+        }
+        if (m_budget.maxMilliseconds > 0 &&
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count() >= m_budget.maxMilliseconds) {
+            m_stopCriterion = StopTimeBudget;
+            return true;
+        }
+        return false;
+    }
+
+    /// Number of vertices that can still be inserted without exceeding the vertex/byte budgets (0 if unlimited)
+    std::size_t remainingVertices(const std::size_t& numVertices) const
+    {
+        if (m_vertexLimit == 0)
+            return 0;
+        return numVertices < m_vertexLimit ? m_vertexLimit - numVertices : 1;
+    }
+
+    /// The criterion that stopped the last refinement
+    StopCriterion stopCriterion() const { return m_stopCriterion; }
+
+    /// Largest number of vertices whose estimated encoded size fits in the given size
+    static std::size_t maxVerticesForSize(const std::size_t& bytes)
+    {
+        const std::size_t headerSize = estimateEncodedTileSize(0);
+        if (bytes <= headerSize)
+            return 1;
+        std::size_t n = (bytes - headerSize)/18; // 16-bit indices
+        if (n > 64*1024)
+            n = std::max<std::size_t>((bytes - headerSize)/30, 64*1024); // 32-bit indices
+        return std::max<std::size_t>(n, 1);
+    }
+
+private:
+    RefinementBudget m_budget;
+    std::chrono::steady_clock::time_point m_start;
+    std::size_t m_vertexLimit;
+    StopCriterion m_vertexLimitCriterion;
+    StopCriterion m_stopCriterion;
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_REFINEMENT_BUDGET_H
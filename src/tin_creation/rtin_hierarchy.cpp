@@ -0,0 +1,215 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "rtin_hierarchy.h"
+#include <algorithm>
+#include <cmath>
+
+namespace TinCreation {
+
+// Integer division rounding towards -infinity
+static inline long long floorDiv(const long long& a, const long long& b)
+{
+    long long q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0)))
+        q--;
+    return q;
+}
+
+
+bool RtinHierarchy::isValidGridSize(const int& gridSize)
+{
+    const int tileSize = gridSize-1;
+    return tileSize > 0 && (tileSize & (tileSize-1)) == 0;
+}
+
+
+int RtinHierarchy::validGridSizeFor(const int& gridSize)
+{
+    int tileSize = 1;
+    while (tileSize+1 < gridSize)
+        tileSize *= 2;
+    return tileSize+1;
+}
+
+
+bool RtinHierarchy::build(const std::vector<double>& heights, const int& gridSize)
+{
+    return build(heights, gridSize, heights, gridSize, gridSize);
+}
+
+
+bool RtinHierarchy::build(const std::vector<double>& heights, const int& gridSize,
+                          const std::vector<double>& samples, const int& numCols, const int& numRows)
+{
+    if (!isValidGridSize(gridSize) || heights.size() != (std::size_t)gridSize*gridSize ||
+        numCols < 2 || numRows < 2 || samples.size() != (std::size_t)numCols*numRows)
+        return false;
+
+    const int tileSize = gridSize-1;
+    const int numTriangles = tileSize*tileSize*2 - 2;
+    const int numParentTriangles = numTriangles - tileSize*tileSize;
+
+    // The coordinates of the triangles only depend on the grid size, compute them once
+    if (gridSize != m_gridSize) {
+        m_gridSize = gridSize;
+        m_coords.resize(4*(std::size_t)numTriangles);
+        for (int i = 0; i < numTriangles; i++) {
+            // The binary representation of the id encodes the path of splits from one of the two root triangles
+            int id = i + 2;
+            int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+            if (id & 1) {
+                bx = by = cx = tileSize; // Root triangle (0,0)-(n,n)-(n,0)
+            } else {
+                ax = ay = cy = tileSize; // Root triangle (n,n)-(0,0)-(0,n)
+            }
+            while ((id >>= 1) > 1) {
+                const int mx = (ax + bx) >> 1;
+                const int my = (ay + by) >> 1;
+                if (id & 1) { // Left half
+                    bx = ax; by = ay;
+                    ax = cx; ay = cy;
+                } else { // Right half
+                    ax = bx; ay = by;
+                    bx = cx; by = cy;
+                }
+                cx = mx; cy = my;
+            }
+            m_coords[4*i] = ax;
+            m_coords[4*i+1] = ay;
+            m_coords[4*i+2] = bx;
+            m_coords[4*i+3] = by;
+        }
+    }
+
+    m_heights = heights;
+    m_samples = samples;
+    m_numSampleCols = numCols;
+    m_numSampleRows = numRows;
+    m_errors.assign(heights.size(), 0.0);
+
+    // From the smallest triangles to the largest ones, so that the errors of the children are ready for their parents
+    for (int i = numTriangles-1; i >= 0; i--) {
+        const int ax = m_coords[4*i], ay = m_coords[4*i+1], bx = m_coords[4*i+2], by = m_coords[4*i+3];
+        const int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+        const int cx = mx + my - ay, cy = my + ax - mx;
+
+        const int middleIndex = my*gridSize + mx;
+        double& middleError = m_errors[middleIndex];
+        middleError = std::max(middleError, triangleError(ax, ay, bx, by, cx, cy));
+
+        if (i < numParentTriangles) {
+            const int leftChildIndex = ((ay + cy) >> 1)*gridSize + ((ax + cx) >> 1);
+            const int rightChildIndex = ((by + cy) >> 1)*gridSize + ((bx + cx) >> 1);
+            middleError = std::max(middleError, std::max(m_errors[leftChildIndex], m_errors[rightChildIndex]));
+        }
+    }
+
+    return true;
+}
+
+
+double RtinHierarchy::triangleError(const int& ax, const int& ay, const int& bx, const int& by,
+                                    const int& cx, const int& cy) const
+{
+    // Plane of the triangle, as h = h0 + gx*(x-cx) + gy*(y-cy) (the triangles are never degenerate)
+    const double area2 = (double)(bx-ax)*(cy-ay) - (double)(by-ay)*(cx-ax);
+    const double ha = m_heights[ay*m_gridSize + ax], hb = m_heights[by*m_gridSize + bx], hc = m_heights[cy*m_gridSize + cx];
+    const double gx = ((ha-hc)*(by-cy) - (hb-hc)*(ay-cy))/area2;
+    const double gy = ((hb-hc)*(ax-cx) - (ha-hc)*(bx-cx))/area2;
+
+    // Integer coordinates common to both grids: the grid of the hierarchy is scaled by the number of cells of the
+    // samples grid, and the other way around, so that the vertices of the triangle and the samples have exact positions
+    const long long tileSize = m_gridSize-1, scaleX = m_numSampleCols-1, scaleY = m_numSampleRows-1;
+    const long long px[3] = { ax*scaleX, bx*scaleX, cx*scaleX }, py[3] = { ay*scaleY, by*scaleY, cy*scaleY };
+
+    // Scan the rows of samples covered by the triangle, computing the range of samples within it (borders included) from its edges
+    const long long sign = area2 > 0 ? 1 : -1;
+    const long long minRow = -floorDiv(-std::min(py[0], std::min(py[1], py[2])), tileSize);
+    const long long maxRow = floorDiv(std::max(py[0], std::max(py[1], py[2])), tileSize);
+    double maxError = 0.0;
+    for (long long row = minRow; row <= maxRow; row++) {
+        const long long y = row*tileSize;
+        long long colMin = 0, colMax = m_numSampleCols-1;
+        for (int i = 0; i < 3; i++) {
+            const int j = (i+1)%3;
+            // Inside (or on) the edge i->j: sign*(dx*(y-py[i]) - dy*(x-px[i])) >= 0, with x = col*tileSize
+            const long long dx = sign*(px[j]-px[i]), dy = sign*(py[j]-py[i]);
+            const long long k = dx*(y-py[i]) + dy*px[i]; // dy*tileSize*col <= k
+            if (dy > 0)
+                colMax = std::min(colMax, floorDiv(k, dy*tileSize));
+            else if (dy < 0)
+                colMin = std::max(colMin, -floorDiv(k, -dy*tileSize)); // ceil(k/(dy*tileSize))
+            else if (dx*(y-py[i]) < 0)
+                colMax = -1;
+        }
+        const double* samples = &m_samples[row*m_numSampleCols];
+        const double rowHeight = hc + gy*((double)y/scaleY - cy);
+        const double colStep = (double)tileSize/scaleX; // Distance between samples, in cells of the hierarchy grid
+        for (long long col = colMin; col <= colMax; col++)
+            maxError = std::max(maxError, std::fabs(rowHeight + gx*(col*colStep - cx) - samples[col]));
+    }
+    return maxError;
+}
+
+
+void RtinHierarchy::extract(const double& maxError, std::vector<int>& vertices, std::vector<std::size_t>& triangles)
+{
+    vertices.clear();
+    triangles.clear();
+    if (m_gridSize == 0)
+        return;
+
+    m_vertexIndex.assign((std::size_t)m_gridSize*m_gridSize, -1);
+    const int tileSize = m_gridSize-1;
+    extractTriangle(0, 0, tileSize, tileSize, tileSize, 0, maxError, vertices, triangles);
+    extractTriangle(tileSize, tileSize, 0, 0, 0, tileSize, maxError, vertices, triangles);
+}
+
+
+void RtinHierarchy::extractTriangle(const int& ax, const int& ay, const int& bx, const int& by, const int& cx, const int& cy,
+                                    const double& maxError, std::vector<int>& vertices, std::vector<std::size_t>& triangles)
+{
+    const int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+    if (std::abs(ax - cx) + std::abs(ay - cy) > 1 && m_errors[my*m_gridSize + mx] > maxError) {
+        // Split through the midpoint of the hypotenuse
+        extractTriangle(cx, cy, ax, ay, mx, my, maxError, vertices, triangles);
+        extractTriangle(bx, by, cx, cy, mx, my, maxError, vertices, triangles);
+        return;
+    }
+
+    // All the triangles of the hierarchy are clockwise, flip them
+    triangles.push_back(vertexIndex(ax, ay, vertices));
+    triangles.push_back(vertexIndex(cx, cy, vertices));
+    triangles.push_back(vertexIndex(bx, by, vertices));
+}
+
+
+std::size_t RtinHierarchy::vertexIndex(const int& x, const int& y, std::vector<int>& vertices)
+{
+    int& index = m_vertexIndex[y*m_gridSize + x];
+    if (index < 0) {
+        index = (int)vertices.size();
+        vertices.push_back(y*m_gridSize + x);
+    }
+    return (std::size_t)index;
+}
+
+} // End namespace TinCreation
@@ -0,0 +1,118 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_RTIN_HIERARCHY_H
+#define EMODNET_QMGC_RTIN_HIERARCHY_H
+
+#include <cstddef>
+#include <vector>
+
+namespace TinCreation {
+
+/**
+ * @class RtinHierarchy
+ * @brief Error hierarchy of a right-triangulated irregular network (RTIN) over a square grid of (2^k+1)x(2^k+1) heights.
+ *
+ * An RTIN is obtained by recursively splitting the two right triangles covering the grid through the midpoint of their
+ * hypotenuse. The error of each triangle is stored at the midpoint of its hypotenuse, and propagated to the parents, in
+ * a single pass over the hierarchy. Then, meshes for any tolerance can be extracted in time proportional to the output.
+ * The splits are always compatible between neighboring triangles, so that the extracted meshes do not contain
+ * T-junctions.
+ *
+ * Contrary to the usual formulation, which only considers the error at the midpoint of the hypotenuse (O(n)), the
+ * error of a triangle is the maximum vertical distance between its plane and all the samples it covers (O(n log n)).
+ * The samples can be those of the (2^k+1)x(2^k+1) grid itself, or those of another grid covering the same square
+ * (e.g., the original grid of a tile, when the heights of the hierarchy are resampled from it). In the first case, the
+ * extracted meshes fulfill the tolerance at every sample. In the second one, they do at every sample but those
+ * covered by the smallest triangles of the hierarchy, which are never split and whose error is the one of the
+ * resampling (i.e., at most the variation of the heights within a cell of the original grid).
+ *
+ * Based on the approach in:
+ *
+ * W. Evans, D. Kirkpatrick, G. Townsend, Right-Triangulated Irregular Networks, Algorithmica 30 (2001) 264-286.
+ *
+ * Popularized for terrain tiles by the MARTINI library (https://github.com/mapbox/martini).
+ */
+class RtinHierarchy
+{
+public:
+    /// Constructor
+    RtinHierarchy() : m_gridSize(0), m_numSampleCols(0), m_numSampleRows(0) {}
+
+    /**
+     * @brief Compute the errors of the hierarchy for a grid of heights
+     * @param heights Heights of the grid, row by row (the index of the sample at column x and row y is y*gridSize+x)
+     * @param gridSize Number of samples per side (must be 2^k+1)
+     * @return False if the size is not valid
+     */
+    bool build(const std::vector<double>& heights, const int& gridSize);
+
+    /**
+     * @brief Compute the errors of the hierarchy for a grid of heights, measured against the samples of another grid
+     * covering the same square
+     * @param heights Heights of the grid of the hierarchy, row by row (the index of the sample at column x and row y is y*gridSize+x)
+     * @param gridSize Number of samples per side of the grid of the hierarchy (must be 2^k+1)
+     * @param samples Heights against which the errors are measured, row by row (the index of the sample at column x
+     * and row y is y*numCols+x). The corners of both grids must coincide
+     * @param numCols Number of columns of \p samples
+     * @param numRows Number of rows of \p samples
+     * @return False if the sizes are not valid
+     */
+    bool build(const std::vector<double>& heights, const int& gridSize,
+               const std::vector<double>& samples, const int& numCols, const int& numRows);
+
+    /**
+     * @brief Extract the mesh for a given tolerance
+     * @param maxError Maximum vertical error allowed, in the units of the heights
+     * @param[out] vertices Grid indices (y*gridSize+x) of the vertices of the mesh
+     * @param[out] triangles Indices to \p vertices of the triangles, three per triangle, counterclockwise
+     */
+    void extract(const double& maxError, std::vector<int>& vertices, std::vector<std::size_t>& triangles);
+
+    /// Number of samples per side of the grid
+    int gridSize() const { return m_gridSize; }
+
+    /// Check if a grid size is valid (i.e., 2^k+1)
+    static bool isValidGridSize(const int& gridSize);
+
+    /// Smallest valid grid size (i.e., 2^k+1) containing a grid of the given size
+    static int validGridSizeFor(const int& gridSize);
+
+private:
+    int m_gridSize;
+    std::vector<int> m_coords;      //!< Coordinates of the hypotenuse (ax, ay, bx, by) of all the triangles of the hierarchy, depend on the grid size only
+    std::vector<double> m_heights;
+    std::vector<double> m_samples;  //!< Heights against which the errors are measured
+    int m_numSampleCols, m_numSampleRows;
+    std::vector<double> m_errors;   //!< Error of each sample of the grid, as midpoint of a hypotenuse, propagated to the parents
+    std::vector<int> m_vertexIndex; //!< Scratch: index in the output vertices of each sample (-1 if not used)
+
+    /// Maximum vertical distance between the samples in m_samples within a triangle (borders included) and its plane
+    double triangleError(const int& ax, const int& ay, const int& bx, const int& by, const int& cx, const int& cy) const;
+
+    void extractTriangle(const int& ax, const int& ay, const int& bx, const int& by, const int& cx, const int& cy,
+                         const double& maxError, std::vector<int>& vertices, std::vector<std::size_t>& triangles);
+
+    std::size_t vertexIndex(const int& x, const int& y, std::vector<int>& vertices);
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_RTIN_HIERARCHY_H
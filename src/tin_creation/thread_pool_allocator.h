@@ -0,0 +1,162 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_THREAD_POOL_ALLOCATOR_H
+#define EMODNET_QMGC_THREAD_POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace TinCreation {
+
+namespace internal {
+
+/**
+ * @class ThreadBlockPool
+ * @brief Free list of memory blocks of a fixed size, one per thread.
+ *
+ * Released blocks are kept in the free list of the releasing thread and handed back by the next allocations of that
+ * thread, so that, once a thread has processed its first tiles, building and destroying meshes of similar sizes does
+ * not go through malloc anymore. The blocks are returned to the system when the thread finishes, so this only pays off
+ * when the threads outlive the tiles (QuantizedMeshTilesPyramidBuilder runs each tiler on a persistent worker thread).
+ */
+template <std::size_t BlockSize>
+class ThreadBlockPool
+{
+public:
+    static void* allocate()
+    {
+        FreeList& fl = freeList();
+        if (s_released || fl.head == NULL)
+            return ::operator new(BlockSize);
+        Node* n = fl.head;
+        fl.head = n->next;
+        return n;
+    }
+
+    static void deallocate(void* p)
+    {
+        // Blocks released after the pool of the thread has been destroyed (e.g., by static objects) go to the system
+        if (s_released) {
+            ::operator delete(p);
+            return;
+        }
+        FreeList& fl = freeList();
+        Node* n = static_cast<Node*>(p);
+        n->next = fl.head;
+        fl.head = n;
+    }
+
+private:
+    struct Node { Node* next; };
+
+    struct FreeList
+    {
+        Node* head = NULL;
+        ~FreeList()
+        {
+            while (head != NULL) {
+                Node* n = head;
+                head = head->next;
+                ::operator delete(n);
+            }
+            s_released = true;
+        }
+    };
+
+    static FreeList& freeList()
+    {
+        static thread_local FreeList fl;
+        return fl;
+    }
+
+    static thread_local bool s_released;
+};
+
+template <std::size_t BlockSize>
+thread_local bool ThreadBlockPool<BlockSize>::s_released = false;
+
+} // End namespace internal
+
+
+
+/**
+ * @class ThreadPoolAllocator
+ * @brief Allocator recycling the single-element allocations in per-thread free lists (see internal::ThreadBlockPool).
+ *
+ * Meant for node-based containers with many small allocations, such as the lists of vertices, halfedges and faces of
+ * the Polyhedron used to represent each tile. Allocations of more than one element go directly to the system.
+ */
+template <class T>
+class ThreadPoolAllocator
+{
+public:
+    typedef T                   value_type;
+    typedef T*                  pointer;
+    typedef const T*            const_pointer;
+    typedef T&                  reference;
+    typedef const T&            const_reference;
+    typedef std::size_t         size_type;
+    typedef std::ptrdiff_t      difference_type;
+
+    template <class U> struct rebind { typedef ThreadPoolAllocator<U> other; };
+
+    ThreadPoolAllocator() {}
+    template <class U> ThreadPoolAllocator(const ThreadPoolAllocator<U>&) {}
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+    size_type max_size() const { return std::size_t(-1)/sizeof(T); }
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        if (n == 1)
+            return static_cast<pointer>(Pool::allocate());
+        return static_cast<pointer>(::operator new(n*sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (n == 1)
+            Pool::deallocate(p);
+        else
+            ::operator delete(p);
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...); }
+
+    template <class U>
+    void destroy(U* p) { p->~U(); }
+
+private:
+    typedef internal::ThreadBlockPool<(sizeof(T) > sizeof(void*) ? sizeof(T) : sizeof(void*))> Pool;
+};
+
+template <class T, class U>
+inline bool operator==(const ThreadPoolAllocator<T>&, const ThreadPoolAllocator<U>&) { return true; }
+
+template <class T, class U>
+inline bool operator!=(const ThreadPoolAllocator<T>&, const ThreadPoolAllocator<U>&) { return false; }
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_THREAD_POOL_ALLOCATOR_H
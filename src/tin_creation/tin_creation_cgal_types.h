@@ -41,9 +41,12 @@
 #include <CGAL/Polyhedral_mesh_domain_with_features_3.h>
 #include <CGAL/Projection_traits_xy_3.h>
 #include <CGAL/Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
 #include <CGAL/Polyhedron_incremental_builder_3.h>
 #include <CGAL/HalfedgeDS_vector.h>
 #include <CGAL/Polyhedron_3.h>
+#include <CGAL/Surface_mesh.h>
+#include <CGAL/boost/graph/graph_traits_Surface_mesh.h>
 #include <CGAL/Min_sphere_of_spheres_d.h>
 #include <CGAL/Min_sphere_of_points_d_traits_3.h>
 
@@ -64,6 +67,9 @@
 // STD
 #include <vector>
 
+// Project-related
+#include "thread_pool_allocator.h"
+
 namespace TinCreation {
 
 // Renaming of namespaces
@@ -76,6 +82,12 @@ typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
 typedef K::FT                                               FT;
 typedef CGAL::Projection_traits_xy_3<K>                     Gt;
 typedef CGAL::Delaunay_triangulation_2<Gt>                  Delaunay;
+typedef CGAL::Triangulation_vertex_base_with_info_2<
+        std::size_t, Gt>                                    IndexedVb;
+typedef CGAL::Triangulation_face_base_2<Gt>                 IndexedFb;
+typedef CGAL::Triangulation_data_structure_2<
+        IndexedVb, IndexedFb>                               IndexedTds;
+typedef CGAL::Delaunay_triangulation_2<Gt, IndexedTds>      IndexedDelaunay; // Keeps the index of the input point in each vertex
 typedef K::Point_3                                          Point_3;
 typedef K::Point_2                                          Point_2;
 typedef K::Vector_2                                         Vector_2;
@@ -85,16 +97,28 @@ typedef std::vector<Point_3>                                Polyline;
 typedef std::vector<Point_3>                                PointCloud;
 typedef std::vector<Polyline>                               Polylines;
 
+// Surface of a tile. Its vertices, halfedges and faces are recycled between tiles in per-thread pools
+typedef CGAL::Polyhedron_3<K,
+                           CGAL::Mesh_polyhedron_items<int>,
+                           CGAL::HalfedgeDS_default,
+                           ThreadPoolAllocator<int> >       Polyhedron;
+
 // Remeshing related
-typedef CGAL::Polyhedral_mesh_domain_with_features_3<K>     MeshDomain;
+typedef CGAL::Polyhedral_mesh_domain_with_features_3<K,
+                                                     Polyhedron> MeshDomain;
+#if defined(CGAL_LINKED_WITH_TBB) && defined(CGAL_CONCURRENT_MESH_3)
+typedef CGAL::Mesh_triangulation_3<MeshDomain,
+                                   CGAL::Default,
+                                   CGAL::Parallel_tag>::type Tr; // Triangulation (allowing parallel meshing)
+#else
 typedef CGAL::Mesh_triangulation_3<MeshDomain>::type        Tr; // Triangulation
+#endif
 typedef CGAL::Mesh_complex_3_in_triangulation_3<
         Tr,
         MeshDomain::Corner_index,
         MeshDomain::Curve_segment_index>                    C3T3;
 typedef CGAL::Mesh_criteria_3<Tr>                           MeshCriteria; // Criteria
 
-typedef CGAL::Mesh_polyhedron_3<K>::type                    Polyhedron;
 typedef Polyhedron::HalfedgeDS                              HalfedgeDS;
 typedef Polyhedron::Halfedge_handle                         Halfedge_handle;
 typedef Polyhedron::Vertex_handle                           Vertex_handle;
@@ -112,10 +136,17 @@ typedef SMS::LindstromTurk_params                           SimplificationCostPa
 typedef SMS::Bounded_normal_change_placement<
         SMS::LindstromTurk_placement<Polyhedron> >          SimplificationPlacement; // Note: Do not change this to use edge_length cost! While it lowers computational overhead, it will certainly destroy the border edges
 typedef SMS::Count_stop_predicate<Polyhedron>               SimplificationStopPredicate;
+typedef CGAL::Surface_mesh<Point_3>                         SurfaceMesh; // Array-based alternative to Polyhedron, used for simplification
+typedef SMS::LindstromTurk_cost<SurfaceMesh>                SurfaceMeshSimplificationCost;
+typedef SMS::Bounded_normal_change_placement<
+        SMS::LindstromTurk_placement<SurfaceMesh> >         SurfaceMeshSimplificationPlacement;
+typedef SMS::Count_stop_predicate<SurfaceMesh>              SurfaceMeshSimplificationStopPredicate;
 
 // Polyline simplification related
 typedef PS::Stop_above_cost_threshold                       PSStopCost;
 
+// Concurrency (CGAL_LINKED_WITH_TBB is defined by the build when TBB is available, see the USE_TBB option). Within
+// the tiler, prefer choosing the tag at run time depending on ParallelismBudget::threadsPerTile()
 #ifdef CGAL_LINKED_WITH_TBB
     typedef CGAL::Parallel_tag Concurrency_tag;
 #else
@@ -20,7 +20,7 @@
 
 #include "tin_creation_delaunay_strategy.h"
 #include "tin_creation_cgal_types.h"
-#include "cgal/polyhedron_builder_from_projected_triangulation.h"
+#include "height_grid_triangulation.h"
 
 namespace TinCreation {
 
@@ -30,14 +30,30 @@ Polyhedron TinCreationDelaunayStrategy::create(const std::vector<Point_3> &dataP
                                                const bool &constrainNorthernVertices,
                                                const bool &constrainSouthernVertices) {
     // Delaunay triangulation
-    Delaunay dt(dataPts.begin(), dataPts.end());
+    Polyhedron surface;
+    triangulatePoints(dataPts, surface);
+
+    return surface;
+}
 
-    // Translate to Polyhedron
+Polyhedron TinCreationDelaunayStrategy::create(const HeightGridView &grid,
+                                               const HeightGridBorders &borders) {
     Polyhedron surface;
-    PolyhedronBuilderFromProjectedTriangulation<Delaunay, HalfedgeDS> builder(dt);
-    surface.delegate(builder);
+    if (!triangulateHeightGrid(grid, borders, surface))
+        return TinCreationStrategy::create(grid, borders);
 
     return surface;
 }
 
+void TinCreationDelaunayStrategy::createIndexedMesh(const HeightGridView &grid,
+                                                    const HeightGridBorders &borders,
+                                                    IndexedMesh &mesh) {
+    std::size_t numGridSamples;
+    if (!triangulateHeightGrid(grid, borders, mesh.vertices, mesh.triangles, numGridSamples)) {
+        // Delaunay triangulation of the points (the repeated ones are left unreferenced)
+        heightGridToPoints(grid, borders, mesh.vertices);
+        triangulatePoints(mesh.vertices, mesh.triangles);
+    }
+}
+
 } // End namespace TinCreation
\ No newline at end of file
@@ -31,6 +31,9 @@ namespace TinCreation {
  *
  * Also, the constrain<X>Vertices parameters are ignored. This creation strategy is useful to just triangulate regular
  * grids, where the vertices at the borders are always the same for neighboring tiles.
+ *
+ * When the input is a height grid, the triangulation is known in advance and built directly, in linear time (see
+ * triangulateHeightGrid), instead of computing the Delaunay triangulation of its points.
  */
 class TinCreationDelaunayStrategy : public TinCreationStrategy {
 public:
@@ -42,7 +45,17 @@ public:
                       const bool &constrainNorthernVertices,
                       const bool &constrainSouthernVertices);
 
+    Polyhedron create(const HeightGridView &grid,
+                      const HeightGridBorders &borders);
+
+    void createIndexedMesh(const HeightGridView &grid,
+                           const HeightGridBorders &borders,
+                           IndexedMesh &mesh);
+
     void setParamsForZoom(const unsigned int& zoom) {}
+
+    /// All the samples must be kept (the borders of the tiles are not constrained), so planar tiles are not simplified either
+    double getPlanarTileTolerance() const { return -1.0; }
 };
 
 } // End namespace TinCreation
@@ -21,10 +21,12 @@
 #include "tin_creation_greedy_insertion_strategy.h"
 #include <CGAL/convex_hull_2.h>
 #include <CGAL/ch_selected_extreme_points_2.h>
+#include <cmath>
 #include <algorithm>
-#include <CGAL/intersections.h>
 #include "cgal/polyhedron_builder_from_projected_triangulation.h"
 #include "cgal/extract_tile_borders_from_polyhedron.h"
+#include "base/parallel_for.h"
+#include "base/parallelism_budget.h"
 
 namespace TinCreation {
 
@@ -33,29 +35,98 @@ Polyhedron TinCreationGreedyInsertionStrategy::create(const std::vector<Point_3>
                                                       const bool &constrainWesternVertices,
                                                       const bool &constrainNorthernVertices,
                                                       const bool &constrainSouthernVertices) {
-    m_dt.clear(); // To clear data from other executions using this same object
-    m_heap.clear(); // To clear data from other executions using this same object
+    reset();
     m_dataPts = dataPts; // Copy the data points
 
+    // Initialize the data structures
+    initialize(constrainEasternVertices, constrainWesternVertices,
+               constrainNorthernVertices, constrainSouthernVertices);
+
+    refine();
+
+    return triangulationToPolyhedron();
+}
+
+
+Polyhedron TinCreationGreedyInsertionStrategy::create(const HeightGridView &grid,
+                                                      const HeightGridBorders &borders) {
+    if (!refineGrid(grid, borders))
+        return TinCreationStrategy::create(grid, borders);
+
+    return triangulationToPolyhedron();
+}
+
+
+void TinCreationGreedyInsertionStrategy::createIndexedMesh(const HeightGridView &grid,
+                                                           const HeightGridBorders &borders,
+                                                           IndexedMesh &mesh) {
+    if (!refineGrid(grid, borders)) {
+        polyhedronToIndexedMesh(TinCreationStrategy::create(grid, borders), mesh);
+        return;
+    }
+
+    projectedTriangulationToIndexedMesh(m_dt, mesh);
+}
+
+
+bool TinCreationGreedyInsertionStrategy::refineGrid(const HeightGridView &grid,
+                                                    const HeightGridBorders &borders) {
+    if (grid.numCols() < 2 || grid.numRows() < 2)
+        return false;
+
+    reset();
+    heightGridToPoints(grid, borders, m_dataPts); // Reuses the memory of the previous tile
+
+    if (!initialize(grid, borders)) {
+        // The tile is not fully covered by the data, let the scattered version find its actual borders
+        reset();
+        initialize(borders.constrainEast(), borders.constrainWest(),
+                   borders.constrainNorth(), borders.constrainSouth());
+    }
+
+    refine();
+
+    return true;
+}
+
+
+void TinCreationGreedyInsertionStrategy::reset() {
+    m_dt.clear(); // To clear data from other executions using this same object
+    m_heap.clear(); // To clear data from other executions using this same object (keeps the allocated memory)
+    m_bucketPool.clear();
+    m_bucketPoolX.clear();
+    m_bucketPoolY.clear();
+    m_bucketPoolZ.clear();
+
     // Scale the approximation threshold to the units of the tile!
     m_scaledSqApproxTol = m_approxTol*this->getScaleZ();
     m_scaledSqApproxTol *= m_scaledSqApproxTol; // Squared value to ease distance computations
+}
 
-    // Initialize the data structures
-    initialize(constrainEasternVertices, constrainWesternVertices,
-               constrainNorthernVertices, constrainSouthernVertices);
 
-    // Try to perform one step
+void TinCreationGreedyInsertionStrategy::refine() {
+    // Try to perform one step, until all the points are within the tolerance or a budget runs out
+    m_budgetTracker.start(m_budget);
     while (!m_heap.empty()) {
-        // Pop the first element in the priority heap
-        GIHeapNode nh = m_heap.top();
+        if (m_budgetTracker.exhausted(m_dt.number_of_vertices()))
+            break;
+
+        if (m_batchSize > 1) {
+            insertBatch(m_budgetTracker.remainingVertices(m_dt.number_of_vertices()));
+            continue;
+        }
+
+        // Get the candidate of the first element in the priority heap
         // WARNING: do NOT pop the heap's top entry here, it will be effectively done in the insert function
+        int candidate = m_candidates[m_heap.top()];
 
         // Insert the point and update the internal structures
-        insert(nh.candidate);
+        insert(candidate);
     }
+}
+
 
-    // Translate to Polyhedron
+Polyhedron TinCreationGreedyInsertionStrategy::triangulationToPolyhedron() const {
     Polyhedron surface;
     PolyhedronBuilderFromProjectedTriangulation<DT, HalfedgeDS> builderDT(m_dt);
     surface.delegate(builderDT);
@@ -77,11 +148,6 @@ void TinCreationGreedyInsertionStrategy::initialize(const bool &constrainEastern
 
         // Insert them in the triangulation
         m_dt.insert(chPts.begin(), chPts.end());
-
-        // Remove corner points from the data points to be considered
-        for (std::vector<Point_3>::iterator it = chPts.begin(); it != chPts.end(); ++it) {
-            m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), *it), m_dataPts.end());
-        }
     } else {
         // Temporal triangulation with all the points
         DT tmpDt;
@@ -101,32 +167,18 @@ void TinCreationGreedyInsertionStrategy::initialize(const bool &constrainEastern
             std::cout << "Not all 4 corners were detected!" << std::endl;
         }
 
-        // For each constrained border, add the points to the internal triangulation and remove the points from the data points
+        // For each constrained border, add the points to the internal triangulation
         if (constrainEasternVertices) {
             m_dt.insert(easternBorderPts.begin(), easternBorderPts.end());
-            for (std::vector<Point_3>::iterator it = easternBorderPts.begin(); it != easternBorderPts.end(); ++it) {
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), *it), m_dataPts.end());
-            }
         }
         if (constrainWesternVertices) {
             m_dt.insert(westernBorderPts.begin(), westernBorderPts.end());
-            for (std::vector<Point_3>::iterator it = westernBorderPts.begin(); it != westernBorderPts.end(); ++it) {
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), *it), m_dataPts.end());
-            }
         }
         if (constrainSouthernVertices) {
             m_dt.insert(southernBorderPts.begin(), southernBorderPts.end());
-            for (std::vector<Point_3>::iterator it = southernBorderPts.begin();
-                 it != southernBorderPts.end(); ++it) {
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), *it), m_dataPts.end());
-            }
         }
         if (constrainNorthernVertices) {
             m_dt.insert(northernBorderPts.begin(), northernBorderPts.end());
-            for (std::vector<Point_3>::iterator it = northernBorderPts.begin();
-                 it != northernBorderPts.end(); ++it) {
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), *it), m_dataPts.end());
-            }
         }
 
         // If required, create the base grid
@@ -141,7 +193,6 @@ void TinCreationGreedyInsertionStrategy::initialize(const bool &constrainEastern
             FT extY = endY - startY;
             FT stepX = extX / (double)m_initGridSamples;
             FT stepY = extY / (double)m_initGridSamples;
-            std::vector<Point_3> insertedPts;
             for (int i = 0; i <= m_initGridSamples; i++) {
                 if ( (i == 0 && constrainWesternVertices ) ||
                      (i == m_initGridSamples && constrainEasternVertices ) )
@@ -167,214 +218,487 @@ void TinCreationGreedyInsertionStrategy::initialize(const bool &constrainEastern
                     Point_3 pi(curX, curY, h);
 
                     m_dt.insert(pi);
-
-                    insertedPts.push_back(pi);
                 }
             }
-
-            // Remove the inserted points in case they are part of the input data points
-            for (std::vector<Point_3>::iterator it = insertedPts.begin(); it != insertedPts.end(); ++it) {
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), *it), m_dataPts.end());
-            }
         }
         else {
             // Add the corner points if none of its adjacent borders is constrained
             if (!constrainWesternVertices && !constrainSouthernVertices) {
                 m_dt.insert(cornerPoint00);
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), cornerPoint00), m_dataPts.end());
             }
             if (!constrainWesternVertices && !constrainNorthernVertices) {
                 m_dt.insert(cornerPoint01);
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), cornerPoint01), m_dataPts.end());
             }
             if (!constrainNorthernVertices && !constrainEasternVertices) {
                 m_dt.insert(cornerPoint11);
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), cornerPoint11), m_dataPts.end());
             }
             if (!constrainEasternVertices && !constrainSouthernVertices) {
                 m_dt.insert(cornerPoint10);
-                m_dataPts.erase(std::remove(m_dataPts.begin(), m_dataPts.end(), cornerPoint10), m_dataPts.end());
             }
         }
     }
-    // NOTE: From now on, the vector m_dataPts should not be modified again, as the GIFaceInfo class will maintain a list of pointers to this vector!
 
-    // For all the points in the data set, check in which triangle they fall
-    for (std::vector<Point_3>::iterator it = m_dataPts.begin(); it != m_dataPts.end(); ++it) {
-        // Locate the triangle containing the current point
-        FaceHandle fh = m_dt.locate(*it);
+    initializeBuckets();
+}
 
-        // Add the point to the list of points in this triangle
-        fh->info().addPointPtr(std::make_shared<Point_3>(*it));
+
+bool TinCreationGreedyInsertionStrategy::initialize(const HeightGridView& grid, const HeightGridBorders& borders) {
+    const int lastCol = grid.numCols()-1, lastRow = grid.numRows()-1;
+
+    // The vertices of the constrained borders, as given
+    const Polyline* constrainedBorders[4] = { &borders.eastern, &borders.western, &borders.northern, &borders.southern };
+    for (int b = 0; b < 4; b++)
+        m_dt.insert(constrainedBorders[b]->begin(), constrainedBorders[b]->end());
+
+    // The corners: the constrained ones as given, the rest (if not part of a constrained border) from the grid
+    const bool constrainedCorner[4] = { borders.constrainSouthWestCorner, borders.constrainSouthEastCorner,
+                                        borders.constrainNorthWestCorner, borders.constrainNorthEastCorner };
+    const Point_3 constrainedCornerPts[4] = { borders.southWestCorner, borders.southEastCorner,
+                                              borders.northWestCorner, borders.northEastCorner };
+    const bool cornerInConstrainedBorder[4] = { borders.constrainWest() || borders.constrainSouth(),
+                                                borders.constrainEast() || borders.constrainSouth(),
+                                                borders.constrainWest() || borders.constrainNorth(),
+                                                borders.constrainEast() || borders.constrainNorth() };
+    const int cornerCol[4] = { 0, lastCol, 0, lastCol };
+    const int cornerRow[4] = { 0, 0, lastRow, lastRow };
+    for (int k = 0; k < 4; k++) {
+        if (constrainedCorner[k])
+            m_dt.insert(constrainedCornerPts[k]);
+        else if (!cornerInConstrainedBorder[k] && m_initGridSamples <= 0) {
+            if (!grid.isValid(cornerCol[k], cornerRow[k]))
+                return false;
+            m_dt.insert(grid.point(cornerCol[k], cornerRow[k]));
+        }
+    }
+
+    // If required, create the base grid, interpolating the heights from the input grid
+    if (m_initGridSamples > 0) {
+        for (int i = 0; i <= m_initGridSamples; i++) {
+            if ( (i == 0 && borders.constrainWest() ) ||
+                 (i == m_initGridSamples && borders.constrainEast() ) )
+                continue ;
+            for (int j = 0; j <= m_initGridSamples; j++) {
+                if ( (j == 0 && borders.constrainSouth()) ||
+                     (j == m_initGridSamples && borders.constrainNorth() ) )
+                    continue ;
+
+                const double u = (double)i/m_initGridSamples, v = (double)j/m_initGridSamples;
+                double h;
+                if (interpolateGridHeight(grid, u, v, h))
+                    m_dt.insert(Point_3(u, v, h));
+                else if ((i == 0 || i == m_initGridSamples) && (j == 0 || j == m_initGridSamples))
+                    return false; // Unconstrained corner without data
+            }
+        }
     }
 
+    // The base mesh should cover the whole tile, otherwise some of the data points would be left out of it
+    if (m_dt.dimension() < 2)
+        return false;
+    const double cornerU[4] = { 0.0, 1.0, 0.0, 1.0 };
+    const double cornerV[4] = { 0.0, 0.0, 1.0, 1.0 };
+    for (int k = 0; k < 4; k++) {
+        DT::Locate_type lt;
+        int li;
+        m_dt.locate(Point_3(cornerU[k], cornerV[k], 0.0), lt, li);
+        if (lt != DT::VERTEX)
+            return false;
+    }
+
+    initializeBuckets();
+    return true;
+}
+
+
+void TinCreationGreedyInsertionStrategy::initializeBuckets() {
+    // NOTE: From now on, the vector m_dataPts should not be modified again, as the buckets of the faces are indices to it!
+
+    // For all the points in the data set, check in which triangle they fall. Note that the points already inserted in
+    // the triangulation are not removed from m_dataPts, they are just discarded when locating them on a vertex
+    m_stamp++;
+    m_newFaces.clear();
+    for (DT::Finite_faces_iterator fit = m_dt.finite_faces_begin(); fit != m_dt.finite_faces_end(); fit++) {
+        fit->info().setStamp(m_stamp);
+        m_newFaces.push_back(fit);
+    }
+
+    m_conflictPts.resize(m_dataPts.size());
+    for (std::size_t i = 0; i < m_dataPts.size(); i++)
+        m_conflictPts[i] = (int)i;
+    locatePoints(m_conflictPts, FaceHandle());
+    fillBuckets(m_newFaces, m_conflictPts);
+
     // Select the best candidate for each face
-    DT::Finite_faces_iterator fit;
-    for (fit = m_dt.finite_faces_begin(); fit != m_dt.finite_faces_end(); fit++) {
-        computeErrorAndUpdateHeap(fit);
+    for (std::vector<FaceHandle>::iterator fit = m_newFaces.begin(); fit != m_newFaces.end(); ++fit) {
+        computeErrorAndUpdateHeap(*fit);
     }
 }
 
 
-FT TinCreationGreedyInsertionStrategy::errorHeight(const Point_3 &p, const Triangle_3 &t) const {
-    // Construct a line in the Z direction
-    Line_3 l(p, Vector_3(0, 0, 1));
+void TinCreationGreedyInsertionStrategy::locatePoints(const std::vector<int>& ptsIds, FaceHandle hint) {
+    m_ptsFaces.resize(ptsIds.size());
+    for (std::size_t i = 0; i < ptsIds.size(); i++) {
+        // Locate the triangle containing the current point, starting from the face of the previous one (the points are
+        // spatially coherent, either because they come from a grid or because they come from the same conflict zone)
+        DT::Locate_type lt;
+        int li;
+        FaceHandle fh = m_dt.locate(m_dataPts[ptsIds[i]], lt, li, hint);
 
-    // Compute their intersection
-    CGAL::cpp11::result_of<Intersect_3(Line_3, Triangle_3)>::type intersect = CGAL::intersection(l, t);
+        if (lt == DT::VERTEX || lt == DT::OUTSIDE_AFFINE_HULL || m_dt.is_infinite(fh)) {
+            // Already in the triangulation, or out of it: the point is not considered anymore
+            m_ptsFaces[i] = FaceHandle();
+            continue;
+        }
 
-    // If everything goes as expected, the intersection should exist and should be a point
-    if (!intersect) {
-        std::cerr << "Error! Empty intersection" << std::endl;
-        return FT(0.0);
+        m_ptsFaces[i] = newFaceContaining(fh, m_dataPts[ptsIds[i]]);
+        hint = fh;
     }
-    if (const Segment_3 *s = boost::get<Segment_3>(&*intersect)) {
-        std::cerr << "Error! Segment intersection" << std::endl;
-        return FT(0.0);
+}
+
+
+TinCreationGreedyInsertionStrategy::FaceHandle
+TinCreationGreedyInsertionStrategy::newFaceContaining(FaceHandle fh, const Point_3& p) const {
+    if (fh == FaceHandle() || fh->info().hasStamp(m_stamp))
+        return fh;
+
+    // The point is on an edge of the boundary of the new faces, take the new face on the other side
+    Gt::Orientation_2 orientation = Gt().orientation_2_object();
+    for (int i = 0; i < 3; i++) {
+        FaceHandle nh = fh->neighbor(i);
+        if (!m_dt.is_infinite(nh) && nh->info().hasStamp(m_stamp) &&
+            orientation(fh->vertex(DT::ccw(i))->point(), fh->vertex(DT::cw(i))->point(), p) == CGAL::COLLINEAR)
+            return nh;
     }
 
-    // Get the intersection point
-    const Point_3 *ip = boost::get<Point_3>(&*intersect);
+    return FaceHandle();
+}
+
+
+void TinCreationGreedyInsertionStrategy::fillBuckets(const std::vector<FaceHandle>& faces, const std::vector<int>& ptsIds) {
+    // Count the points per face. Only the new faces have a range reserved in the pool, so a point located elsewhere
+    // would overwrite the range of another face
+    for (std::vector<FaceHandle>::iterator it = m_ptsFaces.begin(); it != m_ptsFaces.end(); ++it) {
+        if (*it == FaceHandle())
+            continue;
+        CGAL_assertion((*it)->info().hasStamp(m_stamp));
+        if (!(*it)->info().hasStamp(m_stamp)) {
+            *it = FaceHandle(); // Never write out of the reserved ranges
+            continue;
+        }
+        (*it)->info().countPoint();
+    }
 
-    // Finally, compute the squared distance between the query point and the intersection
-    return CGAL::squared_distance(p, *ip);
+    // Reserve a contiguous range at the end of the pool for each face
+    std::size_t end = m_bucketPool.size();
+    for (std::vector<FaceHandle>::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+        end += (*it)->info().getNumPtsInFace();
+        (*it)->info().setBucketEnd(end);
+    }
+    m_bucketPool.resize(end);
+    m_bucketPoolX.resize(end);
+    m_bucketPoolY.resize(end);
+    m_bucketPoolZ.resize(end);
+
+    // Fill the ranges
+    for (std::size_t i = 0; i < ptsIds.size(); i++) {
+        if (m_ptsFaces[i] == FaceHandle())
+            continue;
+        std::size_t slot = m_ptsFaces[i]->info().nextBucketSlot();
+        const Point_3& p = m_dataPts[ptsIds[i]];
+        m_bucketPool[slot] = ptsIds[i];
+        m_bucketPoolX[slot] = p.x();
+        m_bucketPoolY[slot] = p.y();
+        m_bucketPoolZ[slot] = p.z();
+    }
 }
 
 
-FT TinCreationGreedyInsertionStrategy::error3D(const Point_3 &p, const Triangle_3 &t) const {
-//    return CGAL::squared_distance(p, t.supporting_plane());
-    return CGAL::squared_distance(p, t);
+void TinCreationGreedyInsertionStrategy::compactBucketPool() {
+    m_bucketPoolScratch.clear();
+    m_bucketPoolScratchX.clear();
+    m_bucketPoolScratchY.clear();
+    m_bucketPoolScratchZ.clear();
+    for (DT::Finite_faces_iterator fit = m_dt.finite_faces_begin(); fit != m_dt.finite_faces_end(); fit++) {
+        std::size_t begin = fit->info().bucketBegin(), end = begin + fit->info().getNumPtsInFace();
+        fit->info().setBucket(m_bucketPoolScratch.size(), end - begin);
+        m_bucketPoolScratch.insert(m_bucketPoolScratch.end(), m_bucketPool.begin() + begin, m_bucketPool.begin() + end);
+        m_bucketPoolScratchX.insert(m_bucketPoolScratchX.end(), m_bucketPoolX.begin() + begin, m_bucketPoolX.begin() + end);
+        m_bucketPoolScratchY.insert(m_bucketPoolScratchY.end(), m_bucketPoolY.begin() + begin, m_bucketPoolY.begin() + end);
+        m_bucketPoolScratchZ.insert(m_bucketPoolScratchZ.end(), m_bucketPoolZ.begin() + begin, m_bucketPoolZ.begin() + end);
+    }
+    m_bucketPool.swap(m_bucketPoolScratch);
+    m_bucketPoolX.swap(m_bucketPoolScratchX);
+    m_bucketPoolY.swap(m_bucketPoolScratchY);
+    m_bucketPoolZ.swap(m_bucketPoolScratchZ);
 }
 
 
 void
 TinCreationGreedyInsertionStrategy::
-insert(const Point_3 &p) {
+insert(const int &ptIndex) {
+    const Point_3& p = m_dataPts[ptIndex];
+
     // Get the conflict zone in the Delaunay triangulation for the point to be inserted
-    std::vector<FaceHandle> facesInConflict;
-    m_dt.get_conflicts(p, std::back_inserter(facesInConflict));
+    m_conflictFaces.clear();
+    m_dt.get_conflicts(p, std::back_inserter(m_conflictFaces));
 
-    if (facesInConflict.empty()) {
-        // If no faces are in conflict, the point we are trying to add is already in the triangulation! (should not happen...)
+    if (m_conflictFaces.empty()) {
+        // If no faces are in conflict, the point we are trying to add is already in the triangulation! (should not happen,
+        // as these points are discarded when locating them)
         std::cout << "Point already in surface!!!!!!!!!!!!!" << std::endl;
         std::cout << "p = " << p << std::endl;
-//        m_heap.pop(); // Do not consider this point anymore
-//        return;
+        m_heap.pop(); // Do not consider this point anymore
+        return;
     }
 
     // All the faces in the conflict zone will be changed
     // Thus, collect all the points falling in these faces and delete their corresponding entries in the heap
-    std::vector<std::shared_ptr<Point_3>> ptsInConflictZone;
+    m_conflictPts.clear();
     std::vector<FaceHandle>::iterator fit;
-    for (fit = facesInConflict.begin(); fit != facesInConflict.end(); fit++) {
-        // Collect points' pointers in this face
-        std::vector<std::shared_ptr<Point_3>> ptsPtrs = (*(*fit)).info().getPtsSharedPtrs();
-        ptsInConflictZone.insert(ptsInConflictZone.end(), ptsPtrs.begin(), ptsPtrs.end());
+    for (fit = m_conflictFaces.begin(); fit != m_conflictFaces.end(); fit++) {
+        // Collect points' indices in this face
+        std::vector<int>::const_iterator bucketBegin = m_bucketPool.begin() + (*fit)->info().bucketBegin();
+        m_conflictPts.insert(m_conflictPts.end(), bucketBegin, bucketBegin + (*fit)->info().getNumPtsInFace());
 
         // Delete heap entry associated to the face, if any
         if ((*fit)->info().hasHeapNodeHandle()) {
-            m_heap.erase((*(*fit)).info().getHeapNodeHandle());
+            m_heap.erase((*fit)->info().getHeapNodeHandle());
         }
 
         // Some face handles may not be erased after insertion, clear info as it will be recalculated for the new face shape in case it is not eliminated by insertion
-        (*(*fit)).info().clearInfo();
+        (*fit)->info().clearInfo();
     }
 
-    // Insert the point and modify the triangulation
-    VertexHandle vh = m_dt.insert(p); // TODO: Use point location once to get a nearby face and then use this face as guess?
+    // Insert the point and modify the triangulation (we already know a face containing it)
+    VertexHandle vh = m_dt.insert(p, m_conflictFaces.front());
 
-    // Check in which faces previously collected points fall
-    // While there is no check in this regard, they are all supposed to be falling in the newly created faces that are now
-    // covering the previous conflict zone.
-    std::vector<std::shared_ptr<Point_3>>::iterator it;
-    std::vector<int>::iterator itInd;
-    for (it = ptsInConflictZone.begin(); it != ptsInConflictZone.end(); ++it) {
-        Point_3 p = *(*it);
-
-        // Locate the triangle containing the current point
-        FaceHandle fh = m_dt.locate(p);
-
-        fh->info().addPointPtr(*it);
-    }
-
-    // Update the internal structure of the new faces with the points falling on them, and also update the heap
+    // The new faces, covering the previous conflict zone
+    m_stamp++;
+    m_newFaces.clear();
     FaceCirculator fc = m_dt.incident_faces(vh), end(fc);
     do {
         if (!m_dt.is_infinite(fc)) {
-            // Compute the maximum error on this face and update the heap
-            computeErrorAndUpdateHeap(fc);
+            fc->info().setStamp(m_stamp);
+            m_newFaces.push_back(fc);
         }
     } while (++fc != end);
+
+    // Check in which of the new faces the previously collected points fall. The inserted point itself is discarded
+    // here, as it falls on a vertex.
+    locatePoints(m_conflictPts, vh->face());
+
+    // Update the internal structure of the new faces with the points falling on them, and also update the heap
+    fillBuckets(m_newFaces, m_conflictPts);
+
+    // The ranges of the faces destroyed are left unused in the pool, compact it when they dominate
+    if (m_bucketPool.size() > 2*m_dataPts.size() + 1024)
+        compactBucketPool();
+
+    // Compute the maximum error on the new faces and update the heap
+    for (fit = m_newFaces.begin(); fit != m_newFaces.end(); ++fit)
+        computeErrorAndUpdateHeap(*fit);
 }
 
 
 void
 TinCreationGreedyInsertionStrategy::
 computeErrorAndUpdateHeap(FaceHandle fh) {
-    Triangle_3 t = m_dt.triangle(fh);
+    FT maxSqError;
+    std::size_t candidate = computeFaceCandidate(fh, maxSqError);
+    pushFaceCandidate(fh, candidate, maxSqError);
+}
+
+
+std::size_t
+TinCreationGreedyInsertionStrategy::
+computeFaceCandidate(FaceHandle fh, FT& maxSqError) const {
+    HeightPlane plane = facePlane(fh);
 
     // Run over candidates and find the one inducing the worst error
-    Point_3 best;
-    FT maxSqError = 0;
-
-    std::vector<std::shared_ptr<Point_3>> ptsPtrs = fh->info().getPtsSharedPtrs();
-    std::vector<std::shared_ptr<Point_3>>::iterator itPtPtr;
-    for (itPtPtr = ptsPtrs.begin();
-         itPtPtr != ptsPtrs.end(); ++itPtPtr) {
-        Point_3 p = *(*itPtPtr);
-        FT e = error(p, t);
-        if (e > maxSqError) {
-            best = p;
-            maxSqError = e;
-        }
-    }
+    const std::size_t begin = fh->info().bucketBegin();
+    double scale = m_errorType == ErrorHeight ? 1.0 : plane.sqVerticalToOrthogonalFactor();
+    return begin + maxPlaneError(m_bucketPoolX.data() + begin, m_bucketPoolY.data() + begin, m_bucketPoolZ.data() + begin,
+                                 fh->info().getNumPtsInFace(), plane, scale, maxSqError);
+}
+
+
+void
+TinCreationGreedyInsertionStrategy::
+pushFaceCandidate(FaceHandle fh, const std::size_t& candidate, const FT& maxSqError) {
     if (maxSqError > std::numeric_limits<double>::epsilon() && maxSqError > m_scaledSqApproxTol) {
-        GIHeapNodeHandle nh = m_heap.push(GIHeapNode(maxSqError, best));
+        GIHeapNodeHandle nh = m_heap.push(maxSqError);
+        if ((std::size_t)nh >= m_candidates.size()) {
+            m_candidates.resize(nh+1);
+            m_candidatesFaces.resize(nh+1);
+        }
+        m_candidates[nh] = m_bucketPool[candidate];
+        m_candidatesFaces[nh] = fh;
         fh->info().setHeapNodeHandle(nh);
     }
 }
 
 
-FT
+void
 TinCreationGreedyInsertionStrategy::
-error(const Point_3 &p, const Triangle_3 &t) const {
-    if (m_errorType == ErrorHeight) {
-        return errorHeight(p, t);
+insertBatch(const std::size_t& maxPoints) {
+    // --- Select the candidates to insert ---
+    // Take the candidates in the order of the heap, as long as their conflict zone does not overlap with the ones of
+    // the candidates already selected. The first one is always selected, the rest are deferred to the next batches.
+    m_stamp++;
+    m_batchPts.clear();
+    m_batchZone.clear();
+    m_batchZoneBegin.clear();
+    m_candidatesDeferred.clear();
+    const std::size_t batchSize = maxPoints > 0 ? std::min<std::size_t>(m_batchSize, maxPoints) : m_batchSize;
+    const std::size_t maxCandidates = 2*batchSize;
+    for (std::size_t numCandidates = 0; !m_heap.empty() && m_batchPts.size() < batchSize && numCandidates < maxCandidates; numCandidates++) {
+        GIHeapNodeHandle nh = m_heap.top();
+        GIDeferredCandidate dc(m_heap.topPriority(), m_candidates[nh], m_candidatesFaces[nh]);
+        m_heap.pop();
+        dc.face->info().setHeapNodeHandle(-1);
+
+        std::size_t zoneBegin = m_batchZone.size();
+        m_dt.get_conflicts(m_dataPts[dc.candidate], std::back_inserter(m_batchZone));
+        if (m_batchZone.size() == zoneBegin)
+            continue; // Already in the triangulation (should not happen, as these points are discarded when locating them)
+        bool overlaps = false;
+        for (std::size_t i = zoneBegin; i < m_batchZone.size() && !overlaps; i++)
+            overlaps = m_batchZone[i]->info().hasStamp(m_stamp);
+
+        if (overlaps) {
+            m_batchZone.resize(zoneBegin);
+            m_candidatesDeferred.push_back(dc);
+            continue;
+        }
+        for (std::size_t i = zoneBegin; i < m_batchZone.size(); i++)
+            m_batchZone[i]->info().setStamp(m_stamp);
+        m_batchPts.push_back(dc.candidate);
+        m_batchZoneBegin.push_back(zoneBegin);
     }
-    else
-        return error3D(p, t);
-}
 
+    // Back to the heap with the deferred candidates (if their face is in a conflict zone, it is erased below)
+    for (std::vector<GIDeferredCandidate>::iterator it = m_candidatesDeferred.begin(); it != m_candidatesDeferred.end(); ++it) {
+        GIHeapNodeHandle nh = m_heap.push(it->error);
+        if ((std::size_t)nh >= m_candidates.size()) {
+            m_candidates.resize(nh+1);
+            m_candidatesFaces.resize(nh+1);
+        }
+        m_candidates[nh] = it->candidate;
+        m_candidatesFaces[nh] = it->face;
+        it->face->info().setHeapNodeHandle(nh);
+    }
 
-FT
-TinCreationGreedyInsertionStrategy::eval(const Point_3& p, const Triangle_3&t) const{
-    // Compute the distance to the triangle in the Z direction
-    Line_3 l(p, Vector_3(0, 0, 1));
+    // --- Collect the points in the conflict zones, and clear the faces ---
+    m_conflictPts.clear();
+    m_conflictPtsBatch.clear();
+    m_batchZoneBegin.push_back(m_batchZone.size());
+    for (std::size_t b = 0; b < m_batchPts.size(); b++) {
+        for (std::size_t z = m_batchZoneBegin[b]; z < m_batchZoneBegin[b+1]; z++) {
+            FaceHandle fh = m_batchZone[z];
+            std::vector<int>::const_iterator bucketBegin = m_bucketPool.begin() + fh->info().bucketBegin();
+            m_conflictPts.insert(m_conflictPts.end(), bucketBegin, bucketBegin + fh->info().getNumPtsInFace());
+            m_conflictPtsBatch.resize(m_conflictPts.size(), (int)b);
+            if (fh->info().hasHeapNodeHandle())
+                m_heap.erase(fh->info().getHeapNodeHandle());
+            fh->info().clearInfo();
+        }
+    }
+
+    // --- Insert the points ---
+    // Note that, while the zones did not overlap before the insertions, the zone of a point may grow to include new
+    // faces created by the previous points of the batch. These faces have no points assigned yet, so nothing is lost,
+    // and all the faces finally covering the zones are incident to some of the inserted vertices.
+    m_batchVertices.resize(m_batchPts.size());
+    for (std::size_t b = 0; b < m_batchPts.size(); b++)
+        m_batchVertices[b] = m_dt.insert(m_dataPts[m_batchPts[b]], m_batchZone[m_batchZoneBegin[b]]);
+
+    m_stamp++;
+    m_newFaces.clear();
+    for (std::vector<VertexHandle>::iterator vit = m_batchVertices.begin(); vit != m_batchVertices.end(); ++vit) {
+        FaceCirculator fc = m_dt.incident_faces(*vit), end(fc);
+        do {
+            if (!m_dt.is_infinite(fc) && !fc->info().hasStamp(m_stamp)) {
+                fc->info().setStamp(m_stamp);
+                m_newFaces.push_back(fc);
+            }
+        } while (++fc != end);
+    }
+
+    // --- Redistribute the points (in parallel, using the cores not busy with other tiles) ---
+    const int numThreads = ParallelismBudget::threadsPerTile(m_batchNumThreads);
+    m_ptsFaces.resize(m_conflictPts.size());
+    parallelFor(m_conflictPts.size(), numThreads, [this](const std::size_t& begin, const std::size_t& end) {
+        for (std::size_t i = begin; i < end; i++)
+            m_ptsFaces[i] = walkLocate(m_dataPts[m_conflictPts[i]], m_batchVertices[m_conflictPtsBatch[i]]->face());
+    });
+    fillBuckets(m_newFaces, m_conflictPts);
+
+    if (m_bucketPool.size() > 2*m_dataPts.size() + 1024)
+        compactBucketPool();
+
+    // --- Compute the errors of the new faces (in parallel), and update the heap ---
+    m_newFacesErrors.resize(m_newFaces.size());
+    m_newFacesCandidates.resize(m_newFaces.size());
+    parallelFor(m_newFaces.size(), numThreads, [this](const std::size_t& begin, const std::size_t& end) {
+        for (std::size_t i = begin; i < end; i++)
+            m_newFacesCandidates[i] = computeFaceCandidate(m_newFaces[i], m_newFacesErrors[i]);
+    }, 16);
+    for (std::size_t i = 0; i < m_newFaces.size(); i++)
+        pushFaceCandidate(m_newFaces[i], m_newFacesCandidates[i], m_newFacesErrors[i]);
+}
 
-    // Compute their intersection
-    CGAL::cpp11::result_of<Intersect_3(Line_3, Triangle_3)>::type intersect = CGAL::intersection(l, t);
 
-    // If everything goes as expected, the intersection should exist and should be a point
-    if (!intersect) {
-        std::cerr << "Error! Empty intersection" << std::endl;
-        return FT(0.0);
+TinCreationGreedyInsertionStrategy::FaceHandle
+TinCreationGreedyInsertionStrategy::walkLocate(const Point_3& p, FaceHandle start) const {
+    Gt::Orientation_2 orientation = Gt().orientation_2_object();
+
+    FaceHandle fh = start;
+    if (m_dt.is_infinite(fh))
+        fh = fh->neighbor(fh->index(m_dt.infinite_vertex()));
+
+    // Visibility walk (always terminates on a Delaunay triangulation)
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int i = 0; i < 3; i++) {
+            const Point_3& a = fh->vertex(DT::ccw(i))->point();
+            const Point_3& b = fh->vertex(DT::cw(i))->point();
+            if (orientation(a, b, p) == CGAL::RIGHT_TURN) {
+                fh = fh->neighbor(i);
+                if (m_dt.is_infinite(fh))
+                    return FaceHandle(); // Out of the triangulation
+                moved = true;
+                break;
+            }
+        }
     }
-    if (const Segment_3 *s = boost::get<Segment_3>(&*intersect)) {
-        std::cerr << "Error! Segment intersection" << std::endl;
-        return FT(0.0);
+
+    // Points on a vertex are already in the triangulation
+    for (int i = 0; i < 3; i++) {
+        const Point_3& v = fh->vertex(i)->point();
+        if (v.x() == p.x() && v.y() == p.y())
+            return FaceHandle();
     }
 
-    // Get the intersection point
-    const Point_3 *ip = boost::get<Point_3>(&*intersect);
+    // The walk stops at the first face whose closure contains the point, which may be out of the new faces if the point
+    // is on the boundary of the conflict zones
+    return newFaceContaining(fh, p);
+}
 
-    // Finally, compute the squared distance between the query point and the intersection
-    FT sqDist = CGAL::squared_distance(p, *ip);
-    FT dist = CGAL::sqrt(sqDist);
 
-    if (p.z() > ip->z())
-        dist = -dist;
+HeightPlane
+TinCreationGreedyInsertionStrategy::facePlane(FaceHandle fh) const {
+    const Point_3& p0 = fh->vertex(0)->point();
+    const Point_3& p1 = fh->vertex(1)->point();
+    const Point_3& p2 = fh->vertex(2)->point();
+    return HeightPlane(p0.x(), p0.y(), p0.z(), p1.x(), p1.y(), p1.z(), p2.x(), p2.y(), p2.z());
+}
 
-    return dist;
+
+FT
+TinCreationGreedyInsertionStrategy::eval(const Point_3& p, const Triangle_3&t) const{
+    HeightPlane plane(t[0].x(), t[0].y(), t[0].z(), t[1].x(), t[1].y(), t[1].z(), t[2].x(), t[2].y(), t[2].z());
+    return plane.eval(p.x(), p.y());
 }
 
 
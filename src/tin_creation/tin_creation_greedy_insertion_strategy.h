@@ -25,65 +25,56 @@
 #include "tin_creation_cgal_types.h"
 #include <CGAL/Triangulation_face_base_2.h>
 #include <CGAL/Triangulation_face_base_with_info_2.h>
-#include <memory>
-#include <boost/heap/fibonacci_heap.hpp>
+#include <algorithm>
+#include "indexed_dary_heap.h"
+#include "height_plane_errors.h"
 #include "tin_creation_utils.h"
+#include "refinement_budget.h"
 
 namespace TinCreation {
 
-/**
- * @class GIHeapNode
- * @brief The information to be maintained in the heap structure
- */
-struct GIHeapNode {
-    FT error ;
-    Point_3 candidate ;
-
-    GIHeapNode() : error(0.0), candidate(Point_3(.0,.0,.0)) {}
-    GIHeapNode( const FT& e, const Point_3& c ) : error(e), candidate(c) {}
-};
-
-/**
- * @class CompareGIHeapNodes
- * @brief Comparison operator (less than) for GIHeapNodes
- */
-struct CompareGIHeapNodes
-{
-    bool operator()(const GIHeapNode& n1, const GIHeapNode& n2) const
-    {
-        return n1.error < n2.error;
-    }
-};
-
-typedef boost::heap::fibonacci_heap<GIHeapNode, boost::heap::compare<CompareGIHeapNodes>> GIHeap ;
-typedef typename GIHeap::handle_type GIHeapNodeHandle ;
+typedef IndexedDaryHeap<FT> GIHeap ;
+typedef GIHeap::Handle GIHeapNodeHandle ;
 
 /**
  * @class GIFaceInfo
  * @brief Additional information associated to a face in a Delaunay triangulation required by the Greedy Insertion algorithm
+ *
+ * The points falling in the face are not stored in the face itself, but as a range of indices in a pool shared by all
+ * the faces (see TinCreationGreedyInsertionStrategy), so that no memory is allocated per face.
  */
 class GIFaceInfo {
 public:
-    GIFaceInfo() : m_pointsInFacePtrs(), m_heapNodeHandle(), m_hasHeapNodeHandle(false) {}
+    GIFaceInfo() : m_bucketBegin(0), m_bucketSize(0), m_heapNodeHandle(-1), m_stamp(0) {}
     ~GIFaceInfo() {}
 
-    void setHeapNodeHandle( GIHeapNodeHandle h ) { m_heapNodeHandle = h; m_hasHeapNodeHandle = true ; }
-    void addPointPtr(std::shared_ptr<Point_3> pp) {m_pointsInFacePtrs.push_back(pp);}
-    std::vector<std::shared_ptr<Point_3>> getPtsSharedPtrs() { return m_pointsInFacePtrs; } ;
-    size_t getNumPtsInFace() { return m_pointsInFacePtrs.size(); }
-    bool hasHeapNodeHandle() {return m_hasHeapNodeHandle; }
-    GIHeapNodeHandle getHeapNodeHandle() { return m_heapNodeHandle ; }
+    void setHeapNodeHandle( GIHeapNodeHandle h ) { m_heapNodeHandle = h; }
+    bool hasHeapNodeHandle() const { return m_heapNodeHandle >= 0; }
+    GIHeapNodeHandle getHeapNodeHandle() const { return m_heapNodeHandle ; }
+
+    // The bucket of a face is filled in three passes: count the points falling in the face, set the end of its range in
+    // the pool, and fill the range backwards (after that, bucketBegin() is the start of the range)
+    void countPoint() { m_bucketSize++; }
+    void setBucketEnd(const std::size_t& end) { m_bucketBegin = end; }
+    std::size_t nextBucketSlot() { return --m_bucketBegin; }
+    void setBucket(const std::size_t& begin, const std::size_t& size) { m_bucketBegin = begin; m_bucketSize = size; }
+    std::size_t bucketBegin() const { return m_bucketBegin; }
+    size_t getNumPtsInFace() const { return m_bucketSize; }
+
+    // Marks used to detect the faces already visited while processing a batch of insertions
+    void setStamp(const unsigned int& stamp) { m_stamp = stamp; }
+    bool hasStamp(const unsigned int& stamp) const { return m_stamp == stamp; }
 
     // Some face handles may not be erased after insertion, apply this to all the faces on the conflict zone prior to insert a point to ensure that all the faces' info are empty
     void clearInfo() {
-        m_pointsInFacePtrs.clear();
-        m_heapNodeHandle = GIHeapNodeHandle();
-        m_hasHeapNodeHandle = false;
+        m_bucketBegin = 0;
+        m_bucketSize = 0;
+        m_heapNodeHandle = -1;
     };
 private:
-    std::vector<std::shared_ptr<Point_3>> m_pointsInFacePtrs;
+    std::size_t m_bucketBegin, m_bucketSize ; //!< Range of the points in this face within the pool of buckets
     GIHeapNodeHandle m_heapNodeHandle ;
-    bool m_hasHeapNodeHandle ;
+    unsigned int m_stamp ;
 };
 
 /**
@@ -154,11 +145,56 @@ public:
         m_approxTol = standardHandlingOfThresholdPerZoom(m_approxTolPerZoom, zoom);
     }
 
+    /**
+     * Insert the points in batches instead of one at a time.
+     *
+     * Each batch takes the candidates with the largest errors whose conflict zones do not overlap, inserts all of them,
+     * and then redistributes the points of the modified faces and computes their new errors using several threads.
+     * The errors of the resulting TIN are within the same tolerance, but since the insertion order differs slightly
+     * from the one-by-one version, the TIN may differ too.
+     *
+     * @param batchSize Maximum number of points inserted per batch (batches are disabled if <= 1)
+     * @param numThreads Maximum number of threads to use to update the faces modified by a batch (the actual number
+     *                   depends on the cores left idle by the other tiles being processed, see ParallelismBudget).
+     *                   The threads are only used when compiled with TBB, the faces are updated sequentially otherwise
+     */
+    void setBatchInsertion(const int& batchSize, const int& numThreads) {
+        m_batchSize = batchSize;
+        m_batchNumThreads = std::max(numThreads, 1);
+    }
+
+    /**
+     * Limit the refinement of each TIN to a number of vertices, an estimated encoded size and/or a time budget.
+     *
+     * Since points are inserted by decreasing error, the TIN obtained when a budget runs out is the most accurate the
+     * algorithm could reach within it, although it may not fulfill the error tolerance.
+     */
+    void setRefinementBudget(const RefinementBudget& budget) { m_budget = budget; }
+
+    /// A planar tile within the approximation tolerance would end up as the minimal mesh anyway
+    double getPlanarTileTolerance() const { return m_approxTol; }
+
+    StopCriterion getLastStopCriterion() const { return m_budgetTracker.stopCriterion(); }
+
     Polyhedron create(const std::vector<Point_3>& dataPts,
                       const bool& constrainEasternVertices = false,
                       const bool& constrainWesternVertices = false,
                       const bool& constrainNorthernVertices = false,
                       const bool& constrainSouthernVertices = false);
+
+    /**
+     * @brief Create a TIN from a regular grid of heights.
+     *
+     * Same as the scattered version, but the base mesh (constrained borders, corners and initial grid, if any) is
+     * obtained directly from the structure of the grid.
+     */
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders);
+
+    /// Same as create(grid, borders), but the triangulation is exported directly to the indexed mesh
+    void createIndexedMesh(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           IndexedMesh& mesh);
 private:
     // --- Attributes ---
     FT m_approxTol ;
@@ -166,42 +202,132 @@ private:
     std::vector<Point_3> m_dataPts ;
     DT m_dt ;
     GIHeap m_heap;
+    std::vector<int> m_candidates; //!< Index of the candidate point for each heap handle
+    std::vector<FaceHandle> m_candidatesFaces; //!< Face of the candidate point for each heap handle
+    std::vector<int> m_bucketPool; //!< Indices of the points falling in each face, as a contiguous range per face
+    std::vector<double> m_bucketPoolX, m_bucketPoolY, m_bucketPoolZ; //!< Coordinates of the points in m_bucketPool (SoA layout, for the error computation)
+    // Scratch buffers, kept as members so that their memory is reused between insertions and tiles
+    std::vector<FaceHandle> m_conflictFaces, m_newFaces, m_ptsFaces;
+    std::vector<int> m_conflictPts, m_bucketPoolScratch;
+    std::vector<double> m_bucketPoolScratchX, m_bucketPoolScratchY, m_bucketPoolScratchZ;
+    RefinementBudget m_budget;
+    RefinementBudgetTracker m_budgetTracker;
+    // Batch insertion
+    int m_batchSize = 0;
+    int m_batchNumThreads = 1;
+    unsigned int m_stamp = 0;
+    struct GIDeferredCandidate {
+        GIDeferredCandidate(const FT& e, const int& c, FaceHandle f) : error(e), candidate(c), face(f) {}
+        FT error;
+        int candidate;
+        FaceHandle face;
+    };
+    std::vector<int> m_batchPts, m_conflictPtsBatch; //!< Points inserted in the batch, and index in the batch of the point whose zone contained each conflict point
+    std::vector<FaceHandle> m_batchZone; //!< Conflict zones of the points in the batch, one after the other
+    std::vector<std::size_t> m_batchZoneBegin; //!< Start of the conflict zone of each point in m_batchZone
+    std::vector<GIDeferredCandidate> m_candidatesDeferred; //!< Candidates popped from the heap but not inserted in the current batch
+    std::vector<VertexHandle> m_batchVertices;
+    std::vector<FT> m_newFacesErrors;
+    std::vector<std::size_t> m_newFacesCandidates;
     int m_errorType;
     int m_initGridSamples;
     std::vector<FT> m_approxTolPerZoom; // in metric, not squared!
 
     // --- Private Methods ---
+    /// Clear the data from previous executions using this same object (keeps the allocated memory)
+    void reset();
+
     /// Initialize the data structures
     void initialize(const bool& constrainEasternVertices,
                     const bool& constrainWesternVertices,
                     const bool& constrainNorthernVertices,
                     const bool& constrainSouthernVertices);
 
-    /// Compute the error induced by a point w.r.t. a triangle
-    /// \pre the triangle \param t is the closest to point p in the current approximation
-    FT error(const Point_3& p, const Triangle_3&t) const;
+    /**
+     * Initialize the data structures for an input grid, without triangulating all its samples
+     * @return False if the base mesh could not be built from the grid (i.e., some unconstrained corner has no data)
+     */
+    bool initialize(const HeightGridView& grid, const HeightGridBorders& borders);
 
-    /// Compute the error given a point/triangle
-    /// \pre Point's XY projection falls within triangle's XY projection
-    FT errorHeight(const Point_3& p, const Triangle_3&t) const;
+    /// Distribute all the data points in the faces of the base mesh and fill the heap
+    void initializeBuckets();
 
-    /// Compute the error given a point/triangle. Orthogonal distance.
-    /// \pre Point's XY projection falls within triangle's XY projection
-    FT error3D(const Point_3& p, const Triangle_3&t) const;
+    /**
+     * Build the TIN of a grid in the internal triangulation (the common part of create(grid, borders) and
+     * createIndexedMesh)
+     * @return False if the grid is too small for the method, and the default implementation should be used instead
+     */
+    bool refineGrid(const HeightGridView& grid, const HeightGridBorders& borders);
+
+    /// Insert the candidates until the tolerance is fulfilled or a budget runs out
+    void refine();
+
+    /// Translate the internal triangulation to a Polyhedron
+    Polyhedron triangulationToPolyhedron() const;
+
+    /// Plane supporting a face of the triangulation
+    HeightPlane facePlane(FaceHandle fh) const;
 
     /// Evaluate the height of a point in the current approximation. Just the XY part of \p p is used.
     /// \pre Point's XY projection falls within triangle's XY projection
     FT eval(const Point_3& p, const Triangle_3&t) const;
 
     /// Contains all the steps to perform when inserting a new point in the triangulation
-    void insert(const Point_3& p);
+    void insert(const int& ptIndex);
+
+    /**
+     * Insert a batch of points with non-overlapping conflict zones, taken from the top of the heap, and update the
+     * internal structures (see setBatchInsertion)
+     * @param maxPoints Maximum number of points to insert in this batch, on top of the batch size (unlimited if 0)
+     */
+    void insertBatch(const std::size_t& maxPoints);
+
+    /**
+     * Locate a point in the triangulation by walking from a given face, using only (thread-safe) predicates
+     * @return The face containing the point, among the ones stamped with m_stamp (see newFaceContaining), or a null
+     * handle if it is out of the triangulation or on a vertex
+     */
+    FaceHandle walkLocate(const Point_3& p, FaceHandle start) const;
+
+    /**
+     * Locate the points in the triangulation (using \p hint as the starting face), storing the face containing each of
+     * them in m_ptsFaces. Points coinciding with a vertex of the triangulation (i.e., already inserted) or out of it are
+     * given a null face handle, and thus they are removed from the process.
+     * \pre The points fall in the faces stamped with m_stamp (see newFaceContaining)
+     */
+    void locatePoints(const std::vector<int>& ptsIds, FaceHandle hint);
+
+    /**
+     * Among the faces stamped with m_stamp (i.e., the new faces covering a conflict zone), the one containing a point
+     * located in \p fh. They differ when the point lies on an edge of the boundary of the new faces, as locating it may
+     * return the (old) face on the other side of the edge.
+     * @return The new face, or a null handle if \p fh is null or the point is not in a new face
+     */
+    FaceHandle newFaceContaining(FaceHandle fh, const Point_3& p) const;
+
+    /**
+     * Append the buckets of the \p faces to the pool, filling them with the points located by locatePoints
+     * \pre The buckets of the faces are empty, and they are the faces stamped with m_stamp
+     */
+    void fillBuckets(const std::vector<FaceHandle>& faces, const std::vector<int>& ptsIds);
+
+    /// Remove the unused ranges of the pool of buckets (left by the faces destroyed on insertion)
+    void compactBucketPool();
 
     /**
      * Find the point falling in the face inducing the largest error and add it to the heap.
      * Also adds the reference to the introduced heap node in the face.
+     * The errors are computed with respect to the plane of the face: squared vertical distance for ErrorHeight, and
+     * squared orthogonal distance for Error3D.
      * \pre The face has its internal points ptrs set using the findPointsInFace function
      */
     void computeErrorAndUpdateHeap(FaceHandle fh);
+
+    /// Find the point falling in the face inducing the largest error (returns the position in the pool, or the end of the bucket if no error)
+    std::size_t computeFaceCandidate(FaceHandle fh, FT& maxSqError) const;
+
+    /// Add the candidate of a face to the heap if its error is above the tolerance
+    void pushFaceCandidate(FaceHandle fh, const std::size_t& candidate, const FT& maxSqError);
 };
 
 } // End namespace TinCreation
@@ -0,0 +1,322 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "tin_creation_greedy_scan_strategy.h"
+#include <algorithm>
+#include <cmath>
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+
+namespace TinCreation {
+
+// Integer division rounding towards -infinity
+static inline long long floorDiv(const long long& a, const long long& b)
+{
+    long long q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0)))
+        q--;
+    return q;
+}
+
+/**
+ * Range of lattice x coordinates [xMin, xMax] within a triangle (counterclockwise, borders included) at row y.
+ * Returns false if the row does not intersect the triangle.
+ */
+static bool triangleRowSpan(const long long px[3], const long long py[3], const long long& y,
+                            long long& xMin, long long& xMax)
+{
+    xMin = std::numeric_limits<long long>::min();
+    xMax = std::numeric_limits<long long>::max();
+    for (int i = 0; i < 3; i++) {
+        int j = (i+1)%3;
+        long long dx = px[j]-px[i], dy = py[j]-py[i];
+        // Inside (or on) the edge i->j: dx*(y-py[i]) - dy*(x-px[i]) >= 0  <=>  dy*x <= k
+        long long k = dx*(y-py[i]) + dy*px[i];
+        if (dy > 0)
+            xMax = std::min(xMax, floorDiv(k, dy));
+        else if (dy < 0)
+            xMin = std::max(xMin, -floorDiv(-k, dy)); // ceil(k/dy)
+        else if (dx*(y-py[i]) < 0)
+            return false;
+    }
+    return xMin <= xMax;
+}
+
+
+
+Polyhedron TinCreationGreedyScanStrategy::create(const std::vector<Point_3> &dataPts,
+                                                 const bool &constrainEasternVertices,
+                                                 const bool &constrainWesternVertices,
+                                                 const bool &constrainNorthernVertices,
+                                                 const bool &constrainSouthernVertices) {
+    // Without the grid structure, use the standard greedy insertion
+    m_scatteredStrategy.setScaleZ(getScaleZ());
+    Polyhedron surface = m_scatteredStrategy.create(dataPts,
+                                                    constrainEasternVertices, constrainWesternVertices,
+                                                    constrainNorthernVertices, constrainSouthernVertices);
+    m_lastStopCriterion = m_scatteredStrategy.getLastStopCriterion();
+    return surface;
+}
+
+
+Polyhedron TinCreationGreedyScanStrategy::create(const HeightGridView &grid,
+                                                 const HeightGridBorders &borders) {
+    if (!refineGrid(grid, borders))
+        return TinCreationStrategy::create(grid, borders);
+
+    // Translate to Polyhedron
+    collectTriangles(m_triangles);
+    Polyhedron surface;
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(m_vertices, m_triangles);
+    surface.delegate(builder);
+
+    return surface;
+}
+
+
+void TinCreationGreedyScanStrategy::createIndexedMesh(const HeightGridView &grid,
+                                                      const HeightGridBorders &borders,
+                                                      IndexedMesh &mesh) {
+    if (!refineGrid(grid, borders)) {
+        polyhedronToIndexedMesh(TinCreationStrategy::create(grid, borders), mesh);
+        return;
+    }
+
+    mesh.vertices.assign(m_vertices.begin(), m_vertices.end());
+    collectTriangles(mesh.triangles);
+}
+
+
+bool TinCreationGreedyScanStrategy::refineGrid(const HeightGridView &grid,
+                                               const HeightGridBorders &borders) {
+    if (grid.numCols() < 2 || grid.numRows() < 2)
+        return false;
+
+    m_grid = grid;
+
+    // Scale the approximation threshold to the units of the tile!
+    m_scaledSqApproxTol = m_approxTol*this->getScaleZ();
+    m_scaledSqApproxTol *= m_scaledSqApproxTol; // Squared value to ease distance computations
+
+    // Initialize the data structures
+    if (!initialize(borders))
+        return false;
+
+    // Insert the candidate with the largest error until all of them are within the tolerance or a budget runs out
+    m_budgetTracker.start(m_budget);
+    while (!m_heap.empty() && !m_budgetTracker.exhausted(m_dt.number_of_vertices())) {
+        // WARNING: do NOT pop the heap's top entry here, it will be effectively done in the insertSample function
+        insertSample(m_candidates[m_heap.top()]);
+    }
+
+    m_lastStopCriterion = m_budgetTracker.stopCriterion();
+
+    return true;
+}
+
+
+void TinCreationGreedyScanStrategy::collectTriangles(std::vector<std::size_t>& triangles) const {
+    triangles.clear();
+    triangles.reserve(3*m_dt.number_of_faces());
+    for (DT::Finite_faces_iterator fit = m_dt.finite_faces_begin(); fit != m_dt.finite_faces_end(); ++fit) {
+        triangles.push_back(fit->vertex(0)->info());
+        triangles.push_back(fit->vertex(1)->info());
+        triangles.push_back(fit->vertex(2)->info());
+    }
+}
+
+
+bool TinCreationGreedyScanStrategy::initialize(const HeightGridBorders& borders) {
+    m_dt.clear(); // To clear data from other executions using this same object
+    m_heap.clear();
+    m_vertices.clear();
+
+    const int numCols = m_grid.numCols(), numRows = m_grid.numRows();
+
+    // Position of the samples in the lattice
+    m_colX.resize(numCols);
+    m_colU.resize(numCols);
+    for (int c = 0; c < numCols; c++) {
+        m_colX[c] = (int)std::lround((double)c*LatticeSize/(numCols-1));
+        m_colU[c] = (double)m_colX[c]/LatticeSize;
+    }
+    m_rowY.resize(numRows);
+    m_rowV.resize(numRows);
+    for (int r = 0; r < numRows; r++) {
+        m_rowY[r] = (int)std::lround((double)r*LatticeSize/(numRows-1));
+        m_rowV[r] = (double)m_rowY[r]/LatticeSize;
+    }
+    m_isVertex.assign((std::size_t)numCols*numRows, 0);
+
+    // The samples in the constrained borders are ignored
+    m_startCol = borders.constrainWest() ? 1 : 0;
+    m_endCol = borders.constrainEast() ? numCols-1 : numCols;
+    m_startRow = borders.constrainSouth() ? 1 : 0;
+    m_endRow = borders.constrainNorth() ? numRows-1 : numRows;
+
+    // Vertices to maintain in the borders, snapped to the lattice (but keeping their original coordinates in the output)
+    const Polyline* bordersPts[4] = { &borders.eastern, &borders.western, &borders.northern, &borders.southern };
+    for (int b = 0; b < 4; b++) {
+        for (Polyline::const_iterator it = bordersPts[b]->begin(); it != bordersPts[b]->end(); ++it) {
+            int x = b == 0 ? LatticeSize : b == 1 ? 0 : (int)std::lround(std::max(0.0, std::min(it->x(), 1.0))*LatticeSize);
+            int y = b == 2 ? LatticeSize : b == 3 ? 0 : (int)std::lround(std::max(0.0, std::min(it->y(), 1.0))*LatticeSize);
+            insertVertex(*it, x, y);
+        }
+    }
+
+    // Corners: the constrained ones, or the samples of the grid if not already part of the constrained borders
+    const int cornerCols[4] = { 0, numCols-1, 0, numCols-1 };
+    const int cornerRows[4] = { 0, 0, numRows-1, numRows-1 };
+    const bool constrainCorners[4] = { borders.constrainSouthWestCorner, borders.constrainSouthEastCorner,
+                                       borders.constrainNorthWestCorner, borders.constrainNorthEastCorner };
+    const Point_3* cornerPts[4] = { &borders.southWestCorner, &borders.southEastCorner,
+                                    &borders.northWestCorner, &borders.northEastCorner };
+    for (int k = 0; k < 4; k++) {
+        const int c = cornerCols[k], r = cornerRows[k];
+        if (constrainCorners[k]) {
+            insertVertex(*cornerPts[k], m_colX[c], m_rowY[r]);
+        }
+        else if (m_grid.isValid(c, r)) {
+            insertVertex(Point_3(m_colU[c], m_rowV[r], m_grid.h(c, r)), m_colX[c], m_rowY[r]);
+        }
+        else {
+            // Without a valid height, the corner must come from the constrained borders. Otherwise, do not make up a
+            // height for it (neighboring tiles would inherit it), and let the caller fall back to the scattered version
+            VertexHandle vh;
+            if (!m_dt.is_vertex(K::Point_2(m_colX[c], m_rowY[r]), vh))
+                return false;
+        }
+        m_isVertex[(std::size_t)r*numCols + c] = 1;
+    }
+
+    // Select the best candidate for each face
+    for (DT::Finite_faces_iterator fit = m_dt.finite_faces_begin(); fit != m_dt.finite_faces_end(); ++fit)
+        scanFace(fit);
+
+    return true;
+}
+
+
+TinCreationGreedyScanStrategy::VertexHandle
+TinCreationGreedyScanStrategy::insertVertex(const Point_3& p, const int& x, const int& y, FaceHandle hint) {
+    std::size_t numVertices = m_dt.number_of_vertices();
+    VertexHandle vh = m_dt.insert(K::Point_2(x, y), hint);
+    if (m_dt.number_of_vertices() > numVertices) {
+        // New vertex (otherwise, the first one inserted at this position is kept)
+        vh->info() = (int)m_vertices.size();
+        m_vertices.push_back(p);
+    }
+    return vh;
+}
+
+
+void TinCreationGreedyScanStrategy::insertSample(const int& sample) {
+    const int numCols = m_grid.numCols();
+    const int c = sample % numCols, r = sample / numCols;
+    const K::Point_2 p(m_colX[c], m_rowY[r]);
+
+    // Delete the heap entries of the faces that will be destroyed by the insertion
+    m_conflictFaces.clear();
+    m_dt.get_conflicts(p, std::back_inserter(m_conflictFaces));
+    for (std::vector<FaceHandle>::iterator fit = m_conflictFaces.begin(); fit != m_conflictFaces.end(); ++fit) {
+        if ((*fit)->info().heapNodeHandle >= 0) {
+            m_heap.erase((*fit)->info().heapNodeHandle);
+            (*fit)->info().heapNodeHandle = -1;
+        }
+    }
+
+    std::size_t numVertices = m_dt.number_of_vertices();
+    FaceHandle hint = m_conflictFaces.empty() ? FaceHandle() : m_conflictFaces.front();
+    VertexHandle vh = insertVertex(Point_3(m_colU[c], m_rowV[r], m_grid.h(c, r)), m_colX[c], m_rowY[r], hint);
+    m_isVertex[sample] = 1;
+
+    if (m_dt.number_of_vertices() == numVertices) {
+        // The position was already a vertex (should not happen), the faces were not modified: just look for new candidates
+        for (std::vector<FaceHandle>::iterator fit = m_conflictFaces.begin(); fit != m_conflictFaces.end(); ++fit) {
+            if (!m_dt.is_infinite(*fit))
+                scanFace(*fit);
+        }
+        return;
+    }
+
+    // Update the candidates of the new faces
+    FaceCirculator fc = m_dt.incident_faces(vh), end(fc);
+    do {
+        if (!m_dt.is_infinite(fc))
+            scanFace(fc);
+    } while (++fc != end);
+}
+
+
+void TinCreationGreedyScanStrategy::scanFace(FaceHandle fh) {
+    // Vertices of the face in the lattice (exact integer coordinates), and the plane they define in u/v/h
+    long long px[3], py[3];
+    double u[3], v[3], h[3];
+    for (int i = 0; i < 3; i++) {
+        const K::Point_2& lp = fh->vertex(i)->point();
+        px[i] = (long long)lp.x();
+        py[i] = (long long)lp.y();
+        u[i] = (double)px[i]/LatticeSize;
+        v[i] = (double)py[i]/LatticeSize;
+        h[i] = m_vertices[fh->vertex(i)->info()].z();
+    }
+    HeightPlane plane(u[0], v[0], h[0], u[1], v[1], h[1], u[2], v[2], h[2]);
+    const double scale = m_errorType == ErrorHeight ? 1.0 : plane.sqVerticalToOrthogonalFactor();
+
+    // Rows of samples covered by the face
+    const long long minY = std::min(py[0], std::min(py[1], py[2]));
+    const long long maxY = std::max(py[0], std::max(py[1], py[2]));
+    int r = (int)(std::lower_bound(m_rowY.begin(), m_rowY.end(), minY) - m_rowY.begin());
+    r = std::max(r, m_startRow);
+
+    // Scan them, looking for the sample with the largest error
+    const int numCols = m_grid.numCols();
+    int best = -1;
+    double maxSqError = 0.0;
+    for (; r < m_endRow && m_rowY[r] <= maxY; r++) {
+        long long xMin, xMax;
+        if (!triangleRowSpan(px, py, m_rowY[r], xMin, xMax))
+            continue;
+        int c = (int)(std::lower_bound(m_colX.begin(), m_colX.end(), xMin) - m_colX.begin());
+        c = std::max(c, m_startCol);
+        const float* row = m_grid.row(r);
+        const char* isVertex = &m_isVertex[(std::size_t)r*numCols];
+        const double rowHeight = plane.a + plane.c*m_rowV[r];
+        for (; c < m_endCol && m_colX[c] <= xMax; c++) {
+            if (isVertex[c])
+                continue;
+            const double d = m_grid.normalizeHeight(row[c]) - (rowHeight + plane.b*m_colU[c]);
+            const double e = d*d*scale;
+            if (e > maxSqError) { // Note: no data samples (NaN) are never selected
+                maxSqError = e;
+                best = r*numCols + c;
+            }
+        }
+    }
+
+    if (maxSqError > std::numeric_limits<double>::epsilon() && maxSqError > m_scaledSqApproxTol) {
+        GIHeapNodeHandle nh = m_heap.push(maxSqError);
+        if ((std::size_t)nh >= m_candidates.size())
+            m_candidates.resize(nh+1);
+        m_candidates[nh] = best;
+        fh->info().heapNodeHandle = nh;
+    }
+}
+
+} // End namespace TinCreation
@@ -0,0 +1,184 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_TIN_CREATION_GREEDY_SCAN_H
+#define EMODNET_QMGC_TIN_CREATION_GREEDY_SCAN_H
+
+#include "tin_creator.h"
+#include "tin_creation_cgal_types.h"
+#include "tin_creation_greedy_insertion_strategy.h"
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
+#include "indexed_dary_heap.h"
+#include "height_plane_errors.h"
+#include "tin_creation_utils.h"
+
+namespace TinCreation {
+
+/**
+ * @struct GSFaceInfo
+ * @brief Additional information associated to a face in the triangulation of the greedy scan algorithm
+ */
+struct GSFaceInfo {
+    GIHeapNodeHandle heapNodeHandle ; //!< Handle of the heap entry with the candidate of the face (-1 if none)
+
+    GSFaceInfo() : heapNodeHandle(-1) {}
+};
+
+/**
+ * @class TinCreationGreedyScanStrategy
+ * @brief Creates a TIN using greedy insertion over the regular grid of heights of the tile.
+ *
+ * Same approach as TinCreationGreedyInsertionStrategy (i.e., the sample with the largest error is inserted until all
+ * errors are within the tolerance), but following more closely the original method in:
+ *
+ * M. Garland, P. S. Heckbert, Fast polygonal approximation of terrains and height Fields, Technical report CMU-CS-95-181, Carnegie Mellon University 575 (September 1995).
+ *
+ * Instead of keeping the points falling in each face, the candidate of each new face is found by scanning the rows of
+ * grid samples it covers. The triangulation is built on an integer lattice, the one of the quantized mesh format (i.e.,
+ * u/v coordinates in [0..LatticeSize]), where the output vertices will be quantized anyway.
+ *
+ * The border constraints and tolerance per zoom have the same meaning as in TinCreationGreedyInsertionStrategy. The
+ * regular structure is only available through create(HeightGridView, HeightGridBorders), the scattered input version of
+ * create() falls back to TinCreationGreedyInsertionStrategy.
+ */
+class TinCreationGreedyScanStrategy : public TinCreationStrategy
+{
+public:
+    // --- Typedefs ---
+    typedef CGAL::Triangulation_vertex_base_with_info_2<int, K>         Vb; // Index of the vertex in the output mesh
+    typedef CGAL::Triangulation_face_base_with_info_2<GSFaceInfo, K>    Fb;
+    typedef CGAL::Triangulation_data_structure_2<Vb, Fb>                Tds;
+    typedef CGAL::Delaunay_triangulation_2<K, Tds>                      DT;
+    typedef DT::Face_handle                                             FaceHandle;
+    typedef DT::Vertex_handle                                           VertexHandle;
+    typedef DT::Face_circulator                                         FaceCirculator;
+
+    /// Size of the integer lattice where the triangulation is computed (same as QuantizedMesh::MAX_VERTEX_DATA)
+    static const int LatticeSize = 32767;
+
+public:
+    enum ErrorType { ErrorHeight=0, Error3D } ; //! Types of errors to use (same as TinCreationGreedyInsertionStrategy)
+
+    // --- Public Methods ---
+
+    /**
+     * Constructor
+     * @param approxTolPerZoom Approximation tolerances per zoom (the errors guiding the end of the process)
+     * @param errorType Type of error to use.
+     */
+    TinCreationGreedyScanStrategy(const std::vector<FT>& approxTolPerZoom,
+                                  int errorType = ErrorHeight)
+            : m_errorType(errorType)
+            , m_approxTolPerZoom(approxTolPerZoom)
+            , m_scatteredStrategy(approxTolPerZoom, -1, errorType)
+    {
+        setParamsForZoom(0);
+    }
+
+    void setParamsForZoom(const unsigned int& zoom)
+    {
+        m_approxTol = standardHandlingOfThresholdPerZoom(m_approxTolPerZoom, zoom);
+        m_scatteredStrategy.setParamsForZoom(zoom);
+    }
+
+    /// Limit the refinement of each TIN (see TinCreationGreedyInsertionStrategy::setRefinementBudget)
+    void setRefinementBudget(const RefinementBudget& budget)
+    {
+        m_budget = budget;
+        m_scatteredStrategy.setRefinementBudget(budget);
+    }
+
+    /// A planar tile within the approximation tolerance would end up as the minimal mesh anyway
+    double getPlanarTileTolerance() const { return m_approxTol; }
+
+    StopCriterion getLastStopCriterion() const { return m_lastStopCriterion; }
+
+    Polyhedron create(const std::vector<Point_3>& dataPts,
+                      const bool& constrainEasternVertices = false,
+                      const bool& constrainWesternVertices = false,
+                      const bool& constrainNorthernVertices = false,
+                      const bool& constrainSouthernVertices = false);
+
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders);
+
+    /// Same as create(grid, borders), but the triangulation is exported directly to the indexed mesh
+    void createIndexedMesh(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           IndexedMesh& mesh);
+
+private:
+    // --- Attributes ---
+    FT m_approxTol ;
+    FT m_scaledSqApproxTol ;
+    int m_errorType;
+    std::vector<FT> m_approxTolPerZoom; // in metric, not squared!
+    TinCreationGreedyInsertionStrategy m_scatteredStrategy; //!< Used for the scattered input version of create()
+    RefinementBudget m_budget;
+    RefinementBudgetTracker m_budgetTracker;
+    StopCriterion m_lastStopCriterion = StopNotApplicable;
+    HeightGridView m_grid;
+    DT m_dt;
+    GIHeap m_heap;
+    std::vector<int> m_candidates;      //!< Index of the candidate sample (column + row*numCols) for each heap handle
+    std::vector<Point_3> m_vertices;    //!< Vertices of the triangulation, in u/v/h
+    std::vector<int> m_colX, m_rowY;    //!< Lattice coordinates of the columns/rows of the grid
+    std::vector<double> m_colU, m_rowV; //!< u/v coordinates of the columns/rows of the grid (i.e., lattice coordinates normalized to [0..1])
+    std::vector<char> m_isVertex;       //!< Flag per sample indicating whether it is already a vertex of the triangulation
+    int m_startCol, m_endCol, m_startRow, m_endRow; //!< Range of samples to scan (the constrained borders are excluded)
+    // Scratch buffers, kept as members so that their memory is reused between insertions and tiles
+    std::vector<FaceHandle> m_conflictFaces;
+    std::vector<std::size_t> m_triangles;
+
+    // --- Private Methods ---
+    /**
+     * Build the TIN of a grid in the internal triangulation (the common part of create(grid, borders) and
+     * createIndexedMesh)
+     * @return False if the grid is too small for the method, or an unconstrained corner has no valid height, and the
+     * default implementation should be used instead
+     */
+    bool refineGrid(const HeightGridView& grid, const HeightGridBorders& borders);
+
+    /// Indices of the vertices (in m_vertices) of the faces of the internal triangulation
+    void collectTriangles(std::vector<std::size_t>& triangles) const;
+
+    /**
+     * Initialize the data structures: lattice, base mesh with the corners and the constrained borders, and heap
+     * @return False if a corner has neither a valid height nor a constrained vertex
+     */
+    bool initialize(const HeightGridBorders& borders);
+
+    /// Insert a vertex (if not present already), given its u/v/h coordinates and its position in the lattice
+    VertexHandle insertVertex(const Point_3& p, const int& x, const int& y, FaceHandle hint = FaceHandle());
+
+    /// Insert a sample of the grid in the triangulation and update the candidates of the modified faces
+    void insertSample(const int& sample);
+
+    /**
+     * Find the sample covered by the face inducing the largest error, scanning the rows of the grid, and add it to the
+     * heap. Also adds the reference to the introduced heap node in the face.
+     */
+    void scanFace(FaceHandle fh);
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_TIN_CREATION_GREEDY_SCAN_H
@@ -21,51 +21,168 @@
 #include "tin_creation_remeshing_strategy.h"
 #include "cgal/generate_border_features_polylines.h"
 #include <CGAL/make_mesh_3.h>
+#include <CGAL/Mesh_error_code.h>
 #include <iostream>
 #include "cgal/polyhedron_builder_from_c3t3_boundary.h"
 #include "cgal/polyhedron_builder_from_projected_triangulation.h"
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+#include "height_grid_triangulation.h"
 #include <CGAL/config.h>
 #include "tin_creation_cgal_types.h"
 #include <limits>
 #include "cgal/extract_tile_borders_from_polyhedron.h"
+#include "planar_tile.h"
+#include "base/parallelism_budget.h"
 #include <CGAL/bounding_box.h>
+#include <CGAL/atomic.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef CGAL_LINKED_WITH_TBB
+#include <tbb/task_arena.h>
+#endif
 
 namespace TinCreation {
 
+/**
+ * Raises a flag after a given time, unless destroyed before. Mesh_3 checks the flag regularly, so this allows stopping
+ * it when the time budget runs out.
+ */
+class MeshingWatchdog
+{
+public:
+    MeshingWatchdog(CGAL::cpp11::atomic<bool>& stop, const double& milliseconds)
+            : m_done(false)
+    {
+        if (milliseconds <= 0)
+            return;
+        m_thread = std::thread([this, &stop, milliseconds]() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_cv.wait_for(lock, std::chrono::duration<double, std::milli>(milliseconds), [this]() { return m_done; }))
+                stop = true;
+        });
+    }
+
+    ~MeshingWatchdog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+private:
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_done;
+};
+
+
 Polyhedron TinCreationRemeshingStrategy::create(const std::vector<Point_3> &dataPts,
                                                 const bool &constrainEasternVertices,
                                                 const bool &constrainWesternVertices,
                                                 const bool &constrainNorthernVertices,
                                                 const bool &constrainSouthernVertices) {
-    using namespace CGAL::parameters;
+    m_budgetTracker = RefinementBudgetTracker();
 
-    // First of all, check if the input data points are planar. If a planar mesh is input, the meshing algorithm never finishes!
-    if (dataPtsArePlanar(dataPts)) {
-        // Create a default triangulation for the grid and return
-        std::vector<Point_3> defaultPts = defaultPointsForPlanarTile();
+    // First of all, check if the input data points are planar. If a planar mesh is input, the meshing algorithm never
+    // finishes! When the bounds of the tile are known, there is no need to go through all the points
+    if (hasOriginalBoundingBox() ? getMaxZ() <= getMinZ() : dataPtsArePlanar(dataPts))
+        return planarTileSurface();
 
-        // Delaunay triangulation
-        Delaunay dt(defaultPts.begin(), defaultPts.end());
-
-        // Translate to Polyhedron
-        Polyhedron surface;
-        PolyhedronBuilderFromProjectedTriangulation<Delaunay, HalfedgeDS> builderDT(dt);
-        surface.delegate(builderDT);
+    // Delaunay triangulation
+    Polyhedron surface;
+    triangulatePoints(dataPts, surface);
 
-        return surface;
+    Polyhedron remeshedSurface;
+    if (remesh(surface,
+               constrainEasternVertices,
+               constrainWesternVertices,
+               constrainNorthernVertices,
+               constrainSouthernVertices,
+               remeshedSurface))
+        return remeshedSurface;
+
+    // Out of budget
+    if (m_fallback) {
+        setupFallback();
+        return m_fallback->create(dataPts,
+                                  constrainEasternVertices,
+                                  constrainWesternVertices,
+                                  constrainNorthernVertices,
+                                  constrainSouthernVertices);
     }
+    // Triangulate the points again, as remesh() has transformed the ones of surface
+    Polyhedron fullSurface;
+    triangulatePoints(dataPts, fullSurface);
+    return fullSurface;
+}
 
-    // Delaunay triangulation
-    Delaunay dt(dataPts.begin(), dataPts.end());
 
-    // Translate to Polyhedron
+Polyhedron TinCreationRemeshingStrategy::create(const HeightGridView &grid,
+                                                const HeightGridBorders &borders) {
+    m_budgetTracker = RefinementBudgetTracker();
+
+    // If a planar mesh is input, the meshing algorithm never finishes! The normalized heights of a tile are all 0 when
+    // its height range is empty, including the ones of the borders, so we can check it without going through the
+    // samples, and directly create the minimal mesh preserving the borders
+    if (grid.maxHeight() <= grid.minHeight())
+        return createPlanarTileMesh(grid, borders, TilePlane());
+
+    // The triangulation of the grid is known in advance, no need for a Delaunay triangulation of its points
+    std::vector<Point_3> vertices;
+    std::vector<std::size_t> triangles;
+    std::size_t numGridSamples;
+    if (!triangulateHeightGrid(grid, borders, vertices, triangles, numGridSamples))
+        return TinCreationStrategy::create(grid, borders);
+
     Polyhedron surface;
-    PolyhedronBuilderFromProjectedTriangulation<Delaunay, HalfedgeDS> builderDT(dt);
-    surface.delegate(builderDT);
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(vertices, triangles);
+    surface.delegate(builder);
+
+    Polyhedron remeshedSurface;
+    if (remesh(surface,
+               borders.constrainEast(),
+               borders.constrainWest(),
+               borders.constrainNorth(),
+               borders.constrainSouth(),
+               remeshedSurface))
+        return remeshedSurface;
+
+    // Out of budget
+    if (m_fallback) {
+        setupFallback();
+        return m_fallback->create(grid, borders);
+    }
+    Polyhedron fullSurface;
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builderFull(vertices, triangles);
+    fullSurface.delegate(builderFull);
+    return fullSurface;
+}
+
+
+void TinCreationRemeshingStrategy::setupFallback() {
+    m_fallback->setBounds(getMinX(), getMinY(), getMinZ(), getMaxX(), getMaxY(), getMaxZ());
+    m_fallback->setScaleZ(getScaleZ());
+}
+
+
+bool TinCreationRemeshingStrategy::remesh(Polyhedron &surface,
+                                          const bool &constrainEasternVertices,
+                                          const bool &constrainWesternVertices,
+                                          const bool &constrainNorthernVertices,
+                                          const bool &constrainSouthernVertices,
+                                          Polyhedron &remeshedSurface) {
+    using namespace CGAL::parameters;
 
     // Convert the points to metric, but preserve the connectivity provided by the 2D Delaunay
-    for (Polyhedron::Point_iterator it = surface.points_begin(); it != surface.points_end(); ++it)
-        *it = this->convertUVHToECEF(*it);
+    std::vector<Point_3> pts(surface.points_begin(), surface.points_end());
+    pts = this->convertUVHToMetric(pts);
+    std::copy(pts.begin(), pts.end(), surface.points_begin());
 
     // Reset the origin of the points
     K::Iso_cuboid_3 boundingBox = CGAL::bounding_box(surface.points_begin(), surface.points_end());
@@ -137,7 +254,7 @@ Polyhedron TinCreationRemeshingStrategy::create(const std::vector<Point_3> &data
         polylines.push_back(southernBorderVertices);
     }
 
-    std::cout << "Adding features, imposing " << polylines.size() << " polylines" << std::endl ;
+//    std::cout << "Adding features, imposing " << polylines.size() << " polylines" << std::endl ;
     domain.add_features(polylines.begin(), polylines.end());
 
     // Mesh criteria
@@ -157,19 +274,44 @@ Polyhedron TinCreationRemeshingStrategy::create(const std::vector<Point_3> &data
 //    std::cout << "    - facet_distance = " << m_facetDistance << std::endl ;
 //    std::cout << "    - facet_topology = CGAL::MANIFOLD_WITH_BOUNDARY" << std::endl ;
 
-    // Mesh generation
-    C3T3 c3t3 = CGAL::make_mesh_3<C3T3>(domain, criteria, no_perturb(), no_exude());
+    // Mesh generation, stopped by Mesh_3 itself when reaching the maximum number of vertices, or by the watchdog when
+    // the time budget runs out. When TBB is available, the parallel version runs on the cores not used by other tiles
+    m_budgetTracker.start(m_budget);
+    CGAL::cpp11::atomic<bool> stop(false);
+    CGAL::Mesh_error_code errorCode = CGAL::CGAL_MESH_3_NO_ERROR;
+    C3T3 c3t3;
+    {
+        MeshingWatchdog watchdog(stop, m_budget.maxMilliseconds);
+        auto meshSurface = [&]() {
+            c3t3 = CGAL::make_mesh_3<C3T3>(domain, criteria, no_perturb(), no_exude(),
+                                           mesh_3_options(maximal_number_of_vertices = m_budgetTracker.remainingVertices(0),
+                                                          pointer_to_error_code = &errorCode,
+                                                          pointer_to_stop_atomic_boolean = &stop));
+        };
+#ifdef CGAL_LINKED_WITH_TBB
+        tbb::task_arena arena(ParallelismBudget::threadsPerTile());
+        arena.execute(meshSurface);
+#else
+        meshSurface();
+#endif
+    }
+    if (errorCode != CGAL::CGAL_MESH_3_NO_ERROR) {
+        m_budgetTracker.exhausted(c3t3.triangulation().number_of_vertices()); // Records the criterion that stopped it
+        return false;
+    }
 
     // Extract the surface boundary as a polyhedron
-    Polyhedron remeshedSurface;
     PolyhedronBuilderFromC3T3Boundary<C3T3, HalfedgeDS> builderC3T3Boundary(c3t3, 0);
     remeshedSurface.delegate(builderC3T3Boundary);
 
-    // Convert back the points to UVH
-    for (Polyhedron::Point_iterator it = remeshedSurface.points_begin(); it != remeshedSurface.points_end(); ++it)
-        *it = this->convertECEFToUVH(*it);
+    // Convert back the points to UVH (undoing the change of origin first)
+    pts.assign(remeshedSurface.points_begin(), remeshedSurface.points_end());
+    for (std::vector<Point_3>::iterator it = pts.begin(); it != pts.end(); ++it)
+        *it = Point_3(it->x() + boundingBox.xmin(), it->y() + boundingBox.ymin(), it->z() + boundingBox.zmin());
+    pts = this->convertMetricToUVH(pts);
+    std::copy(pts.begin(), pts.end(), remeshedSurface.points_begin());
 
-    return remeshedSurface;
+    return true;
 }
 
 
@@ -183,6 +325,22 @@ bool TinCreationRemeshingStrategy::dataPtsArePlanar(const std::vector<Point_3> &
 }
 
 
+Polyhedron TinCreationRemeshingStrategy::planarTileSurface() const {
+    // Create a default triangulation for the grid
+    std::vector<Point_3> defaultPts = defaultPointsForPlanarTile();
+
+    // Delaunay triangulation
+    Delaunay dt(defaultPts.begin(), defaultPts.end());
+
+    // Translate to Polyhedron
+    Polyhedron surface;
+    PolyhedronBuilderFromProjectedTriangulation<Delaunay, HalfedgeDS> builderDT(dt);
+    surface.delegate(builderDT);
+
+    return surface;
+}
+
+
 std::vector<Point_3> TinCreationRemeshingStrategy::defaultPointsForPlanarTile() const {
     std::vector<Point_3> pts;
 
@@ -42,6 +42,11 @@ namespace TinCreation {
  * When the simplification takes place, all the coordinates of the vertices are normalized between 0..1
  * Note that this also means that, if the parameters are not set wisely, using this process we can
  * get a mesh of even larger complexity with respect to the original one!
+ *
+ * Since the time and the size of the result of Mesh_3 are hard to predict, the remeshing of each tile can be bounded
+ * by a RefinementBudget (vertices and/or time). When it runs out, the remeshing is abandoned and the tile is created
+ * with a fallback strategy instead. Mesh_3 runs in parallel when TBB is available, using the cores left idle by the
+ * other tiles in flight (see ParallelismBudget).
  */
 class TinCreationRemeshingStrategy : public TinCreationStrategy
 {
@@ -76,13 +81,35 @@ public:
                       const bool& constrainNorthernVertices,
                       const bool& constrainSouthernVertices);
 
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders);
+
     // WARNING: The remeshing strategy should not be used for tiled rendering!
     void setParamsForZoom(const unsigned int& zoom) {
         m_facetDistance = standardHandlingOfThresholdPerZoom(m_facetDistancePerZoom, zoom);
         m_facetSize = standardHandlingOfThresholdPerZoom(m_facetSizePerZoom, zoom);
         m_edgeSize = standardHandlingOfThresholdPerZoom(m_edgeSizePerZoom, zoom);
+        if (m_fallback)
+            m_fallback->setParamsForZoom(zoom);
     }
 
+    /**
+     * Limit the remeshing of each tile to a number of vertices, an estimated encoded size and/or a time budget.
+     *
+     * Unlike the refinement strategies, Mesh_3 cannot provide a valid surface when stopped before the end, so the tile
+     * is created with the fallback strategy when a budget runs out (see setFallbackStrategy).
+     */
+    void setRefinementBudget(const RefinementBudget& budget) { m_budget = budget; }
+
+    /**
+     * Set the strategy creating the tiles whose remeshing runs out of budget (must be a different instance than the
+     * one used elsewhere). If not set, the full resolution triangulation of the input points is returned.
+     */
+    void setFallbackStrategy(std::shared_ptr<TinCreationStrategy> fallback) { m_fallback = fallback; }
+
+    /// The budget criterion that made the last tile use the fallback strategy, or StopErrorTolerance if remeshed
+    StopCriterion getLastStopCriterion() const { return m_budgetTracker.stopCriterion(); }
+
 private:
     // Algorithm parameters
     double m_facetDistance;
@@ -92,9 +119,29 @@ private:
     std::vector<double> m_facetDistancePerZoom;
     std::vector<double> m_facetSizePerZoom;
     std::vector<double> m_edgeSizePerZoom;
+    RefinementBudget m_budget;
+    RefinementBudgetTracker m_budgetTracker;
+    std::shared_ptr<TinCreationStrategy> m_fallback;
 
     // Internal functions
 
+    /**
+     * Remeshes the full resolution surface of the tile (a triangulation of all the input points, in u/v/h coordinates)
+     * @return False if the budget ran out before finishing (remeshedSurface is not valid then)
+     */
+    bool remesh(Polyhedron& surface,
+                const bool& constrainEasternVertices,
+                const bool& constrainWesternVertices,
+                const bool& constrainNorthernVertices,
+                const bool& constrainSouthernVertices,
+                Polyhedron& remeshedSurface);
+
+    /// Prepares the fallback strategy to create the current tile
+    void setupFallback();
+
+    /// Triangulation of the default points for a planar tile (see defaultPointsForPlanarTile)
+    Polyhedron planarTileSurface() const;
+
     /// Checks if all input points are collinear
     bool dataPtsArePlanar(const std::vector<Point_3>& dataPts) const;
 
@@ -0,0 +1,191 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "tin_creation_rtin_strategy.h"
+#include <algorithm>
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+#include "cgal/polyhedron_builder_from_projected_triangulation.h"
+
+namespace TinCreation {
+
+Polyhedron TinCreationRtinStrategy::create(const std::vector<Point_3> &dataPts,
+                                           const bool &constrainEasternVertices,
+                                           const bool &constrainWesternVertices,
+                                           const bool &constrainNorthernVertices,
+                                           const bool &constrainSouthernVertices) {
+    // Without the grid structure, use the standard greedy insertion
+    m_scatteredStrategy.setScaleZ(getScaleZ());
+    return m_scatteredStrategy.create(dataPts,
+                                      constrainEasternVertices, constrainWesternVertices,
+                                      constrainNorthernVertices, constrainSouthernVertices);
+}
+
+
+// Check if any of the borders (or corners) of a tile is constrained
+static inline bool hasConstrainedBorders(const HeightGridBorders& borders)
+{
+    return borders.constrainEast() || borders.constrainWest() || borders.constrainNorth() || borders.constrainSouth() ||
+           borders.constrainSouthWestCorner || borders.constrainSouthEastCorner ||
+           borders.constrainNorthWestCorner || borders.constrainNorthEastCorner;
+}
+
+
+Polyhedron TinCreationRtinStrategy::create(const HeightGridView &grid,
+                                           const HeightGridBorders &borders) {
+    if (grid.numCols() < 2 || grid.numRows() < 2)
+        return TinCreationStrategy::create(grid, borders);
+
+    if (!extract(grid)) {
+        m_scatteredStrategy.setScaleZ(getScaleZ());
+        return m_scatteredStrategy.create(grid, borders);
+    }
+
+    Polyhedron surface;
+    if (hasConstrainedBorders(borders)) {
+        CDT cdt;
+        stitchConstrainedBorders(borders, cdt);
+        PolyhedronBuilderFromProjectedTriangulation<CDT, HalfedgeDS> builder(cdt);
+        surface.delegate(builder);
+    }
+    else {
+        PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(m_vertices, m_rtinTriangles);
+        surface.delegate(builder);
+    }
+
+    return surface;
+}
+
+
+void TinCreationRtinStrategy::createIndexedMesh(const HeightGridView &grid,
+                                                const HeightGridBorders &borders,
+                                                IndexedMesh &mesh) {
+    if (grid.numCols() < 2 || grid.numRows() < 2) {
+        polyhedronToIndexedMesh(TinCreationStrategy::create(grid, borders), mesh);
+        return;
+    }
+
+    if (!extract(grid)) {
+        m_scatteredStrategy.setScaleZ(getScaleZ());
+        m_scatteredStrategy.createIndexedMesh(grid, borders, mesh);
+        return;
+    }
+
+    if (hasConstrainedBorders(borders)) {
+        CDT cdt;
+        stitchConstrainedBorders(borders, cdt);
+        projectedTriangulationToIndexedMesh(cdt, mesh);
+    }
+    else {
+        mesh.vertices.assign(m_vertices.begin(), m_vertices.end());
+        mesh.triangles.assign(m_rtinTriangles.begin(), m_rtinTriangles.end());
+    }
+}
+
+
+bool TinCreationRtinStrategy::extract(const HeightGridView &grid) {
+    // The hierarchy requires all the samples of the grid
+    for (int r = 0; r < grid.numRows(); r++) {
+        for (int c = 0; c < grid.numCols(); c++) {
+            if (!grid.isValid(c, r))
+                return false;
+        }
+    }
+
+    // Heights of the (2^k+1)x(2^k+1) grid, resampled if needed
+    const int gridSize = RtinHierarchy::validGridSizeFor(std::max(grid.numCols(), grid.numRows()));
+    m_heights.resize((std::size_t)gridSize*gridSize);
+    if (grid.numCols() == gridSize && grid.numRows() == gridSize) {
+        for (int r = 0; r < gridSize; r++)
+            for (int c = 0; c < gridSize; c++)
+                m_heights[r*gridSize + c] = grid.h(c, r);
+        m_hierarchy.build(m_heights, gridSize);
+    }
+    else {
+        for (int r = 0; r < gridSize; r++)
+            for (int c = 0; c < gridSize; c++)
+                interpolateGridHeight(grid, (double)c/(gridSize-1), (double)r/(gridSize-1), m_heights[r*gridSize + c]);
+
+        // The errors are measured against the original samples, not against the resampled ones
+        m_samples.resize((std::size_t)grid.numCols()*grid.numRows());
+        for (int r = 0; r < grid.numRows(); r++)
+            for (int c = 0; c < grid.numCols(); c++)
+                m_samples[r*grid.numCols() + c] = grid.h(c, r);
+        m_hierarchy.build(m_heights, gridSize, m_samples, grid.numCols(), grid.numRows());
+    }
+
+    // Extract the mesh for the tolerance, scaled to the units of the tile
+    m_hierarchy.extract(m_approxTol*getScaleZ(), m_rtinVertices, m_rtinTriangles);
+
+    m_vertices.clear();
+    m_vertices.reserve(m_rtinVertices.size());
+    for (std::vector<int>::const_iterator it = m_rtinVertices.begin(); it != m_rtinVertices.end(); ++it) {
+        const int c = *it % gridSize, r = *it / gridSize;
+        m_vertices.push_back(Point_3((double)c/(gridSize-1), (double)r/(gridSize-1), m_heights[*it]));
+    }
+
+    return true;
+}
+
+
+void TinCreationRtinStrategy::stitchConstrainedBorders(const HeightGridBorders& borders, CDT& cdt) const {
+    // Check if a vertex of the RTIN is on a constrained border (including the corners)
+    std::vector<char> onConstrainedBorder(m_vertices.size(), 0);
+    for (std::size_t i = 0; i < m_vertices.size(); i++) {
+        const Point_3& p = m_vertices[i];
+        onConstrainedBorder[i] = ( borders.constrainWest() && p.x() == 0.0 ) ||
+                                 ( borders.constrainEast() && p.x() == 1.0 ) ||
+                                 ( borders.constrainSouth() && p.y() == 0.0 ) ||
+                                 ( borders.constrainNorth() && p.y() == 1.0 ) ||
+                                 ( borders.constrainSouthWestCorner && p.x() == 0.0 && p.y() == 0.0 ) ||
+                                 ( borders.constrainSouthEastCorner && p.x() == 1.0 && p.y() == 0.0 ) ||
+                                 ( borders.constrainNorthWestCorner && p.x() == 0.0 && p.y() == 1.0 ) ||
+                                 ( borders.constrainNorthEastCorner && p.x() == 1.0 && p.y() == 1.0 );
+    }
+
+    // The vertices to preserve go first, so that they prevail over the RTIN vertices at the same position
+    if (borders.constrainSouthWestCorner) cdt.insert(borders.southWestCorner);
+    if (borders.constrainSouthEastCorner) cdt.insert(borders.southEastCorner);
+    if (borders.constrainNorthWestCorner) cdt.insert(borders.northWestCorner);
+    if (borders.constrainNorthEastCorner) cdt.insert(borders.northEastCorner);
+    const Polyline* constrainedBorders[4] = { &borders.eastern, &borders.western, &borders.northern, &borders.southern };
+    for (int b = 0; b < 4; b++)
+        cdt.insert(constrainedBorders[b]->begin(), constrainedBorders[b]->end());
+
+    // The vertices of the RTIN not in a constrained border. The corners of the tile are kept unless they are preserved
+    // from a neighbor, so that the tile is completely covered
+    std::vector<CDT::Vertex_handle> vertexHandles(m_vertices.size());
+    for (std::size_t i = 0; i < m_vertices.size(); i++) {
+        const Point_3& p = m_vertices[i];
+        const bool isCorner = (p.x() == 0.0 || p.x() == 1.0) && (p.y() == 0.0 || p.y() == 1.0);
+        if (!onConstrainedBorder[i] || isCorner)
+            vertexHandles[i] = cdt.insert(p);
+    }
+
+    // The edges of the triangles of the RTIN not touching a constrained border are maintained
+    for (std::size_t t = 0; t+2 < m_rtinTriangles.size(); t += 3) {
+        const std::size_t ids[3] = { m_rtinTriangles[t], m_rtinTriangles[t+1], m_rtinTriangles[t+2] };
+        if (onConstrainedBorder[ids[0]] || onConstrainedBorder[ids[1]] || onConstrainedBorder[ids[2]])
+            continue;
+        for (int i = 0; i < 3; i++)
+            cdt.insert_constraint(vertexHandles[ids[i]], vertexHandles[ids[(i+1)%3]]);
+    }
+}
+
+} // End namespace TinCreation
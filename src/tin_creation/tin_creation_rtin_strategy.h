@@ -0,0 +1,122 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_TIN_CREATION_RTIN_H
+#define EMODNET_QMGC_TIN_CREATION_RTIN_H
+
+#include "tin_creator.h"
+#include "tin_creation_cgal_types.h"
+#include "tin_creation_greedy_insertion_strategy.h"
+#include "rtin_hierarchy.h"
+#include "tin_creation_utils.h"
+#include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Constrained_triangulation_face_base_2.h>
+
+namespace TinCreation {
+
+/**
+ * @class TinCreationRtinStrategy
+ * @brief Creates a TIN by extracting a right-triangulated irregular network (RTIN) from the regular grid of the tile.
+ *
+ * See RtinHierarchy. The grid must be of (2^k+1)x(2^k+1) samples to use it directly (e.g., 129 samples per tile).
+ * Otherwise, it is resampled to the next valid size by bilinear interpolation (e.g., the default 256 samples per tile
+ * become 257), so the vertices of the RTIN are not at the original samples, and the errors are measured against the
+ * original samples, which fulfill the tolerance except within the smallest triangles of the hierarchy (see
+ * RtinHierarchy). Grids with no data values fall back to TinCreationGreedyInsertionStrategy, as does the scattered
+ * input version of create().
+ *
+ * The vertices of the RTIN are restricted to the positions of the grid, so they can not match the constrained vertices
+ * of the borders shared with neighboring tiles. In this case, the triangles of the RTIN touching a constrained border
+ * are removed, and the gap is retriangulated using a constrained Delaunay triangulation including the vertices to
+ * preserve in the borders.
+ */
+class TinCreationRtinStrategy : public TinCreationStrategy
+{
+    // --- Typedefs ---
+    typedef CGAL::Triangulation_vertex_base_2<Gt>                               Vb;
+    typedef CGAL::Constrained_triangulation_face_base_2<Gt>                     Fb;
+    typedef CGAL::Triangulation_data_structure_2<Vb, Fb>                        Tds;
+    typedef CGAL::Constrained_Delaunay_triangulation_2<Gt, Tds, CGAL::Exact_predicates_tag> CDT;
+
+public:
+    /**
+     * Constructor
+     * @param approxTolPerZoom Approximation tolerances per zoom (maximum vertical error, in meters)
+     */
+    TinCreationRtinStrategy(const std::vector<FT>& approxTolPerZoom)
+            : m_approxTolPerZoom(approxTolPerZoom)
+            , m_scatteredStrategy(approxTolPerZoom)
+    {
+        setParamsForZoom(0);
+    }
+
+    void setParamsForZoom(const unsigned int& zoom)
+    {
+        m_approxTol = standardHandlingOfThresholdPerZoom(m_approxTolPerZoom, zoom);
+        m_scatteredStrategy.setParamsForZoom(zoom);
+    }
+
+    /// A planar tile within the approximation tolerance would end up as the minimal mesh anyway
+    double getPlanarTileTolerance() const { return m_approxTol; }
+
+    Polyhedron create(const std::vector<Point_3>& dataPts,
+                      const bool& constrainEasternVertices = false,
+                      const bool& constrainWesternVertices = false,
+                      const bool& constrainNorthernVertices = false,
+                      const bool& constrainSouthernVertices = false);
+
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders);
+
+    /// Same as create(grid, borders), but the RTIN (or the stitched triangulation) is exported directly to the indexed mesh
+    void createIndexedMesh(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           IndexedMesh& mesh);
+
+private:
+    // --- Attributes ---
+    FT m_approxTol;
+    std::vector<FT> m_approxTolPerZoom; // in metric, not squared!
+    TinCreationGreedyInsertionStrategy m_scatteredStrategy; //!< Used for the scattered input version of create() and grids with no data
+    RtinHierarchy m_hierarchy;
+    // Scratch buffers, kept as members so that their memory is reused between tiles
+    std::vector<double> m_heights;
+    std::vector<double> m_samples;
+    std::vector<int> m_rtinVertices;
+    std::vector<std::size_t> m_rtinTriangles;
+    std::vector<Point_3> m_vertices;
+
+    // --- Private Methods ---
+    /**
+     * Extract the RTIN of a grid for the current tolerance into m_vertices/m_rtinTriangles
+     * @return False if some sample of the grid is missing (the hierarchy requires all of them)
+     */
+    bool extract(const HeightGridView& grid);
+
+    /**
+     * Triangulate the RTIN vertices and the vertices to preserve in the constrained borders into \p cdt, maintaining
+     * the triangles of the RTIN not touching any constrained border
+     */
+    void stitchConstrainedBorders(const HeightGridBorders& borders, CDT& cdt) const;
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_TIN_CREATION_RTIN_H
@@ -20,11 +20,12 @@
 
 #include "tin_creation_simplification_lindstrom_turk_strategy.h"
 #include "tin_creation_cgal_types.h"
-#include "cgal/border_edges_are_constrained_edge_map.h"
-#include "cgal/corner_vertices_are_constrained_vertex_map.h"
+#include "height_grid_triangulation.h"
+#include "cgal/surface_mesh_constraint_maps.h"
 #include "cgal/further_constrained_placement.h"
 #include "cgal/avoid_vertical_walls_placement.h"
-#include "cgal/polyhedron_builder_from_projected_triangulation.h"
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+#include <limits>
 
 namespace TinCreation {
 
@@ -34,73 +35,132 @@ Polyhedron TinCreationSimplificationLindstromTurkStrategy::create( const std::ve
                                                                    const bool& constrainNorthernVertices,
                                                                    const bool& constrainSouthernVertices )
 {
-    // Delaunay triangulation
-    Delaunay dt( dataPts.begin(), dataPts.end() );
+    // Delaunay triangulation as the mesh to simplify
+    m_vertices.assign( dataPts.begin(), dataPts.end() );
+    triangulatePoints( m_vertices, m_triangles );
 
-    // Translate to Polyhedron
-    Polyhedron surface ;
-    PolyhedronBuilderFromProjectedTriangulation<Delaunay, HalfedgeDS> builder(dt);
-    surface.delegate(builder);
+    simplify( constrainEasternVertices,
+              constrainWesternVertices,
+              constrainNorthernVertices,
+              constrainSouthernVertices );
+
+    return toPolyhedron();
+}
+
+
+
+Polyhedron TinCreationSimplificationLindstromTurkStrategy::create( const HeightGridView& grid,
+                                                                   const HeightGridBorders& borders )
+{
+    std::size_t numGridSamples;
+    if ( !triangulateHeightGrid( grid, borders, m_vertices, m_triangles, numGridSamples ) )
+        return TinCreationStrategy::create( grid, borders );
+
+    simplify( borders.constrainEast(),
+              borders.constrainWest(),
+              borders.constrainNorth(),
+              borders.constrainSouth() );
+
+    return toPolyhedron();
+}
+
+
+
+void TinCreationSimplificationLindstromTurkStrategy::createIndexedMesh( const HeightGridView& grid,
+                                                                        const HeightGridBorders& borders,
+                                                                        IndexedMesh& mesh )
+{
+    std::size_t numGridSamples;
+    if ( !triangulateHeightGrid( grid, borders, m_vertices, m_triangles, numGridSamples ) ) {
+        polyhedronToIndexedMesh( TinCreationStrategy::create( grid, borders ), mesh );
+        return;
+    }
+
+    simplify( borders.constrainEast(),
+              borders.constrainWest(),
+              borders.constrainNorth(),
+              borders.constrainSouth() );
+
+    mesh.vertices.assign( m_vertices.begin(), m_vertices.end() );
+    mesh.triangles.assign( m_triangles.begin(), m_triangles.end() );
+}
+
+
+
+void TinCreationSimplificationLindstromTurkStrategy::simplify( const bool& constrainEasternVertices,
+                                                                     const bool& constrainWesternVertices,
+                                                                     const bool& constrainNorthernVertices,
+                                                                     const bool& constrainSouthernVertices )
+{
+    typedef SurfaceMesh::Vertex_index VertexIndex;
+    typedef SurfaceMesh::Property_map<SurfaceMesh::Edge_index, bool> EdgeIsConstrainedMap;
+    typedef boost::property_map<SurfaceMesh, CGAL::vertex_point_t>::const_type VertexPointMap;
+    typedef TileCornerVerticesAreConstrainedVertexMap<VertexPointMap> VertexIsConstrainedMap;
+
+    // Translate to Surface_mesh (the vertex with index i is m_vertices[i])
+    const std::size_t numFaces = m_triangles.size()/3;
+    SurfaceMesh surface;
+    surface.reserve( m_vertices.size(), m_vertices.size() + numFaces, numFaces );
+    for ( std::vector<Point_3>::const_iterator it = m_vertices.begin(); it != m_vertices.end(); ++it )
+        surface.add_vertex( *it );
+    for ( std::size_t i = 0; i+2 < m_triangles.size(); i += 3 )
+        surface.add_face( VertexIndex( m_triangles[i] ), VertexIndex( m_triangles[i+1] ), VertexIndex( m_triangles[i+2] ) );
 
     // Set up the edge constrainer
-    typedef SMS::FurtherConstrainedPlacement<SimplificationPlacement,
-                                             Polyhedron,
-                                             BorderEdgesAreConstrainedEdgeMap<Polyhedron>,
-                                             CornerVerticesAreConstrainedVertexMap<Polyhedron> > SimplificationConstrainedPlacement;
-//    typedef SMS::AvoidVerticalWallsPlacement<SimplificationConstrainedPlacement> SimplificationConstrainedPlacementVerticalWalls;
-    BorderEdgesAreConstrainedEdgeMap<Polyhedron> beac( surface,
-                                             constrainEasternVertices,
-                                             constrainWesternVertices,
-                                             constrainNorthernVertices,
-                                             constrainSouthernVertices ) ;
-    CornerVerticesAreConstrainedVertexMap<Polyhedron> cvacvm(surface) ;
+    typedef SMS::FurtherConstrainedPlacement<SurfaceMeshSimplificationPlacement,
+                                             SurfaceMesh,
+                                             EdgeIsConstrainedMap,
+                                             VertexIsConstrainedMap > SimplificationConstrainedPlacement;
+    EdgeIsConstrainedMap beac = surface.add_property_map<SurfaceMesh::Edge_index, bool>( "e:is_constrained", false ).first ;
+    markConstrainedBorderEdges( surface, beac,
+                                constrainEasternVertices,
+                                constrainWesternVertices,
+                                constrainNorthernVertices,
+                                constrainSouthernVertices ) ;
+    VertexIsConstrainedMap cvacvm( get( CGAL::vertex_point, static_cast<const SurfaceMesh&>(surface) ) ) ;
     SimplificationConstrainedPlacement scp( beac, cvacvm ) ;
-//    SimplificationConstrainedPlacementVerticalWalls scpvw(scp);
 
-    SimplificationCost sc( SimplificationCostParams( m_weightVolume,
-                                                     m_weightBoundary,
-                                                     m_weightShape ) ) ;
+    SurfaceMeshSimplificationCost sc( SimplificationCostParams( m_weightVolume,
+                                                                m_weightBoundary,
+                                                                m_weightShape ) ) ;
 
     // TODO: Find a way to provide an intuitive stop predicate based on cost...
     int r = SMS::edge_collapse
             ( surface,
-              SimplificationStopPredicate(m_stopEdgesCount),
-//              cacsp,
-              CGAL::parameters::vertex_index_map( get( CGAL::vertex_external_index,surface ) )
-                      .halfedge_index_map(get(CGAL::halfedge_external_index, surface))
-                      .get_cost(sc)
-                              //                      .get_placement(pl)
-                              //                      .get_placement(SimplificationPlacement())
+              SurfaceMeshSimplificationStopPredicate(m_stopEdgesCount),
+              CGAL::parameters::get_cost(sc)
                       .edge_is_constrained_map(beac)
                       .get_placement(scp)
             ) ;
 
-    // --- Debug (start) ---
-//    surface.normalize_border();
-//    typedef typename Polyhedron::Halfedge_const_iterator Halfedge_const_iterator;
-//    Halfedge_const_iterator e = surface.border_halfedges_begin() ;
-//    ++e ; // We start at the second halfedge!
-//    while( e->is_border() ) {
-//        // Relevant geometric info of the current edge
-//        Point_3 p0 = e->vertex()->point(); // This is the point we will take care of now
-//        Point_3 p1 = e->prev()->vertex()->point(); // This is the previous vertex, with which p0 forms an edge
-//
-//        // Differences between the points in the edge
-//        double diffX = fabs(p1.x() - p0.x());
-//        double diffY = fabs(p1.y() - p0.y());
-//
-//        if (fabs(diffX) < std::numeric_limits<double>::epsilon() && fabs(diffY) < std::numeric_limits<double>::epsilon()) {
-////        if (fabs(diffX) < 0.001 && fabs(diffY) < 0.001) {
-//            std::cout << "Equal points on border!" << std::endl;
-//            std::cout << "Points p0 = " << p0 << std::endl;
-//            std::cout << "Points p1 = " << p1 << std::endl;
-//        }
-//        // Advance 2 positions (i.e., skip non-border halfedges)
-//        std::advance(e,2) ;
-//    }
-    // --- Debug (end) ---
-
-    return surface ;
+    // Translate the remaining faces back to the indexed mesh, keeping only the vertices still in use (the collapsed
+    // elements are just marked as removed in the Surface_mesh)
+    const std::size_t unused = std::numeric_limits<std::size_t>::max();
+    m_vertexRemap.assign( m_vertices.size(), unused );
+    m_vertices.clear();
+    m_triangles.clear();
+    m_triangles.reserve( 3*surface.number_of_faces() );
+    BOOST_FOREACH( SurfaceMesh::Face_index f, faces(surface) ) {
+        BOOST_FOREACH( VertexIndex v, vertices_around_face( halfedge(f, surface), surface ) ) {
+            std::size_t& index = m_vertexRemap[(std::size_t)v];
+            if ( index == unused ) {
+                index = m_vertices.size();
+                m_vertices.push_back( surface.point(v) );
+            }
+            m_triangles.push_back( index );
+        }
+    }
+}
+
+
+
+Polyhedron TinCreationSimplificationLindstromTurkStrategy::toPolyhedron() const
+{
+    Polyhedron poly ;
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder( m_vertices, m_triangles );
+    poly.delegate( builder );
+
+    return poly ;
 }
 
 
@@ -22,6 +22,7 @@
 #define EMODNET_QMGC_TIN_CREATION_LINDSTROM_TURK_STRATEGY_H
 
 #include "tin_creator.h"
+#include "tin_creation_cgal_types.h"
 
 namespace TinCreation {
 
@@ -32,6 +33,10 @@ namespace TinCreation {
  *
  * This class uses a modified version of the Lindstrom-Turk algorithm [1][2]
  *
+ * The simplification runs on an array-based CGAL::Surface_mesh, which is built directly from the height grid when it is
+ * available (see triangulateHeightGrid) or from a Delaunay triangulation of the points otherwise. The constraints on the
+ * borders and the corners of the tile are given to the algorithm as property maps of that mesh.
+ *
  * [1] P. Lindstrom and G. Turk. Fast and memory efficient polygonal simplification. In IEEE Visualization, pages 279–286, 1998. <br>
  * [2] P. Lindstrom and G. Turk. Evaluation of memoryless simplification. IEEE Transactions on Visualization and Computer Graphics, 5(2):98–115, slash 1999.
  */
@@ -91,6 +96,14 @@ public:
                       const bool &constrainNorthernVertices = false,
                       const bool &constrainSouthernVertices = false);
 
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders);
+
+    /// Same as create(grid, borders), but the simplified mesh is exported directly to the indexed mesh
+    void createIndexedMesh(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           IndexedMesh& mesh);
+
 private:
     // Algorithm parameters
     int m_stopEdgesCount;    // Simplification edges count stop condition. If the number of edges in the surface being simplified drops below this threshold the process finishes
@@ -98,6 +111,22 @@ private:
     double m_weightBoundary; // Weight for the boundary part of Lindstrom-Turk's cost function
     double m_weightShape;    // Weight for the shape part of Lindstrom-Turk's cost function
     std::vector<int> m_stopEdgesCountPerZoom; // Vector of desired edges count per zoom level
+    // Scratch buffers, kept as members so that their memory is reused between tiles
+    std::vector<Point_3> m_vertices;
+    std::vector<std::size_t> m_triangles;
+    std::vector<std::size_t> m_vertexRemap;
+
+    /**
+     * Simplify the mesh in m_vertices/m_triangles in place, preserving the border edges in the constrained borders and
+     * the corners of the tile (only the vertices still in use are kept)
+     */
+    void simplify(const bool &constrainEasternVertices,
+                  const bool &constrainWesternVertices,
+                  const bool &constrainNorthernVertices,
+                  const bool &constrainSouthernVertices);
+
+    /// Build the Polyhedron with the mesh in m_vertices/m_triangles
+    Polyhedron toPolyhedron() const;
 };
 
 } // End namespace TinCreation
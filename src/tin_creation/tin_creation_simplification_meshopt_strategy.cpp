@@ -0,0 +1,151 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#include "tin_creation_simplification_meshopt_strategy.h"
+#include "height_grid_triangulation.h"
+#include "cgal/polyhedron_builder_from_indexed_triangles.h"
+#include <algorithm>
+#include <limits>
+
+namespace TinCreation {
+
+// Check if a point is one of the corners of the tile
+static inline bool isTileCorner(const Point_3& p)
+{
+    return (p.x() == 0.0 || p.x() == 1.0) && (p.y() == 0.0 || p.y() == 1.0);
+}
+
+
+Polyhedron TinCreationSimplificationMeshoptStrategy::create(const std::vector<Point_3>& dataPts,
+                                                            const bool& constrainEasternVertices,
+                                                            const bool& constrainWesternVertices,
+                                                            const bool& constrainNorthernVertices,
+                                                            const bool& constrainSouthernVertices)
+{
+    // Delaunay triangulation as the mesh to simplify
+    m_vertices.assign(dataPts.begin(), dataPts.end());
+    triangulatePoints(m_vertices, m_triangles);
+
+    // Lock the vertices in the constrained borders and the corners
+    m_locked.resize(m_vertices.size());
+    for (std::size_t i = 0; i < m_vertices.size(); i++) {
+        const Point_3& p = m_vertices[i];
+        m_locked[i] = ( constrainWesternVertices && p.x() == 0.0 ) ||
+                      ( constrainEasternVertices && p.x() == 1.0 ) ||
+                      ( constrainSouthernVertices && p.y() == 0.0 ) ||
+                      ( constrainNorthernVertices && p.y() == 1.0 ) ||
+                      isTileCorner(p);
+    }
+
+    return simplify();
+}
+
+
+Polyhedron TinCreationSimplificationMeshoptStrategy::create(const HeightGridView& grid,
+                                                            const HeightGridBorders& borders)
+{
+    if (!initializeGrid(grid, borders))
+        return TinCreationStrategy::create(grid, borders);
+
+    return simplify();
+}
+
+
+void TinCreationSimplificationMeshoptStrategy::createIndexedMesh(const HeightGridView& grid,
+                                                                 const HeightGridBorders& borders,
+                                                                 IndexedMesh& mesh)
+{
+    if (!initializeGrid(grid, borders)) {
+        polyhedronToIndexedMesh(TinCreationStrategy::create(grid, borders), mesh);
+        return;
+    }
+
+    simplify(mesh.vertices, mesh.triangles);
+}
+
+
+bool TinCreationSimplificationMeshoptStrategy::initializeGrid(const HeightGridView& grid,
+                                                              const HeightGridBorders& borders)
+{
+    std::size_t numGridSamples;
+    if (!triangulateHeightGrid(grid, borders, m_vertices, m_triangles, numGridSamples))
+        return false;
+
+    // The vertices after the grid samples are the ones in the constrained borders
+    m_locked.resize(m_vertices.size());
+    for (std::size_t i = 0; i < m_vertices.size(); i++)
+        m_locked[i] = i >= numGridSamples || isTileCorner(m_vertices[i]);
+
+    return true;
+}
+
+
+Polyhedron TinCreationSimplificationMeshoptStrategy::simplify()
+{
+    simplify(m_usedVertices, m_triangles);
+
+    Polyhedron surface;
+    PolyhedronBuilderFromIndexedTriangles<HalfedgeDS, Point_3> builder(m_usedVertices, m_triangles);
+    surface.delegate(builder);
+
+    return surface;
+}
+
+
+void TinCreationSimplificationMeshoptStrategy::simplify(std::vector<Point_3>& vertices,
+                                                        std::vector<std::size_t>& triangles)
+{
+    const std::size_t numVertices = m_vertices.size();
+
+    m_positions.resize(3*numVertices);
+    for (std::size_t i = 0; i < numVertices; i++) {
+        m_positions[3*i] = (float)m_vertices[i].x();
+        m_positions[3*i+1] = (float)m_vertices[i].y();
+        m_positions[3*i+2] = (float)m_vertices[i].z();
+    }
+    m_indices.assign(m_triangles.begin(), m_triangles.end());
+    m_simplifiedIndices.resize(m_indices.size());
+
+    // In a triangulated tile there are about 3 edges for each 2 triangles
+    const std::size_t targetIndexCount = std::min(m_indices.size(), (std::size_t)std::max(2*m_stopEdgesCount, 0));
+    // The tolerance is scaled to the units of the tile, as in the rest of the strategies
+    const float targetError = m_approxTol > 0.0 ? (float)(m_approxTol*getScaleZ()) : std::numeric_limits<float>::max();
+
+    const std::size_t numIndices = m_simplifier.simplify(m_simplifiedIndices.data(), m_indices.data(), m_indices.size(),
+                                                         m_positions.data(), numVertices,
+                                                         targetIndexCount, targetError, m_locked.data());
+
+    // Keep only the vertices still in use, with their original (double) coordinates
+    const std::size_t unused = std::numeric_limits<std::size_t>::max();
+    m_vertexRemap.assign(numVertices, unused);
+    vertices.clear();
+    triangles.clear();
+    triangles.reserve(numIndices);
+    for (std::size_t i = 0; i < numIndices; i++) {
+        const unsigned int v = m_simplifiedIndices[i];
+        if (m_vertexRemap[v] == unused) {
+            m_vertexRemap[v] = vertices.size();
+            vertices.push_back(m_vertices[v]);
+        }
+        triangles.push_back(m_vertexRemap[v]);
+    }
+}
+
+} // End namespace TinCreation
@@ -0,0 +1,132 @@
+// Copyright (c) 2018 Coronis Computing S.L. (Spain)
+// All rights reserved.
+//
+// This file is part of EMODnet Quantized Mesh Generator for Cesium.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Author: Ricard Campos (ricardcd@gmail.com)
+
+#ifndef EMODNET_QMGC_TIN_CREATION_SIMPLIFICATION_MESHOPT_STRATEGY_H
+#define EMODNET_QMGC_TIN_CREATION_SIMPLIFICATION_MESHOPT_STRATEGY_H
+
+#include "tin_creator.h"
+#include "tin_creation_cgal_types.h"
+#include "tin_creation_utils.h"
+#include "height_field_simplifier.h"
+
+namespace TinCreation {
+
+/**
+ * @class TinCreationSimplificationMeshoptStrategy
+ * @brief Creates a TIN by simplifying the full resolution mesh with a quadric edge-collapse simplifier derived from the
+ * one of the meshoptimizer library [1].
+ *
+ * The height grid is triangulated directly (see triangulateHeightGrid), and the resulting indexed mesh is simplified in
+ * place by HeightFieldSimplifier, which never flips a triangle in the u/v plane and keeps the vertices on the
+ * constrained borders and the corners of the tile locked. The vertices on the unconstrained borders may only slide along
+ * them. Grids with no data values, and the scattered input version of create(), use a Delaunay triangulation of the
+ * points as the mesh to simplify instead.
+ *
+ * It is a lightweight alternative to TinCreationSimplificationLindstromTurkStrategy, that targets the same number of
+ * edges and works on flat arrays instead of a Polyhedron. Optionally, the simplification also stops before the quadric
+ * error of a vertex (roughly, the RMS distance to the planes of the triangles it replaces) exceeds a tolerance.
+ *
+ * [1] https://github.com/zeux/meshoptimizer
+ */
+class TinCreationSimplificationMeshoptStrategy : public TinCreationStrategy
+{
+public:
+    /**
+     * Constructor
+     * @param stopEdgesCountPerZoom Desired number of edges for the simplified mesh per zoom
+     * @param approxTolPerZoom Approximation tolerances per zoom (in meters). If empty, only the number of edges is used
+     */
+    TinCreationSimplificationMeshoptStrategy(const std::vector<int>& stopEdgesCountPerZoom,
+                                             const std::vector<FT>& approxTolPerZoom = std::vector<FT>())
+            : m_stopEdgesCountPerZoom(stopEdgesCountPerZoom)
+            , m_approxTolPerZoom(approxTolPerZoom)
+    {
+        setParamsForZoom(0);
+    }
+
+    void setParamsForZoom(const unsigned int& zoom)
+    {
+        if (m_stopEdgesCountPerZoom.size() == 0) {
+            std::cerr << "[WARNING::TinCreationSimplificationMeshoptStrategy] Input edges count per zoom vector is empty, using 500 (default value)" << std::endl;
+            m_stopEdgesCount = 500;
+        }
+        else if (zoom < m_stopEdgesCountPerZoom.size())
+            m_stopEdgesCount = m_stopEdgesCountPerZoom[zoom];
+        else
+            m_stopEdgesCount = m_stopEdgesCountPerZoom.back();
+
+        m_approxTol = m_approxTolPerZoom.empty() ? -1.0 : standardHandlingOfThresholdPerZoom(m_approxTolPerZoom, zoom);
+    }
+
+    /// A planar tile within the approximation tolerance (if any) would end up as the minimal mesh anyway
+    double getPlanarTileTolerance() const { return m_approxTol > 0.0 ? m_approxTol : 0.0; }
+
+    Polyhedron create(const std::vector<Point_3>& dataPts,
+                      const bool& constrainEasternVertices = false,
+                      const bool& constrainWesternVertices = false,
+                      const bool& constrainNorthernVertices = false,
+                      const bool& constrainSouthernVertices = false);
+
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders);
+
+    /// Same as create(grid, borders), but the simplified mesh is exported directly to the indexed mesh
+    void createIndexedMesh(const HeightGridView& grid,
+                           const HeightGridBorders& borders,
+                           IndexedMesh& mesh);
+
+private:
+    // --- Attributes ---
+    int m_stopEdgesCount;                     // Simplification stops when the number of edges drops below this value
+    FT m_approxTol;                           // Error tolerance, in meters (negative if not used)
+    std::vector<int> m_stopEdgesCountPerZoom; // Vector of desired edges count per zoom level
+    std::vector<FT> m_approxTolPerZoom;       // Vector of error tolerances per zoom level (may be empty)
+    // Scratch buffers, kept as members so that their memory is reused between tiles
+    std::vector<Point_3> m_vertices;
+    std::vector<std::size_t> m_triangles;
+    std::vector<unsigned char> m_locked;
+    std::vector<float> m_positions;
+    std::vector<unsigned int> m_indices;
+    std::vector<unsigned int> m_simplifiedIndices;
+    std::vector<std::size_t> m_vertexRemap;
+    std::vector<Point_3> m_usedVertices;
+    HeightFieldSimplifier m_simplifier;
+
+    // --- Private Methods ---
+    /**
+     * Set the full resolution mesh of a grid in m_vertices/m_triangles, and its locked vertices in m_locked
+     * @return False if the grid can not be triangulated directly (see triangulateHeightGrid)
+     */
+    bool initializeGrid(const HeightGridView& grid, const HeightGridBorders& borders);
+
+    /**
+     * Simplify the mesh in m_vertices/m_triangles, keeping the vertices flagged in m_locked
+     * @param[out] vertices The vertices still in use (may not be m_vertices)
+     * @param[out] triangles The simplified triangles, indexing \p vertices (may be m_triangles)
+     */
+    void simplify(std::vector<Point_3>& vertices, std::vector<std::size_t>& triangles);
+
+    /// Simplify the mesh in m_vertices/m_triangles (see above) and build the Polyhedron with the result
+    Polyhedron simplify();
+};
+
+} // End namespace TinCreation
+
+#endif //EMODNET_QMGC_TIN_CREATION_SIMPLIFICATION_MESHOPT_STRATEGY_H
@@ -20,6 +20,9 @@
 #include "tin_creation_simplification_point_set.h"
 #include <CGAL/convex_hull_2.h>
 #include <CGAL/Triangulation_conformer_2.h>
+#include "height_grid_triangulation.h"
+#include "height_grid_sharp_edges.h"
+#include "height_profile_simplification.h"
 #include "cgal/polyhedron_builder_from_projected_triangulation.h"
 //#include "cgal/Polyhedral_mesh_domain_with_features_3_extended.h"
 // Project-related
@@ -30,38 +33,175 @@
 
 namespace TinCreation {
 
+// Dihedral angle (in degrees) for an edge to be considered a sharp feature
+static const double kSharpEdgeAngle = 60.0;
+
+// Tolerance to consider that a vertex is on a border of the tile
+static const double kBorderTolerance = 1e-9;
+
 Polyhedron TinCreationSimplificationPointSet::create( const std::vector<Point_3>& dataPts,
                                                       const bool &constrainEasternVertices,
                                                       const bool &constrainWesternVertices,
                                                       const bool &constrainNorthernVertices,
                                                       const bool &constrainSouthernVertices)
 {
-    // Scale the parameters according to the tile
-    m_borderSimpMaxScaledSqDist = m_borderSimpMaxDist*this->getScaleZ();
-    m_borderSimpMaxScaledSqDist *= m_borderSimpMaxScaledSqDist; // Squared value to ease distance computations
+    // Delaunay triangulation
+    Polyhedron surface;
+    triangulatePoints(dataPts, surface);
 
-    PointCloud ptsToSimplify;
+    return createFromSurface(surface,
+                             constrainEasternVertices,
+                             constrainWesternVertices,
+                             constrainNorthernVertices,
+                             constrainSouthernVertices);
+}
 
-    // Delaunay triangulation
-    Delaunay dt( dataPts.begin(), dataPts.end() );
 
-    // Translate to Polyhedron
-    Polyhedron surface;
-    PolyhedronBuilderFromProjectedTriangulation<Delaunay, HalfedgeDS> builderDT(dt);
-    surface.delegate(builderDT);
+
+Polyhedron TinCreationSimplificationPointSet::create( const HeightGridView& grid,
+                                                      const HeightGridBorders& borders )
+{
+    // The triangulation of the grid is known in advance, so we can get its border vertices and sharp edges directly
+    // from the grid, without building a mesh
+    std::size_t numGridSamples;
+    if ( !triangulateHeightGrid(grid, borders, m_gridVertices, m_gridTriangles, numGridSamples) )
+        return TinCreationStrategy::create(grid, borders);
+
+    // Split the vertices into the ones on each border of the tile (corners in both) and the rest
+    PointCloud ptsToSimplify, easternBorderVertices, westernBorderVertices, northernBorderVertices, southernBorderVertices;
+    for ( std::vector<Point_3>::const_iterator it = m_gridVertices.begin(); it != m_gridVertices.end(); ++it ) {
+        bool onBorder = false;
+        if ( it->x() <= kBorderTolerance ) {
+            westernBorderVertices.push_back(*it);
+            onBorder = true;
+        }
+        if ( it->x() >= 1.0-kBorderTolerance ) {
+            easternBorderVertices.push_back(*it);
+            onBorder = true;
+        }
+        if ( it->y() <= kBorderTolerance ) {
+            southernBorderVertices.push_back(*it);
+            onBorder = true;
+        }
+        if ( it->y() >= 1.0-kBorderTolerance ) {
+            northernBorderVertices.push_back(*it);
+            onBorder = true;
+        }
+        if ( !onBorder )
+            ptsToSimplify.push_back(*it);
+    }
+
+    Polylines featurePolylines;
+    if ( m_preserveSharpEdges )
+        extractHeightGridSharpEdgePolylines(grid, borders, kSharpEdgeAngle, featurePolylines);
+
+    return createFromParts(ptsToSimplify,
+                           easternBorderVertices,
+                           westernBorderVertices,
+                           northernBorderVertices,
+                           southernBorderVertices,
+                           featurePolylines,
+                           borders.constrainEast(),
+                           borders.constrainWest(),
+                           borders.constrainNorth(),
+                           borders.constrainSouth());
+}
+
+
+
+Polyhedron TinCreationSimplificationPointSet::createFromSurface( Polyhedron& surface,
+                                                                 const bool &constrainEasternVertices,
+                                                                 const bool &constrainWesternVertices,
+                                                                 const bool &constrainNorthernVertices,
+                                                                 const bool &constrainSouthernVertices)
+{
+    PointCloud ptsToSimplify;
+
     surface.normalize_border();
 
-    // Simplification
     getAllNonBorderVertices(surface, ptsToSimplify); // Note that, because of the required pixel overlap for terrain tiles, this additional line of pixels go over the poles in extreme tiles when in ECEF and when converted back they get lat/lon on the other half of the globe... Since we treat border points differently, we don't have any problem. If you try to simplify ALL the points in the tile, the method will fail because of that reason!
+
+    // NOTE: we do not use the convex hull to get the borders, basically because the implementation of CGAL only
+    // considers the corner vertices of the tiles as points on the convex hull, and not the ones ON the edges joining them.
+    // We leave the code comented for future reference:
+    // Compute the convex hull in the base 2D plane
+//    PointCloud chPts;
+//    CGAL::convex_hull_2( pts.begin(), pts.end(), std::back_inserter(chPts), CGAL::Projection_traits_xy_3<K>() );
+
+    // Extract the points at the borders
+    PointCloud northernBorderVertices, southernBorderVertices, easternBorderVertices, westernBorderVertices ;
+    Point_3 cornerPoint00, cornerPoint01, cornerPoint10, cornerPoint11;
+    extractTileBordersFromPolyhedron<Polyhedron>(surface, easternBorderVertices, westernBorderVertices, northernBorderVertices, southernBorderVertices, cornerPoint00, cornerPoint01, cornerPoint10, cornerPoint11);
+
+    Polylines featurePolylines;
+    if (m_preserveSharpEdges) {
+        // Create a property map storing if an edge is sharp or not (since the Polyhedron_3 does not have internal property_maps creation, we use a map container within a boost::associative_property_map)
+        typedef typename boost::graph_traits<Polyhedron>::edge_descriptor edge_descriptor;
+        typedef typename std::map<edge_descriptor, bool> EdgeIsSharpMap;
+        typedef typename boost::associative_property_map<EdgeIsSharpMap> EdgeIsSharpPropertyMap;
+        EdgeIsSharpMap map;
+        EdgeIsSharpPropertyMap eisMap(map);
+
+        // Detect sharp edges
+        detect_sharp_edges_without_borders<Polyhedron, double, EdgeIsSharpPropertyMap, K>(surface, FT(kSharpEdgeAngle), eisMap);
+
+        // Trace the polylines from the detected edges
+        extract_polylines_from_sharp_edges(surface, eisMap, featurePolylines);
+    }
+
+    return createFromParts(ptsToSimplify,
+                           easternBorderVertices,
+                           westernBorderVertices,
+                           northernBorderVertices,
+                           southernBorderVertices,
+                           featurePolylines,
+                           constrainEasternVertices,
+                           constrainWesternVertices,
+                           constrainNorthernVertices,
+                           constrainSouthernVertices);
+}
+
+
+
+Polyhedron TinCreationSimplificationPointSet::createFromParts( PointCloud& ptsToSimplify,
+                                                               PointCloud& easternBorderVertices,
+                                                               PointCloud& westernBorderVertices,
+                                                               PointCloud& northernBorderVertices,
+                                                               PointCloud& southernBorderVertices,
+                                                               const Polylines& featurePolylines,
+                                                               const bool &constrainEasternVertices,
+                                                               const bool &constrainWesternVertices,
+                                                               const bool &constrainNorthernVertices,
+                                                               const bool &constrainSouthernVertices)
+{
+    // Scale the parameters according to the tile
+    m_borderSimpMaxScaledSqDist = m_borderSimpMaxDist*this->getScaleZ();
+    m_borderSimpMaxScaledSqDist *= m_borderSimpMaxScaledSqDist; // Squared value to ease distance computations
+
+    // Simplification
     ptsToSimplify = simplify(ptsToSimplify);
 
     // Impose the constraints based on borders and features in the original mesh
-    imposeConstraintsAndSimplifyPolylines(surface,
+    bool hasFeatureConstraints = imposeConstraintsAndSimplifyPolylines(easternBorderVertices,
+                                          westernBorderVertices,
+                                          northernBorderVertices,
+                                          southernBorderVertices,
+                                          featurePolylines,
                                           constrainEasternVertices,
                                           constrainWesternVertices,
                                           constrainNorthernVertices,
                                           constrainSouthernVertices);
 
+    // Without feature constraints, the triangulation is just the Delaunay triangulation of the remaining border vertices
+    // and the simplified points, which can use the lattice of the heightmap as long as the simplification kept the
+    // original samples (see triangulatePoints)
+    PointCloud unconstrainedPts;
+    if (!hasFeatureConstraints) {
+        unconstrainedPts.reserve(m_cdt.number_of_vertices() + ptsToSimplify.size());
+        for (CTXY::Finite_vertices_iterator it = m_cdt.finite_vertices_begin(); it != m_cdt.finite_vertices_end(); ++it)
+            unconstrainedPts.push_back(it->point());
+    }
+
     // Insert the simplified points in the constrained triangulation
     for( PointCloud::iterator it = ptsToSimplify.begin(); it != ptsToSimplify.end(); ++it ) {
         // Error check
@@ -71,7 +211,17 @@ Polyhedron TinCreationSimplificationPointSet::create( const std::vector<Point_3>
         }
 
         // Insert the point
-        m_cdt.insert(*it);
+        if (hasFeatureConstraints)
+            m_cdt.insert(*it);
+        else
+            unconstrainedPts.push_back(*it);
+    }
+
+    if (!hasFeatureConstraints) {
+        m_cdt.clear() ; // Clear internal variables for reusing the object
+        Polyhedron surface;
+        triangulatePoints(unconstrainedPts, surface);
+        return surface;
     }
 
     // Test: Make it conforming Delaunay before storing (don't know why but this results in an infinite loop...)
@@ -89,26 +239,18 @@ Polyhedron TinCreationSimplificationPointSet::create( const std::vector<Point_3>
 
 
 
-void
+bool
 TinCreationSimplificationPointSet::
-imposeConstraintsAndSimplifyPolylines(Polyhedron& surface, // Note: points in the borders to maintain will be removed from this list!
+imposeConstraintsAndSimplifyPolylines(PointCloud& easternBorderVertices,
+                  PointCloud& westernBorderVertices,
+                  PointCloud& northernBorderVertices,
+                  PointCloud& southernBorderVertices,
+                  const Polylines& featurePolylines,
                   const bool &constrainEasternVertices,
                   const bool &constrainWesternVertices,
                   const bool &constrainNorthernVertices,
                   const bool &constrainSouthernVertices)
 {
-    // NOTE: we do not use the convex hull to get the borders, basically because the implementation of CGAL only
-    // considers the corner vertices of the tiles as points on the convex hull, and not the ones ON the edges joining them.
-    // We leave the code comented for future reference:
-    // Compute the convex hull in the base 2D plane
-//    PointCloud chPts;
-//    CGAL::convex_hull_2( pts.begin(), pts.end(), std::back_inserter(chPts), CGAL::Projection_traits_xy_3<K>() );
-
-    // Extract the points at the borders
-    PointCloud northernBorderVertices, southernBorderVertices, easternBorderVertices, westernBorderVertices ;
-    Point_3 cornerPoint00, cornerPoint01, cornerPoint10, cornerPoint11;
-    extractTileBordersFromPolyhedron<Polyhedron>(surface, easternBorderVertices, westernBorderVertices, northernBorderVertices, southernBorderVertices, cornerPoint00, cornerPoint01, cornerPoint10, cornerPoint11);
-
     // Sort the points in the borders
     auto smallerThanInX = [](const Point_3& a, const Point_3& b) -> bool {return a.x() < b.x();};
     auto smallerThanInY = [](const Point_3& a, const Point_3& b) -> bool {return a.y() < b.y();};
@@ -222,70 +364,36 @@ std::cout << "icsp: insert the border polylines that need to be maintained as th
 std::cout << "icsp: insert the border polylines that need to be maintained as they are DONE" << std::endl;
 */
 
-    if (!constrainEasternVertices) {
-        // Add as a constraint (will be simplified by PS::simplify())
-        m_cdt.insert_constraint(easternBorderVertices.begin(), easternBorderVertices.end(), false);
-    }
-    else {
-        // Add as regular vertices in the triangulation: since they are in the borders, the edges will be maintained!
-		for (Polyline::iterator it = easternBorderVertices.begin(); it != easternBorderVertices.end(); ++it)
-			m_cdt.insert(*it);
-    }
-    if (!constrainWesternVertices) {
-        // Add as a constraint (will be simplified by PS::simplify())
-        m_cdt.insert_constraint(westernBorderVertices.begin(), westernBorderVertices.end(), false);
-    }
-    else {
-        // Add as regular vertices in the triangulation: since they are in the borders, the edges will be maintained!
-		for (Polyline::iterator it = westernBorderVertices.begin(); it != westernBorderVertices.end(); ++it)
-			m_cdt.insert(*it);
-    }
-    if (!constrainSouthernVertices) {
-        // Add as a constraint (will be simplified by PS::simplify())
-        m_cdt.insert_constraint(southernBorderVertices.begin(), southernBorderVertices.end(), false);
-    }
-    else {
-        // Add as regular vertices in the triangulation: since they are in the borders, the edges will be maintained!
-		for (Polyline::iterator it = southernBorderVertices.begin(); it != southernBorderVertices.end(); ++it)
-			m_cdt.insert(*it);
-    }
-    if (!constrainNorthernVertices) {
-        // Add as a constraint (will be simplified by PS::simplify())
-        m_cdt.insert_constraint(northernBorderVertices.begin(), northernBorderVertices.end(), false);
-    }
-    else {
-        // Add as regular vertices in the triangulation: since they are in the borders, the edges will be maintained!
-		for (Polyline::iterator it = northernBorderVertices.begin(); it != northernBorderVertices.end(); ++it)
-			m_cdt.insert(*it);
+    // Borders are 1D height profiles: the ones not constrained are simplified on their own, and the remaining vertices
+    // are added as regular vertices in the triangulation (since they are in the borders, the edges will be maintained!)
+    PointCloud* borderVertices[4] = { &easternBorderVertices, &westernBorderVertices, &southernBorderVertices, &northernBorderVertices };
+    const bool constrainBorder[4] = { constrainEasternVertices, constrainWesternVertices, constrainSouthernVertices, constrainNorthernVertices };
+    const bool borderAlongX[4] = { false, false, true, true };
+    for (int b = 0; b < 4; b++) {
+        if (!constrainBorder[b])
+            simplifyHeightProfile(*borderVertices[b], borderAlongX[b], m_borderSimpMaxScaledSqDist, m_borderSimpMaxLengthPercent);
+        for (Polyline::iterator it = borderVertices[b]->begin(); it != borderVertices[b]->end(); ++it)
+            m_cdt.insert(*it);
     }
 
+    bool hasFeatureConstraints = false;
     if (m_preserveSharpEdges) {
-        // Create a property map storing if an edge is sharp or not (since the Polyhedron_3 does not have internal property_maps creation, we use a map container within a boost::associative_property_map)
-        typedef typename boost::graph_traits<Polyhedron>::edge_descriptor edge_descriptor;
-        typedef typename std::map<edge_descriptor, bool> EdgeIsSharpMap;
-        typedef typename boost::associative_property_map<EdgeIsSharpMap> EdgeIsSharpPropertyMap;
-        EdgeIsSharpMap map;
-        EdgeIsSharpPropertyMap eisMap(map);
-
-        // Detect sharp edges
-        detect_sharp_edges_without_borders<Polyhedron, double, EdgeIsSharpPropertyMap, K>(surface, FT(60.0), eisMap);
-
-        // Trace the polylines from the detected edges
-        Polylines featurePolylines;
-        extract_polylines_from_sharp_edges(surface, eisMap, featurePolylines);
-
         for (Polylines::const_iterator it = featurePolylines.begin(); it != featurePolylines.end(); ++it) {
             if ((*it).size() > m_minFeaturePolylineSize) {
                 //	    std::cout << "A polyline to simplify:" << std::endl;
                 //	    for (Polyline::const_iterator itp = (*it).begin(); itp != (*it).end(); ++itp)
                 //		std::cout << *itp << std::endl;
                 m_cdt.insert_constraint((*it).begin(), (*it).end(), false);
+                hasFeatureConstraints = true;
             }
         }
     }
 
-    // Simplify the polylines
-    std::size_t numRemoved = PS::simplify(m_cdt, PSSqDist3Cost(m_borderSimpMaxLengthPercent), PSStopCost(m_borderSimpMaxScaledSqDist), true);
+    // Simplify the feature polylines
+    if (hasFeatureConstraints)
+        PS::simplify(m_cdt, PSSqDist3Cost(m_borderSimpMaxLengthPercent), PSStopCost(m_borderSimpMaxScaledSqDist), true);
+
+    return hasFeatureConstraints;
 }
 
 
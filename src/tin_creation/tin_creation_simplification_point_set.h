@@ -96,6 +96,9 @@ public:
                       const bool &constrainNorthernVertices = false,
                       const bool &constrainSouthernVertices = false) ;
 
+    Polyhedron create(const HeightGridView& grid,
+                      const HeightGridBorders& borders) ;
+
     /**
      * Simplifies a point set
      * @param pts Points to simplify
@@ -131,9 +134,36 @@ private:
     unsigned int m_minFeaturePolylineSize;
     CTXY m_cdt;
     bool m_preserveSharpEdges;
+    std::vector<Point_3> m_gridVertices; // Scratch buffers for the triangulation of the height grid, reused between tiles
+    std::vector<std::size_t> m_gridTriangles;
+
+    /// Creates the TIN from the full resolution surface of the tile (a triangulation of all the input points)
+    Polyhedron createFromSurface(Polyhedron& surface,
+                                 const bool &constrainEasternVertices,
+                                 const bool &constrainWesternVertices,
+                                 const bool &constrainNorthernVertices,
+                                 const bool &constrainSouthernVertices) ;
+
+    /// Creates the TIN from the vertices of the tile, split into the ones to simplify and the ones in each border, and
+    /// the sharp feature polylines to preserve
+    Polyhedron createFromParts(PointCloud& ptsToSimplify,
+                               PointCloud& easternBorderVertices,
+                               PointCloud& westernBorderVertices,
+                               PointCloud& northernBorderVertices,
+                               PointCloud& southernBorderVertices,
+                               const Polylines& featurePolylines,
+                               const bool &constrainEasternVertices,
+                               const bool &constrainWesternVertices,
+                               const bool &constrainNorthernVertices,
+                               const bool &constrainSouthernVertices) ;
 
     /// Imposes the required constraints to the internal CDT structure. Simplified the border/feature polylines when needed
-    void imposeConstraintsAndSimplifyPolylines(Polyhedron& surface,
+    /// Returns true if feature polylines were inserted as constraints (the border vertices are inserted as regular vertices)
+    bool imposeConstraintsAndSimplifyPolylines(PointCloud& easternBorderVertices,
+                                               PointCloud& westernBorderVertices,
+                                               PointCloud& northernBorderVertices,
+                                               PointCloud& southernBorderVertices,
+                                               const Polylines& featurePolylines,
                                                const bool &constrainEasternVertices,
                                                const bool &constrainWesternVertices,
                                                const bool &constrainNorthernVertices,
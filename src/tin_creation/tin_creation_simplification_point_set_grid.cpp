@@ -27,22 +27,22 @@ std::vector<Point_3>
 TinCreationSimplificationPointSetGrid::
 simplify(const std::vector<Point_3> &pts) {
     // Convert to metric
-    std::vector<Point_3> ptsToSimpECEF = this->convertUVHToECEF(pts);
+    std::vector<Point_3> ptsToSimpMetric = this->convertUVHToMetric(pts);
 
-    if (ptsToSimpECEF.size() == 0)
+    if (ptsToSimpMetric.size() == 0)
         return std::vector<Point_3>();
 
     // Simplify using grid simplification (erase-remove idiom)
-    ptsToSimpECEF.erase(CGAL::grid_simplify_point_set(ptsToSimpECEF.begin(),
-                                                      ptsToSimpECEF.end(),
+    ptsToSimpMetric.erase(CGAL::grid_simplify_point_set(ptsToSimpMetric.begin(),
+                                                      ptsToSimpMetric.end(),
                                                       m_cellSize),
-                        ptsToSimpECEF.end());
+                        ptsToSimpMetric.end());
 
     // Optional: after erase(), use Scott Meyer's "swap trick" to trim excess capacity
-//    std::vector<Point_3>(ptsToSimpECEF).swap(ptsToSimpECEF);
+//    std::vector<Point_3>(ptsToSimpMetric).swap(ptsToSimpMetric);
 
     // Convert to the local (XY-projectable) coordinates again
-    std::vector<Point_3> ptsSimp = this->convertECEFToUVH(ptsToSimpECEF);
+    std::vector<Point_3> ptsSimp = this->convertMetricToUVH(ptsToSimpMetric);
 
     return ptsSimp;
 }
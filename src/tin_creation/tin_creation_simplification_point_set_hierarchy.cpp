@@ -28,20 +28,20 @@ std::vector<Point_3>
 TinCreationSimplificationPointSetHierarchy::
 simplify(const std::vector<Point_3> &pts) {
     // Convert to metric
-    std::vector<Point_3> ptsToSimpECEF = this->convertUVHToECEF(pts);
+    std::vector<Point_3> ptsToSimpMetric = this->convertUVHToMetric(pts);
 
-    if (ptsToSimpECEF.size() == 0)
+    if (ptsToSimpMetric.size() == 0)
         return std::vector<Point_3>();
 
     // Simplify using hierarchical point set simplification (erase-remove idiom)
-    ptsToSimpECEF.erase(CGAL::hierarchy_simplify_point_set(ptsToSimpECEF.begin(),
-                                                           ptsToSimpECEF.end(),
+    ptsToSimpMetric.erase(CGAL::hierarchy_simplify_point_set(ptsToSimpMetric.begin(),
+                                                           ptsToSimpMetric.end(),
                                                            m_maxClusterSize, // Max cluster size
                                                            m_maxSurfaceVariance), // Max surface variation
-                        ptsToSimpECEF.end());
+                        ptsToSimpMetric.end());
 
     // Convert to the local (XY-projectable) coordinates again
-    std::vector<Point_3> ptsSimp = this->convertECEFToUVH(ptsToSimpECEF);
+    std::vector<Point_3> ptsSimp = this->convertMetricToUVH(ptsToSimpMetric);
 
     return ptsSimp;
 }
@@ -20,30 +20,54 @@
 
 #include "tin_creation_simplification_point_set_wlop.h"
 #include <CGAL/wlop_simplify_and_regularize_point_set.h>
+#include "base/parallelism_budget.h"
+#ifdef CGAL_LINKED_WITH_TBB
+#include <tbb/task_arena.h>
+#endif
 
 namespace TinCreation {
 
+template <class ConcurrencyTag>
+void wlopSimplify(const std::vector<Point_3>& pts, std::vector<Point_3>& ptsSimp,
+                  const double& retainPercentage, const double& radius)
+{
+    CGAL::wlop_simplify_and_regularize_point_set
+            <ConcurrencyTag>
+            (pts.begin(),
+             pts.end(),
+             std::back_inserter(ptsSimp),
+             retainPercentage,
+             radius
+            );
+}
+
+
 std::vector<Point_3>
 TinCreationSimplificationPointSetWLOP::
 simplify(const std::vector<Point_3> &pts) {
     // Convert to metric
-    std::vector<Point_3> ptsToSimpECEF = this->convertUVHToECEF(pts);
+    std::vector<Point_3> ptsToSimpMetric = this->convertUVHToMetric(pts);
 
-    if (ptsToSimpECEF.size() == 0)
+    if (ptsToSimpMetric.size() == 0)
         return std::vector<Point_3>();
 
-    std::vector<Point_3> ptsSimpECEF;
-    CGAL::wlop_simplify_and_regularize_point_set
-            <Concurrency_tag>
-            (ptsToSimpECEF.begin(),
-             ptsToSimpECEF.end(),
-             std::back_inserter(ptsSimpECEF),
-             m_retainPercentage,
-             m_radius
-            );
+    // Run the parallel version only on the cores left idle by the other tiles in flight. The arena bounds the number
+    // of TBB workers joining this call, all of them taken from the single worker pool shared by the process
+    std::vector<Point_3> ptsSimpMetric;
+#ifdef CGAL_LINKED_WITH_TBB
+    const int numThreads = ParallelismBudget::threadsPerTile();
+    if (numThreads > 1) {
+        tbb::task_arena arena(numThreads);
+        arena.execute([&]() {
+            wlopSimplify<CGAL::Parallel_tag>(ptsToSimpMetric, ptsSimpMetric, m_retainPercentage, m_radius);
+        });
+    }
+    else
+#endif
+        wlopSimplify<CGAL::Sequential_tag>(ptsToSimpMetric, ptsSimpMetric, m_retainPercentage, m_radius);
 
     // Convert to the local (XY-projectable) coordinates again
-    std::vector<Point_3> ptsSimp = this->convertECEFToUVH(ptsSimpECEF);
+    std::vector<Point_3> ptsSimp = this->convertMetricToUVH(ptsSimpMetric);
 
     return ptsSimp;
 }
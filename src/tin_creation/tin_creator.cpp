@@ -20,12 +20,18 @@
 
 #include "tin_creator.h"
 #include <math.h>       /* isnan */
-#include "crs_conversions.h"
-#include <GeographicLib/Geocentric.hpp>
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <cmath>
 
 
 namespace TinCreation {
 
+// A 5% error on the distances is well under the tolerances of the point set simplification methods. With it, the local
+// frame is used from zoom level 4 near the equator, 6 at mid latitudes and 8 near the poles
+const double TinCreationStrategy::LocalTangentFrameMaxDistortion = 0.05;
+
 std::vector<Point_3>
 TinCreationStrategy::
 convertUVHToECEF(const std::vector<Point_3> &pts) const {
@@ -36,22 +42,7 @@ convertUVHToECEF(const std::vector<Point_3> &pts) const {
 
     // Points in ECEF coordinates
     std::vector<Point_3> ecefPoints;
-    ecefPoints.reserve(pts.size());
-    for (std::vector<Point_3>::const_iterator it = pts.begin(); it != pts.end(); ++it) {
-        Point_3 p = convertUVHToECEF(*it);
-//        if (!isnan(p.x()))
-            ecefPoints.push_back(p);
-//        else
-//            std::cout << "Point not converted to ECEF: " << *it << ", result of conversion = " << p << std::endl;
-
-        // --- Debug (start) ---
-//        std::cout << "ECEF point = " << p << std::endl;
-//        // Convert back for testing
-//        Point_3 p2 = convertECEFToUVH(p);
-//        std::cout << "UVH point (original) = " << *it << std::endl;
-//        std::cout << "UVH point (converted back) = " << p2 << std::endl;
-        // --- Debug  (end)  ---
-    }
+    convertUVHToECEF(pts.data(), pts.size(), ecefPoints);
 
     return ecefPoints;
 }
@@ -64,12 +55,9 @@ convertECEFToUVH(const std::vector<Point_3> &pts) const {
         return pts;
     }
 
-    // Points in ECEF coordinates
+    // Points in UVH coordinates
     std::vector<Point_3> uvhPoints;
-    uvhPoints.reserve(pts.size());
-    for (std::vector<Point_3>::const_iterator it = pts.begin(); it != pts.end(); ++it) {
-        uvhPoints.emplace_back(convertECEFToUVH(*it));
-    }
+    convertECEFToUVH(pts.data(), pts.size(), uvhPoints);
 
     return uvhPoints;
 }
@@ -81,39 +69,10 @@ Point_3 TinCreationStrategy::convertUVHToECEF(const Point_3& p) const
         return p;
     }
 
-//    std::cout << "UVHToECEF" << std::endl;
-//    std::cout << "uvh" << std::endl;
-//    std::cout << p << std::endl;
+    std::vector<Point_3> ecefPoints;
+    convertUVHToECEF(&p, 1, ecefPoints);
 
-    // From UVH to lat/lon/height
-    double lat = this->getMinY() + ((this->getMaxY() - this->getMinY()) * p.y());
-    double lon = this->getMinX() + ((this->getMaxX() - this->getMinX()) * p.x());
-    double h = this->getMinZ() + ((this->getMaxZ() - this->getMinZ()) * p.z());
-
-    if (h < this->getMinZ() || h > this->getMaxZ())
-        std::cout << "h = " << std::endl;
-
-    // Requirement of the GeographicLib::Geocentric::Forward function, and makes sense too...
-    if (lat > 90)
-        lat = 90;
-    else if (lat < -90)
-        lat = -90;
-
-//    std::cout << "lat/lon/height" << std::endl;
-//    std::cout << lat << ", " << lon << ", " << h << std::endl;
-
-    // TODO: implement the conversion tools correctly to drop dependency on GeographicLib (or use GDAL directly).
-    //       Currently, the crs_conversions::ecef2llh and crs_conversions::llh2ecef functions do not behave as expected!
-    GeographicLib::Geocentric earth(GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f());
-    double tmpx, tmpy, tmpz;
-//    crs_conversions::llh2ecef(lat, lon, h,
-//                              tmpx, tmpy, tmpz);
-    earth.Forward(lat, lon, h, tmpx, tmpy, tmpz);
-
-//    std::cout << "ECEF" << std::endl;
-//    std::cout << tmpx << ", " << tmpy << ", " << tmpz << std::endl;
-
-    return Point_3(tmpx, tmpy, tmpz);
+    return ecefPoints.front();
 }
 
 /// Convert points from local UVH to ECEF given the limits of the tile
@@ -125,51 +84,151 @@ Point_3 TinCreationStrategy::convertECEFToUVH(const Point_3& p) const
         return p;
     }
 
-//    std::cout << "ECEFToUVH" << std::endl;
-//    std::cout << "ECEF" << std::endl;
-//    std::cout << p << std::endl;
+    std::vector<Point_3> uvhPoints;
+    convertECEFToUVH(&p, 1, uvhPoints);
 
-    // TODO: implement the conversion tools correctly to drop dependency on GeographicLib (or use GDAL directly).
-    //       Currently, the crs_conversions::ecef2llh and crs_conversions::llh2ecef functions do not behave as expected!
+    return uvhPoints.front();
+}
 
-    // From ECEF to lat/lon/height
-    GeographicLib::Geocentric earth(GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f());
-    double lat, lon, height;
-//    crs_conversions::ecef2llh(p.x(), p.y(), p.z(),
-//                              lat, lon, height);
-    earth.Reverse(p.x(), p.y(), p.z(),
-                  lat, lon, height);
+void TinCreationStrategy::convertUVHToECEF(const Point_3* pts, const std::size_t& n, std::vector<Point_3>& ecefPts) const
+{
+    // From UVH to lat/lon/height
+    std::vector<double> lon(n), lat(n), h(n);
+    for (std::size_t i = 0; i < n; i++) {
+        lat[i] = this->getMinY() + ((this->getMaxY() - this->getMinY()) * pts[i].y());
+        lon[i] = this->getMinX() + ((this->getMaxX() - this->getMinX()) * pts[i].x());
+        h[i] = this->getMinZ() + ((this->getMaxZ() - this->getMinZ()) * pts[i].z());
+
+        // The conversion requires the latitude to be in [-90, 90], and it makes sense too...
+        if (lat[i] > 90)
+            lat[i] = 90;
+        else if (lat[i] < -90)
+            lat[i] = -90;
+    }
 
-//    std::cout << "lat/lon/height" << std::endl;
-//    std::cout << lat << ", " << lon << ", " << height << std::endl;
+    // To ECEF, all points at once
+    std::vector<double> x(n), y(n), z(n);
+    m_ecefConverter.geodeticToECEF(lon.data(), lat.data(), h.data(), n, x.data(), y.data(), z.data());
 
-//    std::cout << "(this->getMaxX() - this->getMinX()) = " << (this->getMaxX() - this->getMinX()) << std::endl;
-//    std::cout << "(this->getMaxY() - this->getMinY()) = " << (this->getMaxY() - this->getMinY()) << std::endl;
+    ecefPts.clear();
+    ecefPts.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+        ecefPts.push_back(Point_3(x[i], y[i], z[i]));
+}
 
-    if (height > getMaxZ())
-        height = getMaxZ();
-    if (height < getMinZ())
-        height = getMinZ();
+void TinCreationStrategy::convertECEFToUVH(const Point_3* pts, const std::size_t& n, std::vector<Point_3>& uvhPts) const
+{
+    std::vector<double> x(n), y(n), z(n);
+    for (std::size_t i = 0; i < n; i++) {
+        x[i] = pts[i].x();
+        y[i] = pts[i].y();
+        z[i] = pts[i].z();
+    }
+
+    // From ECEF to lat/lon/height, all points at once
+    std::vector<double> lon(n), lat(n), height(n);
+    m_ecefConverter.ecefToGeodetic(x.data(), y.data(), z.data(), n, lon.data(), lat.data(), height.data());
 
     // Scale to local U/V/H
-    double u = (lon - this->getMinX()) / (this->getMaxX() - this->getMinX());
-    double v = (lat - this->getMinY()) / (this->getMaxY() - this->getMinY());
-    double h = (this->getMaxZ() - this->getMinZ()) < std::numeric_limits<double>::epsilon()
-               ? // Avoid division by 0 ((this->getMaxZ() - this->getMinZ()) == 0 in flat tiles!)
-               height - this->getMinZ()
-               : (height - this->getMinZ()) / (this->getMaxZ() - this->getMinZ());
-
-//    std::cout << "uvh" << std::endl;
-//    std::cout << u << ", " << v << ", " << h << std::endl;
-//
-//    if (u < 0.0 || v < 0.0 || u > 1.0 || v > 1.0) {
-//        std::cout << "[ERROR] ECEF converted point not in the 0..1 range" << std::endl;
-//        std::cout << "        ECEF point = " << p << std::endl;
-//        std::cout << "        lat/lon/height point = " << lat << ", " << lon << ", " << height << std::endl;
-//        std::cout << "        u/v/h point = " << u << ", " << v << ", " << h << std::endl;
-//    }
-
-    return Point_3(u, v, h);
+    const double rangeZ = this->getMaxZ() - this->getMinZ();
+    uvhPts.clear();
+    uvhPts.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        double hgt = height[i];
+        if (hgt > getMaxZ())
+            hgt = getMaxZ();
+        if (hgt < getMinZ())
+            hgt = getMinZ();
+
+        double u = (lon[i] - this->getMinX()) / (this->getMaxX() - this->getMinX());
+        double v = (lat[i] - this->getMinY()) / (this->getMaxY() - this->getMinY());
+        double h = rangeZ < std::numeric_limits<double>::epsilon()
+                   ? // Avoid division by 0 ((this->getMaxZ() - this->getMinZ()) == 0 in flat tiles!)
+                   hgt - this->getMinZ()
+                   : (hgt - this->getMinZ()) / rangeZ;
+
+        uvhPts.push_back(Point_3(u, v, h));
+    }
+}
+
+std::vector<Point_3>
+TinCreationStrategy::
+convertUVHToMetric(const std::vector<Point_3> &pts) const {
+    double scaleU, scaleV, scaleH;
+    if (!this->hasOriginalBoundingBox() || !localTangentFrameScales(scaleU, scaleV, scaleH))
+        return convertUVHToECEF(pts);
+
+    // Affine map, centered on the tile
+    std::vector<Point_3> metricPts;
+    metricPts.reserve(pts.size());
+    for (std::vector<Point_3>::const_iterator it = pts.begin(); it != pts.end(); ++it)
+        metricPts.push_back(Point_3((it->x() - 0.5) * scaleU, (it->y() - 0.5) * scaleV, it->z() * scaleH));
+
+    return metricPts;
+}
+
+std::vector<Point_3>
+TinCreationStrategy::
+convertMetricToUVH(const std::vector<Point_3> &pts) const {
+    double scaleU, scaleV, scaleH;
+    if (!this->hasOriginalBoundingBox() || !localTangentFrameScales(scaleU, scaleV, scaleH))
+        return convertECEFToUVH(pts);
+
+    std::vector<Point_3> uvhPts;
+    uvhPts.reserve(pts.size());
+    for (std::vector<Point_3>::const_iterator it = pts.begin(); it != pts.end(); ++it) {
+        // Clamp the height to the range of the tile, as in convertECEFToUVH
+        double z = std::min(std::max(it->z(), 0.0), scaleH);
+        double h = scaleH < std::numeric_limits<double>::epsilon()
+                   ? // Avoid division by 0 in flat tiles
+                   z
+                   : z / scaleH;
+        uvhPts.push_back(Point_3(it->x() / scaleU + 0.5, it->y() / scaleV + 0.5, h));
+    }
+
+    return uvhPts;
+}
+
+bool TinCreationStrategy::localTangentFrameScales(double& scaleU, double& scaleV, double& scaleH) const
+{
+    const double degToRad = M_PI / 180.0;
+    const double minLat = std::max(this->getMinY(), -90.0);
+    const double maxLat = std::min(this->getMaxY(), 90.0);
+    const double midLat = (minLat + maxLat) / 2.0;
+    const double midHeight = (this->getMinZ() + this->getMaxZ()) / 2.0;
+
+    // Metric length of a degree in the east/north directions at a given latitude
+    auto degreeLengths = [&](const double& lat, double& east, double& north) {
+        double meridian, primeVertical;
+        crs_conversions::radiiOfCurvature(lat, meridian, primeVertical);
+        east = (primeVertical + midHeight) * std::cos(lat * degToRad) * degToRad;
+        north = (meridian + midHeight) * degToRad;
+    };
+
+    // The frame uses the lengths at the center of the tile everywhere. Check how much they change within the tile: the
+    // east-west one is monotonic in each hemisphere, so it suffices to look at the extremes of the latitude range (and
+    // at the equator, if the tile contains it)
+    double midEast, midNorth;
+    degreeLengths(midLat, midEast, midNorth);
+    if (midEast <= 0.0)
+        return false;
+
+    std::vector<double> lats = {minLat, maxLat};
+    if (minLat < 0.0 && maxLat > 0.0)
+        lats.push_back(0.0);
+    for (std::size_t i = 0; i < lats.size(); i++) {
+        double east, north;
+        degreeLengths(lats[i], east, north);
+        if (std::fabs(east / midEast - 1.0) > LocalTangentFrameMaxDistortion ||
+            std::fabs(north / midNorth - 1.0) > LocalTangentFrameMaxDistortion)
+            return false;
+    }
+
+    scaleU = (this->getMaxX() - this->getMinX()) * midEast;
+    scaleV = (this->getMaxY() - this->getMinY()) * midNorth;
+    scaleH = this->getMaxZ() - this->getMinZ();
+
+    return scaleU > 0.0 && scaleV > 0.0;
 }
 
-} // End namespace TinCreation
\ No newline at end of file
+} // End namespace TinCreation
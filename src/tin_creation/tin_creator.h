@@ -22,8 +22,15 @@
 #define EMODNET_QMGC_TIN_CREATOR_H
 
 #include <memory>
+#include <string>
+#include <limits>
+#include <vector>
 #include "tin_creation_cgal_types.h"
+#include "height_grid.h"
+#include "indexed_mesh.h"
+#include "refinement_budget.h"
 #include "base/misc_utils.h"
+#include "base/crs_conversions.h"
 
 // Note: this set of classes implement a Strategy Pattern
 namespace TinCreation {
@@ -61,6 +68,47 @@ public:
                               const bool &constrainNorthernVertices,
                               const bool &constrainSouthernVertices) = 0;
 
+    /**
+     * @brief Create a TIN from a regular grid of heights.
+     *
+     * The default implementation converts the grid to a set of scattered points (see heightGridToPoints) and calls the
+     * function above, so that all the strategies accept this input. Strategies that can take profit of the regular
+     * structure of the input should override it.
+     *
+     * @param grid The grid of heights covering the tile
+     * @param borders Vertices to preserve on the borders of the tile
+     * @return
+     */
+    virtual Polyhedron create(const HeightGridView &grid,
+                              const HeightGridBorders &borders) {
+        return create(heightGridToPoints(grid, borders),
+                      borders.constrainEast(),
+                      borders.constrainWest(),
+                      borders.constrainNorth(),
+                      borders.constrainSouth());
+    }
+
+    /**
+     * @brief Create a TIN from a regular grid of heights, as a compact indexed mesh.
+     *
+     * This is what QuantizedMeshTiler uses to encode the tiles. The default implementation converts the Polyhedron
+     * returned by create(grid, borders) (i.e., the vertices are copied twice), so strategies ending with a list of
+     * vertices and triangles (or with a triangulation) should override it to fill the mesh directly. The border flags
+     * of the mesh and the removal of its unreferenced vertices are left to the caller (see computeBorderFlags and
+     * removeUnreferencedVertices).
+     *
+     * Note that overrides of create(grid, borders) must not call this function, as the default implementation calls them.
+     *
+     * @param grid The grid of heights covering the tile
+     * @param borders Vertices to preserve on the borders of the tile
+     * @param[out] mesh The TIN (the previous contents are replaced, but its memory is reused)
+     */
+    virtual void createIndexedMesh(const HeightGridView &grid,
+                                   const HeightGridBorders &borders,
+                                   IndexedMesh &mesh) {
+        polyhedronToIndexedMesh(create(grid, borders), mesh);
+    }
+
     /**
      * @brief Adapts the parameters of the algorithm for the desired zoom level.
      *
@@ -70,6 +118,22 @@ public:
      */
     virtual void setParamsForZoom(const unsigned int& zoom) = 0;
 
+    /**
+     * @brief Maximum vertical deviation from a plane, in the units of the heights (i.e., meters), for a tile to be
+     * represented with a minimal planar mesh instead of running the TIN creation (see createPlanarTileMesh).
+     *
+     * By default, only exactly planar tiles are affected. Strategies with an error tolerance should return it, and
+     * strategies that must not simplify the tile should return a negative value (disabled).
+     */
+    virtual double getPlanarTileTolerance() const { return 0.0; }
+
+    /**
+     * @brief Criterion that stopped the refinement of the last TIN created (see StopCriterion).
+     *
+     * Only meaningful for the strategies refining the TIN incrementally, the rest return StopNotApplicable.
+     */
+    virtual StopCriterion getLastStopCriterion() const { return StopNotApplicable; }
+
     /**
      * Set the scale in Z (used by some of the methods to scale the parameters w.r.t. the tile units)
      * @param scale Scale in Z
@@ -126,10 +190,39 @@ public:
     // This conversion is used by some point set simplification methods requiring metric coordinates
     Point_3 convertECEFToUVH(const Point_3& p) const;
 
+    /**
+     * @brief Convert points in UVH format to a metric frame, given the limits of the tile
+     *
+     * The frame is a local tangent plane (east/north/up) at the center of the tile, obtained as an affine map of the
+     * lon/lat/height of the points, so that no trigonometric functions are evaluated per point. Where this approximation
+     * distorts the distances too much (polar or very coarse tiles, see LocalTangentFrameMaxDistortion), the points are
+     * converted to ECEF instead. Use convertMetricToUVH to convert the points back.
+     */
+    std::vector<Point_3> convertUVHToMetric(const std::vector<Point_3>& pts) const;
+
+    /// Convert points obtained with convertUVHToMetric (or derived from them) back to UVH
+    std::vector<Point_3> convertMetricToUVH(const std::vector<Point_3>& pts) const;
+
+    /// Maximum relative scale distortion within the tile for convertUVHToMetric to use the local tangent plane frame
+    static const double LocalTangentFrameMaxDistortion;
+
 private:
     double m_scaleZ;
     double m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ;
     bool m_boundsSet;
+    mutable crs_conversions::GeodeticECEFConverter m_ecefConverter; // Keeps per-tile tables, hence mutable (there is a strategy per thread)
+
+    /// Converts a set of u/v/h points to lon/lat/height, and then to ECEF
+    void convertUVHToECEF(const Point_3* pts, const std::size_t& n, std::vector<Point_3>& ecefPts) const;
+
+    /// Converts a set of ECEF points to lon/lat/height, and then to u/v/h
+    void convertECEFToUVH(const Point_3* pts, const std::size_t& n, std::vector<Point_3>& uvhPts) const;
+
+    /**
+     * Scales of the local tangent plane frame of the current tile w.r.t. u/v/h
+     * @return False if the frame distorts the distances more than LocalTangentFrameMaxDistortion (use ECEF instead)
+     */
+    bool localTangentFrameScales(double& scaleU, double& scaleV, double& scaleH) const;
 };
 
 /**
@@ -148,9 +241,76 @@ public:
 
     /**
      * @brief Sets the actual TIN creator algorithm
+     *
+     * When adaptive creators are added (see addAdaptiveCreator), this is the one used for the tiles not matching any
+     * of their rules.
+     *
      * @param creator Pointer to the actual TIN creator algorithm to use
+     * @param name Name of the algorithm (for logging purposes)
+     */
+    void setCreator(std::shared_ptr<TinCreationStrategy> creator, const std::string& name = "") {
+        m_creator = creator;
+        m_defaultCreator = creator;
+        m_defaultName = name;
+        m_creatorName = name;
+    }
+
+    /**
+     * @brief Add an alternative TIN creator algorithm, to be used for the tiles in a range of zooms whose roughness is
+     * below a threshold.
+     *
+     * This allows using cheap algorithms for smooth terrain (e.g., abyssal plains), and leaving the expensive ones for
+     * the rough parts. The rules are checked in the order they were added, so those with lower roughness thresholds
+     * should be added first. See selectCreator.
+     *
+     * @param creator Pointer to the TIN creator algorithm
+     * @param name Name of the algorithm (for logging purposes)
+     * @param maxRoughness Maximum roughness of the tiles using this algorithm (see HeightGridRoughness::rmsDetail)
+     * @param minZoom Minimum zoom of the tiles using this algorithm
+     * @param maxZoom Maximum zoom of the tiles using this algorithm
+     */
+    void addAdaptiveCreator(std::shared_ptr<TinCreationStrategy> creator, const std::string& name,
+                            const double& maxRoughness,
+                            const unsigned int& minZoom = 0,
+                            const unsigned int& maxZoom = std::numeric_limits<unsigned int>::max()) {
+        AdaptiveRule rule;
+        rule.creator = creator;
+        rule.name = name;
+        rule.maxRoughness = maxRoughness;
+        rule.minZoom = minZoom;
+        rule.maxZoom = maxZoom;
+        m_adaptiveRules.push_back(rule);
+    }
+
+    /// Check if the algorithm is selected per tile (i.e., adaptive creators were added)
+    bool isAdaptive() const { return !m_adaptiveRules.empty(); }
+
+    /**
+     * @brief Select the TIN creator algorithm to use for a tile
+     *
+     * The first adaptive rule whose zoom range contains \p zoom and whose roughness threshold is not below
+     * \p roughness is used, or the default algorithm (see setCreator) if none matches. Must be called before
+     * setBounds and create.
+     *
+     * @param zoom Zoom of the tile
+     * @param roughness Roughness of the tile (see HeightGridRoughness::rmsDetail)
+     * @return The name of the selected algorithm
      */
-    void setCreator(std::shared_ptr<TinCreationStrategy> creator) { m_creator = creator; }
+    const std::string& selectCreator(const unsigned int& zoom, const double& roughness) {
+        m_creator = m_defaultCreator;
+        m_creatorName = m_defaultName;
+        for (std::vector<AdaptiveRule>::const_iterator it = m_adaptiveRules.begin(); it != m_adaptiveRules.end(); ++it) {
+            if (zoom >= it->minZoom && zoom <= it->maxZoom && roughness <= it->maxRoughness) {
+                m_creator = it->creator;
+                m_creatorName = it->name;
+                break;
+            }
+        }
+        return m_creatorName;
+    }
+
+    /// Name of the TIN creator algorithm currently in use
+    const std::string& getCreatorName() const { return m_creatorName; }
 
     /**
      * @brief Create a TIN from a set of points.
@@ -177,6 +337,34 @@ public:
                                  constrainSouthernVertices);
     }
 
+    /**
+     * @brief Create a TIN from a regular grid of heights.
+     *
+     * @param grid The grid of heights covering the tile
+     * @param borders Vertices to preserve on the borders of the tile
+     * @return
+     */
+    Polyhedron create(const HeightGridView &grid,
+                      const HeightGridBorders &borders) {
+        return m_creator->create(grid, borders);
+    }
+
+    /**
+     * @brief Create a TIN from a regular grid of heights, as a compact indexed mesh with its border flags (and without
+     * unreferenced vertices).
+     *
+     * @param grid The grid of heights covering the tile
+     * @param borders Vertices to preserve on the borders of the tile
+     * @param[out] mesh The TIN (the previous contents are replaced, but its memory is reused)
+     */
+    void createIndexedMesh(const HeightGridView &grid,
+                           const HeightGridBorders &borders,
+                           IndexedMesh &mesh) {
+        m_creator->createIndexedMesh(grid, borders, mesh);
+        removeUnreferencedVertices(mesh);
+        computeBorderFlags(mesh);
+    }
+
     /**
      * @brief Adapts the parameters of the algorithm for the desired zoom level.
      *
@@ -185,9 +373,17 @@ public:
      * @param zoom Current zoom level
      */
     void setParamsForZoom(const unsigned int& zoom) {
-        m_creator->setParamsForZoom(zoom);
+        m_defaultCreator->setParamsForZoom(zoom);
+        for (std::vector<AdaptiveRule>::iterator it = m_adaptiveRules.begin(); it != m_adaptiveRules.end(); ++it)
+            it->creator->setParamsForZoom(zoom);
     }
 
+    /// Tolerance for a tile to be considered planar by the current algorithm (see TinCreationStrategy::getPlanarTileTolerance)
+    double getPlanarTileTolerance() const { return m_creator->getPlanarTileTolerance(); }
+
+    /// Criterion that stopped the refinement of the last TIN created (see TinCreationStrategy::getLastStopCriterion)
+    StopCriterion getLastStopCriterion() const { return m_creator->getLastStopCriterion(); }
+
     /**
      * Set the scale in Z (used by some of the methods to scale the parameters w.r.t. the tile units)
      * @param scale Scale in Z
@@ -211,8 +407,20 @@ public:
     }
 
 private:
+    /// An alternative TIN creator algorithm, and the tiles where it applies (see addAdaptiveCreator)
+    struct AdaptiveRule {
+        std::shared_ptr<TinCreationStrategy> creator;
+        std::string name;
+        double maxRoughness;
+        unsigned int minZoom, maxZoom;
+    };
+
     // --- Attributes ---
-    std::shared_ptr<TinCreationStrategy> m_creator;
+    std::shared_ptr<TinCreationStrategy> m_creator; //!< The algorithm currently in use
+    std::string m_creatorName;
+    std::shared_ptr<TinCreationStrategy> m_defaultCreator;
+    std::string m_defaultName;
+    std::vector<AdaptiveRule> m_adaptiveRules;
 };
 
 } // End namespace tin_creation